@@ -20,27 +20,19 @@ void client_handle_create_window(Client *client, CompositorCreateWindow create_w
         return;
     }
 
-    auto frontbuffer = Bitmap::create_shared_from_handle(create_window.frontbuffer, create_window.backbuffer_size);
+    auto frontbuffer = Bitmap::create_shared_from_handle(create_window.buffer, create_window.buffer_size);
 
     if (!frontbuffer.success())
     {
         return;
     }
 
-    auto backbuffer = Bitmap::create_shared_from_handle(create_window.backbuffer, create_window.backbuffer_size);
-
-    if (!backbuffer.success())
-    {
-        return;
-    }
-
     new Window(create_window.id,
                create_window.flags,
                create_window.type,
                client,
                create_window.bound,
-               frontbuffer.take_value(),
-               backbuffer.take_value());
+               frontbuffer.take_value());
 }
 
 void client_handle_destroy_window(Client *client, CompositorDestroyWindow destroy_window)
@@ -92,11 +84,7 @@ void client_handle_flip_window(Client *client, CompositorFlipWindow flip_window)
         return;
     }
 
-    window->flip_buffers(flip_window.frontbuffer, flip_window.frontbuffer_size, flip_window.backbuffer, flip_window.backbuffer_size, flip_window.bound);
-
-    CompositorMessage message = {};
-    message.type = COMPOSITOR_MESSAGE_ACK;
-    client->send_message(message);
+    window->flip_buffers(flip_window.buffer, flip_window.buffer_size, flip_window.frame, flip_window.damage, flip_window.opaque);
 }
 
 void client_handle_cursor_window(Client *client, CompositorCursorWindow cursor_window)
@@ -52,11 +52,13 @@ void manager_register_window(Window *window)
 {
     manager_set_focus_window(window);
     renderer_region_dirty(window->bound());
+    renderer_backdrop_dirty(window->bound(), window);
 }
 
 void manager_unregister_window(Window *window)
 {
     renderer_region_dirty(window->bound());
+    renderer_backdrop_dirty(window->bound(), window);
     list_remove(_managed_windows, window);
 
     manager_set_focus_window((Window *)list_peek(_managed_windows));
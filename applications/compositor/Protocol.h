@@ -7,7 +7,6 @@
 enum CompositorMessageType
 {
     COMPOSITOR_MESSAGE_INVALID,
-    COMPOSITOR_MESSAGE_ACK,
     COMPOSITOR_MESSAGE_GREETINGS,
     COMPOSITOR_MESSAGE_EVENT,
     COMPOSITOR_MESSAGE_CHANGED_RESOLUTION,
@@ -17,6 +16,8 @@ enum CompositorMessageType
     COMPOSITOR_MESSAGE_RESIZE_WINDOW,
     COMPOSITOR_MESSAGE_MOVE_WINDOW,
     COMPOSITOR_MESSAGE_FLIP_WINDOW,
+    COMPOSITOR_MESSAGE_BUFFER_RELEASED,
+    COMPOSITOR_MESSAGE_FRAME_DONE,
     COMPOSITOR_MESSAGE_EVENT_WINDOW,
     COMPOSITOR_MESSAGE_CURSOR_WINDOW,
     COMPOSITOR_MESSAGE_SET_RESOLUTION,
@@ -33,9 +34,17 @@ enum CompositorMessageType
 #define WINDOW_SWALLOW (1 << 3)
 #define WINDOW_TRANSPARENT (1 << 4)
 #define WINDOW_NO_FOCUS (1 << 5)
+#define WINDOW_BLUR_BEHIND (1 << 6)
 
 typedef unsigned int WindowFlag;
 
+// Clients render into one buffer while the compositor shows another, the third
+// one lets them start the next frame before the release of the previous one
+// made it back.
+#define COMPOSITOR_BUFFER_COUNT 3
+
+#define COMPOSITOR_DAMAGE_MAX 8
+
 enum WindowType
 {
     WINDOW_TYPE_POPOVER,
@@ -61,10 +70,8 @@ struct CompositorCreateWindow
     WindowFlag flags;
     WindowType type;
 
-    int frontbuffer;
-    Vec2i frontbuffer_size;
-    int backbuffer;
-    Vec2i backbuffer_size;
+    int buffer;
+    Vec2i buffer_size;
 
     Rectangle bound;
 };
@@ -88,16 +95,42 @@ struct CompositorMoveWindow
     Vec2i position;
 };
 
+struct CompositorDamage
+{
+    int count;
+    Rectangle rectangles[COMPOSITOR_DAMAGE_MAX];
+};
+
+// The buffer is owned by the compositor until it sends it back with
+// COMPOSITOR_MESSAGE_BUFFER_RELEASED, flips don't wait for an answer.
 struct CompositorFlipWindow
 {
     int id;
 
-    int frontbuffer;
-    Vec2i frontbuffer_size;
-    int backbuffer;
-    Vec2i backbuffer_size;
+    int buffer;
+    Vec2i buffer_size;
+    int frame;
 
-    Rectangle bound;
+    CompositorDamage damage;
+
+    // Part of a transparent window the client promises to fill with opaque
+    // pixels, relative to the window. Ignored for opaque windows.
+    Rectangle opaque;
+};
+
+struct CompositorBufferReleased
+{
+    int id;
+
+    int buffer;
+};
+
+// Sent once the frame made it to the screen, clients use it to pace themselves.
+struct CompositorFrameDone
+{
+    int id;
+
+    int frame;
 };
 
 struct CompositorEventWindow
@@ -148,6 +181,8 @@ struct CompositorMessage
         CompositorResizeWindow resize_window;
         CompositorMoveWindow move_window;
         CompositorFlipWindow flip_window;
+        CompositorBufferReleased buffer_released;
+        CompositorFrameDone frame_done;
         CompositorEventWindow event_window;
         CompositorCursorWindow cursor_window;
         CompositorSetResolution set_resolution;
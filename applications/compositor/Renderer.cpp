@@ -9,13 +9,61 @@
 static OwnPtr<Framebuffer> _framebuffer;
 static RefPtr<Bitmap> _wallpaper;
 
+// The wallpaper scaled to the resolution of the framebuffer, exposing the
+// desktop is a plain copy out of it.
+static RefPtr<Bitmap> _wallpaper_scaled;
+
 static Vector<Rectangle> _dirty_regions;
 
+#define RENDERER_BLUR_RADIUS 48
+
+enum RendererLayerType
+{
+    RENDERER_LAYER_OPAQUE,
+    RENDERER_LAYER_TRANSLUCENT,
+    RENDERER_LAYER_BLURRED,
+};
+
+struct RendererLayer
+{
+    // The wallpaper when null.
+    Window *window;
+    Rectangle region;
+    RendererLayerType type;
+};
+
+static Vector<RendererLayer> _layers;
+
+static void renderer_scale_wallpaper()
+{
+    Rectangle resolution = _framebuffer->resolution();
+
+    if (_wallpaper_scaled == nullptr || _wallpaper_scaled->size() != resolution.size())
+    {
+        _wallpaper_scaled = nullptr;
+
+        auto bitmap_or_result = Bitmap::create_shared(resolution.width(), resolution.height());
+
+        if (!bitmap_or_result.success())
+        {
+            logger_error("Failed to allocate the wallpaper: %s", get_result_description(bitmap_or_result.result()));
+            return;
+        }
+
+        _wallpaper_scaled = bitmap_or_result.take_value();
+    }
+
+    Painter painter(_wallpaper_scaled);
+    painter.blit_bitmap_no_alpha(*_wallpaper, _wallpaper->bound(), _wallpaper_scaled->bound());
+}
+
 void renderer_initialize()
 {
     _framebuffer = Framebuffer::open().take_value();
     _wallpaper = Bitmap::load_from_or_placeholder("/Files/Wallpapers/mountains.png");
 
+    renderer_scale_wallpaper();
+
     renderer_region_dirty(_framebuffer->resolution());
 }
 
@@ -61,100 +109,224 @@ void renderer_region_dirty(Rectangle new_region)
 
 void renderer_composite_wallpaper(Rectangle region)
 {
-    double scale_x = _wallpaper->width() / (double)_framebuffer->resolution().width();
-    double scale_y = _wallpaper->height() / (double)_framebuffer->resolution().height();
-
-    Rectangle source(
-        region.x() * scale_x,
-        region.y() * scale_y,
-        region.width() * scale_x,
-        region.height() * scale_y);
-
-    _framebuffer->painter().blit_bitmap_no_alpha(*_wallpaper, source, region);
-    _framebuffer->mark_dirty(region);
+    if (_wallpaper_scaled != nullptr)
+    {
+        _framebuffer->bitmap().copy_from(*_wallpaper_scaled, region);
+    }
+    else
+    {
+        _framebuffer->painter().fill_rectangle(region, Colors::BLACK);
+    }
 }
 
-void renderer_composite_region(Rectangle region, Window *window_transparent)
+// Paint everything behind the window into its backdrop and blur it, the
+// result is reused until renderer_backdrop_dirty() invalidates it.
+static RefPtr<Bitmap> renderer_window_backdrop(Window *window)
 {
-    renderer_composite_wallpaper(region);
+    if (window->backdrop_valid())
+    {
+        return window->backdrop();
+    }
+
+    Rectangle bound = window->bound();
+    RefPtr<Bitmap> backdrop = window->backdrop();
 
-    manager_iterate_back_to_front([&](Window *window) {
-        if (window == window_transparent)
+    if (backdrop == nullptr || backdrop->size() != bound.size())
+    {
+        backdrop = Bitmap::create_shared(bound.width(), bound.height()).take_value();
+    }
+
+    Painter painter(backdrop);
+    painter.transform(Vec2i::zero() - bound.position());
+
+    if (_wallpaper_scaled != nullptr)
+    {
+        painter.blit_bitmap_no_alpha(*_wallpaper_scaled, bound, bound);
+    }
+
+    manager_iterate_back_to_front([&](Window *behind) {
+        if (behind == window)
         {
             return Iteration::STOP;
         }
 
-        if (window->bound().colide_with(region))
+        if (!behind->bound().colide_with(bound))
         {
-            Rectangle destination = window->bound().clipped_with(region);
+            return Iteration::CONTINUE;
+        }
 
-            Rectangle source(
-                destination.position() - window->bound().position(),
-                destination.size());
+        Rectangle destination = behind->bound().clipped_with(bound);
 
-            _framebuffer->painter().blit_bitmap(window->frontbuffer(), source, destination);
+        Rectangle source(
+            destination.position() - behind->bound().position(),
+            destination.size());
+
+        if (behind->blur_behind() && behind->backdrop_valid())
+        {
+            painter.blit_bitmap_no_alpha(*behind->backdrop(), source, destination);
         }
 
+        painter.blit_bitmap(behind->frontbuffer(), source, destination);
+
         return Iteration::CONTINUE;
     });
 
-    _framebuffer->mark_dirty(region);
+    painter.blur_rectangle(bound, RENDERER_BLUR_RADIUS);
+
+    window->backdrop(backdrop);
+
+    return backdrop;
 }
 
-void renderer_region(Rectangle region)
+void renderer_backdrop_dirty(Rectangle region, Window *source)
 {
-    bool should_paint_wallpaper = true;
+    // Blurring spreads changes beyond the region itself.
+    region = region.expended(Insets(RENDERER_BLUR_RADIUS));
 
-    if (region.is_empty())
+    list_foreach(Window, window, manager_get_windows())
     {
-        return;
+        if (window == source ||
+            !window->blur_behind() ||
+            !window->backdrop_valid() ||
+            !window->bound().colide_with(region))
+        {
+            continue;
+        }
+
+        window->backdrop_invalidate();
+
+        renderer_region_dirty(window->bound());
+        renderer_backdrop_dirty(window->bound(), window);
     }
+}
+
+static void renderer_substract(Rectangle region, Rectangle hole, Vector<Rectangle> &pieces)
+{
+    Rectangle top;
+    Rectangle botton;
+    Rectangle left;
+    Rectangle right;
+
+    region.substract(hole, top, botton, left, right);
+
+    if (!top.is_empty())
+        pieces.push_back(top);
+
+    if (!botton.is_empty())
+        pieces.push_back(botton);
+
+    if (!left.is_empty())
+        pieces.push_back(left);
+
+    if (!right.is_empty())
+        pieces.push_back(right);
+}
+
+static void renderer_add_layer(Window *window, Rectangle region, RendererLayerType type)
+{
+    _layers.push_back({window, region, type});
+}
+
+// Walk the windows front to back. Opaque parts hide everything behind them
+// and are removed from what is left to draw, translucent parts are layered
+// on top of whatever is behind them. Anything left at the end is wallpaper.
+static void renderer_build_layers(const Vector<Rectangle> &dirty)
+{
+    _layers.clear();
+
+    SmallVector<Rectangle, 16> regions{};
+    regions.push_back_many(dirty);
 
     manager_iterate_front_to_back([&](Window *window) {
-        if (window->bound().colide_with(region))
+        Rectangle bound = window->bound();
+        Rectangle opaque = window->opaque_bound();
+
+        SmallVector<Rectangle, 16> uncovered{};
+
+        for (size_t i = 0; i < regions.count(); i++)
         {
-            Rectangle destination = window->bound().clipped_with(region);
+            Rectangle region = regions[i];
 
-            Rectangle source(
-                destination.position() - window->bound().position(),
-                destination.size());
+            if (!region.colide_with(bound))
+            {
+                uncovered.push_back(region);
+                continue;
+            }
+
+            Rectangle visible = region.clipped_with(bound);
+
+            renderer_substract(region, visible, uncovered);
 
-            if (window->flags() & WINDOW_TRANSPARENT)
+            if (window->blur_behind())
             {
-                renderer_composite_region(destination, window);
-                //_framebuffer->painter().blur_rectangle(destination, 48);
-                _framebuffer->painter().blit_bitmap(window->frontbuffer(), source, destination);
+                // The backdrop comes from the cache, nothing behind is needed.
+                renderer_add_layer(window, visible, RENDERER_LAYER_BLURRED);
+                continue;
             }
-            else
+
+            if (!visible.colide_with(opaque))
             {
-                _framebuffer->painter().blit_bitmap_no_alpha(window->frontbuffer(), source, destination);
+                renderer_add_layer(window, visible, RENDERER_LAYER_TRANSLUCENT);
+                uncovered.push_back(visible);
+                continue;
             }
 
-            _framebuffer->mark_dirty(destination);
+            Rectangle solid = visible.clipped_with(opaque);
+            renderer_add_layer(window, solid, RENDERER_LAYER_OPAQUE);
 
-            Rectangle top;
-            Rectangle botton;
-            Rectangle left;
-            Rectangle right;
+            SmallVector<Rectangle, 4> translucent{};
+            renderer_substract(visible, solid, translucent);
 
-            region.substract(destination, top, botton, left, right);
+            for (size_t j = 0; j < translucent.count(); j++)
+            {
+                renderer_add_layer(window, translucent[j], RENDERER_LAYER_TRANSLUCENT);
+                uncovered.push_back(translucent[j]);
+            }
+        }
 
-            renderer_region(top);
-            renderer_region(botton);
-            renderer_region(left);
-            renderer_region(right);
+        regions = move(uncovered);
 
-            should_paint_wallpaper = false;
+        return regions.any() ? Iteration::CONTINUE : Iteration::STOP;
+    });
 
-            return Iteration::STOP;
+    for (size_t i = 0; i < regions.count(); i++)
+    {
+        renderer_add_layer(nullptr, regions[i], RENDERER_LAYER_OPAQUE);
+    }
+}
+
+// Layers were collected front to back, draw them back to front. Opaque
+// layers never overlap anything drawn before them, so every pixel of opaque
+// content is written exactly once.
+static void renderer_composite_layers()
+{
+    for (size_t i = _layers.count(); i > 0; i--)
+    {
+        RendererLayer &layer = _layers[i - 1];
+
+        if (layer.window == nullptr)
+        {
+            renderer_composite_wallpaper(layer.region);
+            continue;
         }
 
-        return Iteration::CONTINUE;
-    });
+        Rectangle source(
+            layer.region.position() - layer.window->bound().position(),
+            layer.region.size());
 
-    if (should_paint_wallpaper)
-    {
-        renderer_composite_wallpaper(region);
+        if (layer.type == RENDERER_LAYER_OPAQUE)
+        {
+            _framebuffer->painter().blit_bitmap_no_alpha(layer.window->frontbuffer(), source, layer.region);
+        }
+        else if (layer.type == RENDERER_LAYER_BLURRED)
+        {
+            _framebuffer->painter().blit_bitmap_no_alpha(*renderer_window_backdrop(layer.window), source, layer.region);
+            _framebuffer->painter().blit_bitmap(layer.window->frontbuffer(), source, layer.region);
+        }
+        else
+        {
+            _framebuffer->painter().blit_bitmap(layer.window->frontbuffer(), source, layer.region);
+        }
     }
 }
 
@@ -165,28 +337,51 @@ Rectangle renderer_bound()
 
 void renderer_repaint_dirty()
 {
-    _dirty_regions.foreach ([](Rectangle region) {
-        renderer_region(region);
+    bool cursor_damaged = false;
 
+    _dirty_regions.foreach ([&](Rectangle region) {
         if (region.colide_with(cursor_bound()))
         {
-            renderer_region(cursor_bound());
-
-            cursor_render(_framebuffer->painter());
+            cursor_damaged = true;
         }
 
         return Iteration::CONTINUE;
     });
 
+    if (cursor_damaged)
+    {
+        renderer_region_dirty(cursor_bound());
+    }
+
+    _dirty_regions.foreach ([](Rectangle region) {
+        _framebuffer->mark_dirty(region);
+        return Iteration::CONTINUE;
+    });
+
+    renderer_build_layers(_dirty_regions);
+    renderer_composite_layers();
+
+    if (cursor_damaged)
+    {
+        cursor_render(_framebuffer->painter());
+    }
+
     _framebuffer->blit();
 
     _dirty_regions.clear();
+
+    list_foreach(Window, window, manager_get_windows())
+    {
+        window->frame_done();
+    }
 }
 
 bool renderer_set_resolution(int width, int height)
 {
     auto result = _framebuffer->set_resolution(Vec2i(width, height));
+    renderer_scale_wallpaper();
     renderer_region_dirty(renderer_bound());
+    renderer_backdrop_dirty(renderer_bound(), nullptr);
     return result == SUCCESS;
 }
 
@@ -195,5 +390,8 @@ void renderer_set_wallaper(RefPtr<Bitmap> wallaper)
     _wallpaper = wallaper;
     _wallpaper->filtering(BITMAP_FILTERING_LINEAR);
 
+    renderer_scale_wallpaper();
+
     renderer_region_dirty(renderer_bound());
+    renderer_backdrop_dirty(renderer_bound(), nullptr);
 }
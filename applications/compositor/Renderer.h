@@ -3,12 +3,16 @@
 #include <libgraphic/Bitmap.h>
 #include <libgraphic/Shape.h>
 
+struct Window;
+
 void renderer_initialize();
 
 Rectangle renderer_bound();
 
 void renderer_region_dirty(Rectangle region);
 
+void renderer_backdrop_dirty(Rectangle region, Window *source);
+
 void renderer_repaint_dirty();
 
 bool renderer_set_resolution(int width, int height);
@@ -1,6 +1,7 @@
 #include <libsystem/Assert.h>
 #include <libsystem/Logger.h>
 #include <libsystem/core/CString.h>
+#include <libsystem/math/MinMax.h>
 
 #include "compositor/Client.h"
 #include "compositor/Manager.h"
@@ -14,16 +15,16 @@ Window::Window(
     WindowType type,
     struct Client *client,
     Rectangle bound,
-    RefPtr<Bitmap> frontbuffer,
-    RefPtr<Bitmap> backbuffer)
+    RefPtr<Bitmap> frontbuffer)
     : _id(id),
       _flags(flags),
       _type(type),
       _client(client),
       _bound(bound),
-      _frontbuffer(frontbuffer),
-      _backbuffer(backbuffer)
+      _frontbuffer(frontbuffer)
 {
+    _buffers.push_back(frontbuffer);
+
     manager_register_window(this);
 }
 
@@ -37,6 +38,16 @@ Rectangle Window::bound()
     return _bound;
 }
 
+Rectangle Window::opaque_bound()
+{
+    if (!(_flags & WINDOW_TRANSPARENT))
+    {
+        return _bound;
+    }
+
+    return _opaque.offset(_bound.position()).clipped_with(_bound);
+}
+
 Rectangle Window::cursor_capture_bound()
 {
     if (_flags & WINDOW_RESIZABLE)
@@ -52,19 +63,23 @@ Rectangle Window::cursor_capture_bound()
 void Window::move(Vec2i new_position)
 {
     renderer_region_dirty(bound());
+    renderer_backdrop_dirty(bound(), this);
 
     _bound = _bound.moved(new_position);
 
     renderer_region_dirty(bound());
+    renderer_backdrop_dirty(bound(), this);
 }
 
 void Window::resize(Rectangle new_bound)
 {
     renderer_region_dirty(bound());
+    renderer_backdrop_dirty(bound(), this);
 
     _bound = new_bound;
 
     renderer_region_dirty(bound());
+    renderer_backdrop_dirty(bound(), this);
 }
 
 void Window::send_event(Event event)
@@ -183,37 +198,91 @@ void Window::lost_focus()
     send_event(event);
 }
 
-void Window::flip_buffers(int frontbuffer_handle, Vec2i frontbuffer_size, int backbuffer_handle, Vec2i backbuffer_size, Rectangle region)
+void Window::flip_buffers(int buffer_handle, Vec2i buffer_size, int frame, const CompositorDamage &damage, Rectangle opaque)
 {
-    swap(_frontbuffer, _backbuffer);
+    RefPtr<Bitmap> buffer = nullptr;
 
-    if (_frontbuffer->handle() != frontbuffer_handle)
+    for (size_t i = 0; i < _buffers.count(); i++)
     {
+        if (_buffers[i]->handle() == buffer_handle &&
+            _buffers[i]->size() == buffer_size)
+        {
+            buffer = _buffers[i];
+            break;
+        }
+    }
 
-        auto new_frontbuffer = Bitmap::create_shared_from_handle(frontbuffer_handle, frontbuffer_size);
+    if (buffer == nullptr)
+    {
+        auto new_buffer = Bitmap::create_shared_from_handle(buffer_handle, buffer_size);
 
-        if (!new_frontbuffer.success())
+        if (!new_buffer.success())
         {
             logger_error("Client application gave us a jankie shared memory object id");
             return;
         }
 
-        _frontbuffer = new_frontbuffer.take_value();
+        buffer = new_buffer.take_value();
+
+        // The oldest buffers are the ones the client dropped after a resize.
+        if (_buffers.count() >= COMPOSITOR_BUFFER_COUNT)
+        {
+            _buffers.remove_index(0);
+        }
+
+        _buffers.push_back(buffer);
     }
 
-    if (_backbuffer->handle() != backbuffer_handle)
+    if (_frontbuffer->handle() != buffer_handle)
     {
+        // We are done reading from the previous frame, the client can reuse it.
+        CompositorMessage message = {
+            .type = COMPOSITOR_MESSAGE_BUFFER_RELEASED,
+            .buffer_released = {
+                .id = _id,
+                .buffer = _frontbuffer->handle(),
+            },
+        };
 
-        auto new_backbuffer = Bitmap::create_shared_from_handle(backbuffer_handle, backbuffer_size);
+        _client->send_message(message);
+    }
 
-        if (!new_backbuffer.success())
-        {
-            logger_error("Client application gave us a jankie shared memory object id");
-            return;
-        }
+    _frontbuffer = buffer;
+
+    if (_opaque != opaque)
+    {
+        // What shows through the window changed, the damage isn't enough.
+        _opaque = opaque;
+        renderer_region_dirty(bound());
+        renderer_backdrop_dirty(bound(), this);
+    }
 
-        _backbuffer = new_backbuffer.take_value();
+    for (int i = 0; i < MIN(damage.count, COMPOSITOR_DAMAGE_MAX); i++)
+    {
+        renderer_region_dirty(damage.rectangles[i].offset(bound().position()));
+        renderer_backdrop_dirty(damage.rectangles[i].offset(bound().position()), this);
     }
 
-    renderer_region_dirty(region.offset(bound().position()));
+    _frame_pending = true;
+    _frame = frame;
+}
+
+void Window::frame_done()
+{
+    if (!_frame_pending)
+    {
+        return;
+    }
+
+    _frame_pending = false;
+
+    CompositorMessage message = {
+        .type = COMPOSITOR_MESSAGE_FRAME_DONE,
+        .frame_done = {
+            .id = _id,
+            .frame = _frame,
+        },
+    };
+
+    _client->send_message(message);
 }
@@ -2,6 +2,7 @@
 
 #include <libgraphic/Bitmap.h>
 #include <libgraphic/Shape.h>
+#include <libutils/Vector.h>
 #include <libwidget/Cursor.h>
 #include <libwidget/Event.h>
 
@@ -21,7 +22,21 @@ private:
     CursorState _cursor_state{};
 
     RefPtr<Bitmap> _frontbuffer;
-    RefPtr<Bitmap> _backbuffer;
+
+    // The client cycles through the same few buffers, keep them mapped.
+    Vector<RefPtr<Bitmap>> _buffers{};
+
+    // Opaque part of a transparent window, relative to the window.
+    Rectangle _opaque{};
+
+    // What is behind a WINDOW_BLUR_BEHIND window, already blurred. It is
+    // rebuilt when something behind the window changes or the window moves.
+    RefPtr<Bitmap> _backdrop;
+    Rectangle _backdrop_bound{};
+    bool _backdrop_valid = false;
+
+    bool _frame_pending = false;
+    int _frame = 0;
 
 public:
     int id() { return _id; }
@@ -46,13 +61,29 @@ public:
         WindowType type,
         struct Client *client,
         Rectangle bound,
-        RefPtr<Bitmap> frontbuffer,
-        RefPtr<Bitmap> backbuffer);
+        RefPtr<Bitmap> frontbuffer);
 
     ~Window();
 
     Rectangle bound();
 
+    Rectangle opaque_bound();
+
+    bool blur_behind() { return (_flags & WINDOW_TRANSPARENT) && (_flags & WINDOW_BLUR_BEHIND); }
+
+    bool backdrop_valid() { return _backdrop_valid && _backdrop_bound == _bound; }
+
+    void backdrop_invalidate() { _backdrop_valid = false; }
+
+    RefPtr<Bitmap> backdrop() { return _backdrop; }
+
+    void backdrop(RefPtr<Bitmap> backdrop)
+    {
+        _backdrop = backdrop;
+        _backdrop_bound = _bound;
+        _backdrop_valid = true;
+    }
+
     Rectangle cursor_capture_bound();
 
     void move(Vec2i new_position);
@@ -71,5 +102,7 @@ public:
 
     void lost_focus();
 
-    void flip_buffers(int frontbuffer_handle, Vec2i frontbuffer_size, int backbuffer_handle, Vec2i backbuffer_size, Rectangle region);
+    void flip_buffers(int buffer_handle, Vec2i buffer_size, int frame, const CompositorDamage &damage, Rectangle opaque);
+
+    void frame_done();
 };
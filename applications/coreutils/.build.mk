@@ -1,4 +1,15 @@
 UTILS = \
+	__BENCHALLOC \
+	__BENCHCOMPOSE \
+	__BENCHLAYOUT \
+	__BENCHMAP \
+	__BENCHPAINT \
+	__BENCHPIPE \
+	__BENCHSTRING \
+	__BENCHSYSCALL \
+	__BENCHTERM \
+	__BENCHTEXT \
+	__BENCHVECTOR \
 	__TESTEXEC \
 	__TESTTERM \
 	BASENAME \
@@ -23,9 +34,11 @@ UTILS = \
 	NOW \
 	OPEN \
 	PANIC \
+	PROFILE \
 	SYSFETCH \
 	TAC \
 	TOUCH \
+	TRACE \
 	UNLINK \
 	UPTIME \
 	LINK  \
@@ -36,6 +49,39 @@ UTILS = \
 	PWD	\
 	PLAY
 
+__BENCHALLOC_LIBS =
+__BENCHALLOC_NAME = __benchalloc
+
+__BENCHCOMPOSE_LIBS = widget graphic
+__BENCHCOMPOSE_NAME = __benchcompose
+
+__BENCHLAYOUT_LIBS = widget markup graphic
+__BENCHLAYOUT_NAME = __benchlayout
+
+__BENCHMAP_LIBS = graphic
+__BENCHMAP_NAME = __benchmap
+
+__BENCHPAINT_LIBS = graphic
+__BENCHPAINT_NAME = __benchpaint
+
+__BENCHPIPE_LIBS =
+__BENCHPIPE_NAME = __benchpipe
+
+__BENCHSTRING_LIBS =
+__BENCHSTRING_NAME = __benchstring
+
+__BENCHSYSCALL_LIBS =
+__BENCHSYSCALL_NAME = __benchsyscall
+
+__BENCHTERM_LIBS = terminal
+__BENCHTERM_NAME = __benchterm
+
+__BENCHTEXT_LIBS = graphic
+__BENCHTEXT_NAME = __benchtext
+
+__BENCHVECTOR_LIBS =
+__BENCHVECTOR_NAME = __benchvector
+
 __TESTEXEC_LIBS =
 __TESTEXEC_NAME = __testexec
 
@@ -117,12 +163,18 @@ RMDIR_NAME = rmdir
 SYSFETCH_LIBS =
 SYSFETCH_NAME = sysfetch
 
+PROFILE_LIBS =
+PROFILE_NAME = profile
+
 TAC_LIBS =
 TAC_NAME = tac
 
 TOUCH_LIBS =
 TOUCH_NAME = touch
 
+TRACE_LIBS =
+TRACE_NAME = trace
+
 UNLINK_LIBS =
 UNLINK_NAME = unlink
 
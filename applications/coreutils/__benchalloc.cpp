@@ -0,0 +1,99 @@
+#include <libsystem/io/Stream.h>
+#include <libsystem/utils/Benchmark.h>
+#include <libutils/Vector.h>
+
+#define BATCH_SIZE 4096
+
+static void *volatile _sink = nullptr;
+
+static void benchmark_alloc_free(size_t operations)
+{
+    for (size_t i = 0; i < operations; i++)
+    {
+        _sink = malloc(32);
+        free(_sink);
+    }
+}
+
+static void benchmark_batch(size_t operations)
+{
+    static void *pointers[BATCH_SIZE];
+
+    for (size_t done = 0; done < operations; done += BATCH_SIZE)
+    {
+        for (size_t i = 0; i < BATCH_SIZE; i++)
+        {
+            pointers[i] = malloc(16 + (i * 7) % 1008);
+        }
+
+        // Free every other pointer first to fragment the slabs.
+        for (size_t i = 0; i < BATCH_SIZE; i += 2)
+        {
+            free(pointers[i]);
+        }
+
+        for (size_t i = 1; i < BATCH_SIZE; i += 2)
+        {
+            free(pointers[i]);
+        }
+    }
+}
+
+static void benchmark_large(size_t operations)
+{
+    for (size_t i = 0; i < operations; i++)
+    {
+        _sink = malloc(2048 + (i % 8) * 4096);
+        free(_sink);
+    }
+}
+
+static void benchmark_realloc(size_t operations)
+{
+    for (size_t done = 0; done < operations; done += 64)
+    {
+        void *buffer = nullptr;
+
+        for (size_t size = 1; size <= 64; size++)
+        {
+            buffer = realloc(buffer, size * 256);
+        }
+
+        free(buffer);
+    }
+}
+
+static void benchmark_vector(size_t operations)
+{
+    for (size_t done = 0; done < operations; done += 1024)
+    {
+        Vector<int> vector{};
+
+        for (int i = 0; i < 1024; i++)
+        {
+            vector.push_back(i);
+        }
+    }
+}
+
+static Benchmark benchmarks[] = {
+    {"malloc(32)/free", 1000000, benchmark_alloc_free},
+    {"batch 16..1024 bytes", 1024 * BATCH_SIZE / 16, benchmark_batch},
+    {"large 2K..30K", 100000, benchmark_large},
+    {"realloc growth", 64 * 4096, benchmark_realloc},
+    {"Vector<int>::push_back", 1024 * 1024, benchmark_vector},
+};
+
+int main(int argc, char **argv)
+{
+    __unused(argc);
+    __unused(argv);
+
+    benchmark_run(benchmarks);
+
+    stream_flush(out_stream);
+
+    malloc_stats();
+
+    return PROCESS_SUCCESS;
+}
@@ -0,0 +1,106 @@
+#include <libsystem/eventloop/Timer.h>
+#include <libsystem/io/Stream.h>
+#include <libsystem/utils/Benchmark.h>
+#include <libwidget/Application.h>
+#include <libwidget/Screen.h>
+
+#define PANEL_COUNT 8
+#define PANEL_SIZE 320
+#define PANEL_BORDER 24
+#define BENCHMARK_DURATION 5000
+
+// Overlapping translucent panels with an opaque interior, they keep moving so
+// the compositor has to recompose most of the screen every frame.
+class Panel : public Window
+{
+private:
+    int _index;
+    Color _color;
+
+public:
+    int frames = 0;
+
+    Panel(int index)
+        : Window(WINDOW_BORDERLESS | WINDOW_TRANSPARENT | WINDOW_NO_FOCUS),
+          _index(index),
+          _color(Color::from_hsv(index * 360.0 / PANEL_COUNT, 0.6, 0.9))
+    {
+        type(WINDOW_TYPE_PANEL);
+        size(Vec2i(PANEL_SIZE, PANEL_SIZE));
+        opaque_region(bound().shrinked(Insets(PANEL_BORDER)));
+    }
+
+    void step(int tick)
+    {
+        Rectangle screen = Screen::bound();
+
+        int x = (_index * 97 + tick * (2 + _index)) % MAX(1, screen.width() - PANEL_SIZE);
+        int y = (_index * 53 + tick * (1 + _index % 3)) % MAX(1, screen.height() - PANEL_SIZE);
+
+        position(Vec2i(x, y));
+        should_repaint(bound());
+    }
+
+    void repaint(Painter &painter, Rectangle rectangle) override
+    {
+        painter.clear_rectangle(rectangle, Colors::TRANSPARENT);
+        painter.fill_rectangle(bound(), _color.with_alpha(0.5));
+        painter.fill_rectangle(opaque_region(), _color);
+
+        frames++;
+    }
+};
+
+int main(int argc, char **argv)
+{
+    application_initialize(argc, argv);
+
+    Panel *panels[PANEL_COUNT];
+
+    for (int i = 0; i < PANEL_COUNT; i++)
+    {
+        panels[i] = new Panel(i);
+        panels[i]->show();
+    }
+
+    int tick = 0;
+    BenchmarkClock clock{};
+
+    auto step_timer = own<Timer>(1, [&]() {
+        for (int i = 0; i < PANEL_COUNT; i++)
+        {
+            panels[i]->step(tick);
+        }
+
+        tick++;
+
+        uint elapsed = clock.elapsed();
+
+        if (elapsed < BENCHMARK_DURATION)
+        {
+            return;
+        }
+
+        int frames = 0;
+
+        for (int i = 0; i < PANEL_COUNT; i++)
+        {
+            frames += panels[i]->frames;
+        }
+
+        printf("%d panels, %d steps, %d frames in %dms, %d frames/s per panel\n",
+               PANEL_COUNT,
+               tick,
+               frames,
+               elapsed,
+               frames * 1000 / PANEL_COUNT / elapsed);
+
+        stream_flush(out_stream);
+
+        application_exit(PROCESS_SUCCESS);
+    });
+
+    step_timer->start();
+
+    return application_run();
+}
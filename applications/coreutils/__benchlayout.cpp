@@ -0,0 +1,99 @@
+#include <libsystem/io/Stream.h>
+#include <libsystem/utils/Benchmark.h>
+#include <libutils/Scanner.h>
+#include <libutils/StringBuilder.h>
+#include <libwidget/Application.h>
+#include <libwidget/Markup.h>
+#include <libwidget/widgets/Label.h>
+
+#define DOCUMENT_SECTIONS 64
+#define DOCUMENT_COLUMNS 8
+#define DOCUMENT_ROWS 3
+#define BENCHMARK_PASSES 64
+
+// A deep markup document: sections of columns of labels and buttons.
+static String build_document()
+{
+    StringBuilder builder{};
+    char buffer[128];
+
+    builder.append("<Window width=\"800\" height=\"600\" layout=\"vflow(4)\">");
+
+    for (int section = 0; section < DOCUMENT_SECTIONS; section++)
+    {
+        builder.append("<Panel layout=\"hflow(4)\" padding=\"4\">");
+
+        for (int column = 0; column < DOCUMENT_COLUMNS; column++)
+        {
+            builder.append("<Container layout=\"vflow(2)\" fill=\"true\">");
+
+            for (int row = 0; row < DOCUMENT_ROWS; row++)
+            {
+                bool target = section == DOCUMENT_SECTIONS - 1 && column == DOCUMENT_COLUMNS - 1 && row == 0;
+
+                snprintf(buffer, 128, "<Label %stext=\"Label %d.%d.%d\"/>", target ? "id=\"target\" " : "", section, column, row);
+                builder.append(buffer);
+            }
+
+            snprintf(buffer, 128, "<Button text=\"Button %d.%d\"/>", section, column);
+            builder.append(buffer);
+
+            builder.append("</Container>");
+        }
+
+        builder.append("</Panel>");
+    }
+
+    builder.append("</Window>");
+
+    return builder.finalize();
+}
+
+int main(int argc, char **argv)
+{
+    application_initialize(argc, argv);
+
+    String document = build_document();
+
+    StringScanner scan{document.cstring(), document.length()};
+    auto root = markup::parse(scan);
+
+    Window *window = window_create_from_document(root);
+
+    BenchmarkClock initial_clock{};
+
+    window->relayout();
+
+    uint initial_elapsed = initial_clock.elapsed();
+
+    BenchmarkClock resize_clock{};
+
+    for (int i = 0; i < BENCHMARK_PASSES; i++)
+    {
+        window->size(Vec2i(800 + (i % 2) * 64, 600));
+        window->relayout();
+    }
+
+    uint resize_elapsed = resize_clock.elapsed();
+
+    BenchmarkClock text_clock{};
+
+    for (int i = 0; i < BENCHMARK_PASSES; i++)
+    {
+        window->with_widget<Label>("target", [&](Label *label) {
+            label->text(i % 2 ? "Short" : "A much longer label");
+        });
+
+        window->relayout();
+    }
+
+    uint text_elapsed = text_clock.elapsed();
+
+    printf("%-12s %6dms\n", "initial", initial_elapsed);
+    printf("%-12s %6dms %6dms/pass\n", "resize", resize_elapsed, resize_elapsed / BENCHMARK_PASSES);
+    printf("%-12s %6dms %6dms/pass\n", "text", text_elapsed, text_elapsed / BENCHMARK_PASSES);
+
+    delete window;
+
+    return PROCESS_SUCCESS;
+}
@@ -0,0 +1,138 @@
+#include <libfile/MappedFile.h>
+#include <libgraphic/Bitmap.h>
+#include <libgraphic/PNG.h>
+#include <libgraphic/TrueTypeFont.h>
+#include <libsystem/io/File.h>
+#include <libsystem/io/Stream.h>
+#include <libsystem/utils/Benchmark.h>
+
+struct FileBenchmark
+{
+    const char *name;
+    const char *path;
+    size_t operations;
+    void (*run)(const char *path, size_t operations);
+};
+
+static void benchmark_read_all(const char *path, size_t operations)
+{
+    for (size_t i = 0; i < operations; i++)
+    {
+        void *buffer = nullptr;
+        size_t size = 0;
+
+        if (file_read_all(path, &buffer, &size) == SUCCESS)
+        {
+            free(buffer);
+        }
+    }
+}
+
+static void benchmark_mapped_file(const char *path, size_t operations)
+{
+    for (size_t i = 0; i < operations; i++)
+    {
+        MappedFile::open(path);
+    }
+}
+
+static void benchmark_truetype_family(const char *path, size_t operations)
+{
+    for (size_t i = 0; i < operations; i++)
+    {
+        TrueTypeFamily *family = truetype_family_create(path);
+
+        if (family)
+        {
+            truetype_family_destroy(family);
+        }
+    }
+}
+
+static void benchmark_bitmap_decode(const char *path, size_t operations)
+{
+    for (size_t i = 0; i < operations; i++)
+    {
+        Bitmap::decode_from(path);
+    }
+}
+
+static void benchmark_png_decode(const char *path, size_t operations, PNGThreading threading)
+{
+    auto file_or_result = MappedFile::open(path);
+
+    if (!file_or_result.success())
+    {
+        return;
+    }
+
+    auto file = file_or_result.take_value();
+
+    for (size_t i = 0; i < operations; i++)
+    {
+        PNGDecoder decoder{file->start(), file->size()};
+
+        if (decoder.read_header() != SUCCESS)
+        {
+            return;
+        }
+
+        Color *pixels __cleanup_malloc = (Color *)malloc(decoder.width() * decoder.height() * sizeof(Color));
+        decoder.decode(pixels, threading);
+    }
+}
+
+static void benchmark_png_serial(const char *path, size_t operations)
+{
+    benchmark_png_decode(path, operations, PNG_THREADING_NEVER);
+}
+
+// Only faster than the serial decoder when the threads run on different CPUs.
+static void benchmark_png_pipelined(const char *path, size_t operations)
+{
+    benchmark_png_decode(path, operations, PNG_THREADING_ALWAYS);
+}
+
+// Goes through the image service when it's running, the image is decoded once.
+static void benchmark_bitmap_load(const char *path, size_t operations)
+{
+    for (size_t i = 0; i < operations; i++)
+    {
+        Bitmap::load_from(path);
+    }
+}
+
+#define BENCHMARK_FONT "/Files/Fonts/Roboto/Roboto-Medium.ttf"
+#define BENCHMARK_IMAGE "/Files/Wallpapers/brand.png"
+#define BENCHMARK_EXECUTABLE "/Applications/shell/shell"
+
+static FileBenchmark benchmarks[] = {
+    {"read font", BENCHMARK_FONT, 100, benchmark_read_all},
+    {"map font", BENCHMARK_FONT, 100, benchmark_mapped_file},
+    {"read image", BENCHMARK_IMAGE, 100, benchmark_read_all},
+    {"map image", BENCHMARK_IMAGE, 100, benchmark_mapped_file},
+    {"read executable", BENCHMARK_EXECUTABLE, 100, benchmark_read_all},
+    {"map executable", BENCHMARK_EXECUTABLE, 100, benchmark_mapped_file},
+    {"truetype_family_create", BENCHMARK_FONT, 100, benchmark_truetype_family},
+    {"png serial", BENCHMARK_IMAGE, 10, benchmark_png_serial},
+    {"png pipelined", BENCHMARK_IMAGE, 10, benchmark_png_pipelined},
+    {"Bitmap::decode_from", BENCHMARK_IMAGE, 10, benchmark_bitmap_decode},
+    {"Bitmap::load_from", BENCHMARK_IMAGE, 10, benchmark_bitmap_load},
+};
+
+int main(int argc, char **argv)
+{
+    __unused(argc);
+    __unused(argv);
+
+    for (size_t i = 0; i < __array_length(benchmarks); i++)
+    {
+        FileBenchmark &benchmark = benchmarks[i];
+
+        BenchmarkClock clock{};
+        benchmark.run(benchmark.path, benchmark.operations);
+        benchmark_report(benchmark.name, benchmark.operations, "op", clock);
+    }
+
+    return PROCESS_SUCCESS;
+}
@@ -0,0 +1,138 @@
+#include <libgraphic/DisplayList.h>
+#include <libsystem/core/CString.h>
+#include <libsystem/io/Stream.h>
+#include <libsystem/utils/Benchmark.h>
+
+#define SCENE_WIDTH 1024
+#define SCENE_HEIGHT 768
+#define SCENE_FRAMES 16
+
+static const int _threads[] = {1, 2, 4, 8};
+
+static const int _blur_radii[] = {2, 8, 24, 64, 1024};
+
+// The same scene is painted through a Painter and through a DisplayList, both
+// have the same drawing interface.
+template <typename TCanvas>
+static void draw_scene(TCanvas &canvas, Font &font)
+{
+    canvas.clear(Colors::BLACK);
+    canvas.fill_checkboard(Rectangle(SCENE_WIDTH, SCENE_HEIGHT), 32, Colors::DARKGRAY, Colors::GRAY);
+
+    for (int i = 0; i < 64; i++)
+    {
+        Rectangle bound((i * 97) % (SCENE_WIDTH - 200), (i * 61) % (SCENE_HEIGHT - 120), 200, 120);
+
+        canvas.push();
+        canvas.clip(bound);
+        canvas.transform(bound.position());
+
+        canvas.fill_rounded_rectangle(Rectangle(200, 120), 8, Color::from_rgba(0.2, 0.3, 0.8, 0.8));
+        canvas.draw_rounded_rectangle(Rectangle(200, 120), 8, 1, Colors::WHITE);
+        canvas.draw_line_antialias(Vec2i(8, 110), Vec2i(190, 30), Colors::ORANGE);
+        canvas.fill_triangle(Vec2i(20, 100), Vec2i(60, 40), Vec2i(100, 100), Color::from_rgba(1, 0, 0, 0.5));
+        canvas.draw_string(font, "The quick brown fox jumps over the lazy dog", Vec2i(8, 20), Colors::WHITE);
+
+        canvas.pop();
+    }
+}
+
+// A blur of a flat color must give the same color back.
+static bool blur_keeps_flat_color(RefPtr<Bitmap> bitmap, int radius, Color color)
+{
+    Painter painter(bitmap);
+    painter.clear(color);
+    painter.blur_rectangle(bitmap->bound(), radius);
+
+    for (int i = 0; i < bitmap->width() * bitmap->height(); i++)
+    {
+        if (bitmap->pixels()[i] != color)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    __unused(argc);
+    __unused(argv);
+
+    auto font_or_error = Font::create("sans");
+
+    if (!font_or_error.success())
+    {
+        stream_format(err_stream, "__benchpaint: Failed to load the font\n");
+        return PROCESS_FAILURE;
+    }
+
+    auto font = font_or_error.take_value();
+
+    size_t pixels_size = SCENE_WIDTH * SCENE_HEIGHT * sizeof(Color);
+
+    auto immediate = Bitmap::create_static(SCENE_WIDTH, SCENE_HEIGHT, (Color *)calloc(1, pixels_size));
+    auto tiled = Bitmap::create_static(SCENE_WIDTH, SCENE_HEIGHT, (Color *)calloc(1, pixels_size));
+
+    BenchmarkClock immediate_clock{};
+
+    for (int i = 0; i < SCENE_FRAMES; i++)
+    {
+        Painter painter(immediate);
+        draw_scene(painter, *font);
+    }
+
+    uint immediate_elapsed = immediate_clock.elapsed();
+
+    printf("%-12s %6dms %6dms/frame\n", "immediate", immediate_elapsed, immediate_elapsed / SCENE_FRAMES);
+
+    bool passed = true;
+
+    for (size_t i = 0; i < __array_length(_threads); i++)
+    {
+        memset(tiled->pixels(), 0, pixels_size);
+
+        BenchmarkClock tiled_clock{};
+
+        for (int j = 0; j < SCENE_FRAMES; j++)
+        {
+            DisplayList display_list(tiled->bound());
+            draw_scene(display_list, *font);
+            display_list.rasterize(tiled, _threads[i]);
+        }
+
+        uint tiled_elapsed = tiled_clock.elapsed();
+
+        bool tiled_identical = memcmp(immediate->pixels(), tiled->pixels(), pixels_size) == 0;
+
+        printf("%-12s %6dms %6dms/frame %2d threads %s\n",
+               "tiled",
+               tiled_elapsed,
+               tiled_elapsed / SCENE_FRAMES,
+               _threads[i],
+               tiled_identical ? "identical" : "DIFFERENT");
+
+        passed = passed && tiled_identical;
+    }
+
+    for (size_t i = 0; i < __array_length(_blur_radii); i++)
+    {
+        BenchmarkClock blur_clock{};
+
+        bool flat = blur_keeps_flat_color(tiled, _blur_radii[i], Color::from_byte(226, 128, 3, 255));
+
+        printf("%-12s %6dms %4d radius %s\n",
+               "blur",
+               blur_clock.elapsed(),
+               _blur_radii[i],
+               flat ? "flat" : "NOT FLAT");
+
+        passed = passed && flat;
+    }
+
+    free(immediate->pixels());
+    free(tiled->pixels());
+
+    return passed ? PROCESS_SUCCESS : PROCESS_FAILURE;
+}
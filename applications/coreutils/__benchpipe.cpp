@@ -0,0 +1,114 @@
+#include <libsystem/io/IORing.h>
+#include <libsystem/io/Pipe.h>
+#include <libsystem/io/Stream.h>
+#include <libsystem/utils/Benchmark.h>
+
+#define MESSAGE_SIZE 16
+
+// Small enough for a whole batch to fit in the pipe, so the benchmark never
+// blocks, and for a batch of writes and reads to fit in the ring.
+#define MESSAGE_PER_BATCH (IO_RING_SIZE / 2)
+
+struct PipeBenchmark
+{
+    const char *name;
+    void (*run)(Pipe *pipe, size_t messages);
+};
+
+static char _messages[MESSAGE_PER_BATCH][MESSAGE_SIZE];
+
+static char _received[MESSAGE_PER_BATCH][MESSAGE_SIZE];
+
+static void benchmark_write_read(Pipe *pipe, size_t messages)
+{
+    for (size_t done = 0; done < messages; done += MESSAGE_PER_BATCH)
+    {
+        for (size_t i = 0; i < MESSAGE_PER_BATCH; i++)
+        {
+            stream_write(pipe->in, _messages[i], MESSAGE_SIZE);
+        }
+
+        for (size_t i = 0; i < MESSAGE_PER_BATCH; i++)
+        {
+            stream_read(pipe->out, _received[i], MESSAGE_SIZE);
+        }
+    }
+}
+
+static void benchmark_writev_readv(Pipe *pipe, size_t messages)
+{
+    IOVector out_vectors[MESSAGE_PER_BATCH];
+    IOVector in_vectors[MESSAGE_PER_BATCH];
+
+    for (size_t i = 0; i < MESSAGE_PER_BATCH; i++)
+    {
+        out_vectors[i] = {_messages[i], MESSAGE_SIZE};
+        in_vectors[i] = {_received[i], MESSAGE_SIZE};
+    }
+
+    for (size_t done = 0; done < messages; done += MESSAGE_PER_BATCH)
+    {
+        handle_writev(pipe->in, out_vectors, MESSAGE_PER_BATCH);
+        handle_readv(pipe->out, in_vectors, MESSAGE_PER_BATCH);
+    }
+}
+
+static void benchmark_ring(Pipe *pipe, size_t messages)
+{
+    IORing *ring = io_ring_create();
+
+    for (size_t done = 0; done < messages; done += MESSAGE_PER_BATCH)
+    {
+        for (size_t i = 0; i < MESSAGE_PER_BATCH; i++)
+        {
+            io_ring_write(ring, HANDLE(pipe->in), _messages[i], MESSAGE_SIZE, i);
+        }
+
+        for (size_t i = 0; i < MESSAGE_PER_BATCH; i++)
+        {
+            io_ring_read(ring, HANDLE(pipe->out), _received[i], MESSAGE_SIZE, i);
+        }
+
+        io_ring_submit(ring, nullptr);
+
+        IORingCompletion completion;
+
+        while (io_ring_reap(ring, &completion))
+        {
+        }
+    }
+
+    io_ring_destroy(ring);
+}
+
+static PipeBenchmark benchmarks[] = {
+    {"write/read", benchmark_write_read},
+    {"writev/readv", benchmark_writev_readv},
+    {"submission ring", benchmark_ring},
+};
+
+int main(int argc, char **argv)
+{
+    __unused(argc);
+    __unused(argv);
+
+    const size_t messages = 64 * 1024;
+
+    Pipe *pipe = pipe_create();
+
+    stream_set_write_buffer_mode(pipe->in, STREAM_BUFFERED_NONE);
+    stream_set_read_buffer_mode(pipe->out, STREAM_BUFFERED_NONE);
+
+    for (size_t i = 0; i < __array_length(benchmarks); i++)
+    {
+        PipeBenchmark &benchmark = benchmarks[i];
+
+        BenchmarkClock clock{};
+        benchmark.run(pipe, messages);
+        benchmark_report(benchmark.name, messages, "message", clock);
+    }
+
+    pipe_destroy(pipe);
+
+    return PROCESS_SUCCESS;
+}
@@ -0,0 +1,66 @@
+#include <libsystem/io/Stream.h>
+#include <libsystem/json/Json.h>
+#include <libsystem/utils/Benchmark.h>
+#include <libutils/Path.h>
+
+static const char *_paths[] = {
+    "/Applications/terminal/terminal",
+    "/System/Utilities/ls",
+    "/Files/Documents/../Pictures/./wallpaper.png",
+    "/Configs/theme/dark.json",
+    "relative/path/to/a/file.txt",
+};
+
+// Shaped like a theme or a manifest: the same keys in every object.
+static const char *_document =
+    "{\"colors\": ["
+    "{\"name\": \"ansi-bright-magenta\", \"value\": \"#ff00ff\", \"enabled\": true},"
+    "{\"name\": \"ansi-bright-cyan\", \"value\": \"#00ffff\", \"enabled\": true},"
+    "{\"name\": \"ansi-background\", \"value\": \"#000000\", \"enabled\": false},"
+    "{\"name\": \"ansi-foreground\", \"value\": \"#ffffff\", \"enabled\": true},"
+    "{\"name\": \"selection-inactive\", \"value\": \"#808080\", \"enabled\": true}"
+    "], \"dark\": true}";
+
+static void benchmark_path_parse(size_t operations)
+{
+    for (size_t i = 0; i < operations; i++)
+    {
+        auto path = Path::parse(_paths[i % __array_length(_paths)]);
+        __unused(path);
+    }
+}
+
+static void benchmark_path_normalize(size_t operations)
+{
+    for (size_t i = 0; i < operations; i++)
+    {
+        auto path = Path::parse(_paths[i % __array_length(_paths)]).normalized();
+        auto string = path.string();
+        __unused(string);
+    }
+}
+
+static void benchmark_json_parse(size_t operations)
+{
+    for (size_t i = 0; i < operations; i++)
+    {
+        auto value = json::parse(_document, strlen(_document));
+        __unused(value);
+    }
+}
+
+static Benchmark benchmarks[] = {
+    {"Path::parse", 100000, benchmark_path_parse},
+    {"Path normalize+string", 100000, benchmark_path_normalize},
+    {"json::parse", 10000, benchmark_json_parse},
+};
+
+int main(int argc, char **argv)
+{
+    __unused(argc);
+    __unused(argv);
+
+    benchmark_run(benchmarks);
+
+    return PROCESS_SUCCESS;
+}
@@ -0,0 +1,59 @@
+#include <abi/Syscalls.h>
+
+#include <libsystem/io/Stream.h>
+#include <libsystem/utils/Benchmark.h>
+
+// The cheapest system call there is, it only reads the id of the running task.
+static void benchmark_syscall(size_t calls)
+{
+    int pid;
+
+    for (size_t i = 0; i < calls; i++)
+    {
+        __syscall(HJ_PROCESS_THIS, (uintptr_t)&pid);
+    }
+}
+
+// Same call through the interrupt gate, for comparison with the fast path.
+static void benchmark_interrupt(size_t calls)
+{
+    int pid;
+
+    for (size_t i = 0; i < calls; i++)
+    {
+#if defined(__i386__)
+        __asm__ __volatile__("push %%ebx; movl %2,%%ebx; int $0x80; pop %%ebx"
+                             :
+                             : "a"(HJ_PROCESS_THIS), "c"(0), "r"(&pid)
+                             : "memory");
+#else
+        __syscall(HJ_PROCESS_THIS, (uintptr_t)&pid);
+#endif
+    }
+}
+
+static void benchmark_vdso(size_t calls)
+{
+    uint32_t ticks;
+
+    for (size_t i = 0; i < calls; i++)
+    {
+        hj_system_tick(&ticks);
+    }
+}
+
+static Benchmark benchmarks[] = {
+    {"syscall", 1024 * 1024, benchmark_syscall},
+    {"int 0x80", 1024 * 1024, benchmark_interrupt},
+    {"vdso ticks", 1024 * 1024, benchmark_vdso},
+};
+
+int main(int argc, char **argv)
+{
+    __unused(argc);
+    __unused(argv);
+
+    benchmark_run(benchmarks, "call");
+
+    return PROCESS_SUCCESS;
+}
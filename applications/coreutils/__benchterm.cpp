@@ -0,0 +1,85 @@
+#include <libsystem/io/Stream.h>
+#include <libsystem/utils/Benchmark.h>
+#include <libterminal/Terminal.h>
+#include <libutils/StringBuilder.h>
+
+#define OUTPUT_LINES 16384
+#define BENCHMARK_PASSES 4
+
+// Mostly plain text, like the output of cat or ls, with a few colored lines.
+static String build_output()
+{
+    StringBuilder builder{};
+    char buffer[128];
+
+    for (int i = 0; i < OUTPUT_LINES; i++)
+    {
+        if (i % 8 == 0)
+        {
+            snprintf(buffer, 128, "\e[3%dmline %d\e[m: colored output\n", i % 7 + 1, i);
+        }
+        else
+        {
+            snprintf(buffer, 128, "line %d: the quick brown fox jumps over the lazy dog\n", i);
+        }
+
+        builder.append(buffer);
+    }
+
+    return builder.finalize();
+}
+
+static uint megabytes_per_second(size_t size, uint elapsed)
+{
+    return (size * BENCHMARK_PASSES / MAX(1u, elapsed)) * 1000 / (1024 * 1024);
+}
+
+int main(int argc, char **argv)
+{
+    __unused(argc);
+    __unused(argv);
+
+    String output = build_output();
+
+    terminal::Terminal bytewise{80, 24, 1000};
+
+    BenchmarkClock bytewise_clock{};
+
+    for (int i = 0; i < BENCHMARK_PASSES; i++)
+    {
+        for (size_t j = 0; j < output.length(); j++)
+        {
+            bytewise.write(output.cstring()[j]);
+        }
+    }
+
+    uint bytewise_elapsed = bytewise_clock.elapsed();
+
+    terminal::Terminal bulk{80, 24, 1000};
+
+    BenchmarkClock bulk_clock{};
+
+    for (int i = 0; i < BENCHMARK_PASSES; i++)
+    {
+        bulk.write(output.cstring(), output.length());
+    }
+
+    uint bulk_elapsed = bulk_clock.elapsed();
+
+    printf("%-12s %6dms %6dMB/s\n", "bytewise", bytewise_elapsed, megabytes_per_second(output.length(), bytewise_elapsed));
+    printf("%-12s %6dms %6dMB/s\n", "bulk", bulk_elapsed, megabytes_per_second(output.length(), bulk_elapsed));
+
+    bool identical = true;
+
+    for (int y = -bulk.history(); y < bulk.height(); y++)
+    {
+        for (int x = 0; x < bulk.width(); x++)
+        {
+            identical &= bulk.cell_at(x, y).codepoint == bytewise.cell_at(x, y).codepoint;
+        }
+    }
+
+    printf("output: %s\n", identical ? "identical" : "DIFFERENT");
+
+    return identical ? PROCESS_SUCCESS : PROCESS_FAILURE;
+}
@@ -0,0 +1,144 @@
+#include <libgraphic/Painter.h>
+#include <libsystem/core/CString.h>
+#include <libsystem/io/Stream.h>
+#include <libsystem/utils/Benchmark.h>
+
+#define SCREEN_WIDTH 1024
+#define SCREEN_HEIGHT 768
+
+// Same cell size as the terminal.
+#define CELL_WIDTH 7
+#define CELL_HEIGHT 16
+#define CELL_COLUMNS (SCREEN_WIDTH / CELL_WIDTH)
+#define CELL_ROWS (SCREEN_HEIGHT / CELL_HEIGHT)
+
+#define BENCHMARK_FONT "/Files/Fonts/Roboto/Roboto-Medium.ttf"
+
+static const char *_lines[] = {
+    "int main(int argc, char **argv)",
+    "    for (size_t i = 0; i < __array_length(benchmarks); i++)",
+    "The quick brown fox jumps over the lazy dog",
+    "drwxr-xr-x  2 user  users  4096  Applications/",
+    "    return PROCESS_SUCCESS; // Ünïcödé: àéîõü ñ ß",
+};
+
+static Painter *_painter = nullptr;
+static RefPtr<Font> _mono = nullptr;
+static RefPtr<Font> _sans = nullptr;
+static TrueTypeFont *_truetype = nullptr;
+
+// Glyph by glyph in a grid of cells, like the terminal renders its cells.
+static void benchmark_terminal(size_t glyphs)
+{
+    size_t drawn = 0;
+
+    while (drawn < glyphs)
+    {
+        for (int y = 0; y < CELL_ROWS && drawn < glyphs; y++)
+        {
+            const char *line = _lines[y % __array_length(_lines)];
+            int x = 0;
+
+            codepoint_foreach(reinterpret_cast<const uint8_t *>(line), [&](auto codepoint) {
+                if (x < CELL_COLUMNS)
+                {
+                    Glyph &glyph = _mono->glyph(codepoint);
+                    _painter->draw_glyph(*_mono, glyph, Vec2i(x * CELL_WIDTH, y * CELL_HEIGHT + 12), Colors::WHITE);
+                    x++;
+                }
+            });
+
+            drawn += x;
+        }
+    }
+}
+
+// Glyph by glyph moving by the advance of each glyph, like the text field of
+// the text editor does.
+static void benchmark_text_editor(size_t glyphs)
+{
+    size_t drawn = 0;
+
+    while (drawn < glyphs)
+    {
+        for (int y = 0; y < CELL_ROWS && drawn < glyphs; y++)
+        {
+            Vec2i position = Vec2i(32, y * CELL_HEIGHT + 12);
+
+            codepoint_foreach(reinterpret_cast<const uint8_t *>(_lines[y % __array_length(_lines)]), [&](auto codepoint) {
+                Glyph &glyph = _sans->glyph(codepoint);
+                _painter->draw_glyph(*_sans, glyph, position, Colors::WHITE);
+                position += Vec2i(glyph.advance, 0);
+                drawn++;
+            });
+        }
+    }
+}
+
+static void benchmark_truetype(size_t glyphs)
+{
+    size_t drawn = 0;
+
+    while (drawn < glyphs)
+    {
+        for (int y = 0; y < CELL_ROWS && drawn < glyphs; y++)
+        {
+            const char *line = _lines[y % __array_length(_lines)];
+
+            _painter->draw_truetype_string(_truetype, line, Vec2i(8, y * CELL_HEIGHT + 12), Colors::WHITE);
+
+            codepoint_foreach(reinterpret_cast<const uint8_t *>(line), [&](auto) {
+                drawn++;
+            });
+        }
+    }
+}
+
+static Benchmark benchmarks[] = {
+    {"terminal cells", 1024 * 1024, benchmark_terminal},
+    {"text editor lines", 1024 * 1024, benchmark_text_editor},
+    {"truetype strings", 256 * 1024, benchmark_truetype},
+};
+
+int main(int argc, char **argv)
+{
+    __unused(argc);
+    __unused(argv);
+
+    auto mono_or_error = Font::create("mono");
+    auto sans_or_error = Font::create("sans");
+
+    if (!mono_or_error.success() || !sans_or_error.success())
+    {
+        stream_format(err_stream, "__benchtext: Failed to load the fonts\n");
+        return PROCESS_FAILURE;
+    }
+
+    _mono = mono_or_error.take_value();
+    _sans = sans_or_error.take_value();
+
+    TrueTypeFamily *family = truetype_family_create(BENCHMARK_FONT);
+
+    if (family == nullptr)
+    {
+        stream_format(err_stream, "__benchtext: Failed to load " BENCHMARK_FONT "\n");
+        return PROCESS_FAILURE;
+    }
+
+    _truetype = truetypefont_create(family, 14);
+
+    size_t pixels_size = SCREEN_WIDTH * SCREEN_HEIGHT * sizeof(Color);
+    auto bitmap = Bitmap::create_static(SCREEN_WIDTH, SCREEN_HEIGHT, (Color *)calloc(1, pixels_size));
+
+    Painter painter(bitmap);
+    _painter = &painter;
+
+    benchmark_run(benchmarks, "glyph");
+
+    truetypefont_destroy(_truetype);
+    truetype_family_destroy(family);
+
+    free(bitmap->pixels());
+
+    return PROCESS_SUCCESS;
+}
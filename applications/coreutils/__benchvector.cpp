@@ -0,0 +1,88 @@
+#include <libgraphic/Shape.h>
+#include <libsystem/io/Stream.h>
+#include <libsystem/utils/Benchmark.h>
+#include <libutils/HashMap.h>
+#include <libutils/String.h>
+#include <libutils/Vector.h>
+
+static void benchmark_push_back_int(size_t operations)
+{
+    for (size_t i = 0; i < operations; i++)
+    {
+        Vector<int> vector{};
+
+        for (int j = 0; j < 1000; j++)
+        {
+            vector.push_back(j);
+        }
+    }
+}
+
+static void benchmark_push_back_string(size_t operations)
+{
+    String string = "a string too long to be stored inline";
+
+    for (size_t i = 0; i < operations; i++)
+    {
+        Vector<String> vector{};
+
+        for (int j = 0; j < 100; j++)
+        {
+            vector.push_back(string);
+        }
+    }
+}
+
+// Shaped like a json object: a map with a handful of keys.
+static void benchmark_hashmap(size_t operations)
+{
+    String keys[] = {"name", "value", "enabled", "a-key-long-enough-for-the-heap"};
+
+    for (size_t i = 0; i < operations; i++)
+    {
+        HashMap<String, int> map{};
+
+        for (size_t j = 0; j < __array_length(keys); j++)
+        {
+            map[keys[j]] = j;
+        }
+    }
+}
+
+// Shaped like a compositor frame: a few dirty regions cut into pieces.
+template <typename TVector>
+static void benchmark_regions(size_t operations)
+{
+    for (size_t i = 0; i < operations; i++)
+    {
+        TVector regions{};
+
+        for (int j = 0; j < 6; j++)
+        {
+            regions.push_back(Rectangle(j * 16, j * 16, 64, 64));
+        }
+
+        while (regions.any())
+        {
+            regions.pop_back();
+        }
+    }
+}
+
+static Benchmark benchmarks[] = {
+    {"Vector<int> x1000", 1000, benchmark_push_back_int},
+    {"Vector<String> x100", 1000, benchmark_push_back_string},
+    {"HashMap 4 keys", 10000, benchmark_hashmap},
+    {"Vector<Rectangle> x6", 100000, benchmark_regions<Vector<Rectangle>>},
+    {"SmallVector<Rectangle> x6", 100000, benchmark_regions<SmallVector<Rectangle, 8>>},
+};
+
+int main(int argc, char **argv)
+{
+    __unused(argc);
+    __unused(argv);
+
+    benchmark_run(benchmarks);
+
+    return PROCESS_SUCCESS;
+}
@@ -18,6 +18,10 @@ int main(int argc, char **argv)
 
     if (filesystem_exist(FRAMEBUFFER_DEVICE_PATH, FILE_TYPE_DEVICE))
     {
+        // Started first so the splash screen and the compositor already get
+        // their images from it.
+        process_run("image-service", nullptr);
+
         int splash_pid = -1;
         process_run("splash-screen", &splash_pid);
         process_wait(splash_pid, nullptr);
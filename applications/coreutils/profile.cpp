@@ -0,0 +1,448 @@
+#include <abi/IOCall.h>
+#include <abi/Profile.h>
+
+#include <libfile/ELF32.h>
+#include <libfile/ELF64.h>
+#include <libfile/MappedFile.h>
+#include <libsystem/cmdline/CMDLine.h>
+#include <libsystem/io/File.h>
+#include <libsystem/io/Stream.h>
+#include <libsystem/math/MinMax.h>
+#include <libsystem/process/Process.h>
+#include <libsystem/thread/Thread.h>
+#include <libutils/HashMap.h>
+#include <libutils/Slice.h>
+#include <libutils/String.h>
+#include <libutils/StringBuilder.h>
+#include <libutils/Vector.h>
+
+#include <stdlib.h>
+
+#define PROFILE_READ_SIZE 4096
+
+#define PROFILE_DRAIN_INTERVAL 250
+
+static int option_frequency = PROFILE_DEFAULT_FREQUENCY;
+static int option_duration = 1000;
+static char *option_kernel = nullptr;
+
+static const char *usages[] = {
+    "",
+    "OPTION...",
+    "OPTION... COMMAND",
+    nullptr,
+};
+
+static CommandLineOption options[] = {
+    COMMANDLINE_OPT_HELP,
+
+    COMMANDLINE_OPT_INT("frequency", 'f', option_frequency, "Sample FREQUENCY times per second (1-1000).", COMMANDLINE_NO_CALLBACK),
+    COMMANDLINE_OPT_INT("duration", 'd', option_duration, "Profile for DURATION milliseconds when no command is given.", COMMANDLINE_NO_CALLBACK),
+    COMMANDLINE_OPT_STRING("kernel", 'k', option_kernel, "Resolve kernel frames using the symbols of the kernel image at PATH.", COMMANDLINE_NO_CALLBACK),
+
+    COMMANDLINE_OPT_END};
+
+static CommandLine cmdline = CMDLINE(
+    usages,
+    options,
+    "Sample the call stacks of every task and print them as folded stacks.",
+    "The output can be turned into a flamegraph with flamegraph.pl or speedscope.");
+
+struct ProfileSymbol
+{
+    uintptr_t address;
+    size_t size;
+    const char *name;
+};
+
+struct ProfileSymbols
+{
+    Slice image;
+    Vector<ProfileSymbol> symbols;
+};
+
+static int profile_symbol_compare(const void *left, const void *right)
+{
+    auto left_symbol = reinterpret_cast<const ProfileSymbol *>(left);
+    auto right_symbol = reinterpret_cast<const ProfileSymbol *>(right);
+
+    if (left_symbol->address < right_symbol->address)
+    {
+        return -1;
+    }
+
+    if (left_symbol->address > right_symbol->address)
+    {
+        return 1;
+    }
+
+    return 0;
+}
+
+template <typename ELFFormat>
+static void profile_symbols_load_elf(ProfileSymbols &symbols, Slice &image)
+{
+    using Header = typename ELFFormat::Header;
+    using Section = typename ELFFormat::Section;
+    using Symbole = typename ELFFormat::Symbole;
+
+    auto header = image.as<Header>();
+    auto sections = image.as_array<Section>(header->shoff, header->shnum);
+
+    if (sections == nullptr)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < header->shnum; i++)
+    {
+        const Section &section = sections[i];
+
+        if (section.type != ELF_SECTION_TYPE_SYMTAB ||
+            section.link >= header->shnum)
+        {
+            continue;
+        }
+
+        const Section &strings = sections[section.link];
+
+        size_t count = section.size / sizeof(Symbole);
+        auto entries = image.as_array<Symbole>(section.offset, count);
+        auto names = image.as_array<char>(strings.offset, strings.size);
+
+        if (entries == nullptr || names == nullptr)
+        {
+            continue;
+        }
+
+        for (size_t j = 0; j < count; j++)
+        {
+            const Symbole &entry = entries[j];
+
+            if (ELF_SYMBOL_TYPE(entry.info) != ELF_SYMBOL_TYPE_FUNC ||
+                entry.value == 0 ||
+                entry.name >= strings.size)
+            {
+                continue;
+            }
+
+            symbols.symbols.push_back({(uintptr_t)entry.value, (size_t)entry.size, names + entry.name});
+        }
+    }
+}
+
+static ProfileSymbols *profile_symbols_load(const char *path)
+{
+    auto symbols = new ProfileSymbols();
+
+    if (path == nullptr)
+    {
+        return symbols;
+    }
+
+    auto result_or_file = MappedFile::open(path);
+
+    if (!result_or_file.success())
+    {
+        return symbols;
+    }
+
+    // The names of the symbols point into the image, it's kept mapped for
+    // as long as the symbols are used.
+    symbols->image = Slice{result_or_file.take_value()};
+
+    auto header32 = symbols->image.as<ELF32Header>();
+    auto header64 = symbols->image.as<ELF64Header>();
+
+    if (header32 && header32->valid())
+    {
+        profile_symbols_load_elf<ELF32>(*symbols, symbols->image);
+    }
+    else if (header64 && header64->valid())
+    {
+        profile_symbols_load_elf<ELF64>(*symbols, symbols->image);
+    }
+
+    // Vector::sort() is quadratic, executables easily have thousands of symbols.
+    qsort(symbols->symbols.raw_storage(), symbols->symbols.count(), sizeof(ProfileSymbol), profile_symbol_compare);
+
+    return symbols;
+}
+
+static const char *profile_symbols_lookup(ProfileSymbols &symbols, uintptr_t address)
+{
+    size_t low = 0;
+    size_t high = symbols.symbols.count();
+
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+
+        if (symbols.symbols[middle].address <= address)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    if (low == 0)
+    {
+        return nullptr;
+    }
+
+    ProfileSymbol &symbol = symbols.symbols[low - 1];
+
+    if (symbol.size != 0 && address >= symbol.address + symbol.size)
+    {
+        return nullptr;
+    }
+
+    return symbol.name;
+}
+
+static HashMap<String, ProfileSymbols *> _symbols{};
+
+static ProfileSymbols &profile_symbols_for(const char *path)
+{
+    String key = path ? path : "";
+
+    if (!_symbols.has_key(key))
+    {
+        _symbols[key] = profile_symbols_load(path);
+    }
+
+    return *_symbols[key];
+}
+
+static void profile_append_frame(StringBuilder &builder, ProfileSymbols &symbols, uintptr_t address, bool kernel)
+{
+    const char *name = profile_symbols_lookup(symbols, address);
+
+    builder.append(';');
+
+    if (name != nullptr)
+    {
+        builder.append(name);
+    }
+    else
+    {
+        char buffer[16];
+        snprintf(buffer, 16, "0x%08x", address);
+        builder.append(buffer);
+    }
+
+    if (kernel)
+    {
+        builder.append("_[k]");
+    }
+}
+
+// Frames are stored innermost first, folded stacks go from the root down.
+static String profile_fold(ProfileTask &task, ProfileSample &sample)
+{
+    StringBuilder builder{};
+
+    builder.append(task.name);
+
+    ProfileSymbols &user_symbols = profile_symbols_for(task.executable);
+    ProfileSymbols &kernel_symbols = profile_symbols_for(option_kernel);
+
+    for (int i = sample.depth - 1; i >= 0; i--)
+    {
+        // Only the first frame is the interrupted instruction, the others are
+        // return addresses that may point past the end of the calling function.
+        uintptr_t address = i == 0 ? sample.frames[i] : sample.frames[i] - 1;
+
+        bool kernel = i < sample.kernel_depth;
+
+        profile_append_frame(builder, kernel ? kernel_symbols : user_symbols, address, kernel);
+    }
+
+    return builder.finalize();
+}
+
+struct ProfileData
+{
+    uint8_t *buffer;
+    size_t size;
+    size_t capacity;
+};
+
+// Each read returns the samples collected since the previous one, the kernel
+// only keeps PROFILE_BUFFER_SIZE samples per task so drain it regularly.
+static void profile_collect(Stream *stream, ProfileData &data)
+{
+    size_t read = 0;
+
+    do
+    {
+        if (data.capacity - data.size < PROFILE_READ_SIZE)
+        {
+            data.capacity = MAX(data.capacity * 2, PROFILE_READ_SIZE);
+            data.buffer = (uint8_t *)realloc(data.buffer, data.capacity);
+        }
+
+        read = stream_read(stream, data.buffer + data.size, data.capacity - data.size);
+        data.size += read;
+    } while (read > 0);
+}
+
+struct ProfileCommand
+{
+    int pid;
+    int exit_value;
+    Result result;
+    bool exited;
+};
+
+// process_wait() blocks, so the command is waited from another thread while
+// this one keeps draining the samples.
+static int profile_wait_command(void *argument)
+{
+    auto waiter = reinterpret_cast<ProfileCommand *>(argument);
+
+    waiter->result = process_wait(waiter->pid, &waiter->exit_value);
+    __atomic_store_n(&waiter->exited, true, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+static Result profile_run(Stream *stream, ProfileData &data, int argc, char **argv)
+{
+    if (argc <= 1)
+    {
+        for (int elapsed = 0; elapsed < option_duration; elapsed += PROFILE_DRAIN_INTERVAL)
+        {
+            Result result = process_sleep(MIN(PROFILE_DRAIN_INTERVAL, option_duration - elapsed));
+
+            if (result != SUCCESS)
+            {
+                return result;
+            }
+
+            profile_collect(stream, data);
+        }
+
+        return SUCCESS;
+    }
+
+    StringBuilder command{};
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (i > 1)
+        {
+            command.append(' ');
+        }
+
+        command.append(argv[i]);
+    }
+
+    ProfileCommand waiter = {};
+    Result result = process_run(command.finalize().cstring(), &waiter.pid);
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    int tid = -1;
+    result = thread_create(profile_wait_command, &waiter, &tid);
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    while (!__atomic_load_n(&waiter.exited, __ATOMIC_ACQUIRE))
+    {
+        process_sleep(PROFILE_DRAIN_INTERVAL);
+        profile_collect(stream, data);
+    }
+
+    thread_join(tid, nullptr);
+
+    profile_collect(stream, data);
+
+    return waiter.result;
+}
+
+int main(int argc, char **argv)
+{
+    argc = cmdline_parse(&cmdline, argc, argv);
+
+    __cleanup(stream_cleanup) Stream *stream = stream_open(PROFILE_DEVICE_PATH, OPEN_READ);
+
+    if (handle_has_error(stream))
+    {
+        handle_printf_error(stream, "profile: Couldn't open " PROFILE_DEVICE_PATH);
+        return PROCESS_FAILURE;
+    }
+
+    stream_set_read_buffer_mode(stream, STREAM_BUFFERED_NONE);
+
+    IOCallProfileFrequencyArgs frequency_args = {option_frequency};
+
+    if (stream_call(stream, IOCALL_PROFILE_SET_FREQUENCY, &frequency_args) != SUCCESS)
+    {
+        stream_format(err_stream, "profile: Invalid frequency %d\n", option_frequency);
+        return PROCESS_FAILURE;
+    }
+
+    ProfileData data = {};
+
+    Result result = profile_run(stream, data, argc, argv);
+
+    if (result != SUCCESS)
+    {
+        stream_format(err_stream, "profile: %s\n", get_result_description(result));
+        return PROCESS_FAILURE;
+    }
+
+    HashMap<String, int> stacks{};
+    int dropped = 0;
+
+    size_t offset = 0;
+
+    while (offset + sizeof(ProfileTask) <= data.size)
+    {
+        ProfileTask &task = *reinterpret_cast<ProfileTask *>(data.buffer + offset);
+        offset += sizeof(ProfileTask);
+
+        dropped += task.dropped;
+
+        for (int i = 0; i < task.samples && offset + sizeof(ProfileSample) <= data.size; i++)
+        {
+            ProfileSample &sample = *reinterpret_cast<ProfileSample *>(data.buffer + offset);
+            offset += sizeof(ProfileSample);
+
+            String stack = profile_fold(task, sample);
+
+            if (stacks.has_key(stack))
+            {
+                stacks[stack]++;
+            }
+            else
+            {
+                stacks[stack] = 1;
+            }
+        }
+    }
+
+    stacks.foreach ([](auto &stack, auto &count) {
+        printf("%s %d\n", stack.cstring(), count);
+        return Iteration::CONTINUE;
+    });
+
+    if (dropped > 0)
+    {
+        stream_format(err_stream, "profile: %d samples dropped, try a lower frequency\n", dropped);
+    }
+
+    free(data.buffer);
+
+    return PROCESS_SUCCESS;
+}
@@ -0,0 +1,279 @@
+#include <abi/Syscalls.h>
+#include <abi/Trace.h>
+
+#include <libsystem/cmdline/CMDLine.h>
+#include <libsystem/io/Stream.h>
+
+#define TRACE_READ_COUNT 128
+
+static bool option_json = false;
+static int option_count = 0;
+
+static const char *usages[] = {
+    "",
+    "OPTION...",
+    nullptr,
+};
+
+static CommandLineOption options[] = {
+    COMMANDLINE_OPT_HELP,
+
+    COMMANDLINE_OPT_BOOL("json", 'j', option_json, "Output Chrome trace event JSON (chrome://tracing, Perfetto).", COMMANDLINE_NO_CALLBACK),
+    COMMANDLINE_OPT_INT("count", 'c', option_count, "Stop after COUNT events.", COMMANDLINE_NO_CALLBACK),
+
+    COMMANDLINE_OPT_END};
+
+static CommandLine cmdline = CMDLINE(
+    usages,
+    options,
+    "Stream the kernel trace events from " TRACE_DEVICE_PATH ".",
+    "Tracing is only active while this command is running.");
+
+#define SYSCALL_NAMES_ENTRY(__entry) #__entry,
+static const char *syscall_names[] = {SYSCALL_LIST(SYSCALL_NAMES_ENTRY)};
+
+static const char *syscall_name(uint32_t syscall)
+{
+    if (syscall < __SYSCALL_COUNT)
+    {
+        return syscall_names[syscall];
+    }
+
+    return "UNKNOWN_SYSCALL";
+}
+
+// Ticks are milliseconds and cycles come from the TSC. The TSC frequency isn't
+// known, so it is calibrated against the tick boundaries seen in the stream.
+struct TraceClock
+{
+    bool has_anchor;
+    uint32_t anchor_tick;
+    uint64_t anchor_cycles;
+
+    bool has_base;
+    uint32_t base_tick;
+    uint64_t base_cycles;
+
+    uint64_t cycles_per_microsecond;
+};
+
+// Ticks overflow 32 bits of microseconds after 71 minutes.
+static uint64_t trace_clock_microseconds(TraceClock &clock, TraceEvent &event)
+{
+    if (event.type == TRACE_LOST)
+    {
+        return (uint64_t)event.tick * 1000;
+    }
+
+    if (!clock.has_anchor || event.tick != clock.anchor_tick)
+    {
+        if (clock.has_anchor && !clock.has_base)
+        {
+            clock.has_base = true;
+            clock.base_tick = clock.anchor_tick;
+            clock.base_cycles = clock.anchor_cycles;
+        }
+
+        clock.has_anchor = true;
+        clock.anchor_tick = event.tick;
+        clock.anchor_cycles = event.cycles;
+
+        if (clock.has_base && clock.anchor_tick > clock.base_tick)
+        {
+            clock.cycles_per_microsecond = (clock.anchor_cycles - clock.base_cycles) /
+                                           ((uint64_t)(clock.anchor_tick - clock.base_tick) * 1000);
+        }
+    }
+
+    uint32_t sub_tick = 0;
+
+    if (clock.cycles_per_microsecond > 0)
+    {
+        sub_tick = (event.cycles - clock.anchor_cycles) / clock.cycles_per_microsecond;
+
+        if (sub_tick > 999)
+        {
+            sub_tick = 999;
+        }
+    }
+
+    return (uint64_t)event.tick * 1000 + sub_tick;
+}
+
+static void trace_print_text(TraceEvent &event, uint64_t microseconds)
+{
+    printf("%6u.%03u cpu%d %4d %-16s ",
+           (uint32_t)(microseconds / 1000),
+           (uint32_t)(microseconds % 1000),
+           event.cpu,
+           event.task,
+           trace_event_string(event.type));
+
+    auto &arguments = event.arguments;
+
+    switch (event.type)
+    {
+    case TRACE_LOST:
+        printf("%u events lost", arguments[0]);
+        break;
+
+    case TRACE_SYSCALL_ENTER:
+        printf("%s(%08x, %08x)", syscall_name(arguments[0]), arguments[1], arguments[2]);
+        break;
+
+    case TRACE_SYSCALL_EXIT:
+        printf("%s -> %s", syscall_name(arguments[0]), result_to_string((Result)arguments[1]));
+        break;
+
+    case TRACE_CONTEXT_SWITCH:
+        printf("%d -> %d", arguments[0], arguments[1]);
+        break;
+
+    case TRACE_IRQ:
+        printf("irq%d", arguments[0]);
+        break;
+
+    case TRACE_PAGE_FAULT:
+        printf("address=%08x ip=%08x error=%x", arguments[0], arguments[1], arguments[2]);
+        break;
+
+    case TRACE_IO_READ:
+    case TRACE_IO_WRITE:
+        printf("type=%d size=%u done=%u", arguments[0], arguments[1], arguments[2]);
+        break;
+
+    case TRACE_NETWORK_RECEIVE:
+    case TRACE_NETWORK_SEND:
+        printf("size=%u", arguments[0]);
+        break;
+
+    default:
+        printf("%08x %08x %08x", arguments[0], arguments[1], arguments[2]);
+        break;
+    }
+
+    printf("\n");
+}
+
+static void trace_print_json(TraceEvent &event, uint64_t microseconds, bool first)
+{
+    if (!first)
+    {
+        printf(",\n");
+    }
+
+    auto &arguments = event.arguments;
+
+    switch (event.type)
+    {
+    case TRACE_SYSCALL_ENTER:
+        printf("{\"name\":\"%s\",\"cat\":\"syscall\",\"ph\":\"B\"", syscall_name(arguments[0]));
+        printf(",\"args\":{\"arg0\":\"%08x\",\"arg1\":\"%08x\"}", arguments[1], arguments[2]);
+        break;
+
+    case TRACE_SYSCALL_EXIT:
+        printf("{\"name\":\"%s\",\"cat\":\"syscall\",\"ph\":\"E\"", syscall_name(arguments[0]));
+        printf(",\"args\":{\"result\":\"%s\"}", result_to_string((Result)arguments[1]));
+        break;
+
+    case TRACE_CONTEXT_SWITCH:
+        printf("{\"name\":\"%s\",\"cat\":\"sched\",\"ph\":\"i\",\"s\":\"t\"", trace_event_string(event.type));
+        printf(",\"args\":{\"previous\":%d,\"next\":%d}", arguments[0], arguments[1]);
+        break;
+
+    case TRACE_LOST:
+        printf("{\"name\":\"%s\",\"cat\":\"trace\",\"ph\":\"i\",\"s\":\"g\"", trace_event_string(event.type));
+        printf(",\"args\":{\"count\":%u}", arguments[0]);
+        break;
+
+    default:
+        printf("{\"name\":\"%s\",\"cat\":\"kernel\",\"ph\":\"i\",\"s\":\"t\"", trace_event_string(event.type));
+        printf(",\"args\":{\"arg0\":%u,\"arg1\":%u,\"arg2\":%u}", arguments[0], arguments[1], arguments[2]);
+        break;
+    }
+
+    // printf() has no 64 bits conversions, the milliseconds and the
+    // microseconds are printed one after the other.
+    uint32_t milliseconds = microseconds / 1000;
+
+    if (milliseconds > 0)
+    {
+        printf(",\"ts\":%u%03u", milliseconds, (uint32_t)(microseconds % 1000));
+    }
+    else
+    {
+        printf(",\"ts\":%u", (uint32_t)microseconds);
+    }
+
+    printf(",\"pid\":%d,\"tid\":%d}",
+           event.task < 0 ? 0 : event.task,
+           event.task < 0 ? 0 : event.task);
+}
+
+int main(int argc, char **argv)
+{
+    argc = cmdline_parse(&cmdline, argc, argv);
+
+    Stream *stream = stream_open(TRACE_DEVICE_PATH, OPEN_READ);
+
+    if (handle_has_error(stream))
+    {
+        handle_printf_error(stream, "trace: Couldn't open " TRACE_DEVICE_PATH);
+        stream_close(stream);
+        return PROCESS_FAILURE;
+    }
+
+    stream_set_read_buffer_mode(stream, STREAM_BUFFERED_NONE);
+
+    if (option_json)
+    {
+        printf("[\n");
+    }
+
+    TraceClock clock = {};
+    TraceEvent events[TRACE_READ_COUNT];
+
+    int printed = 0;
+    size_t read = 0;
+
+    while ((option_count <= 0 || printed < option_count) &&
+           (read = stream_read(stream, events, sizeof(events))) > 0)
+    {
+        for (size_t i = 0; i < read / sizeof(TraceEvent); i++)
+        {
+            if (option_count > 0 && printed >= option_count)
+            {
+                break;
+            }
+
+            uint64_t microseconds = trace_clock_microseconds(clock, events[i]);
+
+            if (option_json)
+            {
+                trace_print_json(events[i], microseconds, printed == 0);
+            }
+            else
+            {
+                trace_print_text(events[i], microseconds);
+            }
+
+            printed++;
+        }
+
+        if (handle_has_error(out_stream))
+        {
+            handle_printf_error(out_stream, "trace: Couldn't write to stdout");
+            stream_close(stream);
+            return PROCESS_FAILURE;
+        }
+    }
+
+    if (option_json)
+    {
+        printf("\n]\n");
+    }
+
+    stream_close(stream);
+
+    return PROCESS_SUCCESS;
+}
@@ -127,13 +127,20 @@ Variant Listing::data(int row, int column)
 
 void Listing::update()
 {
-    _files.clear();
+    String current = _navigation->current().string();
 
-    auto directory = directory_open(_navigation->current().string().cstring(), OPEN_READ);
+    // Refreshing the same directory only reports the rows that changed.
+    bool refresh = _files_path == current;
+
+    Vector<FileSystemNode> old_files = move(_files);
+    _files_path = current;
+
+    auto directory = directory_open(current.cstring(), OPEN_READ);
 
     if (handle_has_error(directory))
     {
         directory_close(directory);
+        did_update();
         return;
     }
 
@@ -152,7 +159,28 @@ void Listing::update()
 
     directory_close(directory);
 
-    did_update();
+    if (!refresh)
+    {
+        did_update();
+        return;
+    }
+
+    size_t common = MIN(old_files.count(), _files.count());
+
+    for (size_t i = 0; i < common; i++)
+    {
+        if (!(old_files[i].name == _files[i].name) ||
+            old_files[i].type != _files[i].type ||
+            old_files[i].size != _files[i].size)
+        {
+            did_update_rows(i, 1);
+        }
+    }
+
+    did_remove_rows(common, old_files.count() - common);
+    did_insert_rows(common, _files.count() - common);
+
+    did_change();
 }
 
 String Listing::file_name(int index)
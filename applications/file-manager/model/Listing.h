@@ -21,6 +21,7 @@ class Listing : public TableModel
 {
 private:
     RefPtr<Navigation> _navigation;
+    String _files_path{};
     Vector<FileSystemNode> _files{};
     OwnPtr<Observer<Navigation>> _observer;
 
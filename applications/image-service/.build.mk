@@ -0,0 +1,4 @@
+APPS += IMAGE_SERVICE
+
+IMAGE_SERVICE_NAME = image-service
+IMAGE_SERVICE_LIBS = graphic
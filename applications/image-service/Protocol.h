@@ -0,0 +1,44 @@
+#pragma once
+
+#include <abi/Filesystem.h>
+
+#include <libgraphic/Shape.h>
+#include <libsystem/Result.h>
+
+#define IMAGE_SERVICE_SOCKET "/Session/image.ipc"
+#define IMAGE_SERVICE_LOCK "/Session/image.lock"
+
+enum ImageMessageType
+{
+    IMAGE_MESSAGE_INVALID,
+
+    IMAGE_MESSAGE_LOAD,
+    IMAGE_MESSAGE_LOADED,
+};
+
+// The path must be absolute, clients don't share a working directory with
+// the service.
+struct ImageLoad
+{
+    char path[PATH_LENGTH];
+};
+
+// The bitmap is sealed and shared by every client that loaded the same image,
+// they can only include it read-only.
+struct ImageLoaded
+{
+    Result result;
+
+    int bitmap;
+    Vec2i size;
+};
+
+struct ImageMessage
+{
+    ImageMessageType type;
+
+    union {
+        ImageLoad load;
+        ImageLoaded loaded;
+    };
+};
@@ -0,0 +1,269 @@
+#include <libfile/MappedFile.h>
+#include <libgraphic/Bitmap.h>
+#include <libgraphic/PNG.h>
+#include <libsystem/Logger.h>
+#include <libsystem/eventloop/EventLoop.h>
+#include <libsystem/eventloop/Notifier.h>
+#include <libsystem/io/Connection.h>
+#include <libsystem/io/Socket.h>
+#include <libsystem/io/Stream.h>
+#include <libsystem/process/Process.h>
+#include <libsystem/system/Memory.h>
+#include <libutils/HashMap.h>
+#include <libutils/String.h>
+
+#include "image-service/Protocol.h"
+
+// Decoded images are kept within this budget, the least recently used ones
+// are dropped first. Clients keep the bitmaps they already have. An image
+// bigger than the whole budget is refused, the client decodes it itself.
+#define IMAGE_CACHE_BUDGET (64 * 1024 * 1024)
+
+struct CachedImage
+{
+    RefPtr<Bitmap> bitmap;
+    uint32_t generation;
+    size_t bytes;
+    uint32_t last_used;
+};
+
+struct ImageClient
+{
+    Connection *connection;
+    Notifier *notifier;
+};
+
+static HashMap<String, CachedImage> _images{};
+static size_t _cached_bytes = 0;
+static uint32_t _use_counter = 0;
+
+static Result image_file_generation(const char *path, uint32_t *generation)
+{
+    __cleanup(stream_cleanup) Stream *stream = stream_open(path, OPEN_READ);
+
+    if (handle_has_error(stream))
+    {
+        return handle_get_error(stream);
+    }
+
+    FileState state = {};
+    stream_stat(stream, &state);
+
+    if (handle_has_error(stream))
+    {
+        return handle_get_error(stream);
+    }
+
+    *generation = state.generation;
+
+    return SUCCESS;
+}
+
+static void image_cache_make_room(size_t bytes)
+{
+    while (_cached_bytes + bytes > IMAGE_CACHE_BUDGET && _images.count() > 0)
+    {
+        String oldest_key;
+        uint32_t oldest_use = 0;
+        bool found = false;
+
+        _images.foreach([&](auto &key, auto &image) {
+            if (!found || image.last_used < oldest_use)
+            {
+                oldest_key = key;
+                oldest_use = image.last_used;
+                found = true;
+            }
+
+            return Iteration::CONTINUE;
+        });
+
+        logger_info("Dropping %s from the image cache", oldest_key.cstring());
+
+        _cached_bytes -= _images[oldest_key].bytes;
+        _images.remove_key(oldest_key);
+    }
+}
+
+static ResultOr<RefPtr<Bitmap>> image_load(const char *path)
+{
+    // The generation changes with every write, so an image rewritten since it
+    // was decoded is decoded again.
+    uint32_t generation = 0;
+    Result result = image_file_generation(path, &generation);
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    String key = path;
+
+    if (_images.has_key(key))
+    {
+        CachedImage &cached = _images[key];
+
+        if (cached.generation == generation)
+        {
+            cached.last_used = ++_use_counter;
+            return cached.bitmap;
+        }
+
+        _cached_bytes -= cached.bytes;
+        _images.remove_key(key);
+    }
+
+    auto file_or_result = MappedFile::open(path);
+
+    if (!file_or_result.success())
+    {
+        return file_or_result.result();
+    }
+
+    auto file = file_or_result.take_value();
+
+    PNGDecoder decoder{file->start(), file->size()};
+
+    result = decoder.read_header();
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    // Checked before anything is allocated, the service has to stay within
+    // its budget or it gets killed.
+    size_t bytes = (size_t)decoder.width() * decoder.height() * sizeof(Color);
+
+    if (bytes > IMAGE_CACHE_BUDGET)
+    {
+        return ERR_OUT_OF_MEMORY;
+    }
+
+    image_cache_make_room(bytes);
+
+    auto bitmap_or_result = Bitmap::decode_from(decoder);
+
+    if (!bitmap_or_result.success())
+    {
+        return bitmap_or_result.result();
+    }
+
+    auto bitmap = bitmap_or_result.take_value();
+
+    // From now on clients can only include the pixels read-only.
+    result = memory_seal(reinterpret_cast<uintptr_t>(bitmap->pixels()));
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    _images[key] = {bitmap, generation, bytes, ++_use_counter};
+    _cached_bytes += bytes;
+
+    return bitmap;
+}
+
+static void image_client_destroy(ImageClient *client)
+{
+    notifier_destroy(client->notifier);
+    connection_close(client->connection);
+    delete client;
+}
+
+static void image_client_request_callback(ImageClient *client, Connection *connection, PollEvent events)
+{
+    __unused(events);
+
+    ImageMessage request = {};
+    size_t request_size = connection_receive(connection, &request, sizeof(ImageMessage));
+
+    if (handle_has_error(connection) ||
+        request_size != sizeof(ImageMessage) ||
+        request.type != IMAGE_MESSAGE_LOAD)
+    {
+        image_client_destroy(client);
+        return;
+    }
+
+    request.load.path[PATH_LENGTH - 1] = '\0';
+
+    ImageMessage reply = {};
+    reply.type = IMAGE_MESSAGE_LOADED;
+
+    auto bitmap_or_result = image_load(request.load.path);
+
+    if (bitmap_or_result.success())
+    {
+        auto bitmap = bitmap_or_result.take_value();
+
+        reply.loaded.result = SUCCESS;
+        reply.loaded.bitmap = bitmap->handle();
+        reply.loaded.size = bitmap->size();
+    }
+    else
+    {
+        reply.loaded.result = bitmap_or_result.result();
+    }
+
+    connection_send(connection, &reply, sizeof(ImageMessage));
+
+    if (handle_has_error(connection))
+    {
+        image_client_destroy(client);
+    }
+}
+
+static void accept_callback(void *target, Socket *socket, PollEvent events)
+{
+    __unused(target);
+    __unused(events);
+
+    auto client = new ImageClient();
+
+    client->connection = socket_accept(socket);
+    client->notifier = notifier_create(
+        client,
+        HANDLE(client->connection),
+        POLL_READ,
+        (NotifierCallback)image_client_request_callback);
+}
+
+static bool acquire_lock()
+{
+    Stream *lock_stream = stream_open(IMAGE_SERVICE_LOCK, OPEN_READ);
+
+    if (!handle_has_error(lock_stream))
+    {
+        stream_close(lock_stream);
+        return false;
+    }
+
+    stream_close(lock_stream);
+
+    lock_stream = stream_open(IMAGE_SERVICE_LOCK, OPEN_READ | OPEN_CREATE);
+    stream_close(lock_stream);
+
+    return true;
+}
+
+int main(int argc, char const *argv[])
+{
+    __unused(argc);
+    __unused(argv);
+
+    if (!acquire_lock())
+    {
+        stream_format(err_stream, "The image service is already running.\n");
+        return PROCESS_FAILURE;
+    }
+
+    eventloop_initialize();
+
+    Socket *socket = socket_open(IMAGE_SERVICE_SOCKET, OPEN_CREATE);
+
+    notifier_create(nullptr, HANDLE(socket), POLL_ACCEPT, (NotifierCallback)accept_callback);
+
+    return eventloop_run();
+}
@@ -1,5 +1,6 @@
 #include "task-manager/TaskModel.h"
 #include <libsystem/process/Process.h>
+#include <libutils/HashMap.h>
 
 enum Column
 {
@@ -83,10 +84,69 @@ Variant TaskModel::data(int row, int column)
     }
 }
 
+static uint32_t task_id(const json::Value &task)
+{
+    return task.get("id").as_integer();
+}
+
+static bool task_has_same_content(const json::Value &left, const json::Value &right)
+{
+    return left.get("user").is(json::TRUE) == right.get("user").is(json::TRUE) &&
+           left.get("name").as_string() == right.get("name").as_string() &&
+           left.get("state").as_string() == right.get("state").as_string() &&
+           left.get("cpu").as_integer() == right.get("cpu").as_integer() &&
+           left.get("ram").as_integer() == right.get("ram").as_integer();
+}
+
 void TaskModel::update()
 {
-    _data = json::parse_file("/System/processes");
-    did_update();
+    auto data = json::parse_file("/System/processes");
+
+    // Task ids come from reused slots and aren't listed in any order, rows are
+    // matched by id instead. The tasks that kept their order relative to each
+    // other are updated in place, the others are removed and inserted again.
+    HashMap<uint32_t, size_t> new_rows{};
+    Vector<int> old_rows(data.length());
+
+    for (size_t i = 0; i < data.length(); i++)
+    {
+        new_rows[task_id(data.get(i))] = i;
+        old_rows.push_back(-1);
+    }
+
+    int row = 0;
+    int previous = -1;
+
+    for (size_t i = 0; i < _data.length(); i++)
+    {
+        uint32_t id = task_id(_data.get(i));
+
+        if (new_rows.has_key(id) && (int)new_rows[id] > previous)
+        {
+            previous = new_rows[id];
+            old_rows[previous] = i;
+            row++;
+        }
+        else
+        {
+            did_remove_rows(row, 1);
+        }
+    }
+
+    for (size_t i = 0; i < data.length(); i++)
+    {
+        if (old_rows[i] == -1)
+        {
+            did_insert_rows(i, 1);
+        }
+        else if (!task_has_same_content(_data.get(old_rows[i]), data.get(i)))
+        {
+            did_update_rows(i, 1);
+        }
+    }
+
+    _data = move(data);
+    did_change();
 }
 
 static String greedy(json::Value &data, const char *field)
@@ -125,5 +185,11 @@ String TaskModel::cpu_greedy()
 
 void TaskModel::kill_task(int row)
 {
+    // Nothing is selected, or the task exited and its row is gone.
+    if (row < 0 || row >= rows())
+    {
+        return;
+    }
+
     process_cancel(data(row, COLUMN_ID).as_int());
 }
@@ -1,6 +1,7 @@
 #include <libgraphic/Painter.h>
 #include <libsystem/Logger.h>
 #include <libsystem/process/Launchpad.h>
+#include <libsystem/system/System.h>
 #include <libwidget/Event.h>
 #include <libwidget/Window.h>
 
@@ -8,6 +9,8 @@
 #include "terminal/TerminalWidget.h"
 
 #define TERMINAL_IO_BUFFER_SIZE 4096
+#define TERMINAL_SCROLLBACK 1000
+#define TERMINAL_REPAINT_INTERVAL (1000 / 60)
 
 void terminal_widget_server_callback(TerminalWidget *widget, Stream *server, PollEvent events)
 {
@@ -23,12 +26,12 @@ void terminal_widget_server_callback(TerminalWidget *widget, Stream *server, Pol
     }
 
     widget->terminal()->write(buffer, size);
-    widget->should_repaint();
+    widget->should_repaint_output();
 }
 
 TerminalWidget::TerminalWidget(Widget *parent) : Widget(parent)
 {
-    _terminal = new terminal::Terminal(80, 24);
+    _terminal = new terminal::Terminal(80, 24, TERMINAL_SCROLLBACK);
 
     stream_create_term(
         &_server_stream,
@@ -44,13 +47,25 @@ TerminalWidget::TerminalWidget(Widget *parent) : Widget(parent)
         blink();
 
         int cx = terminal()->cursor().x;
-        int cy = terminal()->cursor().y;
+        int cy = terminal()->cursor().y + _history_offset;
 
         should_repaint(cell_bound(cx, cy).offset(bound().position()));
     });
 
     _cursor_blink_timer->start();
 
+    _repaint_timer = own<Timer>(TERMINAL_REPAINT_INTERVAL, [this]() {
+        if (_output_pending)
+        {
+            _output_pending = false;
+            should_repaint_damaged_lines();
+        }
+        else
+        {
+            _repaint_timer->stop();
+        }
+    });
+
     Launchpad *shell_launchpad = launchpad_create("shell", "/Applications/shell/shell");
     launchpad_handle(shell_launchpad, HANDLE(_client_stream), 0);
     launchpad_handle(shell_launchpad, HANDLE(_client_stream), 1);
@@ -68,6 +83,95 @@ TerminalWidget::~TerminalWidget()
     stream_close(_client_stream);
 }
 
+// Lines scrolled since the last call are moved in the window buffer, only
+// the lines which changed and the cursor are repainted.
+void TerminalWidget::should_repaint_damaged_lines()
+{
+    terminal::Terminal *terminal = _terminal;
+
+    int scrolled = terminal->scrolled();
+
+    if (_history_offset != 0 || scrolled >= terminal->height())
+    {
+        _history_offset = 0;
+        should_repaint();
+    }
+    else
+    {
+        Rectangle lines_bound = Rectangle(
+                                    terminal->width() * cell_size().x(),
+                                    terminal->height() * cell_size().y())
+                                    .offset(bound().position());
+
+        if (scrolled > 0)
+        {
+            window()->should_scroll(lines_bound, -scrolled * cell_size().y());
+        }
+
+        if (_painted_cursor.y() - scrolled >= 0)
+        {
+            should_repaint(cell_bound(_painted_cursor.x(), _painted_cursor.y() - scrolled).offset(bound().position()));
+        }
+
+        int dirty_from = -1;
+
+        for (int y = 0; y <= terminal->height(); y++)
+        {
+            bool dirty = y < terminal->height() && terminal->line_dirty(y);
+
+            if (dirty && dirty_from == -1)
+            {
+                dirty_from = y;
+            }
+            else if (!dirty && dirty_from != -1)
+            {
+                should_repaint(Rectangle(
+                                   lines_bound.x(),
+                                   lines_bound.y() + dirty_from * cell_size().y(),
+                                   lines_bound.width(),
+                                   (y - dirty_from) * cell_size().y()));
+
+                dirty_from = -1;
+            }
+        }
+
+        int cx = terminal->cursor().x;
+        int cy = terminal->cursor().y;
+
+        should_repaint(cell_bound(cx, cy).offset(bound().position()));
+    }
+
+    terminal->undirty();
+}
+
+// The first output is repainted right away, what follows while the timer
+// runs is coalesced into one repaint per frame.
+void TerminalWidget::should_repaint_output()
+{
+    if (_repaint_timer->running())
+    {
+        _output_pending = true;
+    }
+    else
+    {
+        should_repaint_damaged_lines();
+
+        _repaint_timer->schedule(system_get_ticks() + TERMINAL_REPAINT_INTERVAL);
+        _repaint_timer->start();
+    }
+}
+
+void TerminalWidget::scroll_history(int lines)
+{
+    int offset = clamp(_history_offset + lines, 0, _terminal->history());
+
+    if (offset != _history_offset)
+    {
+        _history_offset = offset;
+        should_repaint();
+    }
+}
+
 void TerminalWidget::paint(Painter &painter, Rectangle rectangle)
 {
     painter.clear_rectangle(rectangle, color(THEME_ANSI_BACKGROUND));
@@ -81,20 +185,28 @@ void TerminalWidget::paint(Painter &painter, Rectangle rectangle)
 
     for (int y = 0; y < terminal->height(); y++)
     {
+        Rectangle line_bound = cell_bound(0, y).with_width(terminal->width() * cell_size().x());
+
+        if (!line_bound.colide_with(rectangle))
+        {
+            continue;
+        }
+
         for (int x = 0; x < terminal->width(); x++)
         {
-            terminal::Cell cell = terminal->cell_at(x, y);
+            terminal::Cell cell = terminal->cell_at(x, y - _history_offset);
             render_cell(painter, x, y, cell);
-            terminal->cell_undirty(x, y);
         }
     }
 
     int cx = terminal->cursor().x;
-    int cy = terminal->cursor().y;
+    int cy = terminal->cursor().y + _history_offset;
 
-    if (cell_bound(cx, cy).colide_with(rectangle))
+    if (cy < terminal->height() && cell_bound(cx, cy).colide_with(rectangle))
     {
-        terminal::Cell cell = terminal->cell_at(cx, cy);
+        terminal::Cell cell = terminal->cell_at(cx, cy - _history_offset);
+
+        _painted_cursor = Vec2i(cx, cy);
 
         if (window()->focused())
         {
@@ -200,11 +312,27 @@ void TerminalWidget::event(Event *event)
             break;
 
         case KEYBOARD_KEY_PGUP:
-            send_sequence("\e[5~");
+            if (event->keyboard.modifiers & KEY_MODIFIER_SHIFT)
+            {
+                scroll_history(_terminal->height() / 2);
+                event->accepted = true;
+            }
+            else
+            {
+                send_sequence("\e[5~");
+            }
             break;
 
         case KEYBOARD_KEY_PGDOWN:
-            send_sequence("\e[6~");
+            if (event->keyboard.modifiers & KEY_MODIFIER_SHIFT)
+            {
+                scroll_history(-_terminal->height() / 2);
+                event->accepted = true;
+            }
+            else
+            {
+                send_sequence("\e[6~");
+            }
             break;
 
         case KEYBOARD_KEY_UP:
@@ -13,10 +13,16 @@ private:
     terminal::Terminal *_terminal;
     bool _cursor_blink;
 
+    // How many lines of history are shown above the screen.
+    int _history_offset = 0;
+    Vec2i _painted_cursor{};
+
     Stream *_server_stream;
     Stream *_client_stream;
 
     OwnPtr<Timer> _cursor_blink_timer;
+    OwnPtr<Timer> _repaint_timer;
+    bool _output_pending = false;
     Notifier *_server_notifier;
 
 public:
@@ -28,6 +34,12 @@ public:
 
     ~TerminalWidget();
 
+    void should_repaint_damaged_lines();
+
+    void should_repaint_output();
+
+    void scroll_history(int lines);
+
     void paint(Painter &painter, Rectangle rectangle);
 
     void event(Event *event);
@@ -3,6 +3,7 @@
 #include <libsystem/Time.h>
 
 struct Task;
+struct VDSO;
 
 void arch_disable_interrupts();
 
@@ -16,10 +17,16 @@ void arch_save_context(Task *task);
 
 void arch_load_context(Task *task);
 
+void arch_set_tls(uintptr_t base);
+
+void arch_vdso_initialize(VDSO *vdso);
+
 size_t arch_debug_write(const void *buffer, size_t size);
 
 TimeStamp arch_get_time();
 
+uint64_t arch_get_cycles();
+
 __no_return void arch_reboot();
 
 __no_return void arch_shutdown();
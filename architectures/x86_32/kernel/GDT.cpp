@@ -45,6 +45,7 @@ void gdt_initialize()
     gdt[3] = {0, 0xffffffff, GDT_PRESENT | GDT_READWRITE | GDT_USER | GDT_EXECUTABLE, GDT_FLAGS};
     gdt[4] = {0, 0xffffffff, GDT_PRESENT | GDT_READWRITE | GDT_USER, GDT_FLAGS};
     gdt[5] = {&tss, GDT_TSS_PRESENT | GDT_ACCESSED | GDT_EXECUTABLE | GDT_USER, TSS_FLAGS};
+    gdt[GDT_TLS_ENTRY] = {0, 0xffffffff, GDT_PRESENT | GDT_READWRITE | GDT_USER, GDT_FLAGS};
 
     gdt_flush((uint32_t)&gdt_descriptor);
 }
@@ -53,3 +54,11 @@ void set_kernel_stack(uint32_t stack)
 {
     tss.esp0 = stack;
 }
+
+// The user %gs segment, its base is the thread local storage of the running
+// thread. The descriptor is reloaded when %gs is popped on the way back to
+// userspace.
+void gdt_set_tls(uint32_t base)
+{
+    gdt[GDT_TLS_ENTRY] = {base, 0xffffffff, GDT_PRESENT | GDT_READWRITE | GDT_USER, GDT_FLAGS};
+}
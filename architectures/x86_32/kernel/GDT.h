@@ -3,7 +3,9 @@
 #include <libsystem/Common.h>
 #include <libsystem/Logger.h>
 
-#define GDT_ENTRY_COUNT 6
+#define GDT_ENTRY_COUNT 7
+
+#define GDT_TLS_ENTRY 6
 
 #define GDT_PRESENT 0b10010000     // Present bit. This must be 1 for all valid selectors.
 #define GDT_TSS_PRESENT 0b10000000 // Present bit. This must be 1 for all valid selectors.
@@ -104,3 +106,5 @@ extern "C" void gdt_flush(uint32_t);
 extern "C" void tss_flush(uint32_t);
 
 void set_kernel_stack(uint32_t stack);
+
+void gdt_set_tls(uint32_t base);
@@ -11,6 +11,9 @@
 #include "kernel/scheduling/Scheduler.h"
 #include "kernel/system/System.h"
 #include "kernel/tasking/Syscalls.h"
+#include "kernel/tasking/Task-Memory.h"
+#include "kernel/tracing/Profiler.h"
+#include "kernel/tracing/Trace.h"
 
 static const char *_exception_messages[32] = {
     "Division by zero",
@@ -47,11 +50,62 @@ static const char *_exception_messages[32] = {
     "Reserved",
 };
 
+static void interrupts_profile(InterruptStackFrame &stackframe)
+{
+    Task *task = scheduler_running();
+
+    ProfilerFrame kernel = {};
+    ProfilerFrame user = {};
+
+    if ((stackframe.cs & 3) == 3)
+    {
+        user = {stackframe.eip, stackframe.ebp};
+    }
+    else
+    {
+        kernel = {stackframe.eip, stackframe.ebp};
+
+        if (task->user)
+        {
+            // The frame pushed when the task entered the kernel sits at the top of its kernel stack.
+            auto usf = reinterpret_cast<UserInterruptStackFrame *>(
+                (uintptr_t)task->kernel_stack + PROCESS_STACK_SIZE - sizeof(UserInterruptStackFrame));
+
+            user = {usf->eip, usf->ebp};
+        }
+    }
+
+    profiler_sample(task, kernel, user);
+}
+
+#define PAGE_FAULT_PRESENT (1 << 0)
+#define PAGE_FAULT_WRITE (1 << 1)
+
+// A write to a page shared with a cloned task, the task gets its own copy and
+// the faulting instruction is restarted.
+static bool interrupts_handle_copy_on_write(InterruptStackFrame &stackframe)
+{
+    return stackframe.intno == 14 &&
+           (stackframe.err & PAGE_FAULT_PRESENT) &&
+           (stackframe.err & PAGE_FAULT_WRITE) &&
+           CR2() >= 0x40000000 &&
+           task_memory_handle_page_fault(scheduler_running(), CR2());
+}
+
 extern "C" uint32_t interrupts_handler(uintptr_t esp, InterruptStackFrame stackframe)
 {
     if (stackframe.intno < 32)
     {
-        if (stackframe.eip >= 0x40000000)
+        if (stackframe.intno == 14)
+        {
+            TRACE(PAGE_FAULT, CR2(), stackframe.eip, stackframe.err);
+        }
+
+        if (interrupts_handle_copy_on_write(stackframe))
+        {
+            // Nothing else to do.
+        }
+        else if (stackframe.eip >= 0x40000000)
         {
             sti();
 
@@ -85,9 +139,17 @@ extern "C" uint32_t interrupts_handler(uintptr_t esp, InterruptStackFrame stackf
 
         int irq = stackframe.intno - 32;
 
+        TRACE(IRQ, irq);
+
         if (irq == 0)
         {
             system_tick();
+
+            if (profiler_should_sample())
+            {
+                interrupts_profile(stackframe);
+            }
+
             esp = schedule(esp);
         }
         else
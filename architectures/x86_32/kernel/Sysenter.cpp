@@ -0,0 +1,63 @@
+#include <libsystem/Assert.h>
+#include <libsystem/Logger.h>
+#include <libsystem/core/CString.h>
+
+#include "architectures/x86/kernel/CPUID.h"
+#include "architectures/x86_32/kernel/Sysenter.h"
+#include "architectures/x86_32/kernel/x86_32.h"
+
+#define MSR_SYSENTER_CS 0x174
+#define MSR_SYSENTER_ESP 0x175
+#define MSR_SYSENTER_EIP 0x176
+
+extern "C" void __sysenter_entry();
+
+extern "C" uint8_t __vdso_code_start[];
+extern "C" uint8_t __vdso_code_end[];
+extern "C" uint8_t __vdso_int80[];
+extern "C" uint8_t __vdso_sysenter[];
+extern "C" uint8_t __vdso_sysenter_return[];
+
+extern "C" uint32_t sysenter_return_address;
+uint32_t sysenter_return_address = 0;
+
+static bool _sysenter_enabled = false;
+
+// Where a symbol of the vDSO code ends up in userspace.
+static uint32_t vdso_symbol(uint8_t *symbol)
+{
+    return VDSO_ADDRESS + __builtin_offsetof(VDSO, code) + (symbol - __vdso_code_start);
+}
+
+void sysenter_initialize(VDSO *vdso)
+{
+    size_t code_size = __vdso_code_end - __vdso_code_start;
+    assert(code_size <= VDSO_CODE_SIZE);
+    memcpy(vdso->code, __vdso_code_start, code_size);
+
+    _sysenter_enabled = cpuid_get_feature_EDX() & CPUID_FEAT_EDX_SEP;
+
+    if (_sysenter_enabled)
+    {
+        sysenter_return_address = vdso_symbol(__vdso_sysenter_return);
+
+        wrmsr(MSR_SYSENTER_CS, 0x08, 0);
+        wrmsr(MSR_SYSENTER_EIP, (uint32_t)__sysenter_entry, 0);
+
+        vdso->syscall_entry = vdso_symbol(__vdso_sysenter);
+    }
+    else
+    {
+        vdso->syscall_entry = vdso_symbol(__vdso_int80);
+    }
+
+    logger_info("System calls are using %s", _sysenter_enabled ? "sysenter" : "int 0x80");
+}
+
+void sysenter_set_kernel_stack(uint32_t stack)
+{
+    if (_sysenter_enabled)
+    {
+        wrmsr(MSR_SYSENTER_ESP, stack, 0);
+    }
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <abi/VDSO.h>
+
+void sysenter_initialize(VDSO *vdso);
+
+void sysenter_set_kernel_stack(uint32_t stack);
@@ -0,0 +1,83 @@
+extern interrupts_handler
+extern sysenter_return_address
+
+; The vDSO stub saved the user stack pointer in ebp, the kernel stack pointer
+; comes from the SYSENTER_ESP msr. The frame is laid out like the one of
+; `int 0x80` so the rest of the kernel doesn't have to know the difference.
+global __sysenter_entry
+__sysenter_entry:
+    push 0x23                           ; ss
+    push ebp                            ; user esp
+    pushfd
+    or dword [esp], 0x200               ; sysenter cleared IF
+    push 0x1b                           ; cs
+    push dword [sysenter_return_address]; eip
+    push 0                              ; errcode
+    push 128                            ; int number
+
+    cld
+
+    pushad
+
+    push ds
+    push es
+    push fs
+    push gs
+
+    mov ax, 0x10
+
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+
+    push esp
+
+    call interrupts_handler
+
+    mov esp, eax
+
+    pop gs
+    pop fs
+    pop es
+    pop ds
+
+    popad
+
+    add esp, 8 ; pop errcode and int number
+
+    mov edx, [esp]      ; eip
+    mov ecx, [esp + 12] ; user esp
+
+    ; Give the task its flags back, sysexit doesn't. Interrupts stay off
+    ; until sysexit, we are still on the kernel stack.
+    and dword [esp + 8], ~0x200
+    add esp, 8          ; pop eip and cs
+    popfd
+
+    sti ; Takes effect after sysexit
+    sysexit
+
+; Copied in the vDSO page, this code must be position independent.
+global __vdso_code_start
+global __vdso_code_end
+global __vdso_int80
+global __vdso_sysenter
+global __vdso_sysenter_return
+
+__vdso_code_start:
+
+__vdso_int80:
+    int 0x80
+    ret
+
+__vdso_sysenter:
+    push ebp
+    mov ebp, esp
+    sysenter
+
+__vdso_sysenter_return:
+    pop ebp
+    ret
+
+__vdso_code_end:
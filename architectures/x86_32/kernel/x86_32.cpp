@@ -12,6 +12,7 @@
 #include "architectures/x86_32/kernel/IDT.h"
 #include "architectures/x86_32/kernel/Interrupts.h"
 #include "architectures/x86_32/kernel/LAPIC.h"
+#include "architectures/x86_32/kernel/Sysenter.h"
 #include "architectures/x86_32/kernel/x86_32.h"
 
 #include "kernel/firmware/SMBIOS.h"
@@ -36,12 +37,26 @@ void arch_load_context(Task *task)
 {
     fpu_load_context(task);
     set_kernel_stack((uintptr_t)task->kernel_stack + PROCESS_STACK_SIZE);
+    sysenter_set_kernel_stack((uintptr_t)task->kernel_stack + PROCESS_STACK_SIZE);
+    gdt_set_tls(task->tls);
+}
+
+void arch_vdso_initialize(VDSO *vdso)
+{
+    sysenter_initialize(vdso);
+}
+
+void arch_set_tls(uintptr_t base)
+{
+    gdt_set_tls(base);
 }
 
 size_t arch_debug_write(const void *buffer, size_t size) { return com_write(COM1, buffer, size); }
 
 TimeStamp arch_get_time() { return rtc_now(); }
 
+uint64_t arch_get_cycles() { return rdtsc(); }
+
 extern "C" void arch_main(void *info, uint32_t magic)
 {
     __plug_init();
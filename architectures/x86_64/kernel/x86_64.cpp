@@ -1,3 +1,5 @@
+#include <abi/VDSO.h>
+
 #include <libsystem/Assert.h>
 #include <libsystem/Logger.h>
 #include <libsystem/core/Plugs.h>
@@ -76,6 +78,20 @@ void arch_load_context(Task *task)
     ASSERT_NOT_REACHED();
 }
 
+void arch_set_tls(uintptr_t base)
+{
+    __unused(base);
+
+    ASSERT_NOT_REACHED();
+}
+
+void arch_vdso_initialize(VDSO *vdso)
+{
+    // This port doesn't run userspace yet and its interrupt handler doesn't
+    // dispatch system calls, so there is no entry point to give out.
+    vdso->syscall_entry = 0;
+}
+
 size_t arch_debug_write(const void *buffer, size_t size)
 {
     return com_write(COM1, buffer, size);
@@ -86,6 +102,11 @@ TimeStamp arch_get_time()
     return rtc_now();
 }
 
+uint64_t arch_get_cycles()
+{
+    return rdtsc();
+}
+
 __no_return void arch_reboot()
 {
     logger_warn("STUB %s", __func__);
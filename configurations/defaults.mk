@@ -18,6 +18,7 @@ CONFIGS = \
 	CONFIG_MEMORY \
 	CONFIG_NAME \
 	CONFIG_OPTIMISATIONS \
+	CONFIG_TRACE \
 	CONFIG_VERSION
 
 CONFIG                ?=develop
@@ -66,6 +67,9 @@ CONFIG_NAME           ?=skift
 # The optimisation level used by the compiler.
 CONFIG_OPTIMISATIONS  ?=-O2
 
+# Enable/disable the kernel tracepoints (see /System/trace).
+CONFIG_TRACE          ?=true
+
 # The version number (usualy year.week).
 CONFIG_VERSION        ?=${shell date +'%y.%W'}
 
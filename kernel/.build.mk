@@ -37,6 +37,10 @@ KERNEL_CXXFLAGS += \
 	-D__KERNEL__ \
 	-DCONFIG_KEYBOARD_LAYOUT=\""${CONFIG_KEYBOARD_LAYOUT}"\"
 
+ifeq ($(CONFIG_TRACE), true)
+KERNEL_CXXFLAGS += -DCONFIG_TRACE
+endif
+
 OBJECTS += $(KERNEL_OBJECTS)
 
 $(BUILD_DIRECTORY)/kernel/%.o: libraries/%.cpp
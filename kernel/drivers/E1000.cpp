@@ -1,7 +1,7 @@
 #include <libsystem/Logger.h>
-#include <libsystem/utils/Hexdump.h>
 
 #include "kernel/drivers/E1000.h"
+#include "kernel/tracing/Trace.h"
 
 void E1000::write_register(uint16_t offset, uint32_t value)
 {
@@ -157,8 +157,6 @@ size_t E1000::receive_packet(void *buffer, size_t size)
 {
     __unused(size);
 
-    logger_trace("rx");
-
     uint32_t packet_size = _rx_descriptors[_current_rx_descriptors].length;
     _rx_buffers[_current_rx_descriptors]->read(0, buffer, packet_size);
     _rx_descriptors[_current_rx_descriptors].status = 0;
@@ -172,8 +170,6 @@ size_t E1000::receive_packet(void *buffer, size_t size)
 
 size_t E1000::send_packet(const void *buffer, size_t size)
 {
-    logger_trace("tx");
-
     _tx_buffers[_current_tx_descriptors]->write(0, buffer, size);
     _tx_descriptors[_current_tx_descriptors].length = size;
     _tx_descriptors[_current_tx_descriptors].command = CMD_EOP | CMD_IFCS | CMD_RS;
@@ -243,8 +239,7 @@ ResultOr<size_t> E1000::read(FsHandle &handle, void *buffer, size_t size)
     __unused(handle);
 
     size_t packet_size = receive_packet(buffer, size);
-    logger_trace("Packet receive (size=%u)", packet_size);
-    hexdump(buffer, packet_size);
+    TRACE(NETWORK_RECEIVE, packet_size);
 
     return packet_size;
 }
@@ -254,8 +249,7 @@ ResultOr<size_t> E1000::write(FsHandle &handle, const void *buffer, size_t size)
     __unused(handle);
 
     size_t packet_size = send_packet(buffer, size);
-    logger_trace("Packet send (size=%u)", packet_size);
-    hexdump(buffer, packet_size);
+    TRACE(NETWORK_SEND, packet_size);
 
     return packet_size;
 }
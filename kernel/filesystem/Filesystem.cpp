@@ -131,7 +131,8 @@ ResultOr<FsHandle *> filesystem_connect(Path path)
     auto connection = connection_or_result.take_value();
     auto connection_handle = new FsHandle(connection, OPEN_CLIENT);
 
-    task_block(scheduler_running(), new BlockerConnect(connection), -1);
+    BlockerConnect blocker{connection};
+    task_block(scheduler_running(), blocker, -1);
 
     return connection_handle;
 }
@@ -95,6 +95,12 @@ void __plug_memalloc_free(void *address, size_t size)
     memory_free(arch_kernel_address_space(), (MemoryRange){(uintptr_t)address, size});
 }
 
+// Allocations are already serialized by retaining interrupts.
+void **__plug_memalloc_thread_cache()
+{
+    return nullptr;
+}
+
 /* --- Logger plugs --------------------------------------------------------- */
 
 void __plug_logger_lock()
@@ -119,6 +125,11 @@ int __plug_process_this()
     return scheduler_running_id();
 }
 
+int __plug_process_clone()
+{
+    ASSERT_NOT_REACHED();
+}
+
 const char *__plug_process_name()
 {
     if (scheduler_running())
@@ -146,6 +157,18 @@ Result __plug_process_wait(int pid, int *exit_value)
     return task_wait(pid, exit_value);
 }
 
+/* --- Threads -------------------------------------------------------------- */
+
+int __plug_thread_this()
+{
+    return scheduler_running_id();
+}
+
+void __plug_thread_yield()
+{
+    scheduler_yield();
+}
+
 /* ---Handles plugs --------------------------------------------------------- */
 
 void __plug_handle_open(Handle *handle, const char *raw_path, OpenFlag flags)
@@ -225,6 +248,54 @@ size_t __plug_handle_write(Handle *handle, const void *buffer, size_t size)
     }
 }
 
+size_t __plug_handle_readv(Handle *handle, const IOVector *vectors, size_t count)
+{
+    assert(handle->id != INTERNAL_LOG_STREAM_HANDLE);
+
+    auto result_or_read = task_fshandle_readv(scheduler_running(), handle->id, vectors, count);
+
+    handle->result = result_or_read.result();
+
+    if (result_or_read.success())
+    {
+        return result_or_read.take_value();
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+size_t __plug_handle_writev(Handle *handle, const IOVector *vectors, size_t count)
+{
+    if (handle->id == INTERNAL_LOG_STREAM_HANDLE)
+    {
+        size_t written = 0;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            written += __plug_handle_write(handle, vectors[i].buffer, vectors[i].size);
+        }
+
+        return written;
+    }
+    else
+    {
+        auto result_or_written = task_fshandle_writev(scheduler_running(), handle->id, vectors, count);
+
+        handle->result = result_or_written.result();
+
+        if (result_or_written.success())
+        {
+            return result_or_written.take_value();
+        }
+        else
+        {
+            return 0;
+        }
+    }
+}
+
 Result __plug_handle_call(Handle *handle, IOCall request, void *args)
 {
     assert(handle->id != INTERNAL_LOG_STREAM_HANDLE);
@@ -268,6 +339,18 @@ int __plug_handle_stat(Handle *handle, FileState *stat)
     return 0;
 }
 
+Result __plug_handle_map(Handle *handle, uintptr_t *address, size_t *size)
+{
+    __unused(address);
+    __unused(size);
+
+    // The kernel can't map files into its own address space, callers fall
+    // back to reading them.
+    handle->result = ERR_OPERATION_NOT_SUPPORTED;
+
+    return handle->result;
+}
+
 // The following functions are stubbed on purpose.
 // The kernel is not supposed to connect to services
 // running in userspace using libsystem.
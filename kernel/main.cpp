@@ -15,10 +15,14 @@
 #include "kernel/graphics/Graphics.h"
 #include "kernel/interrupts/Interupts.h"
 #include "kernel/modules/Modules.h"
+#include "kernel/node/CachesInfo.h"
 #include "kernel/node/DevicesInfo.h"
 #include "kernel/node/ProcessInfo.h"
+#include "kernel/node/Profile.h"
+#include "kernel/node/Trace.h"
 #include "kernel/scheduling/Scheduler.h"
 #include "kernel/system/System.h"
+#include "kernel/system/VDSO.h"
 #include "kernel/tasking/Tasking.h"
 #include "kernel/tasking/Userspace.h"
 
@@ -42,6 +46,7 @@ void system_main(Handover *handover)
 
     system_initialize();
     memory_initialize(handover);
+    vdso_initialize();
     scheduler_initialize();
     tasking_initialize();
     interrupts_initialize();
@@ -51,6 +56,9 @@ void system_main(Handover *handover)
     device_initialize();
     process_info_initialize();
     device_info_initialize();
+    caches_info_initialize();
+    trace_device_initialize();
+    profile_device_initialize();
     devices_filesystem_initialize();
     graphic_initialize(handover);
     userspace_initialize();
@@ -9,6 +9,10 @@ struct MemoryObject
 
     int refcount;
 
+    // A sealed object is only included read-only, its owner can hand out its
+    // handle without letting other tasks write to it.
+    bool sealed;
+
     auto range() { return _range; }
 };
 
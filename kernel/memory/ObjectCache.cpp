@@ -0,0 +1,265 @@
+#include <libsystem/Assert.h>
+#include <libsystem/Logger.h>
+
+#include "architectures/VirtualMemory.h"
+
+#include "kernel/interrupts/Interupts.h"
+#include "kernel/memory/Memory.h"
+#include "kernel/memory/ObjectCache.h"
+
+#define OBJECT_CACHE_ALIGN 16
+
+// Slabs are grown until they hold at least this many objects.
+#define OBJECT_CACHE_MIN_OBJECTS 8
+
+struct ObjectCacheSlab
+{
+    ObjectCache *cache;
+
+    ObjectCacheSlab *prev;
+    ObjectCacheSlab *next;
+
+    void *free_list;
+
+    size_t used;
+    size_t capacity;
+    size_t pages;
+};
+
+// Each object is preceded by the slab it belongs to so object_cache_free()
+// doesn't need to know the cache.
+struct ObjectCacheSlot
+{
+    ObjectCacheSlab *slab;
+};
+
+#define OBJECT_CACHE_SLAB_HEADER_SIZE (__align_up(sizeof(ObjectCacheSlab), OBJECT_CACHE_ALIGN))
+#define OBJECT_CACHE_SLOT_HEADER_SIZE (__align_up(sizeof(ObjectCacheSlot), OBJECT_CACHE_ALIGN))
+
+static ObjectCache *_caches = nullptr;
+
+static size_t object_cache_slot_size(ObjectCache *cache)
+{
+    return OBJECT_CACHE_SLOT_HEADER_SIZE + __align_up(cache->object_size, OBJECT_CACHE_ALIGN);
+}
+
+static void *object_cache_slot_object(ObjectCacheSlot *slot)
+{
+    return (void *)((uintptr_t)slot + OBJECT_CACHE_SLOT_HEADER_SIZE);
+}
+
+static ObjectCacheSlot *object_cache_object_slot(void *object)
+{
+    return (ObjectCacheSlot *)((uintptr_t)object - OBJECT_CACHE_SLOT_HEADER_SIZE);
+}
+
+static ObjectCacheSlot *object_cache_slab_slot(ObjectCacheSlab *slab, size_t index)
+{
+    uintptr_t slots = (uintptr_t)slab + OBJECT_CACHE_SLAB_HEADER_SIZE;
+
+    return (ObjectCacheSlot *)(slots + index * object_cache_slot_size(slab->cache));
+}
+
+static void object_cache_link(ObjectCacheSlab *&head, ObjectCacheSlab *slab)
+{
+    slab->prev = nullptr;
+    slab->next = head;
+
+    if (head)
+    {
+        head->prev = slab;
+    }
+
+    head = slab;
+}
+
+static void object_cache_unlink(ObjectCacheSlab *&head, ObjectCacheSlab *slab)
+{
+    if (slab->prev)
+    {
+        slab->prev->next = slab->next;
+    }
+    else
+    {
+        head = slab->next;
+    }
+
+    if (slab->next)
+    {
+        slab->next->prev = slab->prev;
+    }
+
+    slab->prev = nullptr;
+    slab->next = nullptr;
+}
+
+static ObjectCacheSlab *object_cache_slab_create(ObjectCache *cache)
+{
+    size_t slot_size = object_cache_slot_size(cache);
+    size_t size = PAGE_ALIGN_UP(OBJECT_CACHE_SLAB_HEADER_SIZE + slot_size * OBJECT_CACHE_MIN_OBJECTS);
+
+    uintptr_t address = 0;
+
+    if (memory_alloc(arch_kernel_address_space(), size, MEMORY_CLEAR, &address) != SUCCESS)
+    {
+        logger_error("Failed to grow the %s object cache", cache->name);
+        return nullptr;
+    }
+
+    auto slab = (ObjectCacheSlab *)address;
+
+    slab->cache = cache;
+    slab->prev = nullptr;
+    slab->next = nullptr;
+    slab->free_list = nullptr;
+    slab->used = 0;
+    slab->capacity = (size - OBJECT_CACHE_SLAB_HEADER_SIZE) / slot_size;
+    slab->pages = size / ARCH_PAGE_SIZE;
+
+    // Push the slots in reverse so they are handed out in address order.
+    for (size_t i = slab->capacity; i > 0; i--)
+    {
+        ObjectCacheSlot *slot = object_cache_slab_slot(slab, i - 1);
+        slot->slab = slab;
+
+        void *object = object_cache_slot_object(slot);
+
+        if (cache->constructor)
+        {
+            cache->constructor(object);
+        }
+
+        *(void **)slot = slab->free_list;
+        slab->free_list = slot;
+    }
+
+    if (!cache->registered)
+    {
+        cache->registered = true;
+        cache->next = _caches;
+        _caches = cache;
+    }
+
+    cache->statistics.slabs++;
+    cache->statistics.capacity += slab->capacity;
+
+    return slab;
+}
+
+static void object_cache_slab_destroy(ObjectCacheSlab *slab)
+{
+    ObjectCache *cache = slab->cache;
+
+    if (cache->destructor)
+    {
+        for (size_t i = 0; i < slab->capacity; i++)
+        {
+            cache->destructor(object_cache_slot_object(object_cache_slab_slot(slab, i)));
+        }
+    }
+
+    cache->statistics.slabs--;
+    cache->statistics.capacity -= slab->capacity;
+
+    memory_free(arch_kernel_address_space(), MemoryRange{(uintptr_t)slab, slab->pages * ARCH_PAGE_SIZE});
+}
+
+void *object_cache_alloc(ObjectCache *cache)
+{
+    InterruptsRetainer retainer;
+
+    ObjectCacheSlab *slab = cache->partial;
+
+    if (slab == nullptr)
+    {
+        if (cache->empty)
+        {
+            slab = cache->empty;
+            cache->empty = nullptr;
+        }
+        else
+        {
+            slab = object_cache_slab_create(cache);
+        }
+
+        if (slab == nullptr)
+        {
+            return nullptr;
+        }
+
+        object_cache_link(cache->partial, slab);
+    }
+
+    // The free list link overlays the slot header while the slot is free.
+    ObjectCacheSlot *slot = (ObjectCacheSlot *)slab->free_list;
+    slab->free_list = *(void **)slot;
+    slot->slab = slab;
+
+    slab->used++;
+
+    if (slab->used == slab->capacity)
+    {
+        object_cache_unlink(cache->partial, slab);
+    }
+
+    cache->statistics.used++;
+    cache->statistics.allocations++;
+
+    return object_cache_slot_object(slot);
+}
+
+void object_cache_free(void *object)
+{
+    if (object == nullptr)
+    {
+        return;
+    }
+
+    InterruptsRetainer retainer;
+
+    ObjectCacheSlot *slot = object_cache_object_slot(object);
+    ObjectCacheSlab *slab = slot->slab;
+    ObjectCache *cache = slab->cache;
+
+    assert(slab->used > 0);
+
+    if (slab->used == slab->capacity)
+    {
+        object_cache_link(cache->partial, slab);
+    }
+
+    *(void **)slot = slab->free_list;
+    slab->free_list = slot;
+
+    slab->used--;
+
+    cache->statistics.used--;
+    cache->statistics.frees++;
+
+    if (slab->used == 0)
+    {
+        object_cache_unlink(cache->partial, slab);
+
+        // Keep one empty slab around so a single object bouncing in and out
+        // of the cache doesn't map and unmap pages every time.
+        if (cache->empty)
+        {
+            object_cache_slab_destroy(cache->empty);
+        }
+
+        cache->empty = slab;
+    }
+}
+
+void object_cache_iterate(void *target, ObjectCacheIterateCallback callback)
+{
+    InterruptsRetainer retainer;
+
+    for (ObjectCache *cache = _caches; cache; cache = cache->next)
+    {
+        if (callback(target, cache) == Iteration::STOP)
+        {
+            return;
+        }
+    }
+}
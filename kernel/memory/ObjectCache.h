@@ -0,0 +1,58 @@
+#pragma once
+
+#include <libsystem/Common.h>
+#include <libutils/Iteration.h>
+
+typedef void (*ObjectCacheHook)(void *object);
+
+struct ObjectCacheSlab;
+
+struct ObjectCacheStatistics
+{
+    size_t slabs;
+    size_t capacity;
+    size_t used;
+    size_t allocations;
+    size_t frees;
+};
+
+// A cache of fixed-size objects carved out of page-sized slabs. The
+// constructor hook runs once when a slab is populated and the destructor
+// hook when it is given back, objects keep their constructed state while
+// they sit in the cache.
+struct ObjectCache
+{
+    const char *name;
+    size_t object_size;
+
+    ObjectCacheHook constructor;
+    ObjectCacheHook destructor;
+
+    ObjectCacheSlab *partial;
+    ObjectCacheSlab *empty;
+
+    ObjectCacheStatistics statistics;
+
+    bool registered;
+    ObjectCache *next;
+};
+
+#define OBJECT_CACHE(__type, __constructor, __destructor) \
+    {                                                     \
+        .name = #__type,                                  \
+        .object_size = sizeof(__type),                    \
+        .constructor = __constructor,                     \
+        .destructor = __destructor,                       \
+        .partial = nullptr,                               \
+        .empty = nullptr,                                 \
+        .statistics = {},                                 \
+        .registered = false,                              \
+        .next = nullptr,                                  \
+    }
+
+void *object_cache_alloc(ObjectCache *cache);
+
+void object_cache_free(void *object);
+
+typedef Iteration (*ObjectCacheIterateCallback)(void *target, ObjectCache *cache);
+void object_cache_iterate(void *target, ObjectCacheIterateCallback callback);
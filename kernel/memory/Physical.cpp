@@ -10,6 +10,10 @@ size_t USED_MEMORY = 0;
 size_t best_bet = 0;
 uint8_t MEMORY[1024 * 1024 / 8] = {};
 
+// Pages shared by copy on write mappings, counts the references beyond the
+// first one.
+static uint16_t _page_shares[1024 * 1024] = {};
+
 bool physical_page_is_used(uintptr_t address)
 {
     uintptr_t page = address / ARCH_PAGE_SIZE;
@@ -125,3 +129,38 @@ void physical_set_free(MemoryRange range)
         }
     }
 }
+
+void physical_page_ref(uintptr_t address)
+{
+    ASSERT_INTERRUPTS_RETAINED();
+
+    uintptr_t page = address / ARCH_PAGE_SIZE;
+
+    assert(physical_page_is_used(address));
+    assert(_page_shares[page] < 0xffff);
+
+    _page_shares[page]++;
+}
+
+void physical_page_deref(uintptr_t address)
+{
+    ASSERT_INTERRUPTS_RETAINED();
+
+    uintptr_t page = address / ARCH_PAGE_SIZE;
+
+    if (_page_shares[page] > 0)
+    {
+        _page_shares[page]--;
+    }
+    else
+    {
+        physical_free(MemoryRange{page * ARCH_PAGE_SIZE, ARCH_PAGE_SIZE});
+    }
+}
+
+bool physical_page_is_shared(uintptr_t address)
+{
+    ASSERT_INTERRUPTS_RETAINED();
+
+    return _page_shares[address / ARCH_PAGE_SIZE] > 0;
+}
@@ -17,3 +17,9 @@ bool physical_is_used(MemoryRange range);
 void physical_set_used(MemoryRange range);
 
 void physical_set_free(MemoryRange range);
+
+void physical_page_ref(uintptr_t address);
+
+void physical_page_deref(uintptr_t address);
+
+bool physical_page_is_shared(uintptr_t address);
@@ -13,7 +13,9 @@
 void ramdisk_load(Module *module)
 {
     TARBlock block;
-    for (size_t i = 0; tar_read((void *)module->range.base(), &block, i); i++)
+    size_t offset = 0;
+
+    while (tar_read_next((void *)module->range.base(), module->range.size(), &offset, &block))
     {
         auto file_path = Path::parse(block.name);
 
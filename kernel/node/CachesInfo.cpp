@@ -0,0 +1,68 @@
+#include <libsystem/Result.h>
+#include <libsystem/core/CString.h>
+#include <libsystem/json/Json.h>
+#include <libsystem/math/MinMax.h>
+
+#include "kernel/filesystem/Filesystem.h"
+#include "kernel/memory/ObjectCache.h"
+#include "kernel/node/CachesInfo.h"
+#include "kernel/node/Handle.h"
+
+FsCachesInfo::FsCachesInfo() : FsNode(FILE_TYPE_DEVICE)
+{
+}
+
+static Iteration serialize_cache(json::Array *list, ObjectCache *cache)
+{
+    json::Object cache_object{};
+
+    cache_object["name"] = cache->name;
+    cache_object["size"] = (int)cache->object_size;
+    cache_object["slabs"] = (int)cache->statistics.slabs;
+    cache_object["capacity"] = (int)cache->statistics.capacity;
+    cache_object["used"] = (int)cache->statistics.used;
+    cache_object["allocations"] = (int)cache->statistics.allocations;
+    cache_object["frees"] = (int)cache->statistics.frees;
+
+    list->push_back(move(cache_object));
+
+    return Iteration::CONTINUE;
+}
+
+Result FsCachesInfo::open(FsHandle *handle)
+{
+    json::Array list{};
+
+    object_cache_iterate(&list, (ObjectCacheIterateCallback)serialize_cache);
+
+    Prettifier pretty{};
+    json::prettify(pretty, list);
+
+    handle->attached = pretty.finalize().underlying_storage().give_ref();
+    handle->attached_size = reinterpret_cast<StringStorage *>(handle->attached)->length();
+
+    return SUCCESS;
+}
+
+void FsCachesInfo::close(FsHandle *handle)
+{
+    deref_if_not_null(reinterpret_cast<StringStorage *>(handle->attached));
+}
+
+ResultOr<size_t> FsCachesInfo::read(FsHandle &handle, void *buffer, size_t size)
+{
+    size_t read = 0;
+
+    if (handle.offset() <= handle.attached_size)
+    {
+        read = MIN(handle.attached_size - handle.offset(), size);
+        memcpy(buffer, reinterpret_cast<StringStorage *>(handle.attached)->cstring() + handle.offset(), read);
+    }
+
+    return read;
+}
+
+void caches_info_initialize()
+{
+    filesystem_link(Path::parse("/System/caches"), make<FsCachesInfo>());
+}
@@ -4,25 +4,54 @@
 #include <libsystem/core/CString.h>
 #include <libsystem/math/MinMax.h>
 
+#include "architectures/VirtualMemory.h"
+
+#include "kernel/interrupts/Interupts.h"
+#include "kernel/memory/MemoryObject.h"
 #include "kernel/node/File.h"
 #include "kernel/node/Handle.h"
 
+// Shared by every file, so a file created in place of another one doesn't
+// start over with a generation a cache already knows.
+static uint32_t _generation_counter = 0;
+
 FsFile::FsFile() : FsNode(FILE_TYPE_REGULAR)
 {
     _buffer = (char *)malloc(512);
     _buffer_allocated = 512;
     _buffer_size = 0;
+    _generation = __atomic_add_fetch(&_generation_counter, 1, __ATOMIC_RELAXED);
 }
 
 FsFile::~FsFile()
 {
+    discard_memory_object();
     free(_buffer);
 }
 
+void FsFile::discard_memory_object()
+{
+    // Tasks which already mapped the file keep their reference, and so the
+    // content as it was when they mapped it.
+    if (_memory_object)
+    {
+        memory_object_deref(_memory_object);
+        _memory_object = nullptr;
+    }
+}
+
+void FsFile::did_change()
+{
+    discard_memory_object();
+    _generation = __atomic_add_fetch(&_generation_counter, 1, __ATOMIC_RELAXED);
+}
+
 Result FsFile::open(FsHandle *handle)
 {
     if (handle->has_flag(OPEN_TRUNC))
     {
+        did_change();
+
         free(_buffer);
         _buffer = (char *)malloc(512);
         _buffer_allocated = 512;
@@ -52,6 +81,8 @@ ResultOr<size_t> FsFile::read(FsHandle &handle, void *buffer, size_t size)
 
 ResultOr<size_t> FsFile::write(FsHandle &handle, const void *buffer, size_t size)
 {
+    did_change();
+
     if ((handle.offset() + size) > _buffer_allocated)
     {
         _buffer = (char *)realloc(_buffer, handle.offset() + size);
@@ -63,3 +94,34 @@ ResultOr<size_t> FsFile::write(FsHandle &handle, const void *buffer, size_t size
 
     return size;
 }
+
+ResultOr<MemoryObject *> FsFile::memory_object()
+{
+    if (!_memory_object)
+    {
+        // The node is acquired by the caller, so the content can't change
+        // while it is copied, only the mappings need interrupts held.
+        _memory_object = memory_object_create(MAX(_buffer_size, 1));
+
+        MemoryRange window{};
+
+        {
+            InterruptsRetainer retainer;
+            window = arch_virtual_alloc(arch_kernel_address_space(), _memory_object->range(), MEMORY_NONE);
+        }
+
+        memcpy((void *)window.base(), _buffer, _buffer_size);
+        memset((void *)(window.base() + _buffer_size), 0, window.size() - _buffer_size);
+
+        {
+            InterruptsRetainer retainer;
+            arch_virtual_free(arch_kernel_address_space(), window);
+        }
+
+        // Shared by every task which maps the file, none of them may write
+        // to it.
+        _memory_object->sealed = true;
+    }
+
+    return memory_object_ref(_memory_object);
+}
@@ -9,6 +9,16 @@ private:
     size_t _buffer_allocated;
     size_t _buffer_size;
 
+    // Pages holding a copy of the content, shared by every task which mapped
+    // the file since the last write.
+    MemoryObject *_memory_object = nullptr;
+
+    uint32_t _generation;
+
+    void discard_memory_object();
+
+    void did_change();
+
 public:
     FsFile();
 
@@ -18,7 +28,11 @@ public:
 
     size_t size() override;
 
+    uint32_t generation() override { return _generation; }
+
     ResultOr<size_t> read(FsHandle &handle, void *buffer, size_t size) override;
 
     ResultOr<size_t> write(FsHandle &handle, const void *buffer, size_t size) override;
+
+    ResultOr<MemoryObject *> memory_object() override;
 };
@@ -5,10 +5,26 @@
 #include <libsystem/core/CString.h>
 #include <libsystem/math/MinMax.h>
 
+#include "kernel/memory/ObjectCache.h"
 #include "kernel/node/Connection.h"
 #include "kernel/node/Handle.h"
 #include "kernel/scheduling/Blocker.h"
 #include "kernel/scheduling/Scheduler.h"
+#include "kernel/tracing/Trace.h"
+
+static ObjectCache _handle_cache = OBJECT_CACHE(FsHandle, nullptr, nullptr);
+
+void *FsHandle::operator new(size_t size)
+{
+    assert(size == sizeof(FsHandle));
+
+    return object_cache_alloc(&_handle_cache);
+}
+
+void FsHandle::operator delete(void *object)
+{
+    object_cache_free(object);
+}
 
 FsHandle::FsHandle(RefPtr<FsNode> node, OpenFlag flags)
 {
@@ -91,7 +107,26 @@ PollEvent FsHandle::poll(PollEvent events)
     return selected_events;
 }
 
+static size_t io_vectors_size(const IOVector *vectors, size_t count)
+{
+    size_t size = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        size += vectors[i].size;
+    }
+
+    return size;
+}
+
 ResultOr<size_t> FsHandle::read(void *buffer, size_t size)
+{
+    IOVector vector = {buffer, size};
+
+    return readv(&vector, 1);
+}
+
+ResultOr<size_t> FsHandle::readv(const IOVector *vectors, size_t count)
 {
     if (!has_flag(OPEN_READ) &&
         !has_flag(OPEN_SERVER) &&
@@ -100,21 +135,59 @@ ResultOr<size_t> FsHandle::read(void *buffer, size_t size)
         return ERR_WRITE_ONLY_STREAM;
     }
 
-    task_block(scheduler_running(), new BlockerRead(this), -1);
+    // Nothing to read, don't wait for the node to have something.
+    if (io_vectors_size(vectors, count) == 0)
+    {
+        return 0;
+    }
+
+    BlockerRead blocker{this};
+    task_block(scheduler_running(), blocker, -1);
 
-    auto result_or_read = _node->read(*this, buffer, size);
+    // The node is only acquired once, vectors are filled in turn until one of
+    // them can't be filled completely.
+    size_t read = 0;
+    Result result = SUCCESS;
 
-    if (result_or_read.success())
+    for (size_t i = 0; i < count; i++)
     {
+        auto result_or_read = _node->read(*this, vectors[i].buffer, vectors[i].size);
+
+        TRACE(IO_READ, _node->type(), vectors[i].size, result_or_read.success() ? result_or_read.value() : 0);
+
+        if (!result_or_read.success())
+        {
+            result = result_or_read.result();
+            break;
+        }
+
         _offset += result_or_read.value();
+        read += result_or_read.value();
+
+        if (result_or_read.value() < vectors[i].size)
+        {
+            break;
+        }
     }
 
     _node->release(scheduler_running_id());
 
-    return result_or_read;
+    if (result != SUCCESS && read == 0)
+    {
+        return result;
+    }
+
+    return read;
 }
 
 ResultOr<size_t> FsHandle::write(const void *buffer, size_t size)
+{
+    IOVector vector = {const_cast<void *>(buffer), size};
+
+    return writev(&vector, 1);
+}
+
+ResultOr<size_t> FsHandle::writev(const IOVector *vectors, size_t count)
 {
     if (!has_flag(OPEN_WRITE) &&
         !has_flag(OPEN_SERVER) &&
@@ -123,44 +196,59 @@ ResultOr<size_t> FsHandle::write(const void *buffer, size_t size)
         return ERR_READ_ONLY_STREAM;
     }
 
-    auto attemp_a_write = [&](const void *buffer, size_t size) {
-        task_block(scheduler_running(), new BlockerWrite(this), -1);
+    // Nothing to write, don't wait for the node to have room.
+    if (io_vectors_size(vectors, count) == 0)
+    {
+        return 0;
+    }
+
+    size_t written = 0;
 
-        if (has_flag(OPEN_APPEND))
-        {
-            _offset = _node->size();
-        }
+    size_t index = 0;
+    size_t offset = 0;
 
-        auto result_or_written = _node->write(*this, buffer, size);
+    while (index < count)
+    {
+        BlockerWrite blocker{this};
+        task_block(scheduler_running(), blocker, -1);
 
-        if (result_or_written.success())
+        // Keep writing while the node accepts whole vectors, only block again
+        // once it is full.
+        while (index < count)
         {
-            _offset += result_or_written.value();
-        }
-
-        _node->release(scheduler_running_id());
+            if (has_flag(OPEN_APPEND))
+            {
+                _offset = _node->size();
+            }
 
-        return result_or_written;
-    };
+            auto remaining = vectors[index].size - offset;
+            auto remaining_buffer = reinterpret_cast<const char *>(vectors[index].buffer) + offset;
 
-    size_t written = 0;
+            auto result_or_written = _node->write(*this, remaining_buffer, remaining);
 
-    do
-    {
-        auto remaining = size - written;
-        auto remaining_buffer = reinterpret_cast<const char *>((reinterpret_cast<uintptr_t>(buffer)) + written);
+            TRACE(IO_WRITE, _node->type(), remaining, result_or_written.success() ? result_or_written.value() : 0);
 
-        auto result_or_written = attemp_a_write(remaining_buffer, remaining);
+            if (!result_or_written.success())
+            {
+                _node->release(scheduler_running_id());
+                return result_or_written;
+            }
 
-        if (!result_or_written.success())
-        {
-            return result_or_written;
-        }
-        else
-        {
+            _offset += result_or_written.value();
             written += result_or_written.value();
+            offset += result_or_written.value();
+
+            if (offset < vectors[index].size)
+            {
+                break;
+            }
+
+            index++;
+            offset = 0;
         }
-    } while (written < size);
+
+        _node->release(scheduler_running_id());
+    }
 
     return written;
 }
@@ -242,14 +330,31 @@ Result FsHandle::stat(FileState *stat)
     _node->acquire(scheduler_running_id());
     stat->size = _node->size();
     stat->type = _node->type();
+    stat->generation = _node->generation();
     _node->release(scheduler_running_id());
 
     return SUCCESS;
 }
 
+ResultOr<MemoryObject *> FsHandle::memory_object(size_t *size)
+{
+    if (!has_flag(OPEN_READ))
+    {
+        return ERR_WRITE_ONLY_STREAM;
+    }
+
+    _node->acquire(scheduler_running_id());
+    auto result_or_memory_object = _node->memory_object();
+    *size = _node->size();
+    _node->release(scheduler_running_id());
+
+    return result_or_memory_object;
+}
+
 ResultOr<FsHandle *> FsHandle::accept()
 {
-    task_block(scheduler_running(), new BlockerAccept(_node), -1);
+    BlockerAccept blocker{_node};
+    task_block(scheduler_running(), blocker, -1);
 
     auto connection_or_result = _node->accept();
 
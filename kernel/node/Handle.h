@@ -22,6 +22,10 @@ public:
 
     bool has_flag(OpenFlag flag) { return (_flags & flag) == flag; }
 
+    static void *operator new(size_t size);
+
+    static void operator delete(void *object);
+
     FsHandle(RefPtr<FsNode> node, OpenFlag flags);
 
     FsHandle(FsHandle &other);
@@ -38,8 +42,12 @@ public:
 
     ResultOr<size_t> read(void *buffer, size_t size);
 
+    ResultOr<size_t> readv(const IOVector *vectors, size_t count);
+
     ResultOr<size_t> write(const void *buffer, size_t size);
 
+    ResultOr<size_t> writev(const IOVector *vectors, size_t count);
+
     Result seek(int offset, Whence whence);
 
     ResultOr<int> tell(Whence whence);
@@ -48,5 +56,7 @@ public:
 
     Result stat(FileState *stat);
 
+    ResultOr<MemoryObject *> memory_object(size_t *size);
+
     ResultOr<FsHandle *> accept();
 };
@@ -9,6 +9,7 @@
 
 struct FsNode;
 struct FsHandle;
+struct MemoryObject;
 
 struct FsNode : public RefCounted<FsNode>
 {
@@ -58,6 +59,11 @@ public:
         return 0;
     }
 
+    virtual uint32_t generation()
+    {
+        return 0;
+    }
+
     virtual Result call(FsHandle &handle, IOCall request, void *args)
     {
         __unused(handle);
@@ -99,6 +105,13 @@ public:
         return ERR_NOT_WRITABLE;
     }
 
+    // The content of the node as pages a task can map, the caller owns a
+    // reference to the memory object.
+    virtual ResultOr<MemoryObject *> memory_object()
+    {
+        return ERR_OPERATION_NOT_SUPPORTED;
+    }
+
     virtual RefPtr<FsNode> find(String name)
     {
         __unused(name);
@@ -0,0 +1,90 @@
+#include <libsystem/Result.h>
+#include <libsystem/core/CString.h>
+#include <libsystem/math/MinMax.h>
+
+#include "kernel/filesystem/Filesystem.h"
+#include "kernel/node/Handle.h"
+#include "kernel/node/Profile.h"
+#include "kernel/tracing/Profiler.h"
+
+FsProfile::FsProfile() : FsNode(FILE_TYPE_DEVICE)
+{
+}
+
+struct ProfileReader
+{
+    uint8_t *snapshot;
+    size_t size;
+    size_t position;
+};
+
+Result FsProfile::open(FsHandle *handle)
+{
+    handle->attached = __create(ProfileReader);
+    handle->attached_size = sizeof(ProfileReader);
+
+    profiler_start();
+
+    return SUCCESS;
+}
+
+void FsProfile::close(FsHandle *handle)
+{
+    profiler_stop();
+
+    auto reader = reinterpret_cast<ProfileReader *>(handle->attached);
+
+    free(reader->snapshot);
+    free(reader);
+}
+
+ResultOr<size_t> FsProfile::read(FsHandle &handle, void *buffer, size_t size)
+{
+    auto reader = reinterpret_cast<ProfileReader *>(handle.attached);
+
+    // Once the previous snapshot has been consumed the samples collected
+    // since are taken, so the device can be drained while profiling.
+    if (reader->position == reader->size)
+    {
+        free(reader->snapshot);
+
+        reader->snapshot = (uint8_t *)profiler_snapshot(&reader->size);
+        reader->position = 0;
+    }
+
+    size_t read = MIN(reader->size - reader->position, size);
+    memcpy(buffer, reader->snapshot + reader->position, read);
+    reader->position += read;
+
+    return read;
+}
+
+Result FsProfile::call(FsHandle &handle, IOCall request, void *args)
+{
+    __unused(handle);
+
+    switch (request)
+    {
+    case IOCALL_PROFILE_SET_FREQUENCY:
+    {
+        auto frequency_args = reinterpret_cast<IOCallProfileFrequencyArgs *>(args);
+
+        if (frequency_args->frequency <= 0)
+        {
+            return ERR_INVALID_ARGUMENT;
+        }
+
+        profiler_set_frequency(frequency_args->frequency);
+
+        return SUCCESS;
+    }
+
+    default:
+        return ERR_INAPPROPRIATE_CALL_FOR_DEVICE;
+    }
+}
+
+void profile_device_initialize()
+{
+    filesystem_link(Path::parse(PROFILE_DEVICE_PATH), make<FsProfile>());
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "kernel/node/Node.h"
+
+class FsProfile : public FsNode
+{
+private:
+public:
+    FsProfile();
+
+    Result open(FsHandle *handle) override;
+
+    void close(FsHandle *handle) override;
+
+    ResultOr<size_t> read(FsHandle &handle, void *buffer, size_t size) override;
+
+    Result call(FsHandle &handle, IOCall request, void *args) override;
+};
+
+void profile_device_initialize();
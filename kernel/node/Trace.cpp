@@ -0,0 +1,53 @@
+#include <libsystem/Result.h>
+
+#include "kernel/filesystem/Filesystem.h"
+#include "kernel/node/Handle.h"
+#include "kernel/node/Trace.h"
+#include "kernel/tracing/Trace.h"
+
+FsTrace::FsTrace() : FsNode(FILE_TYPE_DEVICE)
+{
+}
+
+Result FsTrace::open(FsHandle *handle)
+{
+    auto cursor = __create(TraceCursor);
+    trace_cursor_initialize(*cursor);
+
+    handle->attached = cursor;
+    handle->attached_size = sizeof(TraceCursor);
+
+    trace_start();
+
+    return SUCCESS;
+}
+
+void FsTrace::close(FsHandle *handle)
+{
+    trace_stop();
+
+    free(handle->attached);
+}
+
+bool FsTrace::can_read(FsHandle *handle)
+{
+    return trace_available(*reinterpret_cast<TraceCursor *>(handle->attached));
+}
+
+ResultOr<size_t> FsTrace::read(FsHandle &handle, void *buffer, size_t size)
+{
+    if (size < sizeof(TraceEvent))
+    {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    auto cursor = reinterpret_cast<TraceCursor *>(handle.attached);
+    auto events = reinterpret_cast<TraceEvent *>(buffer);
+
+    return trace_read(*cursor, events, size / sizeof(TraceEvent)) * sizeof(TraceEvent);
+}
+
+void trace_device_initialize()
+{
+    filesystem_link(Path::parse(TRACE_DEVICE_PATH), make<FsTrace>());
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "kernel/node/Node.h"
+
+class FsTrace : public FsNode
+{
+private:
+public:
+    FsTrace();
+
+    Result open(FsHandle *handle) override;
+
+    void close(FsHandle *handle) override;
+
+    bool can_read(FsHandle *handle) override;
+
+    ResultOr<size_t> read(FsHandle &handle, void *buffer, size_t size) override;
+};
+
+void trace_device_initialize();
@@ -83,18 +83,25 @@ bool BlockerTime::can_unblock(Task *task)
 
 /* --- BlockerWait ---------------------------------------------------------- */
 
+void BlockerWait::finish(int exit_value)
+{
+    *_exit_value = exit_value;
+    _finished = true;
+}
+
 bool BlockerWait::can_unblock(Task *task)
 {
     __unused(task);
 
-    return _task->state() == TASK_STATE_CANCELED;
+    return _finished;
 }
 
-void BlockerWait::on_unblock(Task *task)
+void BlockerWait::on_cancel(Task *task)
 {
-    __unused(task);
-
-    *_exit_value = _task->exit_value;
+    if (!_finished)
+    {
+        list_remove(_task->waiters, task);
+    }
 }
 
 /* --- BlockerWrite ---------------------------------------------------------- */
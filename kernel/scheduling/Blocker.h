@@ -35,6 +35,13 @@ struct Blocker
     {
         __unused(task);
     }
+
+    // The task was canceled while blocked, it will never return from
+    // task_block().
+    virtual void on_cancel(struct Task *task)
+    {
+        __unused(task);
+    }
 };
 
 class BlockerAccept : public Blocker
@@ -130,6 +137,7 @@ class BlockerWait : public Blocker
 private:
     Task *_task;
     int *_exit_value;
+    bool _finished = false;
 
 public:
     BlockerWait(Task *task, int *exit_value)
@@ -137,9 +145,12 @@ public:
     {
     }
 
+    // Called by the task being waited on when it is canceled.
+    void finish(int exit_value);
+
     bool can_unblock(Task *task);
 
-    void on_unblock(Task *task);
+    void on_cancel(Task *task);
 };
 
 class BlockerWrite : public Blocker
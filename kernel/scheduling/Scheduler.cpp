@@ -5,6 +5,7 @@
 #include "kernel/interrupts/Interupts.h"
 #include "kernel/scheduling/Scheduler.h"
 #include "kernel/system/System.h"
+#include "kernel/tracing/Trace.h"
 
 static bool scheduler_context_switch = false;
 static int scheduler_record[SCHEDULER_RECORD_COUNT] = {};
@@ -124,6 +125,18 @@ static Iteration wakeup_task_if_unblocked(void *target, Task *task)
     return Iteration::CONTINUE;
 }
 
+// Wake up a blocked task right away instead of waiting for the next tick to
+// poll its blocker.
+void scheduler_wakeup(Task *task)
+{
+    ASSERT_INTERRUPTS_RETAINED();
+
+    if (task->state() == TASK_STATE_BLOCKED)
+    {
+        wakeup_task_if_unblocked(nullptr, task);
+    }
+}
+
 uintptr_t schedule(uintptr_t current_stack_pointer)
 {
     scheduler_context_switch = true;
@@ -135,6 +148,8 @@ uintptr_t schedule(uintptr_t current_stack_pointer)
 
     list_iterate(blocked_tasks, nullptr, (ListIterationCallback)wakeup_task_if_unblocked);
 
+    Task *previous = running;
+
     // Get the next task
     if (!list_peek_and_pushback(running_tasks, (void **)&running))
     {
@@ -142,6 +157,11 @@ uintptr_t schedule(uintptr_t current_stack_pointer)
         running = idle;
     }
 
+    if (previous != running)
+    {
+        TRACE(CONTEXT_SWITCH, previous->id, running->id);
+    }
+
     arch_address_space_switch(running->address_space);
     arch_load_context(running);
 
@@ -12,6 +12,8 @@ void scheduler_did_create_running_task(Task *task);
 
 void scheduler_did_change_task_state(Task *task, TaskState oldstate, TaskState newstate);
 
+void scheduler_wakeup(Task *task);
+
 bool scheduler_is_context_switch();
 
 int scheduler_get_usage(int task_id);
@@ -4,6 +4,7 @@
 #include "architectures/Architectures.h"
 #include "kernel/scheduling/Scheduler.h"
 #include "kernel/system/System.h"
+#include "kernel/system/VDSO.h"
 
 void system_hang()
 {
@@ -35,6 +36,8 @@ void system_tick()
     }
 
     _system_tick++;
+
+    vdso_update();
 }
 
 uint32_t system_get_tick()
@@ -0,0 +1,53 @@
+#include <abi/Syscalls.h>
+
+#include <libsystem/Assert.h>
+
+#include "architectures/Architectures.h"
+#include "architectures/VirtualMemory.h"
+
+#include "kernel/interrupts/Interupts.h"
+#include "kernel/memory/Memory.h"
+#include "kernel/system/System.h"
+#include "kernel/system/VDSO.h"
+
+static_assert(sizeof(VDSO) <= ARCH_PAGE_SIZE, "The vDSO must fit in a page");
+
+static VDSO *_vdso = nullptr;
+static uintptr_t _vdso_physical = 0;
+
+void vdso_initialize()
+{
+    InterruptsRetainer retainer;
+
+    assert(memory_alloc(arch_kernel_address_space(), ARCH_PAGE_SIZE, MEMORY_CLEAR, (uintptr_t *)&_vdso) == SUCCESS);
+    _vdso_physical = arch_virtual_to_physical(arch_kernel_address_space(), (uintptr_t)_vdso);
+
+    _vdso->ticks = system_get_tick();
+    _vdso->boot_time = arch_get_time() - system_get_tick() / 1000;
+
+    hj_system_info(&_vdso->info);
+
+    arch_vdso_initialize(_vdso);
+}
+
+void vdso_update()
+{
+    if (_vdso)
+    {
+        _vdso->ticks = system_get_tick();
+    }
+}
+
+void vdso_map(void *address_space)
+{
+    InterruptsRetainer retainer;
+
+    arch_virtual_map(address_space, MemoryRange{_vdso_physical, ARCH_PAGE_SIZE}, VDSO_ADDRESS, MEMORY_USER | MEMORY_READONLY);
+}
+
+void vdso_unmap(void *address_space)
+{
+    InterruptsRetainer retainer;
+
+    arch_virtual_free(address_space, MemoryRange{VDSO_ADDRESS, ARCH_PAGE_SIZE});
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <abi/VDSO.h>
+
+void vdso_initialize();
+
+void vdso_update();
+
+void vdso_map(void *address_space);
+
+void vdso_unmap(void *address_space);
@@ -14,6 +14,7 @@
 #include "kernel/tasking/Task-Handles.h"
 #include "kernel/tasking/Task-Lanchpad.h"
 #include "kernel/tasking/Task-Memory.h"
+#include "kernel/tracing/Trace.h"
 
 typedef Result (*SyscallHandler)(uint32_t, uint32_t, uint32_t, uint32_t, uint32_t);
 
@@ -33,7 +34,7 @@ Result hj_process_this(int *pid)
         return ERR_BAD_ADDRESS;
     }
 
-    *pid = scheduler_running_id();
+    *pid = scheduler_running()->process->id;
 
     return SUCCESS;
 }
@@ -107,7 +108,14 @@ Result hj_process_clone(int *pid)
 
 Result hj_process_exit(int exit_code)
 {
-    scheduler_running()->cancel(exit_code);
+    Task *task = scheduler_running();
+
+    if (task->process != task)
+    {
+        task->process->cancel(exit_code);
+    }
+
+    task->cancel(exit_code);
     ASSERT_NOT_REACHED();
 }
 
@@ -127,7 +135,7 @@ Result hj_process_cancel(int pid)
     }
     else
     {
-        task->cancel(PROCESS_FAILURE);
+        task->process->cancel(PROCESS_FAILURE);
         return SUCCESS;
     }
 }
@@ -151,6 +159,78 @@ Result hj_process_wait(int tid, int *user_exit_value)
     return result;
 }
 
+/* --- Threads -------------------------------------------------------------- */
+
+Result hj_thread_create(uintptr_t entry, uintptr_t arg, uintptr_t tls, int *tid)
+{
+    if (!syscall_validate_ptr(entry, 1) ||
+        !syscall_validate_ptr((uintptr_t)tid, sizeof(int)))
+    {
+        return ERR_BAD_ADDRESS;
+    }
+
+    InterruptsRetainer retainer;
+
+    Task *thread = task_thread_create(scheduler_running(), entry, arg, tls);
+
+    // The id is written before the thread has a chance to run, so it can be
+    // read from its own thread control block.
+    *tid = thread->id;
+
+    task_go(thread);
+
+    return SUCCESS;
+}
+
+Result hj_thread_exit(int exit_value)
+{
+    Task *thread = scheduler_running();
+
+    if (thread->process == thread)
+    {
+        return hj_process_exit(exit_value);
+    }
+
+    thread->cancel(exit_value);
+    ASSERT_NOT_REACHED();
+}
+
+Result hj_thread_join(int tid, int *user_exit_value)
+{
+    int exit_value;
+
+    Result result = task_thread_join(tid, &exit_value);
+
+    if (result == SUCCESS && syscall_validate_ptr((uintptr_t)user_exit_value, sizeof(int)))
+    {
+        *user_exit_value = exit_value;
+    }
+
+    return result;
+}
+
+Result hj_thread_detach(int tid)
+{
+    return task_thread_detach(tid);
+}
+
+Result hj_thread_set_tls(uintptr_t base)
+{
+    InterruptsRetainer retainer;
+
+    scheduler_running()->tls = base;
+    arch_set_tls(base);
+
+    return SUCCESS;
+}
+
+Result hj_thread_yield()
+{
+    scheduler_yield();
+
+    return SUCCESS;
+}
+
 /* --- Shared memory -------------------------------------------------------- */
 
 Result hj_memory_alloc(size_t size, uintptr_t *out_address)
@@ -200,6 +280,11 @@ Result hj_memory_get_handle(uintptr_t address, int *out_handle)
     return task_memory_get_handle(scheduler_running(), address, out_handle);
 }
 
+Result hj_memory_seal(uintptr_t address)
+{
+    return task_memory_seal(scheduler_running(), address);
+}
+
 /* --- Filesystem ----------------------------------------------------------- */
 
 Result hj_filesystem_mkdir(const char *raw_path, size_t size)
@@ -484,6 +569,206 @@ Result hj_handle_write(int handle, const void *buffer, size_t size, size_t *writ
     }
 }
 
+static bool syscall_validate_vectors(const IOVector *vectors, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!syscall_validate_ptr((uintptr_t)vectors[i].buffer, vectors[i].size))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+Result hj_handle_readv(int handle, const IOVector *vectors, size_t count, size_t *read)
+{
+    if (count > IO_VECTOR_MAX)
+    {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    if (!syscall_validate_ptr((uintptr_t)vectors, sizeof(IOVector) * count) ||
+        !syscall_validate_ptr((uintptr_t)read, sizeof(size_t)))
+    {
+        return ERR_BAD_ADDRESS;
+    }
+
+    // Copy the vectors so they can't change between validation and use.
+    IOVector vectors_copy[IO_VECTOR_MAX];
+    memcpy(vectors_copy, vectors, sizeof(IOVector) * count);
+
+    if (!syscall_validate_vectors(vectors_copy, count))
+    {
+        return ERR_BAD_ADDRESS;
+    }
+
+    auto result_or_read = task_fshandle_readv(scheduler_running(), handle, vectors_copy, count);
+
+    if (result_or_read.success())
+    {
+        *read = result_or_read.take_value();
+        return SUCCESS;
+    }
+    else
+    {
+        *read = 0;
+        return result_or_read.result();
+    }
+}
+
+Result hj_handle_writev(int handle, const IOVector *vectors, size_t count, size_t *written)
+{
+    if (count > IO_VECTOR_MAX)
+    {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    if (!syscall_validate_ptr((uintptr_t)vectors, sizeof(IOVector) * count) ||
+        !syscall_validate_ptr((uintptr_t)written, sizeof(size_t)))
+    {
+        return ERR_BAD_ADDRESS;
+    }
+
+    IOVector vectors_copy[IO_VECTOR_MAX];
+    memcpy(vectors_copy, vectors, sizeof(IOVector) * count);
+
+    if (!syscall_validate_vectors(vectors_copy, count))
+    {
+        return ERR_BAD_ADDRESS;
+    }
+
+    auto result_or_written = task_fshandle_writev(scheduler_running(), handle, vectors_copy, count);
+
+    if (result_or_written.success())
+    {
+        *written = result_or_written.take_value();
+        return SUCCESS;
+    }
+    else
+    {
+        *written = 0;
+        return result_or_written.result();
+    }
+}
+
+static IORingCompletion hj_handle_submit_execute(IORingSubmission &submission)
+{
+    IORingCompletion completion = {submission.data, SUCCESS, 0};
+
+    switch (submission.operation)
+    {
+    case IO_RING_NOP:
+        break;
+
+    case IO_RING_READ:
+    case IO_RING_WRITE:
+    {
+        if (!syscall_validate_ptr((uintptr_t)submission.buffer, submission.size))
+        {
+            completion.result = ERR_BAD_ADDRESS;
+            break;
+        }
+
+        auto result_or_transferred =
+            submission.operation == IO_RING_READ
+                ? task_fshandle_read(scheduler_running(), submission.handle, submission.buffer, submission.size)
+                : task_fshandle_write(scheduler_running(), submission.handle, submission.buffer, submission.size);
+
+        completion.result = result_or_transferred.result();
+
+        if (result_or_transferred.success())
+        {
+            completion.value = result_or_transferred.value();
+        }
+
+        break;
+    }
+
+    case IO_RING_POLL:
+    {
+        int selected = HANDLE_INVALID_ID;
+        PollEvent selected_events = 0;
+
+        HandleSet handle_set = {&submission.handle, &submission.events, 1};
+
+        completion.result = task_fshandle_poll(
+            scheduler_running(),
+            &handle_set,
+            &selected,
+            &selected_events,
+            submission.timeout);
+
+        completion.value = selected_events;
+
+        break;
+    }
+
+    case IO_RING_ACCEPT:
+    {
+        auto result_or_handle_index = task_fshandle_accept(scheduler_running(), submission.handle);
+
+        completion.result = result_or_handle_index.result();
+        completion.value = result_or_handle_index.success() ? result_or_handle_index.value() : HANDLE_INVALID_ID;
+
+        break;
+    }
+
+    default:
+        completion.result = ERR_INVALID_ARGUMENT;
+        break;
+    }
+
+    return completion;
+}
+
+Result hj_handle_submit(IORing *ring, size_t *completed)
+{
+    if (!syscall_validate_ptr((uintptr_t)ring, sizeof(IORing)) ||
+        !syscall_validate_ptr((uintptr_t)completed, sizeof(size_t)))
+    {
+        return ERR_BAD_ADDRESS;
+    }
+
+    uint32_t head = __atomic_load_n(&ring->submission_head, __ATOMIC_RELAXED);
+    uint32_t tail = __atomic_load_n(&ring->submission_tail, __ATOMIC_ACQUIRE);
+
+    if (tail - head > IO_RING_SIZE)
+    {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    // Submissions run in order, the ones that would block block the task like
+    // the equivalent syscall would. We stop early when the completion queue is
+    // full, the remaining submissions are picked up by the next call.
+    size_t count = 0;
+
+    while (head != tail)
+    {
+        uint32_t completion_tail = __atomic_load_n(&ring->completion_tail, __ATOMIC_RELAXED);
+
+        if (completion_tail - __atomic_load_n(&ring->completion_head, __ATOMIC_ACQUIRE) >= IO_RING_SIZE)
+        {
+            break;
+        }
+
+        IORingSubmission submission = ring->submissions[head & (IO_RING_SIZE - 1)];
+
+        head++;
+        __atomic_store_n(&ring->submission_head, head, __ATOMIC_RELEASE);
+
+        ring->completions[completion_tail & (IO_RING_SIZE - 1)] = hj_handle_submit_execute(submission);
+        __atomic_store_n(&ring->completion_tail, completion_tail + 1, __ATOMIC_RELEASE);
+
+        count++;
+    }
+
+    *completed = count;
+
+    return SUCCESS;
+}
+
 Result hj_handle_call(int handle, IOCall request, void *args)
 {
     return task_fshandle_call(scheduler_running(), handle, request, args);
@@ -525,6 +810,17 @@ Result hj_handle_stat(int handle, FileState *state)
     return task_fshandle_stat(scheduler_running(), handle, state);
 }
 
+Result hj_handle_map(int handle, uintptr_t *out_address, size_t *out_size)
+{
+    if (!syscall_validate_ptr((uintptr_t)out_address, sizeof(uintptr_t)) ||
+        !syscall_validate_ptr((uintptr_t)out_size, sizeof(size_t)))
+    {
+        return ERR_BAD_ADDRESS;
+    }
+
+    return task_fshandle_map(scheduler_running(), handle, out_address, out_size);
+}
+
 Result hj_handle_connect(int *handle, const char *raw_path, size_t size)
 {
     if (!syscall_validate_ptr((uintptr_t)handle, sizeof(int)) &&
@@ -577,11 +873,18 @@ static SyscallHandler syscalls[__SYSCALL_COUNT] = {
     [HJ_PROCESS_CANCEL] = reinterpret_cast<SyscallHandler>(hj_process_cancel),
     [HJ_PROCESS_SLEEP] = reinterpret_cast<SyscallHandler>(hj_process_sleep),
     [HJ_PROCESS_WAIT] = reinterpret_cast<SyscallHandler>(hj_process_wait),
+    [HJ_THREAD_CREATE] = reinterpret_cast<SyscallHandler>(hj_thread_create),
+    [HJ_THREAD_EXIT] = reinterpret_cast<SyscallHandler>(hj_thread_exit),
+    [HJ_THREAD_JOIN] = reinterpret_cast<SyscallHandler>(hj_thread_join),
+    [HJ_THREAD_DETACH] = reinterpret_cast<SyscallHandler>(hj_thread_detach),
+    [HJ_THREAD_SET_TLS] = reinterpret_cast<SyscallHandler>(hj_thread_set_tls),
+    [HJ_THREAD_YIELD] = reinterpret_cast<SyscallHandler>(hj_thread_yield),
     [HJ_MEMORY_ALLOC] = reinterpret_cast<SyscallHandler>(hj_memory_alloc),
     [HJ_MEMORY_MAP] = reinterpret_cast<SyscallHandler>(hj_memory_map),
     [HJ_MEMORY_FREE] = reinterpret_cast<SyscallHandler>(hj_memory_free),
     [HJ_MEMORY_INCLUDE] = reinterpret_cast<SyscallHandler>(hj_memory_include),
     [HJ_MEMORY_GET_HANDLE] = reinterpret_cast<SyscallHandler>(hj_memory_get_handle),
+    [HJ_MEMORY_SEAL] = reinterpret_cast<SyscallHandler>(hj_memory_seal),
     [HJ_FILESYSTEM_LINK] = reinterpret_cast<SyscallHandler>(hj_filesystem_link),
     [HJ_FILESYSTEM_UNLINK] = reinterpret_cast<SyscallHandler>(hj_filesystem_unlink),
     [HJ_FILESYSTEM_RENAME] = reinterpret_cast<SyscallHandler>(hj_filesystem_rename),
@@ -598,10 +901,14 @@ static SyscallHandler syscalls[__SYSCALL_COUNT] = {
     [HJ_HANDLE_POLL] = reinterpret_cast<SyscallHandler>(hj_handle_poll),
     [HJ_HANDLE_READ] = reinterpret_cast<SyscallHandler>(hj_handle_read),
     [HJ_HANDLE_WRITE] = reinterpret_cast<SyscallHandler>(hj_handle_write),
+    [HJ_HANDLE_READV] = reinterpret_cast<SyscallHandler>(hj_handle_readv),
+    [HJ_HANDLE_WRITEV] = reinterpret_cast<SyscallHandler>(hj_handle_writev),
+    [HJ_HANDLE_SUBMIT] = reinterpret_cast<SyscallHandler>(hj_handle_submit),
     [HJ_HANDLE_CALL] = reinterpret_cast<SyscallHandler>(hj_handle_call),
     [HJ_HANDLE_SEEK] = reinterpret_cast<SyscallHandler>(hj_handle_seek),
     [HJ_HANDLE_TELL] = reinterpret_cast<SyscallHandler>(hj_handle_tell),
     [HJ_HANDLE_STAT] = reinterpret_cast<SyscallHandler>(hj_handle_stat),
+    [HJ_HANDLE_MAP] = reinterpret_cast<SyscallHandler>(hj_handle_map),
     [HJ_HANDLE_CONNECT] = reinterpret_cast<SyscallHandler>(hj_handle_connect),
     [HJ_HANDLE_ACCEPT] = reinterpret_cast<SyscallHandler>(hj_handle_accept),
     [HJ_CREATE_PIPE] = reinterpret_cast<SyscallHandler>(hj_create_pipe),
@@ -643,8 +950,12 @@ int task_do_syscall(Syscall syscall, int arg0, int arg1, int arg2, int arg3, int
         return ERR_FUNCTION_NOT_IMPLEMENTED;
     }
 
+    TRACE(SYSCALL_ENTER, syscall, arg0, arg1);
+
     result = handler(arg0, arg1, arg2, arg3, arg4);
 
+    TRACE(SYSCALL_EXIT, syscall, result);
+
     if (result != SUCCESS && result != TIMEOUT && result != ERR_STREAM_CLOSED)
     {
         logger_trace("%s(%08x, %08x, %08x, %08x, %08x) returned %s", syscall_names[syscall], arg0, arg1, arg2, arg3, arg4, result_to_string((Result)result));
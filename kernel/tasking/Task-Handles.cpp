@@ -7,16 +7,17 @@
 #include "kernel/scheduling/Blocker.h"
 #include "kernel/scheduling/Scheduler.h"
 #include "kernel/tasking/Task-Handles.h"
+#include "kernel/tasking/Task-Memory.h"
 
 ResultOr<int> task_fshandle_add(Task *task, FsHandle *handle)
 {
-    LockHolder holder(task->handles_lock);
+    LockHolder holder(task->process->handles_lock);
 
     for (int i = 0; i < PROCESS_HANDLE_COUNT; i++)
     {
-        if (task->handles[i] == nullptr)
+        if (task->process->handles[i] == nullptr)
         {
-            task->handles[i] = handle;
+            task->process->handles[i] = handle;
 
             return i;
         }
@@ -28,12 +29,12 @@ ResultOr<int> task_fshandle_add(Task *task, FsHandle *handle)
 static bool is_valid_handle(Task *task, int handle)
 {
     return handle >= 0 && handle < PROCESS_HANDLE_COUNT &&
-           task->handles[handle] != nullptr;
+           task->process->handles[handle] != nullptr;
 }
 
 Result task_fshandle_remove(Task *task, int handle_index)
 {
-    LockHolder holder(task->handles_lock);
+    LockHolder holder(task->process->handles_lock);
 
     if (!is_valid_handle(task, handle_index))
     {
@@ -41,15 +42,15 @@ Result task_fshandle_remove(Task *task, int handle_index)
         return ERR_BAD_FILE_DESCRIPTOR;
     }
 
-    delete task->handles[handle_index];
-    task->handles[handle_index] = nullptr;
+    delete task->process->handles[handle_index];
+    task->process->handles[handle_index] = nullptr;
 
     return SUCCESS;
 }
 
 FsHandle *task_fshandle_acquire(Task *task, int handle_index)
 {
-    LockHolder holder(task->handles_lock);
+    LockHolder holder(task->process->handles_lock);
 
     if (!is_valid_handle(task, handle_index))
     {
@@ -57,13 +58,13 @@ FsHandle *task_fshandle_acquire(Task *task, int handle_index)
         return nullptr;
     }
 
-    task->handles[handle_index]->acquire(task->id);
-    return task->handles[handle_index];
+    task->process->handles[handle_index]->acquire(task->id);
+    return task->process->handles[handle_index];
 }
 
 Result task_fshandle_release(Task *task, int handle_index)
 {
-    LockHolder holder(task->handles_lock);
+    LockHolder holder(task->process->handles_lock);
 
     if (!is_valid_handle(task, handle_index))
     {
@@ -71,7 +72,7 @@ Result task_fshandle_release(Task *task, int handle_index)
         return ERR_BAD_FILE_DESCRIPTOR;
     }
 
-    task->handles[handle_index]->release(task->id);
+    task->process->handles[handle_index]->release(task->id);
     return SUCCESS;
 }
 
@@ -98,14 +99,14 @@ ResultOr<int> task_fshandle_open(Task *task, Path &path, OpenFlag flags)
 
 void task_fshandle_close_all(Task *task)
 {
-    LockHolder holder(task->handles_lock);
+    LockHolder holder(task->process->handles_lock);
 
     for (int i = 0; i < PROCESS_HANDLE_COUNT; i++)
     {
-        if (task->handles[i])
+        if (task->process->handles[i])
         {
-            delete task->handles[i];
-            task->handles[i] = nullptr;
+            delete task->process->handles[i];
+            task->process->handles[i] = nullptr;
         }
     }
 }
@@ -140,7 +141,7 @@ Result task_fshandle_poll(
     }
 
     {
-        auto blocker = new BlockerSelect{
+        BlockerSelect blocker{
             handles,
             handles_set->events,
             handles_set->count,
@@ -220,6 +221,38 @@ ResultOr<size_t> task_fshandle_write(Task *task, int handle_index, const void *b
     return result_or_written;
 }
 
+ResultOr<size_t> task_fshandle_readv(Task *task, int handle_index, const IOVector *vectors, size_t count)
+{
+    auto handle = task_fshandle_acquire(task, handle_index);
+
+    if (handle == nullptr)
+    {
+        return ERR_BAD_FILE_DESCRIPTOR;
+    }
+
+    auto result_or_read = handle->readv(vectors, count);
+
+    task_fshandle_release(task, handle_index);
+
+    return result_or_read;
+}
+
+ResultOr<size_t> task_fshandle_writev(Task *task, int handle_index, const IOVector *vectors, size_t count)
+{
+    auto handle = task_fshandle_acquire(task, handle_index);
+
+    if (handle == nullptr)
+    {
+        return ERR_BAD_FILE_DESCRIPTOR;
+    }
+
+    auto result_or_written = handle->writev(vectors, count);
+
+    task_fshandle_release(task, handle_index);
+
+    return result_or_written;
+}
+
 Result task_fshandle_seek(Task *task, int handle_index, int offset, Whence whence)
 {
     auto handle = task_fshandle_acquire(task, handle_index);
@@ -284,6 +317,36 @@ Result task_fshandle_stat(Task *task, int handle_index, FileState *stat)
     return result;
 }
 
+Result task_fshandle_map(Task *task, int handle_index, uintptr_t *out_address, size_t *out_size)
+{
+    auto handle = task_fshandle_acquire(task, handle_index);
+
+    if (handle == nullptr)
+    {
+        return ERR_BAD_FILE_DESCRIPTOR;
+    }
+
+    size_t size = 0;
+    auto result_or_memory_object = handle->memory_object(&size);
+
+    task_fshandle_release(task, handle_index);
+
+    if (!result_or_memory_object.success())
+    {
+        return result_or_memory_object.result();
+    }
+
+    auto memory_object = result_or_memory_object.take_value();
+
+    Result result = task_memory_include_readonly(task, memory_object, out_address);
+
+    memory_object_deref(memory_object);
+
+    *out_size = size;
+
+    return result;
+}
+
 ResultOr<int> task_fshandle_connect(Task *task, Path &path)
 {
     auto result_or_connection_handle = filesystem_connect(path);
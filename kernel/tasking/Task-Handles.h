@@ -14,6 +14,10 @@ ResultOr<size_t> task_fshandle_read(Task *task, int handle_index, void *buffer,
 
 ResultOr<size_t> task_fshandle_write(Task *task, int handle_index, const void *buffer, size_t size);
 
+ResultOr<size_t> task_fshandle_readv(Task *task, int handle_index, const IOVector *vectors, size_t count);
+
+ResultOr<size_t> task_fshandle_writev(Task *task, int handle_index, const IOVector *vectors, size_t count);
+
 Result task_fshandle_seek(Task *task, int handle_index, int offset, Whence whence);
 
 ResultOr<int> task_fshandle_tell(Task *task, int handle_index, Whence whence);
@@ -22,6 +26,8 @@ Result task_fshandle_call(Task *task, int handle_index, IOCall request, void *ar
 
 Result task_fshandle_stat(Task *task, int handle_index, FileState *stat);
 
+Result task_fshandle_map(Task *task, int handle_index, uintptr_t *out_address, size_t *out_size);
+
 ResultOr<int> task_fshandle_connect(Task *task, Path &socket_path);
 
 ResultOr<int> task_fshandle_accept(Task *task, int socket_handle_index);
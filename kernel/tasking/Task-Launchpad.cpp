@@ -111,7 +111,7 @@ void task_pass_argc_argv_env(Task *task, Launchpad *launchpad)
 
 void task_pass_handles(Task *parent_task, Task *child_task, Launchpad *launchpad)
 {
-    LockHolder holder(parent_task->handles_lock);
+    LockHolder holder(parent_task->process->handles_lock);
 
     for (int i = 0; i < PROCESS_HANDLE_COUNT; i++)
     {
@@ -120,11 +120,11 @@ void task_pass_handles(Task *parent_task, Task *child_task, Launchpad *launchpad
 
         if (parent_handle_id >= 0 &&
             parent_handle_id < PROCESS_HANDLE_COUNT &&
-            parent_task->handles[parent_handle_id] != nullptr)
+            parent_task->process->handles[parent_handle_id] != nullptr)
         {
-            parent_task->handles[parent_handle_id]->acquire(scheduler_running_id());
-            child_task->handles[child_handle_id] = new FsHandle(*parent_task->handles[parent_handle_id]);
-            parent_task->handles[parent_handle_id]->release(scheduler_running_id());
+            parent_task->process->handles[parent_handle_id]->acquire(scheduler_running_id());
+            child_task->handles[child_handle_id] = new FsHandle(*parent_task->process->handles[parent_handle_id]);
+            parent_task->process->handles[parent_handle_id]->release(scheduler_running_id());
         }
     }
 }
@@ -145,6 +145,7 @@ Result task_launch(Task *parent_task, Launchpad *launchpad, int *pid)
 
     interrupts_retain();
     Task *task = task_create(parent_task, launchpad->name, true);
+    strlcpy(task->executable, launchpad->executable, PATH_LENGTH);
     interrupts_release();
 
 #ifdef __x86_64__
@@ -3,9 +3,27 @@
 #include "architectures/VirtualMemory.h"
 
 #include "kernel/interrupts/Interupts.h"
+#include "kernel/memory/ObjectCache.h"
+#include "kernel/memory/Physical.h"
+#include "kernel/scheduling/Scheduler.h"
+#include "kernel/system/VDSO.h"
 #include "kernel/tasking/Task-Handles.h"
 #include "kernel/tasking/Task-Memory.h"
 
+static ObjectCache _memory_mapping_cache = OBJECT_CACHE(MemoryMapping, nullptr, nullptr);
+
+void *MemoryMapping::operator new(size_t size)
+{
+    assert(size == sizeof(MemoryMapping));
+
+    return object_cache_alloc(&_memory_mapping_cache);
+}
+
+void MemoryMapping::operator delete(void *object)
+{
+    object_cache_free(object);
+}
+
 static bool will_i_be_kill_if_i_allocate_that(Task *task, size_t size)
 {
     auto usage = task_memory_usage(task);
@@ -25,36 +43,47 @@ static void kill_me_if_too_greedy(Task *task, size_t size)
     if (will_i_be_kill_if_i_allocate_that(task, size))
     {
         task_fshandle_write(task, 2, "(ulimit reached)\n", 17);
+
+        // The whole process goes, not only the thread that asked.
+        if (task->process != task)
+        {
+            task->process->cancel(PROCESS_FAILURE);
+        }
+
         task->cancel(PROCESS_FAILURE);
     }
 }
 
-MemoryMapping *task_memory_mapping_create(Task *task, MemoryObject *memory_object)
+MemoryMapping *task_memory_mapping_create(Task *task, MemoryObject *memory_object, MemoryFlags flags)
 {
     InterruptsRetainer retainer;
 
-    auto memory_mapping = __create(MemoryMapping);
+    auto memory_mapping = new MemoryMapping();
 
     memory_mapping->object = memory_object_ref(memory_object);
-    memory_mapping->address = arch_virtual_alloc(task->address_space, memory_object->range(), MEMORY_USER).base();
+    memory_mapping->address = arch_virtual_alloc(task->address_space, memory_object->range(), MEMORY_USER | flags).base();
     memory_mapping->size = memory_object->range().size();
+    memory_mapping->copy_on_write = false;
+    memory_mapping->readonly = flags & MEMORY_READONLY;
 
     list_pushback(task->memory_mapping, memory_mapping);
 
     return memory_mapping;
 }
 
-MemoryMapping *task_memory_mapping_create_at(Task *task, MemoryObject *memory_object, uintptr_t address)
+MemoryMapping *task_memory_mapping_create_at(Task *task, MemoryObject *memory_object, uintptr_t address, MemoryFlags flags = MEMORY_NONE)
 {
     InterruptsRetainer retainer;
 
-    auto memory_mapping = __create(MemoryMapping);
+    auto memory_mapping = new MemoryMapping();
 
     memory_mapping->object = memory_object_ref(memory_object);
     memory_mapping->address = address;
     memory_mapping->size = memory_object->range().size();
+    memory_mapping->copy_on_write = false;
+    memory_mapping->readonly = flags & MEMORY_READONLY;
 
-    arch_virtual_map(task->address_space, memory_object->range(), address, MEMORY_USER);
+    arch_virtual_map(task->address_space, memory_object->range(), address, MEMORY_USER | flags);
 
     list_pushback(task->memory_mapping, memory_mapping);
 
@@ -65,11 +94,169 @@ void task_memory_mapping_destroy(Task *task, MemoryMapping *memory_mapping)
 {
     InterruptsRetainer retainer;
 
+    if (memory_mapping->copy_on_write)
+    {
+        for (size_t offset = 0; offset < memory_mapping->size; offset += ARCH_PAGE_SIZE)
+        {
+            uintptr_t physical = arch_virtual_to_physical(task->address_space, memory_mapping->address + offset);
+
+            if (physical && !memory_mapping->object->range().contains(physical))
+            {
+                physical_page_deref(physical);
+            }
+        }
+    }
+
     arch_virtual_free(task->address_space, (MemoryRange){memory_mapping->address, memory_mapping->size});
     memory_object_deref(memory_mapping->object);
 
     list_remove(task->memory_mapping, memory_mapping);
-    free(memory_mapping);
+    delete memory_mapping;
+}
+
+/* --- Copy on write -------------------------------------------------------- */
+
+static uintptr_t _copy_window = 0;
+
+// Copy memory of the current address space to physical pages, one page at the
+// time through a kernel window.
+static void copy_to_physical(MemoryRange physical_range, uintptr_t source)
+{
+    ASSERT_INTERRUPTS_RETAINED();
+
+    for (size_t offset = 0; offset < physical_range.size(); offset += ARCH_PAGE_SIZE)
+    {
+        MemoryRange physical_page{physical_range.base() + offset, ARCH_PAGE_SIZE};
+
+        if (!_copy_window)
+        {
+            _copy_window = arch_virtual_alloc(arch_kernel_address_space(), physical_page, MEMORY_NONE).base();
+        }
+        else
+        {
+            arch_virtual_map(arch_kernel_address_space(), physical_page, _copy_window, MEMORY_NONE);
+        }
+
+        memcpy((void *)_copy_window, (void *)(source + offset), ARCH_PAGE_SIZE);
+    }
+}
+
+MemoryMapping *task_memory_mapping_clone(Task *task, MemoryMapping *memory_mapping, Task *child)
+{
+    InterruptsRetainer retainer;
+
+    assert(task->address_space == scheduler_running()->address_space);
+
+    if (memory_mapping->readonly)
+    {
+        // Nobody writes to it, the child can look at the same pages.
+        return task_memory_mapping_create_at(child, memory_mapping->object, memory_mapping->address, MEMORY_READONLY);
+    }
+
+    if (!memory_mapping->copy_on_write && memory_mapping->object->refcount > 1)
+    {
+        // Shared memory, the other tasks should not see the writes of the
+        // child, so it gets its own copy right away.
+        auto memory_object = memory_object_create(memory_mapping->size);
+
+        copy_to_physical(memory_object->range(), memory_mapping->address);
+
+        auto child_mapping = task_memory_mapping_create_at(child, memory_object, memory_mapping->address);
+
+        memory_object_deref(memory_object);
+
+        return child_mapping;
+    }
+
+    auto child_mapping = new MemoryMapping();
+
+    child_mapping->object = memory_object_ref(memory_mapping->object);
+    child_mapping->address = memory_mapping->address;
+    child_mapping->size = memory_mapping->size;
+    child_mapping->copy_on_write = true;
+    child_mapping->readonly = false;
+
+    memory_mapping->copy_on_write = true;
+
+    for (size_t offset = 0; offset < memory_mapping->size; offset += ARCH_PAGE_SIZE)
+    {
+        uintptr_t address = memory_mapping->address + offset;
+        uintptr_t physical = arch_virtual_to_physical(task->address_space, address);
+
+        if (!physical)
+        {
+            continue;
+        }
+
+        if (!memory_mapping->object->range().contains(physical))
+        {
+            physical_page_ref(physical);
+        }
+
+        MemoryRange physical_page{physical, ARCH_PAGE_SIZE};
+
+        arch_virtual_map(task->address_space, physical_page, address, MEMORY_USER | MEMORY_READONLY);
+        arch_virtual_map(child->address_space, physical_page, address, MEMORY_USER | MEMORY_READONLY);
+    }
+
+    list_pushback(child->memory_mapping, child_mapping);
+
+    return child_mapping;
+}
+
+static MemoryMapping *task_memory_mapping_containing(Task *task, uintptr_t address)
+{
+    list_foreach(MemoryMapping, memory_mapping, task->memory_mapping)
+    {
+        if (memory_mapping->range().contains(address))
+        {
+            return memory_mapping;
+        }
+    }
+
+    return nullptr;
+}
+
+bool task_memory_handle_page_fault(Task *task, uintptr_t address)
+{
+    InterruptsRetainer retainer;
+
+    auto memory_mapping = task_memory_mapping_containing(task, address);
+
+    if (!memory_mapping || !memory_mapping->copy_on_write)
+    {
+        return false;
+    }
+
+    uintptr_t page = PAGE_ALIGN_DOWN(address);
+    uintptr_t physical = PAGE_ALIGN_DOWN(arch_virtual_to_physical(task->address_space, page));
+
+    bool is_object_page = memory_mapping->object->range().contains(physical);
+
+    bool is_exclusive = is_object_page
+                            ? memory_mapping->object->refcount == 1
+                            : !physical_page_is_shared(physical);
+
+    if (is_exclusive)
+    {
+        // Nobody else is looking at this page anymore.
+        arch_virtual_map(task->address_space, MemoryRange{physical, ARCH_PAGE_SIZE}, page, MEMORY_USER);
+
+        return true;
+    }
+
+    auto copy = physical_alloc(ARCH_PAGE_SIZE);
+
+    copy_to_physical(copy, page);
+
+    arch_virtual_map(task->address_space, copy, page, MEMORY_USER);
+
+    if (!is_object_page)
+    {
+        physical_page_deref(physical);
+    }
+
+    return true;
 }
 
 MemoryMapping *task_memory_mapping_by_address(Task *task, uintptr_t address)
@@ -101,8 +288,14 @@ bool task_memory_mapping_colides(Task *task, uintptr_t address, size_t size)
 
 /* --- User facing API ------------------------------------------------------ */
 
+// The mappings are shared by the threads of a process, looking them up and
+// changing them is done with interrupts retained so two threads can't map or
+// free the same range at the same time.
+
 Result task_memory_alloc(Task *task, size_t size, uintptr_t *out_address)
 {
+    InterruptsRetainer retainer;
+
     kill_me_if_too_greedy(task, size);
 
     auto memory_object = memory_object_create(size);
@@ -118,9 +311,13 @@ Result task_memory_alloc(Task *task, size_t size, uintptr_t *out_address)
 
 Result task_memory_map(Task *task, uintptr_t address, size_t size, MemoryFlags flags)
 {
+    InterruptsRetainer retainer;
+
     kill_me_if_too_greedy(task, size);
 
-    if (task_memory_mapping_colides(task, address, size))
+    if (task_memory_mapping_colides(task, address, size) ||
+        MemoryRange{address, size}.contains(VDSO_ADDRESS) ||
+        MemoryRange{VDSO_ADDRESS, ARCH_PAGE_SIZE}.contains(address))
     {
         return ERR_BAD_ADDRESS;
     }
@@ -131,6 +328,7 @@ Result task_memory_map(Task *task, uintptr_t address, size_t size, MemoryFlags f
 
     memory_object_deref(memory_object);
 
+    // Still retained, another thread can't unmap it under our feet.
     if (flags & MEMORY_CLEAR)
     {
         memset((void *)address, 0, size);
@@ -141,6 +339,8 @@ Result task_memory_map(Task *task, uintptr_t address, size_t size, MemoryFlags f
 
 Result task_memory_free(Task *task, uintptr_t address)
 {
+    InterruptsRetainer retainer;
+
     auto memory_mapping = task_memory_mapping_by_address(task, address);
 
     if (!memory_mapping)
@@ -155,6 +355,8 @@ Result task_memory_free(Task *task, uintptr_t address)
 
 Result task_memory_include(Task *task, int handle, uintptr_t *out_address, size_t *out_size)
 {
+    InterruptsRetainer retainer;
+
     auto memory_object = memory_object_by_id(handle);
 
     if (!memory_object)
@@ -168,7 +370,7 @@ Result task_memory_include(Task *task, int handle, uintptr_t *out_address, size_
         kill_me_if_too_greedy(task, memory_object->range().size());
     }
 
-    auto memory_mapping = task_memory_mapping_create(task, memory_object);
+    auto memory_mapping = task_memory_mapping_create(task, memory_object, memory_object->sealed ? MEMORY_READONLY : MEMORY_NONE);
 
     memory_object_deref(memory_object);
 
@@ -178,8 +380,23 @@ Result task_memory_include(Task *task, int handle, uintptr_t *out_address, size_
     return SUCCESS;
 }
 
+Result task_memory_include_readonly(Task *task, MemoryObject *memory_object, uintptr_t *out_address)
+{
+    InterruptsRetainer retainer;
+
+    kill_me_if_too_greedy(task, memory_object->range().size());
+
+    auto memory_mapping = task_memory_mapping_create(task, memory_object, MEMORY_READONLY);
+
+    *out_address = memory_mapping->address;
+
+    return SUCCESS;
+}
+
 Result task_memory_get_handle(Task *task, uintptr_t address, int *out_handle)
 {
+    InterruptsRetainer retainer;
+
     auto memory_mapping = task_memory_mapping_by_address(task, address);
 
     if (!memory_mapping)
@@ -187,10 +404,45 @@ Result task_memory_get_handle(Task *task, uintptr_t address, int *out_handle)
         return ERR_BAD_ADDRESS;
     }
 
+    if (memory_mapping->copy_on_write)
+    {
+        // Some pages may have been copied, the object is not what the task
+        // sees anymore.
+        return ERR_ACCESS_DENIED;
+    }
+
+    if (memory_mapping->readonly && !memory_mapping->object->sealed)
+    {
+        // Whoever includes the object could write to it.
+        return ERR_ACCESS_DENIED;
+    }
+
     *out_handle = memory_mapping->object->id;
     return SUCCESS;
 }
 
+Result task_memory_seal(Task *task, uintptr_t address)
+{
+    InterruptsRetainer retainer;
+
+    auto memory_mapping = task_memory_mapping_by_address(task, address);
+
+    if (!memory_mapping)
+    {
+        return ERR_BAD_ADDRESS;
+    }
+
+    if (memory_mapping->copy_on_write || memory_mapping->readonly)
+    {
+        // Only the task writing to the object gets to seal it.
+        return ERR_ACCESS_DENIED;
+    }
+
+    memory_mapping->object->sealed = true;
+
+    return SUCCESS;
+}
+
 void *task_switch_address_space(Task *task, void *address_space)
 {
     void *old_address_space = task->address_space;
@@ -204,6 +456,8 @@ void *task_switch_address_space(Task *task, void *address_space)
 
 size_t task_memory_usage(Task *task)
 {
+    InterruptsRetainer retainer;
+
     size_t total = 0;
 
     list_foreach(MemoryMapping, memory_mapping, task->memory_mapping)
@@ -10,16 +10,33 @@ struct MemoryMapping
     uintptr_t address;
     size_t size;
 
+    // The pages are shared read-only with a cloned task until one of them
+    // writes to it. A page which doesn't belong to the object anymore is a
+    // private copy.
+    bool copy_on_write;
+
+    // The object is shared with other tasks which must not see writes, like
+    // the pages of a mapped file.
+    bool readonly;
+
+    static void *operator new(size_t size);
+
+    static void operator delete(void *object);
+
     MemoryRange range()
     {
         return {address, size};
     }
 };
 
-MemoryMapping *task_memory_mapping_create(Task *task, MemoryObject *memory_object);
+MemoryMapping *task_memory_mapping_create(Task *task, MemoryObject *memory_object, MemoryFlags flags = MEMORY_NONE);
 
 void task_memory_mapping_destroy(Task *task, MemoryMapping *memory_mapping);
 
+MemoryMapping *task_memory_mapping_clone(Task *task, MemoryMapping *memory_mapping, Task *child);
+
+bool task_memory_handle_page_fault(Task *task, uintptr_t address);
+
 MemoryMapping *task_memory_mapping_by_address(Task *task, uintptr_t address);
 
 Result task_memory_alloc(Task *task, size_t size, uintptr_t *out_address);
@@ -30,8 +47,12 @@ Result task_memory_free(Task *task, uintptr_t address);
 
 Result task_memory_include(Task *task, int handle, uintptr_t *out_address, size_t *out_size);
 
+Result task_memory_include_readonly(Task *task, MemoryObject *memory_object, uintptr_t *out_address);
+
 Result task_memory_get_handle(Task *task, uintptr_t address, int *out_handle);
 
+Result task_memory_seal(Task *task, uintptr_t address);
+
 void *task_switch_address_space(Task *task, void *address_space);
 
 size_t task_memory_usage(Task *task);
@@ -7,15 +7,79 @@
 #include "architectures/x86_32/kernel/Interrupts.h" /* XXX */
 
 #include "kernel/interrupts/Interupts.h"
+#include "kernel/memory/ObjectCache.h"
 #include "kernel/scheduling/Scheduler.h"
 #include "kernel/system/System.h"
+#include "kernel/system/VDSO.h"
 #include "kernel/tasking/Task-Handles.h"
 #include "kernel/tasking/Task-Memory.h"
 #include "kernel/tasking/Task.h"
+#include "kernel/tasking/Tasking.h"
+#include "kernel/tracing/Profiler.h"
 
-static int _task_ids = 0;
 static List *_tasks;
 
+static ObjectCache _task_cache = OBJECT_CACHE(Task, nullptr, nullptr);
+
+/* --- Task table ----------------------------------------------------------- */
+
+// Task ids are made of a slot in the table and the generation of that slot,
+// so a stale id never resolves to the task that reused the slot.
+#define TASK_TABLE_SIZE 4096
+#define TASK_GENERATION_COUNT (0x7fffffff / TASK_TABLE_SIZE)
+
+static Task *_task_table[TASK_TABLE_SIZE] = {};
+static int _task_generations[TASK_TABLE_SIZE] = {};
+static int _task_free_slots[TASK_TABLE_SIZE];
+static int _task_free_slots_count = -1;
+
+static void task_table_insert(Task *task)
+{
+    if (_task_free_slots_count == -1)
+    {
+        // Lower slots are handed out first, the idle task gets id 0.
+        for (int i = 0; i < TASK_TABLE_SIZE; i++)
+        {
+            _task_free_slots[i] = TASK_TABLE_SIZE - 1 - i;
+        }
+
+        _task_free_slots_count = TASK_TABLE_SIZE;
+    }
+
+    if (_task_free_slots_count == 0)
+    {
+        system_panic("Too many tasks!");
+    }
+
+    int slot = _task_free_slots[--_task_free_slots_count];
+
+    _task_table[slot] = task;
+    task->id = _task_generations[slot] * TASK_TABLE_SIZE + slot;
+}
+
+static void task_table_remove(Task *task)
+{
+    int slot = task->id % TASK_TABLE_SIZE;
+
+    assert(_task_table[slot] == task);
+
+    _task_table[slot] = nullptr;
+    _task_generations[slot] = (_task_generations[slot] + 1) % TASK_GENERATION_COUNT;
+    _task_free_slots[_task_free_slots_count++] = slot;
+}
+
+void *Task::operator new(size_t size)
+{
+    assert(size == sizeof(Task));
+
+    return object_cache_alloc(&_task_cache);
+}
+
+void Task::operator delete(void *object)
+{
+    object_cache_free(object);
+}
+
 TaskState Task::state()
 {
     return _state;
@@ -27,12 +91,57 @@ void Task::state(TaskState state)
     _state = state;
 }
 
+// Called with interrupts retained once the task is canceled.
+static void task_did_cancel(Task *task)
+{
+    if (task->blocker)
+    {
+        task->blocker->on_cancel(task);
+    }
+
+    Task *waiter = nullptr;
+
+    while (list_pop(task->waiters, (void **)&waiter))
+    {
+        static_cast<BlockerWait *>(waiter->blocker)->finish(task->exit_value);
+        scheduler_wakeup(waiter);
+    }
+
+    tasking_did_cancel_task(task);
+}
+
 void Task::cancel(int exit_value)
 {
     InterruptsRetainer retainer;
 
     this->exit_value = exit_value;
     state(TASK_STATE_CANCELED);
+    task_did_cancel(this);
+
+    if (process == this && threads > 0)
+    {
+        list_foreach(Task, thread, _tasks)
+        {
+            if (thread->process != this ||
+                thread == this ||
+                thread == scheduler_running())
+            {
+                continue;
+            }
+
+            if (thread->state() == TASK_STATE_CANCELED)
+            {
+                // Threads waiting to be joined can be collected now.
+                tasking_did_cancel_task(thread);
+            }
+            else
+            {
+                thread->exit_value = exit_value;
+                thread->state(TASK_STATE_CANCELED);
+                task_did_cancel(thread);
+            }
+        }
+    }
 
     if (this == scheduler_running())
     {
@@ -52,15 +161,21 @@ Task *task_create(Task *parent, const char *name, bool user)
         _tasks = list_create();
     }
 
-    Task *task = __create(Task);
+    Task *task = new Task();
 
-    task->id = _task_ids++;
+    task_table_insert(task);
     strlcpy(task->name, name, PROCESS_NAME_SIZE);
     task->_state = TASK_STATE_NONE;
+    task->waiters = list_create();
+    task->collecting = false;
+    task->process = task;
+    task->threads = 0;
+    task->tls = 0;
 
     if (user)
     {
         task->address_space = arch_address_space_create();
+        vdso_map(task->address_space);
     }
     else
     {
@@ -91,6 +206,8 @@ Task *task_create(Task *parent, const char *name, bool user)
 
     arch_save_context(task);
 
+    profiler_did_create_task(task);
+
     list_pushback(_tasks, task);
 
     return task;
@@ -105,13 +222,20 @@ Task *task_clone(Task *parent, uintptr_t sp, uintptr_t ip)
         _tasks = list_create();
     }
 
-    Task *task = __create(Task);
+    Task *task = new Task();
 
-    task->id = _task_ids++;
+    task_table_insert(task);
     strlcpy(task->name, parent->name, PROCESS_NAME_SIZE);
+    strlcpy(task->executable, parent->executable, PATH_LENGTH);
     task->_state = TASK_STATE_NONE;
+    task->waiters = list_create();
+    task->collecting = false;
+    task->process = task;
+    task->threads = 0;
+    task->tls = parent->tls;
 
     task->address_space = arch_address_space_create();
+    vdso_map(task->address_space);
 
     // Setup shms
     task->memory_mapping = list_create();
@@ -120,73 +244,209 @@ Task *task_clone(Task *parent, uintptr_t sp, uintptr_t ip)
     lock_init(task->handles_lock);
     for (int i = 0; i < PROCESS_HANDLE_COUNT; i++)
     {
-        if (parent->handles[i])
+        if (parent->process->handles[i])
         {
-            task->handles[i] = new FsHandle(*parent->handles[i]);
+            task->handles[i] = new FsHandle(*parent->process->handles[i]);
         }
     }
 
     memory_alloc(task->address_space, PROCESS_STACK_SIZE, MEMORY_CLEAR, (uintptr_t *)&task->kernel_stack);
     task->kernel_stack_pointer = ((uintptr_t)task->kernel_stack + PROCESS_STACK_SIZE);
 
+    // The pages are shared until one of the tasks writes to them.
     list_foreach(MemoryMapping, mapping, parent->memory_mapping)
     {
-        auto virtual_range = mapping->range();
+        task_memory_mapping_clone(parent, mapping, task);
+    }
 
-        auto physical_range = mapping->object->range();
+    task->user_stack_pointer = sp;
+    task->entry_point = (TaskEntryPoint)ip;
+    task->user = true;
 
-        void *buffer = malloc(physical_range.size());
-        assert(buffer);
-        assert(virtual_range.base());
-        memcpy(buffer, (void *)virtual_range.base(), virtual_range.size());
+    profiler_did_create_task(task);
 
-        void *parent_address_space = task_switch_address_space(scheduler_running(), task->address_space);
+    list_pushback(_tasks, task);
 
-        task_memory_map(task, virtual_range.base(), virtual_range.size(), MEMORY_USER);
-        memcpy((void *)virtual_range.base(), buffer, virtual_range.size());
+    task_go(task);
 
-        task_switch_address_space(scheduler_running(), parent_address_space);
+    return task;
+}
 
-        free(buffer);
-    }
+Task *task_thread_create(Task *parent, uintptr_t entry, uintptr_t arg, uintptr_t tls)
+{
+    ASSERT_INTERRUPTS_RETAINED();
 
-    task->user_stack_pointer = sp;
-    task->entry_point = (TaskEntryPoint)ip;
+    assert(parent == scheduler_running());
+
+    Task *process = parent->process;
+
+    Task *task = new Task();
+
+    task_table_insert(task);
+    strlcpy(task->name, process->name, PROCESS_NAME_SIZE);
+    strlcpy(task->executable, process->executable, PATH_LENGTH);
+    task->_state = TASK_STATE_NONE;
+    task->waiters = list_create();
+    task->collecting = false;
+    task->process = process;
+    task->threads = 0;
+    task->detached = false;
+    task->joining = false;
+    task->tls = tls;
+
+    // Everything but the stacks is shared with the process.
+    task->address_space = process->address_space;
+    task->memory_mapping = process->memory_mapping;
+    lock_init(task->handles_lock);
+
+    memory_alloc(task->address_space, PROCESS_STACK_SIZE, MEMORY_CLEAR, (uintptr_t *)&task->kernel_stack);
+    task->kernel_stack_pointer = ((uintptr_t)task->kernel_stack + PROCESS_STACK_SIZE);
+
+    // The caller is running in the same address space, so the user stack can
+    // be written to directly.
+    uintptr_t user_stack = 0;
+    task_memory_alloc(process, PROCESS_STACK_SIZE, &user_stack);
+
+    task->user_stack = (void *)user_stack;
+    task->user_stack_pointer = user_stack + PROCESS_STACK_SIZE;
+
+    uintptr_t return_address = 0;
+    task_user_stack_push(task, &arg, sizeof(arg));
+    task_user_stack_push(task, &return_address, sizeof(return_address));
+
+    task->entry_point = (TaskEntryPoint)entry;
     task->user = true;
 
-    task_go(task);
+    arch_save_context(task);
+
+    process->threads++;
+
+    profiler_did_create_task(task);
+
+    list_pushback(_tasks, task);
 
     return task;
 }
 
+static Task *task_thread_by_id(int thread_id)
+{
+    Task *thread = task_by_id(thread_id);
+
+    if (thread == nullptr ||
+        thread->process == thread ||
+        thread->process != scheduler_running()->process)
+    {
+        return nullptr;
+    }
+
+    return thread;
+}
+
+Result task_thread_join(int thread_id, int *exit_value)
+{
+    InterruptsRetainer retainer;
+
+    Task *thread = task_thread_by_id(thread_id);
+
+    if (!thread)
+    {
+        return ERR_NO_SUCH_TASK;
+    }
+
+    if (thread == scheduler_running() || thread->detached || thread->joining)
+    {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    thread->joining = true;
+
+    if (thread->state() == TASK_STATE_CANCELED)
+    {
+        *exit_value = thread->exit_value;
+    }
+    else
+    {
+        BlockerWait blocker{thread, exit_value};
+        list_pushback(thread->waiters, scheduler_running());
+        task_block(scheduler_running(), blocker, -1);
+    }
+
+    // Joinable threads are left alone by the garbage collector until they
+    // are joined.
+    thread->detached = true;
+    tasking_did_cancel_task(thread);
+
+    return SUCCESS;
+}
+
+Result task_thread_detach(int thread_id)
+{
+    InterruptsRetainer retainer;
+
+    Task *thread = task_thread_by_id(thread_id);
+
+    if (!thread)
+    {
+        return ERR_NO_SUCH_TASK;
+    }
+
+    if (thread->joining)
+    {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    thread->detached = true;
+
+    return SUCCESS;
+}
+
 void task_destroy(Task *task)
 {
     interrupts_retain();
     task->state(TASK_STATE_NONE);
 
     list_remove(_tasks, task);
+    task_table_remove(task);
+
+    assert(task->waiters->empty());
+    list_destroy(task->waiters);
 
     interrupts_release();
 
-    MemoryMapping *mapping = nullptr;
+    profiler_did_destroy_task(task);
 
-    while ((mapping = (MemoryMapping *)list_peek(task->memory_mapping)))
+    if (task->process == task)
     {
-        task_memory_mapping_destroy(task, mapping);
-    }
+        assert(task->threads == 0);
+
+        MemoryMapping *mapping = nullptr;
 
-    list_destroy(task->memory_mapping);
+        while ((mapping = (MemoryMapping *)list_peek(task->memory_mapping)))
+        {
+            task_memory_mapping_destroy(task, mapping);
+        }
 
-    task_fshandle_close_all(task);
+        list_destroy(task->memory_mapping);
+
+        task_fshandle_close_all(task);
+    }
+    else
+    {
+        task_memory_free(task->process, (uintptr_t)task->user_stack);
+        task->process->threads--;
+    }
 
     memory_free(task->address_space, MemoryRange{(uintptr_t)task->kernel_stack, PROCESS_STACK_SIZE});
 
-    if (task->address_space != arch_kernel_address_space())
+    if (task->process == task &&
+        task->address_space != arch_kernel_address_space())
     {
+        // The vDSO page is shared, it must not be freed with the address space.
+        vdso_unmap(task->address_space);
         arch_address_space_destroy(task->address_space);
     }
 
-    free(task);
+    delete task;
 }
 
 void task_iterate(void *target, TaskIterateCallback callback)
@@ -203,10 +463,16 @@ void task_iterate(void *target, TaskIterateCallback callback)
 
 Task *task_by_id(int id)
 {
-    list_foreach(Task, task, _tasks)
+    if (id < 0)
+    {
+        return nullptr;
+    }
+
+    Task *task = _task_table[id % TASK_TABLE_SIZE];
+
+    if (task && task->id == id)
     {
-        if (task->id == id)
-            return task;
+        return task;
     }
 
     return nullptr;
@@ -275,7 +541,7 @@ void task_go(Task *task)
         stackframe.ds = 0x23;
         stackframe.es = 0x23;
         stackframe.fs = 0x23;
-        stackframe.gs = 0x23;
+        stackframe.gs = 0x33; // Thread local storage
         stackframe.ss = 0x23;
 
         task_kernel_stack_push(task, &stackframe, sizeof(UserInterruptStackFrame));
@@ -302,7 +568,8 @@ void task_go(Task *task)
 
 Result task_sleep(Task *task, int timeout)
 {
-    task_block(task, new BlockerTime(system_get_tick() + timeout), -1);
+    BlockerTime blocker{system_get_tick() + timeout};
+    task_block(task, blocker, -1);
 
     return TIMEOUT;
 }
@@ -318,36 +585,43 @@ Result task_wait(int task_id, int *exit_value)
         return ERR_NO_SUCH_TASK;
     }
 
-    task_block(scheduler_running(), new BlockerWait(task, exit_value), -1);
+    if (task->state() == TASK_STATE_CANCELED)
+    {
+        *exit_value = task->exit_value;
+        return SUCCESS;
+    }
+
+    BlockerWait blocker{task, exit_value};
+    list_pushback(task->waiters, scheduler_running());
+    task_block(scheduler_running(), blocker, -1);
 
     return SUCCESS;
 }
 
-BlockerResult task_block(Task *task, Blocker *blocker, Timeout timeout)
+BlockerResult task_block(Task *task, Blocker &blocker, Timeout timeout)
 {
     assert(!task->blocker);
 
     interrupts_retain();
-    task->blocker = blocker;
-    if (blocker->can_unblock(task))
+    task->blocker = &blocker;
+    if (blocker.can_unblock(task))
     {
-        blocker->on_unblock(task);
+        blocker.on_unblock(task);
 
         interrupts_release();
 
         task->blocker = nullptr;
-        delete blocker;
 
         return BLOCKER_UNBLOCKED;
     }
 
     if (timeout == (Timeout)-1)
     {
-        blocker->_timeout = (Timeout)-1;
+        blocker._timeout = (Timeout)-1;
     }
     else
     {
-        blocker->_timeout = system_get_tick() + timeout;
+        blocker._timeout = system_get_tick() + timeout;
     }
 
     task->state(TASK_STATE_BLOCKED);
@@ -355,10 +629,9 @@ BlockerResult task_block(Task *task, Blocker *blocker, Timeout timeout)
 
     scheduler_yield();
 
-    BlockerResult result = blocker->_result;
+    BlockerResult result = blocker._result;
 
     task->blocker = nullptr;
-    delete blocker;
 
     return result;
 }
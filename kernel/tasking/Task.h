@@ -9,6 +9,8 @@
 #include "kernel/memory/Memory.h"
 #include "kernel/scheduling/Blocker.h"
 
+struct ProfileBuffer;
+
 typedef void (*TaskEntryPoint)();
 
 struct Task
@@ -16,10 +18,25 @@ struct Task
     int id;
     bool user;
     char name[PROCESS_NAME_SIZE];
+    char executable[PATH_LENGTH];
+
+    // Threads share the address space, the memory mappings and the handles of
+    // their process, `process` points to the task owning them (itself for the
+    // main thread).
+    Task *process;
+    int threads;
+    bool detached;
+    bool joining;
+    uintptr_t tls;
 
     TaskState _state;
     Blocker *blocker;
 
+    // Tasks blocked in task_wait() on this one, they are handed the exit
+    // value as soon as it is canceled.
+    List *waiters;
+    bool collecting;
+
     uintptr_t user_stack_pointer;
     void *user_stack;
 
@@ -37,6 +54,12 @@ struct Task
 
     int exit_value;
 
+    ProfileBuffer *profile;
+
+    static void *operator new(size_t size);
+
+    static void operator delete(void *object);
+
     TaskState state();
 
     void state(TaskState state);
@@ -48,6 +71,12 @@ Task *task_create(Task *parent, const char *name, bool user);
 
 Task *task_clone(Task *parent, uintptr_t sp, uintptr_t ip);
 
+Task *task_thread_create(Task *parent, uintptr_t entry, uintptr_t arg, uintptr_t tls);
+
+Result task_thread_join(int thread_id, int *exit_value);
+
+Result task_thread_detach(int thread_id);
+
 void task_destroy(Task *task);
 
 typedef Iteration (*TaskIterateCallback)(void *target, Task *task);
@@ -73,6 +102,8 @@ Result task_sleep(Task *task, int timeout);
 
 Result task_wait(int task_id, int *exit_value);
 
-BlockerResult task_block(Task *task, Blocker *blocker, Timeout timeout);
+// The blocker is owned by the caller, usually it lives in the caller's stack
+// frame for as long as the task is blocked.
+BlockerResult task_block(Task *task, Blocker &blocker, Timeout timeout);
 
 void task_dump(Task *task);
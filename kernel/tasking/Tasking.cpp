@@ -1,31 +1,94 @@
 #include "kernel/tasking/Tasking.h"
+#include "kernel/interrupts/Interupts.h"
 #include "kernel/scheduling/Scheduler.h"
 #include "kernel/system/System.h"
 #include "kernel/tasking/Task.h"
 
-static Iteration destroy_task_if_canceled(void *target, Task *task)
+// Canceled tasks are queued here as they exit, the garbage collector sleeps
+// until there is something to collect.
+static List *_garbage = nullptr;
+static Task *_garbage_collector = nullptr;
+
+class BlockerGarbage : public Blocker
 {
-    __unused(target);
+public:
+    bool can_unblock(Task *task)
+    {
+        __unused(task);
+
+        return _garbage->any();
+    }
+};
 
-    if (task->state() == TASK_STATE_CANCELED)
+void tasking_did_cancel_task(Task *task)
+{
+    ASSERT_INTERRUPTS_RETAINED();
+
+    if (task->collecting)
     {
-        task_destroy(task);
+        return;
     }
 
-    return Iteration::CONTINUE;
+    task->collecting = true;
+    list_pushback(_garbage, task);
+
+    if (_garbage_collector)
+    {
+        scheduler_wakeup(_garbage_collector);
+    }
+}
+
+static void collect_task(Task *task)
+{
+    if (task->state() != TASK_STATE_CANCELED)
+    {
+        return;
+    }
+
+    if (task->process == task)
+    {
+        // The process goes away with its last thread.
+        if (task->threads == 0)
+        {
+            task_destroy(task);
+        }
+    }
+    else if (task->detached || task->process->state() == TASK_STATE_CANCELED)
+    {
+        Task *process = task->process;
+
+        task_destroy(task);
+
+        if (process->state() == TASK_STATE_CANCELED && process->threads == 0)
+        {
+            tasking_did_cancel_task(process);
+        }
+    }
 }
 
 void garbage_collector()
 {
     while (true)
     {
-        task_sleep(scheduler_running(), 100);
-        task_iterate(nullptr, destroy_task_if_canceled);
+        BlockerGarbage blocker{};
+        task_block(scheduler_running(), blocker, -1);
+
+        InterruptsRetainer retainer;
+
+        Task *task = nullptr;
+
+        while (list_pop(_garbage, (void **)&task))
+        {
+            task->collecting = false;
+            collect_task(task);
+        }
     }
 }
 
 void tasking_initialize()
 {
+    _garbage = list_create();
+
     Task *idle_task = task_spawn(nullptr, "Idle", system_hang, nullptr, false);
     task_go(idle_task);
     idle_task->state(TASK_STATE_HANG);
@@ -37,6 +100,6 @@ void tasking_initialize()
 
     scheduler_did_create_running_task(kernel_task);
 
-    Task *garbage_task = task_spawn(nullptr, "GarbageCollector", garbage_collector, nullptr, false);
-    task_go(garbage_task);
+    _garbage_collector = task_spawn(nullptr, "GarbageCollector", garbage_collector, nullptr, false);
+    task_go(_garbage_collector);
 }
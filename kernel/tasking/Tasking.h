@@ -1,3 +1,8 @@
 #pragma once
 
+struct Task;
+
 void tasking_initialize();
+
+// Queue a canceled task for the garbage collector.
+void tasking_did_cancel_task(Task *task);
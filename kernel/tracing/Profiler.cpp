@@ -0,0 +1,304 @@
+#include <libsystem/core/CString.h>
+#include <libsystem/math/MinMax.h>
+
+#include "kernel/interrupts/Interupts.h"
+#include "kernel/system/System.h"
+#include "kernel/tasking/Task-Memory.h"
+#include "kernel/tracing/Profiler.h"
+
+bool __profiler_enabled = false;
+
+static int _profiler_users = 0;
+
+static int _profiler_interval = 1000 / PROFILE_DEFAULT_FREQUENCY;
+
+// Buffers of the tasks that exited while the profiler was running, they are
+// kept around until the next snapshot so short-lived tasks show up too.
+static List *_profiler_orphans = nullptr;
+
+static ProfileBuffer *profiler_buffer_create()
+{
+    return __create(ProfileBuffer);
+}
+
+static Iteration profiler_attach_buffer(void *target, Task *task)
+{
+    __unused(target);
+
+    if (task->profile == nullptr)
+    {
+        task->profile = profiler_buffer_create();
+    }
+
+    return Iteration::CONTINUE;
+}
+
+static Iteration profiler_detach_buffer(void *target, Task *task)
+{
+    __unused(target);
+
+    free(task->profile);
+    task->profile = nullptr;
+
+    return Iteration::CONTINUE;
+}
+
+void profiler_start()
+{
+    InterruptsRetainer retainer;
+
+    if (_profiler_users++ > 0)
+    {
+        return;
+    }
+
+    if (_profiler_orphans == nullptr)
+    {
+        _profiler_orphans = list_create();
+    }
+
+    task_iterate(nullptr, profiler_attach_buffer);
+
+    __profiler_enabled = true;
+}
+
+void profiler_stop()
+{
+    InterruptsRetainer retainer;
+
+    if (--_profiler_users > 0)
+    {
+        return;
+    }
+
+    __profiler_enabled = false;
+
+    task_iterate(nullptr, profiler_detach_buffer);
+    list_clear_with_callback(_profiler_orphans, free);
+}
+
+void profiler_set_frequency(int frequency)
+{
+    frequency = clamp(frequency, 1, 1000);
+
+    __atomic_store_n(&_profiler_interval, 1000 / frequency, __ATOMIC_RELAXED);
+}
+
+bool profiler_should_sample()
+{
+    if (!__profiler_enabled)
+    {
+        return false;
+    }
+
+    return system_get_tick() % __atomic_load_n(&_profiler_interval, __ATOMIC_RELAXED) == 0;
+}
+
+static bool profiler_kernel_frame_valid(Task *task, uintptr_t frame)
+{
+    uintptr_t stack = (uintptr_t)task->kernel_stack;
+
+    return frame >= stack &&
+           frame + 2 * sizeof(uintptr_t) <= stack + PROCESS_STACK_SIZE;
+}
+
+// Called from the timer IRQ. The mappings are only added and removed with
+// interrupts retained, so the list can't be caught in the middle of a change,
+// even when another thread of the process is mapping memory.
+static bool profiler_user_frame_valid(Task *task, uintptr_t frame)
+{
+    ASSERT_INTERRUPTS_RETAINED();
+
+    list_foreach(MemoryMapping, mapping, task->memory_mapping)
+    {
+        if (frame >= mapping->address &&
+            frame + 2 * sizeof(uintptr_t) <= mapping->address + mapping->size)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Follow the saved frame pointer chain, each frame holds the caller's frame
+// pointer followed by the return address. Frames must move up the stack,
+// anything else means we walked into a function built without frame pointers.
+static int profiler_walk(
+    Task *task,
+    ProfilerFrame start,
+    bool (*valid)(Task *, uintptr_t),
+    uintptr_t *frames,
+    int depth)
+{
+    if (depth >= PROFILE_MAX_DEPTH || start.ip == 0)
+    {
+        return depth;
+    }
+
+    frames[depth++] = start.ip;
+
+    uintptr_t frame = start.frame;
+
+    while (depth < PROFILE_MAX_DEPTH && frame != 0 && valid(task, frame))
+    {
+        uintptr_t *values = reinterpret_cast<uintptr_t *>(frame);
+
+        uintptr_t previous = values[0];
+        uintptr_t return_address = values[1];
+
+        if (return_address == 0)
+        {
+            break;
+        }
+
+        frames[depth++] = return_address;
+
+        if (previous <= frame)
+        {
+            break;
+        }
+
+        frame = previous;
+    }
+
+    return depth;
+}
+
+void profiler_sample(Task *task, ProfilerFrame kernel, ProfilerFrame user)
+{
+    ProfileBuffer *buffer = task->profile;
+
+    if (buffer == nullptr)
+    {
+        return;
+    }
+
+    if (buffer->task.samples >= PROFILE_BUFFER_SIZE)
+    {
+        buffer->task.dropped++;
+        return;
+    }
+
+    ProfileSample &sample = buffer->samples[buffer->task.samples];
+
+    int depth = profiler_walk(task, kernel, profiler_kernel_frame_valid, sample.frames, 0);
+    sample.kernel_depth = depth;
+
+    if (task->user)
+    {
+        depth = profiler_walk(task, user, profiler_user_frame_valid, sample.frames, depth);
+    }
+
+    sample.depth = depth;
+
+    if (depth > 0)
+    {
+        buffer->task.samples++;
+    }
+}
+
+static void profiler_buffer_identify(ProfileBuffer *buffer, Task *task)
+{
+    buffer->task.id = task->id;
+    strlcpy(buffer->task.name, task->name, PROCESS_NAME_SIZE);
+    strlcpy(buffer->task.executable, task->executable, PATH_LENGTH);
+}
+
+void profiler_did_create_task(Task *task)
+{
+    ASSERT_INTERRUPTS_RETAINED();
+
+    if (__profiler_enabled)
+    {
+        task->profile = profiler_buffer_create();
+    }
+}
+
+void profiler_did_destroy_task(Task *task)
+{
+    InterruptsRetainer retainer;
+
+    if (task->profile == nullptr)
+    {
+        return;
+    }
+
+    if (__profiler_enabled && task->profile->task.samples > 0)
+    {
+        profiler_buffer_identify(task->profile, task);
+        list_pushback(_profiler_orphans, task->profile);
+    }
+    else
+    {
+        free(task->profile);
+    }
+
+    task->profile = nullptr;
+}
+
+static size_t profiler_buffer_size(ProfileBuffer *buffer)
+{
+    return sizeof(ProfileTask) + buffer->task.samples * sizeof(ProfileSample);
+}
+
+static size_t profiler_buffer_flush(ProfileBuffer *buffer, uint8_t *destination)
+{
+    size_t size = profiler_buffer_size(buffer);
+
+    memcpy(destination, &buffer->task, sizeof(ProfileTask));
+    memcpy(destination + sizeof(ProfileTask), buffer->samples, buffer->task.samples * sizeof(ProfileSample));
+
+    buffer->task.samples = 0;
+    buffer->task.dropped = 0;
+
+    return size;
+}
+
+void *profiler_snapshot(size_t *size)
+{
+    InterruptsRetainer retainer;
+
+    *size = 0;
+
+    list_foreach(ProfileBuffer, buffer, _profiler_orphans)
+    {
+        *size += profiler_buffer_size(buffer);
+    }
+
+    task_iterate(size, [](void *target, Task *task) {
+        if (task->profile != nullptr && (task->profile->task.samples > 0 || task->profile->task.dropped > 0))
+        {
+            *reinterpret_cast<size_t *>(target) += profiler_buffer_size(task->profile);
+        }
+
+        return Iteration::CONTINUE;
+    });
+
+    if (*size == 0)
+    {
+        return nullptr;
+    }
+
+    uint8_t *snapshot = (uint8_t *)malloc(*size);
+    uint8_t *current = snapshot;
+
+    list_foreach(ProfileBuffer, buffer, _profiler_orphans)
+    {
+        current += profiler_buffer_flush(buffer, current);
+    }
+
+    list_clear_with_callback(_profiler_orphans, free);
+
+    task_iterate(&current, [](void *target, Task *task) {
+        if (task->profile != nullptr && (task->profile->task.samples > 0 || task->profile->task.dropped > 0))
+        {
+            profiler_buffer_identify(task->profile, task);
+            *reinterpret_cast<uint8_t **>(target) += profiler_buffer_flush(task->profile, *reinterpret_cast<uint8_t **>(target));
+        }
+
+        return Iteration::CONTINUE;
+    });
+
+    return snapshot;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <abi/Profile.h>
+
+#include "kernel/tasking/Task.h"
+
+// Number of samples kept per task between two reads of the profile device.
+#define PROFILE_BUFFER_SIZE 256
+
+struct ProfileBuffer
+{
+    ProfileTask task;
+    ProfileSample samples[PROFILE_BUFFER_SIZE];
+};
+
+struct ProfilerFrame
+{
+    uintptr_t ip;
+    uintptr_t frame;
+};
+
+extern bool __profiler_enabled;
+
+void profiler_start();
+
+void profiler_stop();
+
+void profiler_set_frequency(int frequency);
+
+bool profiler_should_sample();
+
+void profiler_sample(Task *task, ProfilerFrame kernel, ProfilerFrame user);
+
+void profiler_did_create_task(Task *task);
+
+void profiler_did_destroy_task(Task *task);
+
+// Serialize and reset the samples of every task, the caller owns the returned buffer.
+void *profiler_snapshot(size_t *size);
@@ -0,0 +1,162 @@
+#include "architectures/Architectures.h"
+
+#include "kernel/scheduling/Scheduler.h"
+#include "kernel/system/System.h"
+#include "kernel/tracing/Trace.h"
+
+struct TraceSlot
+{
+    // Position + 1 once the event is fully written, 0 while a writer owns it.
+    uint32_t sequence;
+    TraceEvent event;
+};
+
+struct TraceBuffer
+{
+    uint32_t head;
+    TraceSlot slots[TRACE_BUFFER_SIZE];
+};
+
+bool __trace_enabled = false;
+
+static int _trace_readers = 0;
+
+static TraceBuffer _trace_buffers[TRACE_CPU_COUNT] = {};
+
+static uint16_t trace_current_cpu()
+{
+    return 0;
+}
+
+void trace_start()
+{
+    if (__atomic_fetch_add(&_trace_readers, 1, __ATOMIC_SEQ_CST) == 0)
+    {
+        __atomic_store_n(&__trace_enabled, true, __ATOMIC_SEQ_CST);
+    }
+}
+
+void trace_stop()
+{
+    if (__atomic_sub_fetch(&_trace_readers, 1, __ATOMIC_SEQ_CST) == 0)
+    {
+        __atomic_store_n(&__trace_enabled, false, __ATOMIC_SEQ_CST);
+    }
+}
+
+void trace_record(TraceEventType type, uint32_t arg0, uint32_t arg1, uint32_t arg2)
+{
+    uint16_t cpu = trace_current_cpu();
+    TraceBuffer &buffer = _trace_buffers[cpu];
+
+    // Reserving the slot is the only shared write, an interrupt firing in the
+    // middle of a record simply gets the next slot.
+    uint32_t position = __atomic_fetch_add(&buffer.head, 1, __ATOMIC_RELAXED);
+    TraceSlot &slot = buffer.slots[position % TRACE_BUFFER_SIZE];
+
+    __atomic_store_n(&slot.sequence, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    slot.event.cycles = arch_get_cycles();
+    slot.event.tick = system_get_tick();
+    slot.event.type = type;
+    slot.event.cpu = cpu;
+    slot.event.task = scheduler_running_id();
+    slot.event.arguments[0] = arg0;
+    slot.event.arguments[1] = arg1;
+    slot.event.arguments[2] = arg2;
+
+    __atomic_store_n(&slot.sequence, position + 1, __ATOMIC_RELEASE);
+}
+
+void trace_cursor_initialize(TraceCursor &cursor)
+{
+    for (size_t i = 0; i < TRACE_CPU_COUNT; i++)
+    {
+        cursor.positions[i] = __atomic_load_n(&_trace_buffers[i].head, __ATOMIC_ACQUIRE);
+    }
+}
+
+bool trace_available(TraceCursor &cursor)
+{
+    for (size_t i = 0; i < TRACE_CPU_COUNT; i++)
+    {
+        if (__atomic_load_n(&_trace_buffers[i].head, __ATOMIC_ACQUIRE) != cursor.positions[i])
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static size_t trace_read_buffer(TraceBuffer &buffer, uint32_t &position, uint16_t cpu, TraceEvent *events, size_t count)
+{
+    size_t read = 0;
+
+    while (read < count)
+    {
+        uint32_t head = __atomic_load_n(&buffer.head, __ATOMIC_ACQUIRE);
+
+        if (head == position)
+        {
+            break;
+        }
+
+        if (head - position > TRACE_BUFFER_SIZE)
+        {
+            uint32_t lost = head - position - TRACE_BUFFER_SIZE;
+
+            events[read] = {};
+            events[read].tick = system_get_tick();
+            events[read].type = TRACE_LOST;
+            events[read].cpu = cpu;
+            events[read].task = -1;
+            events[read].arguments[0] = lost;
+
+            read++;
+            position += lost;
+
+            continue;
+        }
+
+        TraceSlot &slot = buffer.slots[position % TRACE_BUFFER_SIZE];
+
+        uint32_t sequence = __atomic_load_n(&slot.sequence, __ATOMIC_ACQUIRE);
+
+        if (sequence != position + 1)
+        {
+            // The writer was interrupted before publishing this slot, the
+            // following events will be picked up by the next read.
+            break;
+        }
+
+        events[read] = slot.event;
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        if (__atomic_load_n(&slot.sequence, __ATOMIC_RELAXED) != sequence)
+        {
+            // Overwritten while we were copying it, the next iteration will
+            // account for it as lost.
+            continue;
+        }
+
+        read++;
+        position++;
+    }
+
+    return read;
+}
+
+size_t trace_read(TraceCursor &cursor, TraceEvent *events, size_t count)
+{
+    size_t read = 0;
+
+    for (size_t i = 0; i < TRACE_CPU_COUNT && read < count; i++)
+    {
+        read += trace_read_buffer(_trace_buffers[i], cursor.positions[i], i, events + read, count - read);
+    }
+
+    return read;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <abi/Trace.h>
+
+// Must be a power of two so positions can wrap around the 32bits counters.
+#define TRACE_BUFFER_SIZE 4096
+
+// The kernel only runs on the bootstrap processor for now, but each CPU gets
+// its own ring so producers never share a cache line once SMP lands.
+#define TRACE_CPU_COUNT 1
+
+struct TraceCursor
+{
+    uint32_t positions[TRACE_CPU_COUNT];
+};
+
+extern bool __trace_enabled;
+
+void trace_start();
+
+void trace_stop();
+
+void trace_record(TraceEventType type, uint32_t arg0 = 0, uint32_t arg1 = 0, uint32_t arg2 = 0);
+
+void trace_cursor_initialize(TraceCursor &cursor);
+
+bool trace_available(TraceCursor &cursor);
+
+size_t trace_read(TraceCursor &cursor, TraceEvent *events, size_t count);
+
+#ifdef CONFIG_TRACE
+#    define TRACE(__type, __args...)                    \
+        do                                              \
+        {                                               \
+            if (__builtin_expect(__trace_enabled, 0))   \
+            {                                           \
+                trace_record(TRACE_##__type, ##__args); \
+            }                                           \
+        } while (0)
+#else
+#    define TRACE(__type, __args...)                    \
+        do                                              \
+        {                                               \
+            if (0)                                      \
+            {                                           \
+                trace_record(TRACE_##__type, ##__args); \
+            }                                           \
+        } while (0)
+#endif
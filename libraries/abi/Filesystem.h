@@ -45,6 +45,10 @@ struct FileState
 {
     size_t size;
     FileType type;
+
+    // Changes every time the content of the file does, and no two files share
+    // one, so it tells whether a cached copy of the content is stale.
+    uint32_t generation;
 };
 
 struct DirectoryEntry
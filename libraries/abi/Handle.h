@@ -25,6 +25,14 @@ struct HandleSet
     size_t count;
 };
 
+#define IO_VECTOR_MAX 64
+
+struct IOVector
+{
+    void *buffer;
+    size_t size;
+};
+
 #define HANDLE_INVALID_ID (-1)
 
 #define HANDLE(__subclass) ((Handle *)(__subclass))
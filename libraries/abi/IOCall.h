@@ -45,6 +45,11 @@ struct IOCallNetworkSateAgs
     MacAddress mac_address;
 };
 
+struct IOCallProfileFrequencyArgs
+{
+    int frequency;
+};
+
 enum IOCall
 {
     IOCALL_TERMINAL_GET_SIZE,
@@ -62,5 +67,7 @@ enum IOCall
 
     IOCALL_NETWORK_GET_STATE,
 
+    IOCALL_PROFILE_SET_FREQUENCY,
+
     __IOCALL_COUNT,
 };
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <abi/Handle.h>
+
+#include <libsystem/Time.h>
+
+// Must be a power of two, indices wrap around and are masked on access.
+#define IO_RING_SIZE 64
+
+enum IORingOperation
+{
+    IO_RING_NOP,
+    IO_RING_READ,
+    IO_RING_WRITE,
+    IO_RING_POLL,
+    IO_RING_ACCEPT,
+};
+
+struct IORingSubmission
+{
+    IORingOperation operation;
+    int handle;
+    void *buffer;
+    size_t size;
+    PollEvent events;
+    Timeout timeout;
+    uintptr_t data;
+};
+
+// IORingCompletion::value is the number of bytes transferred for reads and
+// writes, the selected events for polls and the new handle for accepts.
+struct IORingCompletion
+{
+    uintptr_t data;
+    Result result;
+    size_t value;
+};
+
+// The ring lives in the memory of the process. The process queues submissions
+// and advances submission_tail, hj_handle_submit() then runs them in order and
+// advances submission_head and completion_tail, completions are reaped by
+// advancing completion_head without entering the kernel.
+struct IORing
+{
+    uint32_t submission_head;
+    uint32_t submission_tail;
+    uint32_t completion_head;
+    uint32_t completion_tail;
+
+    IORingSubmission submissions[IO_RING_SIZE];
+    IORingCompletion completions[IO_RING_SIZE];
+};
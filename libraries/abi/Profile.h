@@ -0,0 +1,33 @@
+#pragma once
+
+#include <abi/Filesystem.h>
+#include <abi/Process.h>
+
+#include <libsystem/Common.h>
+
+#define PROFILE_DEVICE_PATH "/System/profile"
+
+#define PROFILE_MAX_DEPTH 16
+
+#define PROFILE_DEFAULT_FREQUENCY 100
+
+// Reading the profile device returns, for each task sampled since the device
+// was opened, a ProfileTask followed by ProfileTask::samples ProfileSample.
+struct ProfileTask
+{
+    int id;
+    int samples;
+    int dropped;
+    char name[PROCESS_NAME_SIZE];
+    char executable[PATH_LENGTH];
+};
+
+// Frames are ordered from the innermost to the outermost call. The first
+// ProfileSample::kernel_depth frames are kernel addresses, the rest are
+// addresses in the task's executable.
+struct ProfileSample
+{
+    uint16_t depth;
+    uint16_t kernel_depth;
+    uintptr_t frames[PROFILE_MAX_DEPTH];
+};
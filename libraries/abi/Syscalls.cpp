@@ -40,6 +40,36 @@ Result hj_process_wait(int tid, int *user_exit_value)
     return __syscall(HJ_PROCESS_WAIT, (uintptr_t)tid, (uintptr_t)user_exit_value);
 }
 
+Result hj_thread_create(uintptr_t entry, uintptr_t arg, uintptr_t tls, int *tid)
+{
+    return __syscall(HJ_THREAD_CREATE, entry, arg, tls, (uintptr_t)tid);
+}
+
+Result hj_thread_exit(int exit_value)
+{
+    return __syscall(HJ_THREAD_EXIT, (uintptr_t)exit_value);
+}
+
+Result hj_thread_join(int tid, int *user_exit_value)
+{
+    return __syscall(HJ_THREAD_JOIN, (uintptr_t)tid, (uintptr_t)user_exit_value);
+}
+
+Result hj_thread_detach(int tid)
+{
+    return __syscall(HJ_THREAD_DETACH, (uintptr_t)tid);
+}
+
+Result hj_thread_set_tls(uintptr_t base)
+{
+    return __syscall(HJ_THREAD_SET_TLS, base);
+}
+
+Result hj_thread_yield()
+{
+    return __syscall(HJ_THREAD_YIELD);
+}
+
 Result hj_memory_alloc(size_t size, uintptr_t *out_address)
 {
     return __syscall(HJ_MEMORY_ALLOC, (uintptr_t)size, (uintptr_t)out_address);
@@ -65,6 +95,11 @@ Result hj_memory_get_handle(uintptr_t address, int *out_handle)
     return __syscall(HJ_MEMORY_GET_HANDLE, (uintptr_t)address, (uintptr_t)out_handle);
 }
 
+Result hj_memory_seal(uintptr_t address)
+{
+    return __syscall(HJ_MEMORY_SEAL, address);
+}
+
 Result hj_filesystem_mkdir(const char *raw_path, size_t size)
 {
     return __syscall(HJ_FILESYSTEM_MKDIR, (uintptr_t)raw_path, (uintptr_t)size);
@@ -103,9 +138,11 @@ Result hj_filesystem_rename(const char *raw_old_path, size_t old_size, const cha
         (uintptr_t)new_size);
 }
 
+// Served from the vDSO page, without entering the kernel.
 Result hj_system_info(SystemInfo *info)
 {
-    return __syscall(HJ_SYSTEM_INFO, (uintptr_t)info);
+    *info = vdso()->info;
+    return SUCCESS;
 }
 
 Result hj_system_status(SystemStatus *status)
@@ -118,9 +155,11 @@ Result hj_system_time(TimeStamp *timestamp)
     return __syscall(HJ_SYSTEM_TIME, (uintptr_t)timestamp);
 }
 
+// Served from the vDSO page, without entering the kernel.
 Result hj_system_tick(uint32_t *tick)
 {
-    return __syscall(HJ_SYSTEM_TICKS, (uintptr_t)tick);
+    *tick = vdso()->ticks;
+    return SUCCESS;
 }
 
 Result hj_system_reboot()
@@ -168,6 +207,21 @@ Result hj_handle_write(int handle, const void *buffer, size_t size, size_t *writ
     return __syscall(HJ_HANDLE_WRITE, (uintptr_t)handle, (uintptr_t)buffer, (uintptr_t)size, (uintptr_t)written);
 }
 
+Result hj_handle_readv(int handle, const IOVector *vectors, size_t count, size_t *read)
+{
+    return __syscall(HJ_HANDLE_READV, (uintptr_t)handle, (uintptr_t)vectors, (uintptr_t)count, (uintptr_t)read);
+}
+
+Result hj_handle_writev(int handle, const IOVector *vectors, size_t count, size_t *written)
+{
+    return __syscall(HJ_HANDLE_WRITEV, (uintptr_t)handle, (uintptr_t)vectors, (uintptr_t)count, (uintptr_t)written);
+}
+
+Result hj_handle_submit(IORing *ring, size_t *completed)
+{
+    return __syscall(HJ_HANDLE_SUBMIT, (uintptr_t)ring, (uintptr_t)completed);
+}
+
 Result hj_handle_call(int handle, IOCall request, void *args)
 {
     return __syscall(HJ_HANDLE_CALL, (uintptr_t)handle, (uintptr_t)request, (uintptr_t)args);
@@ -188,6 +242,11 @@ Result hj_handle_stat(int handle, FileState *state)
     return __syscall(HJ_HANDLE_STAT, (uintptr_t)handle, (uintptr_t)state);
 }
 
+Result hj_handle_map(int handle, uintptr_t *out_address, size_t *out_size)
+{
+    return __syscall(HJ_HANDLE_MAP, (uintptr_t)handle, (uintptr_t)out_address, (uintptr_t)out_size);
+}
+
 Result hj_handle_connect(int *handle, const char *raw_path, size_t size)
 {
     return __syscall(HJ_HANDLE_CONNECT, (uintptr_t)handle, (uintptr_t)raw_path, (uintptr_t)size);
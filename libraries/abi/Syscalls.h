@@ -7,8 +7,10 @@
 
 #include <abi/Handle.h>
 #include <abi/IOCall.h>
+#include <abi/IORing.h>
 #include <abi/Launchpad.h>
 #include <abi/System.h>
+#include <abi/VDSO.h>
 
 #define SYSCALL_LIST(__ENTRY)     \
     __ENTRY(HJ_PROCESS_THIS)      \
@@ -19,11 +21,18 @@
     __ENTRY(HJ_PROCESS_CANCEL)    \
     __ENTRY(HJ_PROCESS_SLEEP)     \
     __ENTRY(HJ_PROCESS_WAIT)      \
+    __ENTRY(HJ_THREAD_CREATE)     \
+    __ENTRY(HJ_THREAD_EXIT)       \
+    __ENTRY(HJ_THREAD_JOIN)       \
+    __ENTRY(HJ_THREAD_DETACH)     \
+    __ENTRY(HJ_THREAD_SET_TLS)    \
+    __ENTRY(HJ_THREAD_YIELD)      \
     __ENTRY(HJ_MEMORY_ALLOC)      \
     __ENTRY(HJ_MEMORY_MAP)        \
     __ENTRY(HJ_MEMORY_FREE)       \
     __ENTRY(HJ_MEMORY_INCLUDE)    \
     __ENTRY(HJ_MEMORY_GET_HANDLE) \
+    __ENTRY(HJ_MEMORY_SEAL)       \
     __ENTRY(HJ_FILESYSTEM_LINK)   \
     __ENTRY(HJ_FILESYSTEM_UNLINK) \
     __ENTRY(HJ_FILESYSTEM_RENAME) \
@@ -40,10 +49,14 @@
     __ENTRY(HJ_HANDLE_POLL)       \
     __ENTRY(HJ_HANDLE_READ)       \
     __ENTRY(HJ_HANDLE_WRITE)      \
+    __ENTRY(HJ_HANDLE_READV)      \
+    __ENTRY(HJ_HANDLE_WRITEV)     \
+    __ENTRY(HJ_HANDLE_SUBMIT)     \
     __ENTRY(HJ_HANDLE_CALL)       \
     __ENTRY(HJ_HANDLE_SEEK)       \
     __ENTRY(HJ_HANDLE_TELL)       \
     __ENTRY(HJ_HANDLE_STAT)       \
+    __ENTRY(HJ_HANDLE_MAP)        \
     __ENTRY(HJ_HANDLE_CONNECT)    \
     __ENTRY(HJ_HANDLE_ACCEPT)     \
     __ENTRY(HJ_CREATE_PIPE)       \
@@ -70,10 +83,23 @@ static inline Result __syscall(Syscall syscall, uintptr_t p1, uintptr_t p2, uint
     __unused(p5);
 
 #elif defined(__i386__)
-    __asm__ __volatile__("push %%ebx; movl %2,%%ebx; int $0x80; pop %%ebx"
-                         : "=a"(__ret)
-                         : "0"(syscall), "r"(p1), "c"(p2), "d"(p3), "S"(p4), "D"(p5)
-                         : "memory");
+    if (syscall == HJ_PROCESS_CLONE)
+    {
+        // The child starts from the interrupt frame, so this one has to go
+        // through the interrupt gate.
+        __asm__ __volatile__("push %%ebx; movl %2,%%ebx; int $0x80; pop %%ebx"
+                             : "=a"(__ret)
+                             : "0"(syscall), "r"(p1), "c"(p2), "d"(p3), "S"(p4), "D"(p5)
+                             : "memory");
+    }
+    else
+    {
+        // The fast path may use ecx and edx to return to userspace.
+        __asm__ __volatile__("push %%ebx; movl %4,%%ebx; call *%7; pop %%ebx"
+                             : "=a"(__ret), "+c"(p2), "+d"(p3)
+                             : "0"(syscall), "r"(p1), "S"(p4), "D"(p5), "m"(vdso()->syscall_entry)
+                             : "memory");
+    }
 #endif
 
     return __ret;
@@ -119,11 +145,19 @@ Result hj_process_cancel(int pid);
 Result hj_process_sleep(int time);
 Result hj_process_wait(int tid, int *user_exit_value);
 
+Result hj_thread_create(uintptr_t entry, uintptr_t arg, uintptr_t tls, int *tid);
+Result hj_thread_exit(int exit_value);
+Result hj_thread_join(int tid, int *user_exit_value);
+Result hj_thread_detach(int tid);
+Result hj_thread_set_tls(uintptr_t base);
+Result hj_thread_yield();
+
 Result hj_memory_alloc(size_t size, uintptr_t *out_address);
 Result hj_memory_map(uintptr_t address, size_t size, int flags);
 Result hj_memory_free(uintptr_t address);
 Result hj_memory_include(int handle, uintptr_t *out_address, size_t *out_size);
 Result hj_memory_get_handle(uintptr_t address, int *out_handle);
+Result hj_memory_seal(uintptr_t address);
 
 Result hj_filesystem_mkdir(const char *raw_path, size_t size);
 Result hj_filesystem_mkpipe(const char *raw_path, size_t size);
@@ -146,10 +180,14 @@ Result hj_handle_close(int handle);
 Result hj_handle_poll(HandleSet *handles_set, int *selected, PollEvent *selected_events, Timeout timeout);
 Result hj_handle_read(int handle, void *buffer, size_t size, size_t *read);
 Result hj_handle_write(int handle, const void *buffer, size_t size, size_t *written);
+Result hj_handle_readv(int handle, const IOVector *vectors, size_t count, size_t *read);
+Result hj_handle_writev(int handle, const IOVector *vectors, size_t count, size_t *written);
+Result hj_handle_submit(IORing *ring, size_t *completed);
 Result hj_handle_call(int handle, IOCall request, void *args);
 Result hj_handle_seek(int handle, int offset, Whence whence);
 Result hj_handle_tell(int handle, Whence whence, int *offset);
 Result hj_handle_stat(int handle, FileState *state);
+Result hj_handle_map(int handle, uintptr_t *out_address, size_t *out_size);
 Result hj_handle_connect(int *handle, const char *raw_path, size_t size);
 Result hj_handle_accept(int handle, int *connection_handle);
 
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <libsystem/Common.h>
+
+#define TRACE_DEVICE_PATH "/System/trace"
+
+#define TRACE_EVENT_LIST(__ENTRY) \
+    __ENTRY(NONE)                 \
+    __ENTRY(LOST)                 \
+    __ENTRY(SYSCALL_ENTER)        \
+    __ENTRY(SYSCALL_EXIT)         \
+    __ENTRY(CONTEXT_SWITCH)       \
+    __ENTRY(IRQ)                  \
+    __ENTRY(PAGE_FAULT)           \
+    __ENTRY(IO_READ)              \
+    __ENTRY(IO_WRITE)             \
+    __ENTRY(NETWORK_RECEIVE)      \
+    __ENTRY(NETWORK_SEND)
+
+enum TraceEventType : uint16_t
+{
+#define TRACE_EVENT_ENUM_ENTRY(__event) TRACE_##__event,
+    TRACE_EVENT_LIST(TRACE_EVENT_ENUM_ENTRY)
+    __TRACE_EVENT_COUNT
+};
+
+static inline const char *trace_event_string(TraceEventType type)
+{
+#define TRACE_EVENT_STRING_ENTRY(__event) #__event,
+
+    const char *event_strings[] = {TRACE_EVENT_LIST(TRACE_EVENT_STRING_ENTRY)};
+
+    if (type < __TRACE_EVENT_COUNT)
+    {
+        return event_strings[type];
+    }
+
+    return "undefined";
+}
+
+// Events are fixed-size so the kernel can write them from interrupt context
+// without allocating and userspace can decode them without framing.
+//
+// Arguments per event type:
+//  - LOST:            [0] number of events dropped because the reader was too slow
+//  - SYSCALL_ENTER:   [0] syscall number, [1] first argument, [2] second argument
+//  - SYSCALL_EXIT:    [0] syscall number, [1] result
+//  - CONTEXT_SWITCH:  [0] previous task id, [1] next task id
+//  - IRQ:             [0] irq number
+//  - PAGE_FAULT:      [0] faulting address (CR2), [1] instruction pointer, [2] error code
+//  - IO_READ/WRITE:   [0] file type, [1] requested size, [2] transferred size
+//  - NETWORK_*:       [0] packet size
+struct TraceEvent
+{
+    uint64_t cycles;
+    uint32_t tick;
+    TraceEventType type;
+    uint16_t cpu;
+    int32_t task;
+    uint32_t arguments[3];
+};
+
+static_assert(sizeof(TraceEvent) == 32, "TraceEvent should be 32 bytes");
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <abi/System.h>
+
+#include <libsystem/Common.h>
+#include <libsystem/Time.h>
+
+// A read-only page mapped by the kernel at the same address in every user
+// address space. It is kept up to date by the kernel, so reading it doesn't
+// require a system call.
+#define VDSO_ADDRESS 0xffffe000
+#define VDSO_CODE_SIZE 64
+
+struct VDSO
+{
+    // Entry point of the fastest way into the kernel the cpu supports, it
+    // takes the same registers as `int 0x80`. Only set on x86_32, which uses
+    // sysenter when it can.
+    uintptr_t syscall_entry;
+
+    volatile uint32_t ticks;
+    TimeStamp boot_time;
+
+    SystemInfo info;
+
+    uint8_t code[VDSO_CODE_SIZE];
+};
+
+static inline struct VDSO *vdso()
+{
+    return (struct VDSO *)VDSO_ADDRESS;
+}
@@ -19,9 +19,9 @@ struct __packed ELF32Header
     uint16_t shnum;
     uint16_t shstrndx;
 
-    bool valid()
+    bool valid() const
     {
-        char *magic = (char *)&ident;
+        const char *magic = (const char *)&ident;
 
         bool is_magic_ok = magic[ELF_IDENT_MAG0] == ELF_MAG0 &&
                            magic[ELF_IDENT_MAG1] == ELF_MAG1 &&
@@ -68,3 +68,10 @@
 #define ELF_SECTION_TYPE_SHLIB 10
 #define ELF_SECTION_TYPE_DYNSYM 11
 #define ELF_SECTION_TYPE_COUNT 12
+
+#define ELF_SYMBOL_TYPE(__info) ((__info)&0xf)
+#define ELF_SYMBOL_TYPE_NOTYPE 0
+#define ELF_SYMBOL_TYPE_OBJECT 1
+#define ELF_SYMBOL_TYPE_FUNC 2
+#define ELF_SYMBOL_TYPE_SECTION 3
+#define ELF_SYMBOL_TYPE_FILE 4
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <libsystem/io/Handle.h>
+#include <libsystem/io/Stream.h>
+#include <libsystem/system/Memory.h>
+#include <libutils/RefPtr.h>
+#include <libutils/ResultOr.h>
+#include <libutils/SliceStorage.h>
+
+// The content of a file, mapped read-only from the pages the filesystem keeps
+// for it, or read into memory when the file can't be mapped. Parsers look at
+// it through a Slice, which checks their bounds, instead of copying it.
+class MappedFile : public SliceStorage
+{
+private:
+    bool _mapped = false;
+
+public:
+    bool mapped() { return _mapped; }
+
+    static ResultOr<RefPtr<MappedFile>> open(const char *path)
+    {
+        __cleanup(stream_cleanup) Stream *stream = stream_open(path, OPEN_READ);
+
+        if (handle_has_error(stream))
+        {
+            return handle_get_error(stream);
+        }
+
+        uintptr_t address = 0;
+        size_t size = 0;
+
+        if (handle_map(stream, &address, &size) == SUCCESS)
+        {
+            return make<MappedFile>(reinterpret_cast<void *>(address), size, true);
+        }
+
+        FileState state = {};
+        stream_stat(stream, &state);
+
+        if (handle_has_error(stream))
+        {
+            return handle_get_error(stream);
+        }
+
+        void *buffer = malloc(state.size);
+        size_t read = 0;
+
+        // Reads may come back short, keep going until the end of the file.
+        while (read < state.size)
+        {
+            size_t chunk = stream_read(stream, (char *)buffer + read, state.size - read);
+
+            if (handle_has_error(stream))
+            {
+                free(buffer);
+                return handle_get_error(stream);
+            }
+
+            if (chunk == 0)
+            {
+                break;
+            }
+
+            read += chunk;
+        }
+
+        return make<MappedFile>(buffer, read, false);
+    }
+
+    MappedFile(void *data, size_t size, bool mapped)
+        : SliceStorage(mapped ? WRAP : ADOPT, data, size),
+          _mapped(mapped)
+    {
+    }
+
+    ~MappedFile() override
+    {
+        if (_mapped)
+        {
+            memory_free(reinterpret_cast<uintptr_t>(start()));
+        }
+    }
+};
@@ -25,7 +25,7 @@ struct __packed TARRawBlock
                         /* 500 */
 };
 
-uint get_file_size(TARRawBlock *header)
+uint get_file_size(const TARRawBlock *header)
 {
     unsigned int size = 0;
     unsigned int count = 1;
@@ -86,3 +86,35 @@ bool tar_read(void *tarfile, TARBlock *block, uint index)
 
     return true;
 }
+
+bool tar_read_next(const void *tarfile, size_t size, size_t *offset, TARBlock *block)
+{
+    if (*offset > size || size - *offset < 512)
+    {
+        return false;
+    }
+
+    auto header = reinterpret_cast<const TARRawBlock *>(reinterpret_cast<const char *>(tarfile) + *offset);
+
+    if (header->name[0] == '\0')
+    {
+        return false;
+    }
+
+    size_t data_size = get_file_size(header);
+
+    if (data_size > size - *offset - 512)
+    {
+        return false;
+    }
+
+    memcpy(block->name, header->name, 100);
+    block->size = data_size;
+    block->typeflag = header->typeflag;
+    memcpy(block->linkname, header->linkname, 100);
+    block->data = reinterpret_cast<const char *>(header) + 512;
+
+    *offset += 512 + __align_up(data_size, 512);
+
+    return true;
+}
@@ -8,7 +8,12 @@ struct TARBlock
     char typeflag;
     char linkname[100];
     size_t size;
-    char *data;
+    const char *data;
 };
 
 bool tar_read(void *tarfile, TARBlock *block, uint index);
+
+// Reads the block at *offset and moves it past the block, so an archive is
+// walked in one pass. Returns false at the end of the archive or when the
+// block doesn't fit in the SIZE bytes of the archive.
+bool tar_read_next(const void *tarfile, size_t size, size_t *offset, TARBlock *block);
@@ -1,17 +1,27 @@
 #define LODEPNG_NO_COMPILE_DISK
 #define LODEPNG_NO_COMPILE_ANCILLARY_CHUNKS
 #define LODEPNG_NO_COMPILE_CPP
+#define LODEPNG_NO_COMPILE_DECODER
 #include <thirdparty/lodepng/lodepng.cpp>
+#undef LODEPNG_NO_COMPILE_DECODER
 #undef LODEPNG_NO_COMPILE_CPP
 #undef LODEPNG_NO_COMPILE_ANCILLARY_CHUNKS
 #undef LODEPNG_NO_COMPILE_DISK
 
+#include <libfile/MappedFile.h>
 #include <libgraphic/Bitmap.h>
+#include <libgraphic/PNG.h>
 #include <libsystem/Assert.h>
 #include <libsystem/Logger.h>
 #include <libsystem/Result.h>
+#include <libsystem/io/Connection.h>
 #include <libsystem/io/File.h>
+#include <libsystem/io/Socket.h>
+#include <libsystem/process/Process.h>
 #include <libsystem/system/Memory.h>
+#include <libsystem/thread/Lock.h>
+
+#include "image-service/Protocol.h"
 
 static Color _placeholder_buffer[] = {
     Colors::MAGENTA,
@@ -20,7 +30,7 @@ static Color _placeholder_buffer[] = {
     Colors::MAGENTA,
 };
 
-ResultOr<RefPtr<Bitmap>> Bitmap::create_shared(int width, int height)
+static ResultOr<RefPtr<Bitmap>> bitmap_create_shared_uninitialized(int width, int height)
 {
     Color *pixels = nullptr;
     Result result = memory_alloc(width * height * sizeof(Color), reinterpret_cast<uintptr_t *>(&pixels));
@@ -31,9 +41,19 @@ ResultOr<RefPtr<Bitmap>> Bitmap::create_shared(int width, int height)
     int handle = -1;
     memory_get_handle(reinterpret_cast<uintptr_t>(pixels), &handle);
 
-    auto bitmap = make<Bitmap>(handle, BITMAP_SHARED, width, height, pixels);
-    bitmap->clear(Colors::BLACK);
-    return bitmap;
+    return make<Bitmap>(handle, BITMAP_SHARED, width, height, pixels);
+}
+
+ResultOr<RefPtr<Bitmap>> Bitmap::create_shared(int width, int height)
+{
+    auto bitmap_or_result = bitmap_create_shared_uninitialized(width, height);
+
+    if (bitmap_or_result.success())
+    {
+        bitmap_or_result.value()->clear(Colors::BLACK);
+    }
+
+    return bitmap_or_result;
 }
 
 ResultOr<RefPtr<Bitmap>> Bitmap::create_shared_from_handle(int handle, Vec2i width_and_height)
@@ -61,47 +81,114 @@ RefPtr<Bitmap> Bitmap::create_static(int width, int height, Color *pixels)
     return make<Bitmap>(-1, BITMAP_STATIC, width, height, pixels);
 }
 
+// One connection per process, the lock keeps the request and the reply of
+// two threads from interleaving on it.
+static Connection *_image_service = nullptr;
+static Lock _image_service_lock = {.locked = false, .holder = 0, .name = "image_service"};
+
+static ResultOr<RefPtr<Bitmap>> bitmap_load_from_service(const char *path)
+{
+    LockHolder holder(_image_service_lock);
+
+    if (_image_service == nullptr)
+    {
+        Connection *connection = socket_connect(IMAGE_SERVICE_SOCKET);
+
+        if (handle_has_error(connection))
+        {
+            Result result = handle_get_error(connection);
+            connection_close(connection);
+            return result;
+        }
+
+        _image_service = connection;
+    }
+
+    ImageMessage request = {};
+    request.type = IMAGE_MESSAGE_LOAD;
+    strlcpy(request.load.path, process_resolve(path).cstring(), PATH_LENGTH);
+
+    connection_send(_image_service, &request, sizeof(ImageMessage));
+
+    ImageMessage reply = {};
+    size_t reply_size = connection_receive(_image_service, &reply, sizeof(ImageMessage));
+
+    if (handle_has_error(_image_service) ||
+        reply_size != sizeof(ImageMessage) ||
+        reply.type != IMAGE_MESSAGE_LOADED)
+    {
+        connection_close(_image_service);
+        _image_service = nullptr;
+
+        return ERR_CONNECTION_REFUSED;
+    }
+
+    if (reply.loaded.result != SUCCESS)
+    {
+        return reply.loaded.result;
+    }
+
+    return Bitmap::create_shared_from_handle(reply.loaded.bitmap, reply.loaded.size);
+}
+
 ResultOr<RefPtr<Bitmap>> Bitmap::load_from(const char *path)
 {
-    void *rawdata;
-    size_t rawdata_size;
-    Result result = file_read_all(path, &rawdata, &rawdata_size);
+    auto bitmap_or_result = bitmap_load_from_service(path);
 
-    if (result != SUCCESS)
+    // The service already tried the file, there is no point doing it again.
+    if (bitmap_or_result.success() ||
+        bitmap_or_result.result() == ERR_NO_SUCH_FILE_OR_DIRECTORY ||
+        bitmap_or_result.result() == ERR_BAD_IMAGE_FILE_FORMAT)
     {
-        return result;
+        return bitmap_or_result;
     }
 
-    uint decoded_width = 0;
-    uint decoded_height = 0;
-    void *decoded_data = nullptr;
+    return decode_from(path);
+}
 
-    int decode_result = lodepng_decode32(
-        (unsigned char **)&decoded_data,
-        &decoded_width,
-        &decoded_height,
-        (const unsigned char *)rawdata,
-        rawdata_size);
+ResultOr<RefPtr<Bitmap>> Bitmap::decode_from(const char *path)
+{
+    auto file_or_result = MappedFile::open(path);
 
-    if (decode_result != 0)
+    if (!file_or_result.success())
     {
-        return ERR_BAD_IMAGE_FILE_FORMAT;
+        return file_or_result.result();
     }
 
-    auto bitmap_or_result = Bitmap::create_shared(decoded_width, decoded_height);
+    auto file = file_or_result.take_value();
 
-    if (bitmap_or_result.success())
+    PNGDecoder decoder{file->start(), file->size()};
+
+    Result result = decoder.read_header();
+
+    if (result != SUCCESS)
     {
-        auto bitmap = bitmap_or_result.take_value();
-        memcpy(bitmap->pixels(), decoded_data, sizeof(Color) * decoded_width * decoded_height);
-        free(decoded_data);
-        return bitmap;
+        return result;
     }
-    else
+
+    return decode_from(decoder);
+}
+
+ResultOr<RefPtr<Bitmap>> Bitmap::decode_from(PNGDecoder &decoder)
+{
+    // The rows are decoded straight into the shared pixels.
+    auto bitmap_or_result = bitmap_create_shared_uninitialized(decoder.width(), decoder.height());
+
+    if (!bitmap_or_result.success())
     {
-        free(decoded_data);
         return bitmap_or_result;
     }
+
+    auto bitmap = bitmap_or_result.take_value();
+
+    Result result = decoder.decode(bitmap->pixels());
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    return bitmap;
 }
 
 RefPtr<Bitmap> Bitmap::load_from_or_placeholder(const char *path)
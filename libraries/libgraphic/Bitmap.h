@@ -3,11 +3,14 @@
 #include <libgraphic/Color.h>
 #include <libgraphic/Shape.h>
 #include <libsystem/Result.h>
+#include <libsystem/core/CString.h>
 #include <libsystem/math/Math.h>
 
 #include <libutils/RefPtr.h>
 #include <libutils/ResultOr.h>
 
+class PNGDecoder;
+
 enum BitmapStorage
 {
     BITMAP_SHARED,
@@ -55,6 +58,8 @@ public:
     Vec2i size() const { return Vec2i(_width, _height); }
     Rectangle bound() const { return Rectangle(_width, _height); }
 
+    BitmapFiltering filtering() const { return _filtering; }
+
     void filtering(BitmapFiltering filtering) { _filtering = filtering; }
 
     static ResultOr<RefPtr<Bitmap>> create_shared(int width, int height);
@@ -63,8 +68,17 @@ public:
 
     static RefPtr<Bitmap> create_static(int width, int height, Color *pixels);
 
+    // Images are decoded once by the image service and the bitmap is shared
+    // read-only with every process that loads them, drawing into it faults.
+    // It falls back to decode_from() when the service can't be reached.
     static ResultOr<RefPtr<Bitmap>> load_from(const char *path);
 
+    // Decodes the image in this process, into a bitmap that belongs to the caller.
+    static ResultOr<RefPtr<Bitmap>> decode_from(const char *path);
+
+    // Same, once decoder.read_header() succeeded and the size was checked.
+    static ResultOr<RefPtr<Bitmap>> decode_from(PNGDecoder &decoder);
+
     static RefPtr<Bitmap> load_from_or_placeholder(const char *path);
 
     Result save_to(const char *path);
@@ -137,10 +151,34 @@ public:
 
         for (int y = region.y(); y < region.y() + region.height(); y++)
         {
-            for (int x = region.x(); x < region.x() + region.width(); x++)
-            {
-                set_pixel_no_check(Vec2i(x, y), source.get_pixel_no_check(Vec2i(x, y)));
-            }
+            memcpy(
+                _pixels + y * width() + region.x(),
+                source._pixels + y * source.width() + region.x(),
+                region.width() * sizeof(Color));
+        }
+    }
+
+    // Move the pixels of a region up or down by `offset` rows, the rows
+    // uncovered are left untouched.
+    __flatten void scroll(Rectangle region, int offset)
+    {
+        region = region.clipped_with(bound());
+
+        if (region.is_empty() || offset == 0 || abs(offset) >= region.height())
+            return;
+
+        int rows = region.height() - abs(offset);
+        int from = offset < 0 ? region.y() - offset : region.y();
+        int to = from + offset;
+
+        for (int i = 0; i < rows; i++)
+        {
+            int row = offset < 0 ? i : rows - 1 - i;
+
+            memcpy(
+                _pixels + (to + row) * width() + region.x(),
+                _pixels + (from + row) * width() + region.x(),
+                region.width() * sizeof(Color));
         }
     }
 
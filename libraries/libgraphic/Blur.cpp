@@ -0,0 +1,240 @@
+#include <libgraphic/Blur.h>
+#include <libsystem/math/MinMax.h>
+
+#define BLUR_CHANNELS 4
+
+// From a box radius of 153 the rounded multiplier can move a flat color by one.
+#define BLUR_BOX_RADIUS_MAX 127
+
+// Rounded 16.16 reciprocal of the box size, with the rounding in
+// blur_average() a box over a flat color gives the same color back.
+static uint32_t blur_multiplier(int radius)
+{
+    uint32_t size = 2 * radius + 1;
+    return ((1 << 16) + size / 2) / size;
+}
+
+static inline uint8_t blur_average(uint32_t sum, uint32_t multiplier)
+{
+    return (sum * multiplier + (1 << 15)) >> 16;
+}
+
+// Blurring always happens on the same thread, keep the scratch buffers
+// around instead of allocating them for each blur.
+static void *blur_scratch(int index, size_t size)
+{
+    static void *buffers[3] = {};
+    static size_t sizes[3] = {};
+
+    if (sizes[index] < size)
+    {
+        free(buffers[index]);
+        buffers[index] = malloc(size);
+        sizes[index] = size;
+    }
+
+    return buffers[index];
+}
+
+static int blur_factor(int radius)
+{
+    if (radius < 4)
+    {
+        return 1;
+    }
+    else if (radius < 12)
+    {
+        return 2;
+    }
+    else
+    {
+        return 4;
+    }
+}
+
+static void blur_downsample(Bitmap &bitmap, Rectangle region, int factor, uint8_t *destination, int width, int height)
+{
+    for (int y = 0; y < height; y++)
+    {
+        int y0 = region.y() + y * factor;
+        int y1 = MIN(y0 + factor, region.y() + region.height());
+
+        for (int x = 0; x < width; x++)
+        {
+            int x0 = region.x() + x * factor;
+            int x1 = MIN(x0 + factor, region.x() + region.width());
+
+            uint32_t sum[BLUR_CHANNELS] = {};
+
+            for (int yy = y0; yy < y1; yy++)
+            {
+                const uint8_t *row = reinterpret_cast<const uint8_t *>(bitmap.pixels() + yy * bitmap.width());
+
+                for (int xx = x0; xx < x1; xx++)
+                {
+                    for (int c = 0; c < BLUR_CHANNELS; c++)
+                    {
+                        sum[c] += row[xx * BLUR_CHANNELS + c];
+                    }
+                }
+            }
+
+            uint32_t count = (x1 - x0) * (y1 - y0);
+            uint8_t *pixel = destination + (y * width + x) * BLUR_CHANNELS;
+
+            for (int c = 0; c < BLUR_CHANNELS; c++)
+            {
+                pixel[c] = sum[c] / count;
+            }
+        }
+    }
+}
+
+// Running sums along each row, samples past the edges are clamped.
+static void blur_horizontal(const uint8_t *source, uint8_t *destination, int width, int height, int radius)
+{
+    uint32_t multiplier = blur_multiplier(radius);
+
+    for (int y = 0; y < height; y++)
+    {
+        const uint8_t *row = source + y * width * BLUR_CHANNELS;
+        uint8_t *output = destination + y * width * BLUR_CHANNELS;
+
+        uint32_t sum[BLUR_CHANNELS] = {};
+
+        for (int i = -radius; i <= radius; i++)
+        {
+            const uint8_t *pixel = row + clamp(i, 0, width - 1) * BLUR_CHANNELS;
+
+            for (int c = 0; c < BLUR_CHANNELS; c++)
+            {
+                sum[c] += pixel[c];
+            }
+        }
+
+        for (int x = 0; x < width; x++)
+        {
+            const uint8_t *incoming = row + MIN(x + radius + 1, width - 1) * BLUR_CHANNELS;
+            const uint8_t *outgoing = row + MAX(x - radius, 0) * BLUR_CHANNELS;
+
+            for (int c = 0; c < BLUR_CHANNELS; c++)
+            {
+                output[x * BLUR_CHANNELS + c] = blur_average(sum[c], multiplier);
+                sum[c] += incoming[c] - outgoing[c];
+            }
+        }
+    }
+}
+
+// Same as blur_horizontal() but the running sums of a whole row are updated at
+// once, the inner loops walk contiguous memory and vectorize well.
+static void blur_vertical(const uint8_t *source, uint8_t *destination, int width, int height, int radius, uint32_t *sums)
+{
+    uint32_t multiplier = blur_multiplier(radius);
+    int stride = width * BLUR_CHANNELS;
+
+    for (int i = 0; i < stride; i++)
+    {
+        sums[i] = 0;
+    }
+
+    for (int i = -radius; i <= radius; i++)
+    {
+        const uint8_t *row = source + clamp(i, 0, height - 1) * stride;
+
+        for (int j = 0; j < stride; j++)
+        {
+            sums[j] += row[j];
+        }
+    }
+
+    for (int y = 0; y < height; y++)
+    {
+        const uint8_t *incoming = source + MIN(y + radius + 1, height - 1) * stride;
+        const uint8_t *outgoing = source + MAX(y - radius, 0) * stride;
+        uint8_t *output = destination + y * stride;
+
+        for (int j = 0; j < stride; j++)
+        {
+            output[j] = blur_average(sums[j], multiplier);
+            sums[j] += incoming[j] - outgoing[j];
+        }
+    }
+}
+
+static inline uint32_t blur_lerp(uint32_t from, uint32_t to, uint32_t weight)
+{
+    return (from * (256 - weight) + to * weight) >> 8;
+}
+
+// Bilinear upscale in 16.16 fixed point, sample positions are taken at the
+// center of the pixels so a factor of one is an exact copy.
+static void blur_upsample(const uint8_t *source, int width, int height, Bitmap &bitmap, Rectangle region)
+{
+    int step_x = (width << 16) / region.width();
+    int step_y = (height << 16) / region.height();
+
+    for (int y = 0; y < region.height(); y++)
+    {
+        int sy = MAX(0, y * step_y + step_y / 2 - (1 << 15));
+        int y0 = MIN(sy >> 16, height - 1);
+        int y1 = MIN(y0 + 1, height - 1);
+        uint32_t fy = (sy >> 8) & 0xff;
+
+        const uint8_t *row0 = source + y0 * width * BLUR_CHANNELS;
+        const uint8_t *row1 = source + y1 * width * BLUR_CHANNELS;
+
+        uint8_t *output = reinterpret_cast<uint8_t *>(bitmap.pixels() + (region.y() + y) * bitmap.width() + region.x());
+
+        for (int x = 0; x < region.width(); x++)
+        {
+            int sx = MAX(0, x * step_x + step_x / 2 - (1 << 15));
+            int x0 = MIN(sx >> 16, width - 1);
+            int x1 = MIN(x0 + 1, width - 1);
+            uint32_t fx = (sx >> 8) & 0xff;
+
+            for (int c = 0; c < BLUR_CHANNELS; c++)
+            {
+                uint32_t top = blur_lerp(row0[x0 * BLUR_CHANNELS + c], row0[x1 * BLUR_CHANNELS + c], fx);
+                uint32_t bottom = blur_lerp(row1[x0 * BLUR_CHANNELS + c], row1[x1 * BLUR_CHANNELS + c], fx);
+
+                output[x * BLUR_CHANNELS + c] = blur_lerp(top, bottom, fy);
+            }
+        }
+    }
+}
+
+void blur_bitmap_region(Bitmap &bitmap, Rectangle region, int radius)
+{
+    static_assert(sizeof(Color) == BLUR_CHANNELS);
+
+    region = region.clipped_with(bitmap.bound());
+
+    if (region.is_empty() || radius <= 0)
+    {
+        return;
+    }
+
+    int factor = blur_factor(radius);
+    int width = (region.width() + factor - 1) / factor;
+    int height = (region.height() + factor - 1) / factor;
+
+    // A tent of the original radius is two boxes of half of it.
+    int box_radius = clamp(radius / factor / 2, 1, BLUR_BOX_RADIUS_MAX);
+
+    size_t size = width * height * BLUR_CHANNELS;
+
+    auto front = reinterpret_cast<uint8_t *>(blur_scratch(0, size));
+    auto back = reinterpret_cast<uint8_t *>(blur_scratch(1, size));
+    auto sums = reinterpret_cast<uint32_t *>(blur_scratch(2, width * BLUR_CHANNELS * sizeof(uint32_t)));
+
+    blur_downsample(bitmap, region, factor, front, width, height);
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        blur_horizontal(front, back, width, height, box_radius);
+        blur_vertical(back, front, width, height, box_radius, sums);
+    }
+
+    blur_upsample(front, width, height, bitmap, region);
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <libgraphic/Bitmap.h>
+
+// Approximates a gaussian blur of the given radius: the region is shrunk,
+// blurred with two separable box passes and scaled back up. The cost barely
+// depends on the radius, large radii are cheaper than small ones.
+void blur_bitmap_region(Bitmap &bitmap, Rectangle region, int radius);
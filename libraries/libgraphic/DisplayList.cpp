@@ -0,0 +1,519 @@
+#include <libgraphic/DisplayList.h>
+#include <libsystem/Assert.h>
+#include <libsystem/math/MinMax.h>
+#include <libsystem/thread/Thread.h>
+
+// Lines and triangles are stepped in floating point and may overshoot the
+// bounding box of their points by a pixel, give them some slack.
+#define DISPLAY_LIST_SHAPE_MARGIN 2
+
+static Rectangle display_list_bound_of(Vec2i p0, Vec2i p1)
+{
+    return Rectangle::from_two_point(p0, p1)
+        .expended(Insets(
+            DISPLAY_LIST_SHAPE_MARGIN,
+            DISPLAY_LIST_SHAPE_MARGIN + 1,
+            DISPLAY_LIST_SHAPE_MARGIN,
+            DISPLAY_LIST_SHAPE_MARGIN + 1));
+}
+
+static bool display_command_is_barrier(DisplayCommand &command)
+{
+    return command.type == DISPLAY_BLUR_RECTANGLE ||
+           command.type == DISPLAY_DRAW_TRUETYPE_STRING ||
+           command.type == DISPLAY_DRAW_TRUETYPE_STRING_WITHIN;
+}
+
+DisplayList::DisplayList(Rectangle bound)
+{
+    _state_stack_top = 0;
+    _state_stack[0] = {
+        Vec2i::zero(),
+        bound,
+    };
+}
+
+void DisplayList::push()
+{
+    assert(_state_stack_top < STATESTACK_SIZE);
+
+    _state_stack_top++;
+    _state_stack[_state_stack_top] = _state_stack[_state_stack_top - 1];
+}
+
+void DisplayList::pop()
+{
+    assert(_state_stack_top > 0);
+    _state_stack_top--;
+}
+
+void DisplayList::clip(Rectangle rectangle)
+{
+    Rectangle transformed_rectangle = rectangle.offset(state().origine);
+    state().clip = transformed_rectangle.clipped_with(state().clip);
+}
+
+void DisplayList::transform(Vec2i offset)
+{
+    state().origine += offset;
+}
+
+DisplayCommand &DisplayList::record(DisplayCommandType type, Rectangle bound)
+{
+    DisplayCommand command = {};
+
+    command.type = type;
+    command.origine = state().origine;
+    command.clip = state().clip;
+    command.bound = bound.offset(state().origine).clipped_with(state().clip);
+
+    return _commands.push_back(move(command));
+}
+
+// For commands whose extent isn't known until they are rasterized.
+DisplayCommand &DisplayList::record(DisplayCommandType type)
+{
+    auto &command = record(type, Rectangle::empty());
+    command.bound = state().clip;
+
+    return command;
+}
+
+void DisplayList::plot_pixel(Vec2i position, Color color)
+{
+    auto &command = record(DISPLAY_PLOT_PIXEL, Rectangle(position, Vec2i(1, 1)));
+    command.points[0] = position;
+    command.colors[0] = color;
+}
+
+void DisplayList::blit_bitmap(Bitmap &bitmap, Rectangle source, Rectangle destination)
+{
+    auto &command = record(DISPLAY_BLIT_BITMAP, destination);
+    command.bitmap = bitmap;
+    command.source = source;
+    command.rectangle = destination;
+}
+
+void DisplayList::blit_bitmap_no_alpha(Bitmap &bitmap, Rectangle source, Rectangle destination)
+{
+    auto &command = record(DISPLAY_BLIT_BITMAP_NO_ALPHA, destination);
+    command.bitmap = bitmap;
+    command.source = source;
+    command.rectangle = destination;
+}
+
+void DisplayList::blit_icon(Icon &icon, IconSize size, Rectangle destination, Color color)
+{
+    auto &command = record(DISPLAY_BLIT_ICON, destination);
+    command.icon = icon;
+    command.icon_size = size;
+    command.rectangle = destination;
+    command.colors[0] = color;
+}
+
+void DisplayList::clear(Color color)
+{
+    // Painter::clear() clears the bound of the bitmap moved by the transform.
+    auto &command = record(DISPLAY_CLEAR, _state_stack[0].clip);
+    command.colors[0] = color;
+}
+
+void DisplayList::clear_rectangle(Rectangle rectangle, Color color)
+{
+    auto &command = record(DISPLAY_CLEAR_RECTANGLE, rectangle);
+    command.rectangle = rectangle;
+    command.colors[0] = color;
+}
+
+void DisplayList::fill_rectangle(Rectangle rectangle, Color color)
+{
+    auto &command = record(DISPLAY_FILL_RECTANGLE, rectangle);
+    command.rectangle = rectangle;
+    command.colors[0] = color;
+}
+
+void DisplayList::fill_insets(Rectangle rectangle, Insets insets, Color color)
+{
+    auto &command = record(DISPLAY_FILL_INSETS, rectangle);
+    command.rectangle = rectangle;
+    command.insets = insets;
+    command.colors[0] = color;
+}
+
+void DisplayList::fill_triangle(Vec2i p0, Vec2i p1, Vec2i p2, Color color)
+{
+    Rectangle bound = display_list_bound_of(p0, p1).merged_with(display_list_bound_of(p1, p2));
+
+    auto &command = record(DISPLAY_FILL_TRIANGLE, bound);
+    command.points[0] = p0;
+    command.points[1] = p1;
+    command.points[2] = p2;
+    command.colors[0] = color;
+}
+
+void DisplayList::fill_rounded_rectangle(Rectangle bound, int radius, Color color)
+{
+    auto &command = record(DISPLAY_FILL_ROUNDED_RECTANGLE, bound);
+    command.rectangle = bound;
+    command.values[0] = radius;
+    command.colors[0] = color;
+}
+
+void DisplayList::fill_checkboard(Rectangle bound, int cell_size, Color fg_color, Color bg_color)
+{
+    auto &command = record(DISPLAY_FILL_CHECKBOARD, bound);
+    command.rectangle = bound;
+    command.values[0] = cell_size;
+    command.colors[0] = fg_color;
+    command.colors[1] = bg_color;
+}
+
+void DisplayList::draw_line(Vec2i from, Vec2i to, Color color)
+{
+    auto &command = record(DISPLAY_DRAW_LINE, display_list_bound_of(from, to));
+    command.points[0] = from;
+    command.points[1] = to;
+    command.colors[0] = color;
+}
+
+void DisplayList::draw_line_antialias(Vec2i from, Vec2i to, Color color)
+{
+    auto &command = record(DISPLAY_DRAW_LINE_ANTIALIAS, display_list_bound_of(from, to));
+    command.points[0] = from;
+    command.points[1] = to;
+    command.colors[0] = color;
+}
+
+void DisplayList::draw_rectangle(Rectangle rectangle, Color color)
+{
+    auto &command = record(DISPLAY_DRAW_RECTANGLE, rectangle.expended(Insets(DISPLAY_LIST_SHAPE_MARGIN)));
+    command.rectangle = rectangle;
+    command.colors[0] = color;
+}
+
+void DisplayList::draw_triangle(Vec2i p0, Vec2i p1, Vec2i p2, Color color)
+{
+    Rectangle bound = display_list_bound_of(p0, p1).merged_with(display_list_bound_of(p1, p2));
+
+    auto &command = record(DISPLAY_DRAW_TRIANGLE, bound);
+    command.points[0] = p0;
+    command.points[1] = p1;
+    command.points[2] = p2;
+    command.colors[0] = color;
+}
+
+void DisplayList::draw_rounded_rectangle(Rectangle bound, int radius, int thickness, Color color)
+{
+    auto &command = record(DISPLAY_DRAW_ROUNDED_RECTANGLE, bound);
+    command.rectangle = bound;
+    command.values[0] = radius;
+    command.values[1] = thickness;
+    command.colors[0] = color;
+}
+
+void DisplayList::blur_rectangle(Rectangle rectangle, int radius)
+{
+    auto &command = record(DISPLAY_BLUR_RECTANGLE, rectangle);
+    command.rectangle = rectangle;
+    command.values[0] = radius;
+}
+
+void DisplayList::draw_glyph(Font &font, Glyph &glyph, Vec2i position, Color color)
+{
+    auto &command = record(DISPLAY_DRAW_GLYPH, Rectangle(position - glyph.origin, glyph.bound.size()));
+    command.font = font;
+    command.glyph = glyph;
+    command.points[0] = position;
+    command.colors[0] = color;
+}
+
+void DisplayList::draw_string(Font &font, const char *str, Vec2i position, Color color)
+{
+    auto &command = record(DISPLAY_DRAW_STRING);
+    command.font = font;
+    command.text = str;
+    command.points[0] = position;
+    command.colors[0] = color;
+}
+
+void DisplayList::draw_string_within(Font &font, const char *str, Rectangle container, Position position, Color color)
+{
+    auto &command = record(DISPLAY_DRAW_STRING_WITHIN);
+    command.font = font;
+    command.text = str;
+    command.rectangle = container;
+    command.position = position;
+    command.colors[0] = color;
+}
+
+void DisplayList::draw_truetype_string(TrueTypeFont *font, const char *string, Vec2i position, Color color)
+{
+    auto &command = record(DISPLAY_DRAW_TRUETYPE_STRING);
+    command.truetype = font;
+    command.text = string;
+    command.points[0] = position;
+    command.colors[0] = color;
+}
+
+void DisplayList::draw_truetype_string_within(TrueTypeFont *font, const char *str, Rectangle container, Position position, Color color)
+{
+    auto &command = record(DISPLAY_DRAW_TRUETYPE_STRING_WITHIN);
+    command.truetype = font;
+    command.text = str;
+    command.rectangle = container;
+    command.position = position;
+    command.colors[0] = color;
+}
+
+void DisplayList::replay(Painter &painter, DisplayCommand &command, Rectangle clip)
+{
+    painter.push();
+    painter.clip(command.clip.clipped_with(clip));
+    painter.transform(command.origine);
+
+    switch (command.type)
+    {
+    case DISPLAY_PLOT_PIXEL:
+        painter.plot_pixel(command.points[0], command.colors[0]);
+        break;
+
+    case DISPLAY_BLIT_BITMAP:
+        painter.blit_bitmap(*command.bitmap, command.source, command.rectangle);
+        break;
+
+    case DISPLAY_BLIT_BITMAP_NO_ALPHA:
+        painter.blit_bitmap_no_alpha(*command.bitmap, command.source, command.rectangle);
+        break;
+
+    case DISPLAY_BLIT_ICON:
+        painter.blit_icon(*command.icon, command.icon_size, command.rectangle, command.colors[0]);
+        break;
+
+    case DISPLAY_CLEAR:
+        painter.clear(command.colors[0]);
+        break;
+
+    case DISPLAY_CLEAR_RECTANGLE:
+        painter.clear_rectangle(command.rectangle, command.colors[0]);
+        break;
+
+    case DISPLAY_FILL_RECTANGLE:
+        painter.fill_rectangle(command.rectangle, command.colors[0]);
+        break;
+
+    case DISPLAY_FILL_INSETS:
+        painter.fill_insets(command.rectangle, command.insets, command.colors[0]);
+        break;
+
+    case DISPLAY_FILL_TRIANGLE:
+        painter.fill_triangle(command.points[0], command.points[1], command.points[2], command.colors[0]);
+        break;
+
+    case DISPLAY_FILL_ROUNDED_RECTANGLE:
+        painter.fill_rounded_rectangle(command.rectangle, command.values[0], command.colors[0]);
+        break;
+
+    case DISPLAY_FILL_CHECKBOARD:
+        painter.fill_checkboard(command.rectangle, command.values[0], command.colors[0], command.colors[1]);
+        break;
+
+    case DISPLAY_DRAW_LINE:
+        painter.draw_line(command.points[0], command.points[1], command.colors[0]);
+        break;
+
+    case DISPLAY_DRAW_LINE_ANTIALIAS:
+        painter.draw_line_antialias(command.points[0], command.points[1], command.colors[0]);
+        break;
+
+    case DISPLAY_DRAW_RECTANGLE:
+        painter.draw_rectangle(command.rectangle, command.colors[0]);
+        break;
+
+    case DISPLAY_DRAW_TRIANGLE:
+        painter.draw_triangle(command.points[0], command.points[1], command.points[2], command.colors[0]);
+        break;
+
+    case DISPLAY_DRAW_ROUNDED_RECTANGLE:
+        painter.draw_rounded_rectangle(command.rectangle, command.values[0], command.values[1], command.colors[0]);
+        break;
+
+    case DISPLAY_BLUR_RECTANGLE:
+        painter.blur_rectangle(command.rectangle, command.values[0]);
+        break;
+
+    case DISPLAY_DRAW_GLYPH:
+        painter.draw_glyph(*command.font, command.glyph, command.points[0], command.colors[0]);
+        break;
+
+    case DISPLAY_DRAW_STRING:
+        painter.draw_string(*command.font, command.text.cstring(), command.points[0], command.colors[0]);
+        break;
+
+    case DISPLAY_DRAW_STRING_WITHIN:
+        painter.draw_string_within(*command.font, command.text.cstring(), command.rectangle, command.position, command.colors[0]);
+        break;
+
+    case DISPLAY_DRAW_TRUETYPE_STRING:
+        painter.draw_truetype_string(command.truetype, command.text.cstring(), command.points[0], command.colors[0]);
+        break;
+
+    case DISPLAY_DRAW_TRUETYPE_STRING_WITHIN:
+        painter.draw_truetype_string_within(command.truetype, command.text.cstring(), command.rectangle, command.position, command.colors[0]);
+        break;
+
+    default:
+        ASSERT_NOT_REACHED();
+    }
+
+    painter.pop();
+}
+
+void DisplayList::rasterize_tile(Painter &painter, Rectangle tile, Vector<DisplayCommand *> &bin)
+{
+    for (size_t i = 0; i < bin.count(); i++)
+    {
+        replay(painter, *bin[i], tile);
+    }
+}
+
+struct DisplayList::Worker
+{
+    DisplayList *list;
+    RefPtr<Bitmap> *bitmap;
+    Vector<Vector<DisplayCommand *>> *bins;
+    int first_row;
+    int step;
+};
+
+// Every tile only sees the commands that overlap it, each one is replayed with
+// the clip of the command narrowed down to the tile.
+void DisplayList::rasterize_rows(RefPtr<Bitmap> bitmap, Vector<Vector<DisplayCommand *>> &bins, int first_row, int step)
+{
+    int columns = __align_up(bitmap->width(), DISPLAY_LIST_TILE_SIZE) / DISPLAY_LIST_TILE_SIZE;
+    int rows = __align_up(bitmap->height(), DISPLAY_LIST_TILE_SIZE) / DISPLAY_LIST_TILE_SIZE;
+
+    Painter painter(bitmap);
+
+    for (int row = first_row; row < rows; row += step)
+    {
+        for (int column = 0; column < columns; column++)
+        {
+            Rectangle tile = Rectangle(
+                                 column * DISPLAY_LIST_TILE_SIZE,
+                                 row * DISPLAY_LIST_TILE_SIZE,
+                                 DISPLAY_LIST_TILE_SIZE,
+                                 DISPLAY_LIST_TILE_SIZE)
+                                 .clipped_with(bitmap->bound());
+
+            rasterize_tile(painter, tile, bins[row * columns + column]);
+        }
+    }
+}
+
+int DisplayList::rasterize_worker(void *argument)
+{
+    auto worker = reinterpret_cast<Worker *>(argument);
+
+    worker->list->rasterize_rows(*worker->bitmap, *worker->bins, worker->first_row, worker->step);
+
+    return 0;
+}
+
+// The rows of tiles are interleaved between the threads, the tiles don't
+// overlap so they never write to the same pixels.
+void DisplayList::rasterize_tiles(RefPtr<Bitmap> bitmap, size_t start, size_t end, int threads)
+{
+    if (start >= end)
+    {
+        return;
+    }
+
+    int columns = __align_up(bitmap->width(), DISPLAY_LIST_TILE_SIZE) / DISPLAY_LIST_TILE_SIZE;
+    int rows = __align_up(bitmap->height(), DISPLAY_LIST_TILE_SIZE) / DISPLAY_LIST_TILE_SIZE;
+
+    Vector<Vector<DisplayCommand *>> bins(columns * rows);
+
+    for (int i = 0; i < columns * rows; i++)
+    {
+        bins.push_back({});
+    }
+
+    for (size_t i = start; i < end; i++)
+    {
+        Rectangle bound = _commands[i].bound.clipped_with(bitmap->bound());
+
+        if (bound.is_empty())
+        {
+            continue;
+        }
+
+        // Icons load their bitmaps the first time they are used, do it now
+        // before the threads share them.
+        if (_commands[i].type == DISPLAY_BLIT_ICON)
+        {
+            _commands[i].icon->bitmap(_commands[i].icon_size);
+        }
+
+        int first_column = bound.x() / DISPLAY_LIST_TILE_SIZE;
+        int last_column = (bound.x() + bound.width() - 1) / DISPLAY_LIST_TILE_SIZE;
+        int first_row = bound.y() / DISPLAY_LIST_TILE_SIZE;
+        int last_row = (bound.y() + bound.height() - 1) / DISPLAY_LIST_TILE_SIZE;
+
+        for (int row = first_row; row <= last_row; row++)
+        {
+            for (int column = first_column; column <= last_column; column++)
+            {
+                bins[row * columns + column].push_back(&_commands[i]);
+            }
+        }
+    }
+
+    threads = MAX(1, MIN(MIN(threads, DISPLAY_LIST_THREADS_MAX), rows));
+
+    Worker workers[DISPLAY_LIST_THREADS_MAX];
+    int tids[DISPLAY_LIST_THREADS_MAX];
+
+    for (int i = 1; i < threads; i++)
+    {
+        workers[i] = {this, &bitmap, &bins, i, threads};
+
+        if (thread_create(rasterize_worker, &workers[i], &tids[i]) != SUCCESS)
+        {
+            tids[i] = -1;
+        }
+    }
+
+    rasterize_rows(bitmap, bins, 0, threads);
+
+    for (int i = 1; i < threads; i++)
+    {
+        if (tids[i] != -1)
+        {
+            thread_join(tids[i], nullptr);
+        }
+        else
+        {
+            rasterize_rows(bitmap, bins, i, threads);
+        }
+    }
+}
+
+void DisplayList::rasterize(RefPtr<Bitmap> bitmap, int threads)
+{
+    size_t start = 0;
+
+    for (size_t i = 0; i < _commands.count(); i++)
+    {
+        if (display_command_is_barrier(_commands[i]))
+        {
+            rasterize_tiles(bitmap, start, i, threads);
+
+            Painter painter(bitmap);
+            replay(painter, _commands[i], bitmap->bound());
+
+            start = i + 1;
+        }
+    }
+
+    rasterize_tiles(bitmap, start, _commands.count(), threads);
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <libgraphic/Painter.h>
+#include <libutils/String.h>
+#include <libutils/Vector.h>
+
+#define DISPLAY_LIST_TILE_SIZE 64
+
+// Rows of tiles are shared between this many threads, the calling thread
+// included. It only pays off when the threads run on different CPUs.
+#define DISPLAY_LIST_THREADS 4
+#define DISPLAY_LIST_THREADS_MAX 16
+
+enum DisplayCommandType
+{
+    DISPLAY_PLOT_PIXEL,
+    DISPLAY_BLIT_BITMAP,
+    DISPLAY_BLIT_BITMAP_NO_ALPHA,
+    DISPLAY_BLIT_ICON,
+    DISPLAY_CLEAR,
+    DISPLAY_CLEAR_RECTANGLE,
+    DISPLAY_FILL_RECTANGLE,
+    DISPLAY_FILL_INSETS,
+    DISPLAY_FILL_TRIANGLE,
+    DISPLAY_FILL_ROUNDED_RECTANGLE,
+    DISPLAY_FILL_CHECKBOARD,
+    DISPLAY_DRAW_LINE,
+    DISPLAY_DRAW_LINE_ANTIALIAS,
+    DISPLAY_DRAW_RECTANGLE,
+    DISPLAY_DRAW_TRIANGLE,
+    DISPLAY_DRAW_ROUNDED_RECTANGLE,
+    DISPLAY_BLUR_RECTANGLE,
+    DISPLAY_DRAW_GLYPH,
+    DISPLAY_DRAW_STRING,
+    DISPLAY_DRAW_STRING_WITHIN,
+    DISPLAY_DRAW_TRUETYPE_STRING,
+    DISPLAY_DRAW_TRUETYPE_STRING_WITHIN,
+};
+
+struct DisplayCommand
+{
+    DisplayCommandType type;
+
+    // State of the recorder when the command was recorded, the bound is the
+    // part of the destination the command may touch, in bitmap coordinates.
+    Vec2i origine;
+    Rectangle clip;
+    Rectangle bound;
+
+    Rectangle rectangle;
+    Rectangle source;
+    Vec2i points[3];
+    Color colors[2];
+    int values[2];
+    Insets insets;
+    Position position;
+    IconSize icon_size;
+    Glyph glyph;
+
+    RefPtr<Bitmap> bitmap;
+    RefPtr<Icon> icon;
+    RefPtr<Font> font;
+    TrueTypeFont *truetype;
+    String text;
+};
+
+// Records painter operations instead of executing them. On rasterization the
+// commands are binned into tiles and each tile is replayed with a painter
+// clipped to it, this gives the same pixels as painting in immediate mode.
+//
+// Commands that can't be split across tiles (blurs read their neighborhood,
+// TrueType text mutates the shared glyph cache) are barriers, they run on the
+// whole bitmap once everything recorded before them has been rasterized.
+class DisplayList
+{
+private:
+    struct Worker;
+
+    int _state_stack_top = 0;
+    PainterState _state_stack[STATESTACK_SIZE];
+
+    Vector<DisplayCommand> _commands{};
+
+    PainterState &state() { return _state_stack[_state_stack_top]; }
+
+    DisplayCommand &record(DisplayCommandType type, Rectangle bound);
+
+    DisplayCommand &record(DisplayCommandType type);
+
+    void replay(Painter &painter, DisplayCommand &command, Rectangle clip);
+
+    void rasterize_tile(Painter &painter, Rectangle tile, Vector<DisplayCommand *> &bin);
+
+    void rasterize_rows(RefPtr<Bitmap> bitmap, Vector<Vector<DisplayCommand *>> &bins, int first_row, int step);
+
+    void rasterize_tiles(RefPtr<Bitmap> bitmap, size_t start, size_t end, int threads);
+
+    static int rasterize_worker(void *argument);
+
+public:
+    size_t count() { return _commands.count(); }
+
+    DisplayList(Rectangle bound);
+
+    void clear_commands() { _commands = Vector<DisplayCommand>(); }
+
+    void rasterize(RefPtr<Bitmap> bitmap, int threads = DISPLAY_LIST_THREADS);
+
+    void push();
+
+    void pop();
+
+    void clip(Rectangle rectangle);
+
+    void transform(Vec2i offset);
+
+    void plot_pixel(Vec2i position, Color color);
+
+    void blit_bitmap(Bitmap &bitmap, Rectangle source, Rectangle destination);
+
+    void blit_bitmap_no_alpha(Bitmap &bitmap, Rectangle source, Rectangle destination);
+
+    void blit_icon(Icon &icon, IconSize size, Rectangle destination, Color color);
+
+    void clear(Color color);
+
+    void clear_rectangle(Rectangle rectangle, Color color);
+
+    void fill_rectangle(Rectangle rectangle, Color color);
+
+    void fill_insets(Rectangle rectangle, Insets insets, Color color);
+
+    void fill_triangle(Vec2i p0, Vec2i p1, Vec2i p2, Color color);
+
+    void fill_rounded_rectangle(Rectangle bound, int radius, Color color);
+
+    void fill_checkboard(Rectangle bound, int cell_size, Color fg_color, Color bg_color);
+
+    void draw_line(Vec2i from, Vec2i to, Color color);
+
+    void draw_line_antialias(Vec2i from, Vec2i to, Color color);
+
+    void draw_rectangle(Rectangle rectangle, Color color);
+
+    void draw_triangle(Vec2i p0, Vec2i p1, Vec2i p2, Color color);
+
+    void draw_rounded_rectangle(Rectangle bound, int radius, int thickness, Color color);
+
+    void blur_rectangle(Rectangle rectangle, int radius);
+
+    void draw_glyph(Font &font, Glyph &glyph, Vec2i position, Color color);
+
+    void draw_string(Font &font, const char *str, Vec2i position, Color color);
+
+    void draw_string_within(Font &font, const char *str, Rectangle container, Position position, Color color);
+
+    void draw_truetype_string(TrueTypeFont *font, const char *string, Vec2i position, Color color);
+
+    void draw_truetype_string_within(TrueTypeFont *font, const char *str, Rectangle container, Position position, Color color);
+};
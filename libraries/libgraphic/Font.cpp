@@ -60,30 +60,46 @@ ResultOr<RefPtr<Font>> Font::create(String name)
     return _fonts[name];
 }
 
-Glyph &Font::glyph(Codepoint codepoint)
+void Font::index_glyphs()
 {
-    for (int i = 0; _glyphs[i].codepoint != 0; i++)
+    for (size_t i = 0; i < _glyphs.count() && _glyphs[i].codepoint != 0; i++)
     {
-        if (_glyphs[i].codepoint == codepoint)
+        Codepoint codepoint = _glyphs[i].codepoint;
+
+        if (codepoint < __array_length(_ascii))
+        {
+            _ascii[codepoint] = &_glyphs[i];
+        }
+        else
         {
-            return _glyphs[i];
+            _lookup[codepoint] = &_glyphs[i];
         }
     }
+}
+
+Glyph &Font::glyph(Codepoint codepoint)
+{
+    if (codepoint < __array_length(_ascii))
+    {
+        return _ascii[codepoint] ? *_ascii[codepoint] : _default;
+    }
+
+    if (_lookup.has_key(codepoint))
+    {
+        return *_lookup[codepoint];
+    }
 
     return _default;
 }
 
 bool Font::has_glyph(Codepoint codepoint)
 {
-    for (int i = 0; _glyphs[i].codepoint != 0; i++)
+    if (codepoint < __array_length(_ascii))
     {
-        if (_glyphs[i].codepoint == codepoint)
-        {
-            return true;
-        }
+        return _ascii[codepoint] != nullptr;
     }
 
-    return false;
+    return _lookup.has_key(codepoint);
 }
 
 Rectangle Font::mesure_string(const char *string)
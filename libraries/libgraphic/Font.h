@@ -2,6 +2,7 @@
 
 #include <libgraphic/Bitmap.h>
 #include <libsystem/unicode/Codepoint.h>
+#include <libutils/HashMap.h>
 #include <libutils/String.h>
 #include <libutils/Vector.h>
 
@@ -20,6 +21,11 @@ private:
     Glyph _default;
     Vector<Glyph> _glyphs;
 
+    Glyph *_ascii[128] = {};
+    HashMap<Codepoint, Glyph *> _lookup;
+
+    void index_glyphs();
+
 public:
     Bitmap &bitmap() { return *_bitmap; }
 
@@ -29,6 +35,7 @@ public:
         : _bitmap(bitmap),
           _glyphs(move(glyphs))
     {
+        index_glyphs();
         _default = glyph(U'?');
     }
 
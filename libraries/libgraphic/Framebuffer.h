@@ -13,13 +13,15 @@ private:
     RefPtr<Bitmap> _bitmap;
     Painter _painter;
 
-    Vector<Rectangle> _dirty_bounds{};
+    SmallVector<Rectangle, 8> _dirty_bounds{};
 
 public:
     static ResultOr<OwnPtr<Framebuffer>> open();
 
     Painter &painter() { return _painter; }
 
+    Bitmap &bitmap() { return *_bitmap; }
+
     Rectangle resolution() { return _bitmap->bound(); }
 
     Framebuffer(Handle handle, RefPtr<Bitmap> bitmap);
@@ -0,0 +1,486 @@
+#include <libgraphic/Inflate.h>
+#include <libsystem/core/CString.h>
+
+static const uint16_t _length_base[] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+
+static const uint8_t _length_extra[] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+static const uint16_t _distance_base[] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+
+static const uint8_t _distance_extra[] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+static const uint8_t _code_length_order[] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+static uint32_t bit_reverse(uint32_t value, int bits)
+{
+    uint32_t result = 0;
+
+    for (int i = 0; i < bits; i++)
+    {
+        result = (result << 1) | (value & 1);
+        value >>= 1;
+    }
+
+    return result;
+}
+
+Inflate::Inflate()
+{
+    _window = (uint8_t *)malloc(INFLATE_WINDOW_SIZE);
+}
+
+Inflate::~Inflate()
+{
+    free(_window);
+}
+
+void Inflate::append(const void *data, size_t size)
+{
+    _inputs.push_back({(const uint8_t *)data, size});
+}
+
+/* --- Bits ----------------------------------------------------------------- */
+
+uint8_t Inflate::next_byte()
+{
+    while (_input_index < _inputs.count())
+    {
+        Input &input = _inputs[_input_index];
+
+        if (_input_offset < input.size)
+        {
+            return input.data[_input_offset++];
+        }
+
+        _input_index++;
+        _input_offset = 0;
+    }
+
+    // Keep going on zeros, past_end() tells if any of them were used.
+    _overrun++;
+    return 0;
+}
+
+void Inflate::refill()
+{
+    while (_bit_count <= 24)
+    {
+        _bits |= (uint32_t)next_byte() << _bit_count;
+        _bit_count += 8;
+    }
+}
+
+uint32_t Inflate::bits(int count)
+{
+    if (_bit_count < count)
+    {
+        refill();
+    }
+
+    uint32_t value = _bits & ((1u << count) - 1);
+    _bits >>= count;
+    _bit_count -= count;
+
+    return value;
+}
+
+/* --- Huffman -------------------------------------------------------------- */
+
+Result Inflate::build(Huffman &huffman, const uint8_t *sizes, int count)
+{
+    int sizes_count[17] = {};
+    int next_code[16] = {};
+
+    memset(huffman.fast, 0, sizeof(huffman.fast));
+
+    for (int i = 0; i < count; i++)
+    {
+        sizes_count[sizes[i]]++;
+    }
+
+    sizes_count[0] = 0;
+
+    int code = 0;
+    int symbol = 0;
+
+    for (int i = 1; i < 16; i++)
+    {
+        next_code[i] = code;
+        huffman.first_code[i] = code;
+        huffman.first_symbol[i] = symbol;
+
+        code += sizes_count[i];
+
+        if (sizes_count[i] && code - 1 >= (1 << i))
+        {
+            return ERR_BAD_IMAGE_FILE_FORMAT;
+        }
+
+        huffman.max_code[i] = code << (16 - i);
+        code <<= 1;
+        symbol += sizes_count[i];
+    }
+
+    huffman.max_code[16] = 0x10000;
+
+    for (int i = 0; i < count; i++)
+    {
+        int size = sizes[i];
+
+        if (size == 0)
+        {
+            continue;
+        }
+
+        int index = next_code[size] - huffman.first_code[size] + huffman.first_symbol[size];
+
+        huffman.sizes[index] = size;
+        huffman.values[index] = i;
+
+        if (size <= INFLATE_FAST_BITS)
+        {
+            // Every index that starts with this code gets the symbol.
+            uint16_t fast = (size << 9) | i;
+
+            for (uint32_t j = bit_reverse(next_code[size], size);
+                 j < (1 << INFLATE_FAST_BITS);
+                 j += (1 << size))
+            {
+                huffman.fast[j] = fast;
+            }
+        }
+
+        next_code[size]++;
+    }
+
+    return SUCCESS;
+}
+
+int Inflate::decode(Huffman &huffman)
+{
+    if (_bit_count < 16)
+    {
+        refill();
+    }
+
+    uint16_t fast = huffman.fast[_bits & ((1 << INFLATE_FAST_BITS) - 1)];
+
+    if (fast)
+    {
+        int size = fast >> 9;
+        _bits >>= size;
+        _bit_count -= size;
+
+        return fast & 511;
+    }
+
+    // Codes longer than the fast table are compared with the largest code
+    // of each length, most significant bit first.
+    uint32_t code = bit_reverse(_bits, 16);
+
+    int size = INFLATE_FAST_BITS + 1;
+
+    while (code >= (uint32_t)huffman.max_code[size])
+    {
+        size++;
+    }
+
+    if (size >= 16)
+    {
+        return -1;
+    }
+
+    int index = (code >> (16 - size)) - huffman.first_code[size] + huffman.first_symbol[size];
+
+    if (index >= 288 || huffman.sizes[index] != size)
+    {
+        return -1;
+    }
+
+    _bits >>= size;
+    _bit_count -= size;
+
+    return huffman.values[index];
+}
+
+/* --- Blocks --------------------------------------------------------------- */
+
+Result Inflate::read_dynamic_tables()
+{
+    int literals_count = bits(5) + 257;
+    int distances_count = bits(5) + 1;
+    int code_lengths_count = bits(4) + 4;
+
+    uint8_t code_length_sizes[19] = {};
+
+    for (int i = 0; i < code_lengths_count; i++)
+    {
+        code_length_sizes[_code_length_order[i]] = bits(3);
+    }
+
+    Huffman code_lengths;
+    Result result = build(code_lengths, code_length_sizes, 19);
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    uint8_t sizes[288 + 32];
+    int total = literals_count + distances_count;
+    int count = 0;
+
+    while (count < total)
+    {
+        int symbol = decode(code_lengths);
+
+        if (symbol < 0)
+        {
+            return ERR_BAD_IMAGE_FILE_FORMAT;
+        }
+
+        if (symbol < 16)
+        {
+            sizes[count++] = symbol;
+            continue;
+        }
+
+        uint8_t fill = 0;
+        int repeat = 0;
+
+        if (symbol == 16)
+        {
+            if (count == 0)
+            {
+                return ERR_BAD_IMAGE_FILE_FORMAT;
+            }
+
+            fill = sizes[count - 1];
+            repeat = bits(2) + 3;
+        }
+        else if (symbol == 17)
+        {
+            repeat = bits(3) + 3;
+        }
+        else
+        {
+            repeat = bits(7) + 11;
+        }
+
+        if (count + repeat > total)
+        {
+            return ERR_BAD_IMAGE_FILE_FORMAT;
+        }
+
+        memset(sizes + count, fill, repeat);
+        count += repeat;
+    }
+
+    result = build(_literals, sizes, literals_count);
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    return build(_distances, sizes + literals_count, distances_count);
+}
+
+Result Inflate::read_block_header()
+{
+    _final = bits(1);
+    int type = bits(2);
+
+    if (type == 0)
+    {
+        // Stored blocks start on a byte boundary.
+        bits(_bit_count % 8);
+
+        uint32_t length = bits(16);
+        uint32_t complement = bits(16);
+
+        if ((length ^ 0xffff) != complement)
+        {
+            return ERR_BAD_IMAGE_FILE_FORMAT;
+        }
+
+        _stored_remaining = length;
+        _state = STATE_STORED;
+
+        return SUCCESS;
+    }
+    else if (type == 1)
+    {
+        uint8_t sizes[288 + 32];
+
+        memset(sizes, 8, 144);
+        memset(sizes + 144, 9, 112);
+        memset(sizes + 256, 7, 24);
+        memset(sizes + 280, 8, 8);
+        memset(sizes + 288, 5, 32);
+
+        build(_literals, sizes, 288);
+        build(_distances, sizes + 288, 32);
+
+        _state = STATE_HUFFMAN;
+
+        return SUCCESS;
+    }
+    else if (type == 2)
+    {
+        _state = STATE_HUFFMAN;
+
+        return read_dynamic_tables();
+    }
+    else
+    {
+        return ERR_BAD_IMAGE_FILE_FORMAT;
+    }
+}
+
+/* --- Output --------------------------------------------------------------- */
+
+ResultOr<size_t> Inflate::read(void *buffer, size_t size)
+{
+    uint8_t *output = (uint8_t *)buffer;
+    size_t produced = 0;
+
+    if (_window == nullptr)
+    {
+        return ERR_OUT_OF_MEMORY;
+    }
+
+    auto emit = [&](uint8_t byte) {
+        _window[_window_position & (INFLATE_WINDOW_SIZE - 1)] = byte;
+        _window_position++;
+        output[produced++] = byte;
+    };
+
+    while (produced < size && _state != STATE_END)
+    {
+        if (_state == STATE_HEADER)
+        {
+            uint32_t method = bits(8);
+            uint32_t flags = bits(8);
+
+            // Deflate with a window of 32K at most and no preset dictionary.
+            if ((method & 15) != 8 ||
+                (method >> 4) > 7 ||
+                ((method << 8) | flags) % 31 != 0 ||
+                (flags & 32))
+            {
+                return ERR_BAD_IMAGE_FILE_FORMAT;
+            }
+
+            _state = STATE_BLOCK;
+        }
+        else if (_state == STATE_BLOCK)
+        {
+            if (_final)
+            {
+                // The adler32 trailer isn't checked, PNG chunks have their own CRC.
+                _state = STATE_END;
+                break;
+            }
+
+            Result result = read_block_header();
+
+            if (result != SUCCESS)
+            {
+                return result;
+            }
+        }
+        else if (_state == STATE_STORED)
+        {
+            while (_stored_remaining > 0 && produced < size)
+            {
+                emit(bits(8));
+                _stored_remaining--;
+            }
+
+            if (_stored_remaining == 0)
+            {
+                _state = STATE_BLOCK;
+            }
+        }
+        else if (_state == STATE_HUFFMAN)
+        {
+            // Finish the copy the previous read stopped in the middle of.
+            while (_copy_length > 0 && produced < size)
+            {
+                emit(_window[(_window_position - _copy_distance) & (INFLATE_WINDOW_SIZE - 1)]);
+                _copy_length--;
+            }
+
+            while (produced < size)
+            {
+                int symbol = decode(_literals);
+
+                if (symbol < 0)
+                {
+                    return ERR_BAD_IMAGE_FILE_FORMAT;
+                }
+
+                if (symbol < 256)
+                {
+                    emit(symbol);
+                    continue;
+                }
+
+                if (symbol == 256)
+                {
+                    _state = STATE_BLOCK;
+                    break;
+                }
+
+                symbol -= 257;
+
+                if (symbol >= 29)
+                {
+                    return ERR_BAD_IMAGE_FILE_FORMAT;
+                }
+
+                size_t length = _length_base[symbol] + bits(_length_extra[symbol]);
+
+                int distance_symbol = decode(_distances);
+
+                if (distance_symbol < 0 || distance_symbol >= 30)
+                {
+                    return ERR_BAD_IMAGE_FILE_FORMAT;
+                }
+
+                size_t distance = _distance_base[distance_symbol] + bits(_distance_extra[distance_symbol]);
+
+                if (distance > _window_position)
+                {
+                    return ERR_BAD_IMAGE_FILE_FORMAT;
+                }
+
+                _copy_distance = distance;
+                _copy_length = length;
+
+                while (_copy_length > 0 && produced < size)
+                {
+                    emit(_window[(_window_position - _copy_distance) & (INFLATE_WINDOW_SIZE - 1)]);
+                    _copy_length--;
+                }
+            }
+        }
+
+        if (past_end())
+        {
+            return ERR_BAD_IMAGE_FILE_FORMAT;
+        }
+    }
+
+    return produced;
+}
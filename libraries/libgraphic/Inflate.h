@@ -0,0 +1,95 @@
+#pragma once
+
+#include <libsystem/Common.h>
+#include <libsystem/Result.h>
+#include <libutils/ResultOr.h>
+#include <libutils/Vector.h>
+
+#define INFLATE_WINDOW_SIZE (32768)
+#define INFLATE_FAST_BITS (9)
+
+// Decompresses a zlib stream a few bytes at the time, callers pull what they
+// need instead of inflating the whole stream up front. The compressed data
+// doesn't have to be contiguous, a PNG splits it across its IDAT chunks.
+class Inflate
+{
+private:
+    struct Huffman
+    {
+        uint16_t fast[1 << INFLATE_FAST_BITS];
+        uint16_t first_code[16];
+        int max_code[17];
+        uint16_t first_symbol[16];
+        uint8_t sizes[288];
+        uint16_t values[288];
+    };
+
+    enum State
+    {
+        STATE_HEADER,
+        STATE_BLOCK,
+        STATE_STORED,
+        STATE_HUFFMAN,
+        STATE_END,
+    };
+
+    struct Input
+    {
+        const uint8_t *data;
+        size_t size;
+    };
+
+    Vector<Input> _inputs{};
+    size_t _input_index = 0;
+    size_t _input_offset = 0;
+
+    // Bytes handed to the bit buffer past the end of the input.
+    size_t _overrun = 0;
+
+    uint32_t _bits = 0;
+    int _bit_count = 0;
+
+    State _state = STATE_HEADER;
+    bool _final = false;
+    size_t _stored_remaining = 0;
+    size_t _copy_length = 0;
+    size_t _copy_distance = 0;
+
+    Huffman _literals;
+    Huffman _distances;
+
+    uint8_t *_window = nullptr;
+    size_t _window_position = 0;
+
+    __noncopyable(Inflate);
+    __nonmovable(Inflate);
+
+    uint8_t next_byte();
+
+    void refill();
+
+    uint32_t bits(int count);
+
+    bool past_end() { return _overrun * 8 > (size_t)_bit_count; }
+
+    Result build(Huffman &huffman, const uint8_t *sizes, int count);
+
+    // Returns the next symbol, or -1 if the bits aren't a code of the table.
+    int decode(Huffman &huffman);
+
+    Result read_block_header();
+
+    Result read_dynamic_tables();
+
+public:
+    Inflate();
+
+    ~Inflate();
+
+    void append(const void *data, size_t size);
+
+    bool ended() { return _state == STATE_END; }
+
+    // Fills the buffer, it only comes back short at the end of the stream.
+    ResultOr<size_t> read(void *buffer, size_t size);
+};
@@ -0,0 +1,772 @@
+#include <libgraphic/PNG.h>
+#include <libsystem/core/CString.h>
+#include <libsystem/thread/Thread.h>
+#include <libutils/Move.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+static_assert(sizeof(Color) == 4, "Rows of 8 bits RGBA are copied as they are");
+
+static const uint8_t _signature[] = {137, 80, 78, 71, 13, 10, 26, 10};
+
+static const int _adam7_x[] = {0, 4, 0, 2, 0, 1, 0};
+static const int _adam7_y[] = {0, 0, 4, 0, 2, 0, 1};
+static const int _adam7_dx[] = {8, 8, 4, 4, 2, 2, 1};
+static const int _adam7_dy[] = {8, 8, 8, 4, 4, 2, 2};
+
+static uint32_t png_read_u32(const uint8_t *data)
+{
+    return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+}
+
+static uint16_t png_read_u16(const uint8_t *data)
+{
+    return (data[0] << 8) | data[1];
+}
+
+static bool png_valid_depth(PNGColorType color_type, int depth)
+{
+    switch (color_type)
+    {
+    case PNG_GRAYSCALE:
+        return depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16;
+
+    case PNG_INDEXED:
+        return depth == 1 || depth == 2 || depth == 4 || depth == 8;
+
+    case PNG_TRUECOLOR:
+    case PNG_GRAYSCALE_ALPHA:
+    case PNG_TRUECOLOR_ALPHA:
+        return depth == 8 || depth == 16;
+
+    default:
+        return false;
+    }
+}
+
+// Samples aren't byte aligned below 8 bits, they are packed from the most
+// significant bit.
+static uint16_t png_sample(const uint8_t *row, int index, int depth)
+{
+    if (depth == 8)
+    {
+        return row[index];
+    }
+
+    if (depth == 16)
+    {
+        return png_read_u16(row + index * 2);
+    }
+
+    int bit = index * depth;
+    return (row[bit / 8] >> (8 - depth - bit % 8)) & ((1 << depth) - 1);
+}
+
+/* --- Filters -------------------------------------------------------------- */
+
+#ifdef __SSE2__
+
+static inline __m128i png_load_pixel(const uint8_t *pixel, int distance)
+{
+    uint32_t value = 0;
+    memcpy(&value, pixel, distance);
+    return _mm_cvtsi32_si128(value);
+}
+
+static inline void png_store_pixel(uint8_t *pixel, __m128i value, int distance)
+{
+    uint32_t bytes = _mm_cvtsi128_si32(value);
+    memcpy(pixel, &bytes, distance);
+}
+
+static inline __m128i png_select(__m128i condition, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(condition, a), _mm_andnot_si128(condition, b));
+}
+
+static inline __m128i png_abs16(__m128i value)
+{
+    return _mm_max_epi16(value, _mm_sub_epi16(_mm_setzero_si128(), value));
+}
+
+#endif
+
+static void png_unfilter_sub(uint8_t *row, size_t size, int distance)
+{
+    size_t i = distance;
+
+#ifdef __SSE2__
+    if (distance == 4)
+    {
+        // Prefix sum of the four pixels, plus the last pixel of the previous group.
+        __m128i last = _mm_setzero_si128();
+
+        for (i = 0; i + 16 <= size; i += 16)
+        {
+            __m128i x = _mm_loadu_si128((__m128i *)(row + i));
+
+            x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+            x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+            x = _mm_add_epi8(x, last);
+
+            _mm_storeu_si128((__m128i *)(row + i), x);
+            last = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+        }
+
+        i = MAX(i, 4u);
+    }
+    else if (distance == 3)
+    {
+        __m128i a = _mm_setzero_si128();
+
+        for (i = 0; i + 3 <= size; i += 3)
+        {
+            a = _mm_add_epi8(png_load_pixel(row + i, 3), a);
+            png_store_pixel(row + i, a, 3);
+        }
+    }
+#endif
+
+    for (; i < size; i++)
+    {
+        row[i] += row[i - distance];
+    }
+}
+
+static void png_unfilter_up(uint8_t *row, const uint8_t *previous, size_t size)
+{
+    size_t i = 0;
+
+#ifdef __SSE2__
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i x = _mm_loadu_si128((__m128i *)(row + i));
+        __m128i b = _mm_loadu_si128((__m128i *)(previous + i));
+
+        _mm_storeu_si128((__m128i *)(row + i), _mm_add_epi8(x, b));
+    }
+#endif
+
+    for (; i < size; i++)
+    {
+        row[i] += previous[i];
+    }
+}
+
+static void png_unfilter_average(uint8_t *row, const uint8_t *previous, size_t size, int distance)
+{
+    size_t i = 0;
+
+#ifdef __SSE2__
+    if (distance == 3 || distance == 4)
+    {
+        __m128i a = _mm_setzero_si128();
+        __m128i one = _mm_set1_epi8(1);
+
+        for (; i + distance <= size; i += distance)
+        {
+            __m128i b = png_load_pixel(previous + i, distance);
+
+            // _mm_avg_epu8 rounds up, the filter rounds down.
+            __m128i average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+
+            a = _mm_add_epi8(png_load_pixel(row + i, distance), average);
+            png_store_pixel(row + i, a, distance);
+        }
+    }
+#endif
+
+    for (; i < (size_t)distance && i < size; i++)
+    {
+        row[i] += previous[i] / 2;
+    }
+
+    for (; i < size; i++)
+    {
+        row[i] += (row[i - distance] + previous[i]) / 2;
+    }
+}
+
+static uint8_t png_paeth(int a, int b, int c)
+{
+    int pa = b - c;
+    int pb = a - c;
+    int pc = pa + pb;
+
+    pa = pa < 0 ? -pa : pa;
+    pb = pb < 0 ? -pb : pb;
+    pc = pc < 0 ? -pc : pc;
+
+    if (pa <= pb && pa <= pc)
+    {
+        return a;
+    }
+    else if (pb <= pc)
+    {
+        return b;
+    }
+    else
+    {
+        return c;
+    }
+}
+
+static void png_unfilter_paeth(uint8_t *row, const uint8_t *previous, size_t size, int distance)
+{
+    size_t i = 0;
+
+#ifdef __SSE2__
+    if (distance == 3 || distance == 4)
+    {
+        // Same as png_paeth() on 16 bits lanes, a, b and c are one pixel each.
+        __m128i zero = _mm_setzero_si128();
+        __m128i a = zero;
+        __m128i c = zero;
+
+        for (; i + distance <= size; i += distance)
+        {
+            __m128i b = _mm_unpacklo_epi8(png_load_pixel(previous + i, distance), zero);
+
+            __m128i pa = _mm_sub_epi16(b, c);
+            __m128i pb = _mm_sub_epi16(a, c);
+            __m128i pc = _mm_add_epi16(pa, pb);
+
+            pa = png_abs16(pa);
+            pb = png_abs16(pb);
+            pc = png_abs16(pc);
+
+            __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+
+            __m128i nearest = png_select(
+                _mm_cmpeq_epi16(smallest, pa), a,
+                png_select(_mm_cmpeq_epi16(smallest, pb), b, c));
+
+            __m128i x = _mm_add_epi8(png_load_pixel(row + i, distance), _mm_packus_epi16(nearest, nearest));
+            png_store_pixel(row + i, x, distance);
+
+            a = _mm_unpacklo_epi8(x, zero);
+            c = b;
+        }
+    }
+#endif
+
+    for (; i < (size_t)distance && i < size; i++)
+    {
+        row[i] += previous[i];
+    }
+
+    for (; i < size; i++)
+    {
+        row[i] += png_paeth(row[i - distance], previous[i], previous[i - distance]);
+    }
+}
+
+static Result png_unfilter(uint8_t filter, uint8_t *row, const uint8_t *previous, size_t size, int distance)
+{
+    switch (filter)
+    {
+    case 0:
+        return SUCCESS;
+
+    case 1:
+        png_unfilter_sub(row, size, distance);
+        return SUCCESS;
+
+    case 2:
+        png_unfilter_up(row, previous, size);
+        return SUCCESS;
+
+    case 3:
+        png_unfilter_average(row, previous, size, distance);
+        return SUCCESS;
+
+    case 4:
+        png_unfilter_paeth(row, previous, size, distance);
+        return SUCCESS;
+
+    default:
+        return ERR_BAD_IMAGE_FILE_FORMAT;
+    }
+}
+
+/* --- Header --------------------------------------------------------------- */
+
+int PNGDecoder::bits_per_pixel()
+{
+    switch (_color_type)
+    {
+    case PNG_TRUECOLOR:
+        return _depth * 3;
+
+    case PNG_GRAYSCALE_ALPHA:
+        return _depth * 2;
+
+    case PNG_TRUECOLOR_ALPHA:
+        return _depth * 4;
+
+    default:
+        return _depth;
+    }
+}
+
+Result PNGDecoder::read_header()
+{
+    if (_size < sizeof(_signature) || memcmp(_data, _signature, sizeof(_signature)) != 0)
+    {
+        return ERR_BAD_IMAGE_FILE_FORMAT;
+    }
+
+    size_t offset = sizeof(_signature);
+
+    bool has_header = false;
+    bool has_data = false;
+    size_t palette_size = 0;
+
+    while (true)
+    {
+        // Length, type and CRC.
+        if (_size - offset < 12)
+        {
+            return ERR_BAD_IMAGE_FILE_FORMAT;
+        }
+
+        size_t length = png_read_u32(_data + offset);
+        const char *type = (const char *)_data + offset + 4;
+        const uint8_t *chunk = _data + offset + 8;
+
+        if (length > _size - offset - 12)
+        {
+            return ERR_BAD_IMAGE_FILE_FORMAT;
+        }
+
+        offset += 12 + length;
+
+        if (!has_header && memcmp(type, "IHDR", 4) != 0)
+        {
+            return ERR_BAD_IMAGE_FILE_FORMAT;
+        }
+
+        if (memcmp(type, "IHDR", 4) == 0)
+        {
+            if (has_header || length != 13)
+            {
+                return ERR_BAD_IMAGE_FILE_FORMAT;
+            }
+
+            uint32_t width = png_read_u32(chunk);
+            uint32_t height = png_read_u32(chunk + 4);
+
+            if (width == 0 || height == 0 || (uint64_t)width * height > PNG_PIXELS_MAX)
+            {
+                return ERR_BAD_IMAGE_FILE_FORMAT;
+            }
+
+            _width = width;
+            _height = height;
+            _depth = chunk[8];
+            _color_type = (PNGColorType)chunk[9];
+
+            // Deflate, adaptive filtering, no interlacing or Adam7.
+            if (!png_valid_depth(_color_type, _depth) || chunk[10] != 0 || chunk[11] != 0 || chunk[12] > 1)
+            {
+                return ERR_BAD_IMAGE_FILE_FORMAT;
+            }
+
+            if (row_size(_width) > PNG_ROW_SIZE_MAX)
+            {
+                return ERR_BAD_IMAGE_FILE_FORMAT;
+            }
+
+            _interlaced = chunk[12] == 1;
+            has_header = true;
+        }
+        else if (memcmp(type, "PLTE", 4) == 0)
+        {
+            if (length == 0 || length % 3 != 0 || length / 3 > 256)
+            {
+                return ERR_BAD_IMAGE_FILE_FORMAT;
+            }
+
+            palette_size = length / 3;
+
+            for (size_t i = 0; i < palette_size; i++)
+            {
+                _palette[i] = Color::from_byte(chunk[i * 3], chunk[i * 3 + 1], chunk[i * 3 + 2]);
+            }
+        }
+        else if (memcmp(type, "tRNS", 4) == 0)
+        {
+            if (_color_type == PNG_INDEXED && length <= palette_size)
+            {
+                for (size_t i = 0; i < length; i++)
+                {
+                    _palette[i] = Color::from_byte(_palette[i].red(), _palette[i].green(), _palette[i].blue(), chunk[i]);
+                }
+            }
+            else if (_color_type == PNG_GRAYSCALE && length == 2)
+            {
+                _key[0] = png_read_u16(chunk);
+                _has_key = true;
+            }
+            else if (_color_type == PNG_TRUECOLOR && length == 6)
+            {
+                _key[0] = png_read_u16(chunk);
+                _key[1] = png_read_u16(chunk + 2);
+                _key[2] = png_read_u16(chunk + 4);
+                _has_key = true;
+            }
+            else
+            {
+                return ERR_BAD_IMAGE_FILE_FORMAT;
+            }
+        }
+        else if (memcmp(type, "IDAT", 4) == 0)
+        {
+            _inflate.append(chunk, length);
+            has_data = true;
+        }
+        else if (memcmp(type, "IEND", 4) == 0)
+        {
+            break;
+        }
+        else if (!(type[0] & 32))
+        {
+            // Ancillary chunks can be skipped, critical ones we don't know can't.
+            return ERR_BAD_IMAGE_FILE_FORMAT;
+        }
+    }
+
+    if (!has_data || (_color_type == PNG_INDEXED && palette_size == 0))
+    {
+        return ERR_BAD_IMAGE_FILE_FORMAT;
+    }
+
+    return SUCCESS;
+}
+
+/* --- Rows ----------------------------------------------------------------- */
+
+Result PNGDecoder::read_row(uint8_t *row, size_t size)
+{
+    auto read_or_result = _inflate.read(row, size);
+
+    if (!read_or_result.success())
+    {
+        return read_or_result.result();
+    }
+
+    if (read_or_result.value() != size)
+    {
+        return ERR_BAD_IMAGE_FILE_FORMAT;
+    }
+
+    return SUCCESS;
+}
+
+void PNGDecoder::convert(const uint8_t *row, Color *pixels, int width)
+{
+    uint8_t *output = reinterpret_cast<uint8_t *>(pixels);
+
+    // Only the most significant byte of 16 bits samples is kept.
+    int step = _depth == 16 ? 2 : 1;
+
+    switch (_color_type)
+    {
+    case PNG_TRUECOLOR_ALPHA:
+        if (_depth == 8)
+        {
+            memcpy(output, row, width * sizeof(Color));
+            return;
+        }
+
+        for (int i = 0; i < width * 4; i++)
+        {
+            output[i] = row[i * 2];
+        }
+
+        break;
+
+    case PNG_TRUECOLOR:
+        for (int x = 0; x < width; x++)
+        {
+            bool transparent = _has_key &&
+                               png_sample(row, x * 3, _depth) == _key[0] &&
+                               png_sample(row, x * 3 + 1, _depth) == _key[1] &&
+                               png_sample(row, x * 3 + 2, _depth) == _key[2];
+
+            output[x * 4] = row[x * 3 * step];
+            output[x * 4 + 1] = row[(x * 3 + 1) * step];
+            output[x * 4 + 2] = row[(x * 3 + 2) * step];
+            output[x * 4 + 3] = transparent ? 0 : 255;
+        }
+
+        break;
+
+    case PNG_GRAYSCALE_ALPHA:
+        for (int x = 0; x < width; x++)
+        {
+            uint8_t gray = row[x * 2 * step];
+
+            output[x * 4] = gray;
+            output[x * 4 + 1] = gray;
+            output[x * 4 + 2] = gray;
+            output[x * 4 + 3] = row[(x * 2 + 1) * step];
+        }
+
+        break;
+
+    case PNG_GRAYSCALE:
+        for (int x = 0; x < width; x++)
+        {
+            uint16_t sample = png_sample(row, x, _depth);
+            uint8_t gray = _depth == 16 ? sample >> 8 : sample * 255 / ((1 << _depth) - 1);
+
+            output[x * 4] = gray;
+            output[x * 4 + 1] = gray;
+            output[x * 4 + 2] = gray;
+            output[x * 4 + 3] = (_has_key && sample == _key[0]) ? 0 : 255;
+        }
+
+        break;
+
+    case PNG_INDEXED:
+        for (int x = 0; x < width; x++)
+        {
+            pixels[x] = _palette[png_sample(row, x, _depth)];
+        }
+
+        break;
+    }
+}
+
+/* --- Decoding ------------------------------------------------------------- */
+
+Result PNGDecoder::decode_serial(Color *pixels)
+{
+    size_t size = row_size(_width);
+
+    // Each row starts with its filter type.
+    uint8_t *rows __cleanup_malloc = (uint8_t *)calloc(2, size + 1);
+
+    if (rows == nullptr)
+    {
+        return ERR_OUT_OF_MEMORY;
+    }
+
+    uint8_t *current = rows;
+    uint8_t *previous = rows + size + 1;
+
+    for (int y = 0; y < _height; y++)
+    {
+        Result result = read_row(current, size + 1);
+
+        if (result != SUCCESS)
+        {
+            return result;
+        }
+
+        result = png_unfilter(current[0], current + 1, previous + 1, size, filter_distance());
+
+        if (result != SUCCESS)
+        {
+            return result;
+        }
+
+        convert(current + 1, pixels + (size_t)y * _width, _width);
+
+        swap(current, previous);
+    }
+
+    return SUCCESS;
+}
+
+struct PNGDecoder::Pipeline
+{
+    PNGDecoder *decoder;
+
+    uint8_t *rows;
+    size_t stride;
+
+    int produced;
+    int consumed;
+
+    bool failed;
+    bool cancelled;
+    Result result;
+
+    uint8_t *row(int y) { return rows + (y % PNG_PIPELINE_ROWS) * stride; }
+};
+
+int PNGDecoder::pipeline_inflate(void *argument)
+{
+    auto pipeline = reinterpret_cast<Pipeline *>(argument);
+
+    for (int y = 0; y < pipeline->decoder->_height; y++)
+    {
+        // The row before the one being unfiltered is still needed.
+        while (y - __atomic_load_n(&pipeline->consumed, __ATOMIC_ACQUIRE) >= PNG_PIPELINE_ROWS - 1)
+        {
+            if (__atomic_load_n(&pipeline->cancelled, __ATOMIC_ACQUIRE))
+            {
+                return 0;
+            }
+
+            thread_yield();
+        }
+
+        Result result = pipeline->decoder->read_row(pipeline->row(y), pipeline->stride);
+
+        if (result != SUCCESS)
+        {
+            pipeline->result = result;
+            __atomic_store_n(&pipeline->failed, true, __ATOMIC_RELEASE);
+
+            return 0;
+        }
+
+        __atomic_store_n(&pipeline->produced, y + 1, __ATOMIC_RELEASE);
+    }
+
+    return 0;
+}
+
+Result PNGDecoder::decode_pipelined(Color *pixels)
+{
+    size_t size = row_size(_width);
+
+    uint8_t *rows __cleanup_malloc = (uint8_t *)malloc((size + 1) * PNG_PIPELINE_ROWS);
+    uint8_t *first_previous __cleanup_malloc = (uint8_t *)calloc(1, size);
+
+    if (rows == nullptr || first_previous == nullptr)
+    {
+        return ERR_OUT_OF_MEMORY;
+    }
+
+    Pipeline pipeline = {this, rows, size + 1, 0, 0, false, false, SUCCESS};
+
+    int tid = -1;
+
+    if (thread_create(pipeline_inflate, &pipeline, &tid) != SUCCESS)
+    {
+        return decode_serial(pixels);
+    }
+
+    Result result = SUCCESS;
+
+    for (int y = 0; y < _height; y++)
+    {
+        while (__atomic_load_n(&pipeline.produced, __ATOMIC_ACQUIRE) <= y)
+        {
+            if (__atomic_load_n(&pipeline.failed, __ATOMIC_ACQUIRE))
+            {
+                break;
+            }
+
+            thread_yield();
+        }
+
+        if (__atomic_load_n(&pipeline.produced, __ATOMIC_ACQUIRE) <= y)
+        {
+            result = pipeline.result;
+            break;
+        }
+
+        uint8_t *current = pipeline.row(y);
+        const uint8_t *previous = y == 0 ? first_previous : pipeline.row(y - 1) + 1;
+
+        result = png_unfilter(current[0], current + 1, previous, size, filter_distance());
+
+        if (result != SUCCESS)
+        {
+            __atomic_store_n(&pipeline.cancelled, true, __ATOMIC_RELEASE);
+            break;
+        }
+
+        convert(current + 1, pixels + (size_t)y * _width, _width);
+
+        __atomic_store_n(&pipeline.consumed, y + 1, __ATOMIC_RELEASE);
+    }
+
+    thread_join(tid, nullptr);
+
+    return result;
+}
+
+Result PNGDecoder::decode_interlaced(Color *pixels)
+{
+    size_t size = row_size(_width);
+
+    uint8_t *rows __cleanup_malloc = (uint8_t *)malloc(2 * (size + 1));
+    Color *line __cleanup_malloc = (Color *)malloc(_width * sizeof(Color));
+
+    if (rows == nullptr || line == nullptr)
+    {
+        return ERR_OUT_OF_MEMORY;
+    }
+
+    // Each of the seven passes is a smaller image with its own rows.
+    for (int pass = 0; pass < 7; pass++)
+    {
+        int pass_width = (_width - _adam7_x[pass] + _adam7_dx[pass] - 1) / _adam7_dx[pass];
+        int pass_height = (_height - _adam7_y[pass] + _adam7_dy[pass] - 1) / _adam7_dy[pass];
+
+        if (pass_width == 0 || pass_height == 0)
+        {
+            continue;
+        }
+
+        size_t pass_size = row_size(pass_width);
+
+        uint8_t *current = rows;
+        uint8_t *previous = rows + size + 1;
+        memset(previous, 0, pass_size + 1);
+
+        for (int y = 0; y < pass_height; y++)
+        {
+            Result result = read_row(current, pass_size + 1);
+
+            if (result != SUCCESS)
+            {
+                return result;
+            }
+
+            result = png_unfilter(current[0], current + 1, previous + 1, pass_size, filter_distance());
+
+            if (result != SUCCESS)
+            {
+                return result;
+            }
+
+            convert(current + 1, line, pass_width);
+
+            Color *destination = pixels + (size_t)(_adam7_y[pass] + y * _adam7_dy[pass]) * _width + _adam7_x[pass];
+
+            for (int x = 0; x < pass_width; x++)
+            {
+                destination[x * _adam7_dx[pass]] = line[x];
+            }
+
+            swap(current, previous);
+        }
+    }
+
+    return SUCCESS;
+}
+
+Result PNGDecoder::decode(Color *pixels, PNGThreading threading)
+{
+    if (_interlaced)
+    {
+        return decode_interlaced(pixels);
+    }
+
+    if (threading == PNG_THREADING_ALWAYS ||
+        (threading == PNG_THREADING_AUTO && (size_t)_width * _height >= PNG_PIPELINE_THRESHOLD))
+    {
+        return decode_pipelined(pixels);
+    }
+
+    return decode_serial(pixels);
+}
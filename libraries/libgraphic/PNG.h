@@ -0,0 +1,96 @@
+#pragma once
+
+#include <libgraphic/Color.h>
+#include <libgraphic/Inflate.h>
+#include <libsystem/Result.h>
+#include <libsystem/math/MinMax.h>
+
+// Images this large are inflated by a second thread while this one
+// unfilters and converts the rows it already got.
+#define PNG_PIPELINE_THRESHOLD (512 * 512)
+#define PNG_PIPELINE_ROWS (32)
+
+#define PNG_PIXELS_MAX (16384 * 16384)
+
+// Enough for a 16-bit RGBA row a million pixels wide, the pipeline holds
+// PNG_PIPELINE_ROWS of them.
+#define PNG_ROW_SIZE_MAX (8 * 1024 * 1024)
+
+enum PNGColorType
+{
+    PNG_GRAYSCALE = 0,
+    PNG_TRUECOLOR = 2,
+    PNG_INDEXED = 3,
+    PNG_GRAYSCALE_ALPHA = 4,
+    PNG_TRUECOLOR_ALPHA = 6,
+};
+
+enum PNGThreading
+{
+    PNG_THREADING_AUTO,
+    PNG_THREADING_NEVER,
+    PNG_THREADING_ALWAYS,
+};
+
+// Decodes the image row by row straight into the destination pixels, the
+// inflated data is never held in memory as a whole.
+class PNGDecoder
+{
+private:
+    struct Pipeline;
+
+    const uint8_t *_data;
+    size_t _size;
+
+    int _width = 0;
+    int _height = 0;
+    int _depth = 0;
+    PNGColorType _color_type = PNG_GRAYSCALE;
+    bool _interlaced = false;
+
+    Color _palette[256] = {};
+
+    bool _has_key = false;
+    uint16_t _key[3] = {};
+
+    Inflate _inflate;
+
+    __noncopyable(PNGDecoder);
+    __nonmovable(PNGDecoder);
+
+    int bits_per_pixel();
+
+    uint64_t row_size(int width) { return ((uint64_t)width * bits_per_pixel() + 7) / 8; }
+
+    // Distance in bytes between a byte and the one it is filtered against.
+    int filter_distance() { return MAX(1, bits_per_pixel() / 8); }
+
+    Result read_row(uint8_t *row, size_t size);
+
+    void convert(const uint8_t *row, Color *pixels, int width);
+
+    Result decode_serial(Color *pixels);
+
+    Result decode_pipelined(Color *pixels);
+
+    Result decode_interlaced(Color *pixels);
+
+    static int pipeline_inflate(void *argument);
+
+public:
+    int width() { return _width; }
+
+    int height() { return _height; }
+
+    PNGDecoder(const void *data, size_t size)
+        : _data((const uint8_t *)data), _size(size)
+    {
+    }
+
+    // Walks the chunks, it must succeed before decode() is called. The chunks
+    // CRCs aren't checked, a corrupted stream fails to inflate instead.
+    Result read_header();
+
+    // Fills width() * height() pixels.
+    Result decode(Color *pixels, PNGThreading threading = PNG_THREADING_AUTO);
+};
@@ -1,6 +1,11 @@
+// Before Math.h, its abs() macro breaks the declarations of stdlib.h.
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <libgraphic/Blur.h>
 #include <libgraphic/Font.h>
 #include <libgraphic/Painter.h>
-#include <libgraphic/StackBlur.h>
 #include <libsystem/Assert.h>
 #include <libsystem/math/Math.h>
 
@@ -72,6 +77,195 @@ void Painter::plot_pixel(Vec2i position, Color color)
     }
 }
 
+// Colors are stored as red, green, blue and alpha bytes, masks can be read
+// straight out of a channel of a bitmap.
+#define PAINTER_RED_BYTE 0
+#define PAINTER_ALPHA_BYTE 3
+
+static_assert(sizeof(Color) == 4);
+
+static inline uint32_t div255(uint32_t value)
+{
+    value += 128;
+    return (value + (value >> 8)) >> 8;
+}
+
+static inline Color blend_coverage_pixel(Color color, uint32_t alpha, Color background)
+{
+    if (alpha == 255)
+    {
+        return color;
+    }
+
+    uint32_t inverse = 255 - alpha;
+
+    if (background.alpha() == 255)
+    {
+        return Color::from_byte(
+            div255(color.red() * alpha + background.red() * inverse),
+            div255(color.green() * alpha + background.green() * inverse),
+            div255(color.blue() * alpha + background.blue() * inverse),
+            255);
+    }
+
+    uint32_t background_alpha = div255(background.alpha() * inverse);
+    uint32_t result_alpha = alpha + background_alpha;
+
+    if (result_alpha == 0)
+    {
+        return Color::from_byte(0, 0, 0, 0);
+    }
+
+    return Color::from_byte(
+        (color.red() * alpha + background.red() * background_alpha) / result_alpha,
+        (color.green() * alpha + background.green() * background_alpha) / result_alpha,
+        (color.blue() * alpha + background.blue() * background_alpha) / result_alpha,
+        result_alpha);
+}
+
+// Blend a solid color through a span of A8 coverage, this is the inner loop
+// of all text and antialiased shape drawing so it stays in integer math.
+static void blend_coverage_span(Color *destination, const uint8_t *coverage, int step, int count, Color color)
+{
+    uint32_t color_alpha = color.alpha();
+    Color opaque = color.with_alpha(1);
+
+    int i = 0;
+
+#ifdef __SSE2__
+    // Four pixels at a time over an opaque background, which is what windows
+    // and most of the text are drawn on. Every channel fits in 16 bits and
+    // rounds like div255(), so the result is the same as the loop below.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i full = _mm_set1_epi16(255);
+    const __m128i rounding = _mm_set1_epi16(128);
+    const __m128i alpha_mask = _mm_set1_epi32((int)(0xffu << (PAINTER_ALPHA_BYTE * 8)));
+
+    const __m128i foreground = _mm_set_epi16(
+        255, opaque.blue(), opaque.green(), opaque.red(),
+        255, opaque.blue(), opaque.green(), opaque.red());
+
+    auto blend = [&](__m128i background, __m128i alpha) {
+        __m128i value = _mm_add_epi16(
+            _mm_mullo_epi16(foreground, alpha),
+            _mm_mullo_epi16(background, _mm_sub_epi16(full, alpha)));
+
+        value = _mm_add_epi16(value, rounding);
+
+        return _mm_srli_epi16(_mm_add_epi16(value, _mm_srli_epi16(value, 8)), 8);
+    };
+
+    for (; i + 4 <= count; i += 4)
+    {
+        uint32_t alpha0 = div255(coverage[(i + 0) * step] * color_alpha);
+        uint32_t alpha1 = div255(coverage[(i + 1) * step] * color_alpha);
+        uint32_t alpha2 = div255(coverage[(i + 2) * step] * color_alpha);
+        uint32_t alpha3 = div255(coverage[(i + 3) * step] * color_alpha);
+
+        if ((alpha0 | alpha1 | alpha2 | alpha3) == 0)
+        {
+            continue;
+        }
+
+        __m128i background = _mm_loadu_si128((__m128i *)(destination + i));
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(background, alpha_mask), alpha_mask)) != 0xffff)
+        {
+            uint32_t alphas[4] = {alpha0, alpha1, alpha2, alpha3};
+
+            for (int j = 0; j < 4; j++)
+            {
+                if (alphas[j] != 0)
+                {
+                    destination[i + j] = blend_coverage_pixel(opaque, alphas[j], destination[i + j]);
+                }
+            }
+
+            continue;
+        }
+
+        __m128i low = blend(
+            _mm_unpacklo_epi8(background, zero),
+            _mm_set_epi16(alpha1, alpha1, alpha1, alpha1, alpha0, alpha0, alpha0, alpha0));
+
+        __m128i high = blend(
+            _mm_unpackhi_epi8(background, zero),
+            _mm_set_epi16(alpha3, alpha3, alpha3, alpha3, alpha2, alpha2, alpha2, alpha2));
+
+        _mm_storeu_si128((__m128i *)(destination + i), _mm_or_si128(_mm_packus_epi16(low, high), alpha_mask));
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        uint32_t alpha = div255(coverage[i * step] * color_alpha);
+
+        if (alpha != 0)
+        {
+            destination[i] = blend_coverage_pixel(opaque, alpha, destination[i]);
+        }
+    }
+}
+
+void Painter::blend_coverage(Rectangle destination, const uint8_t *coverage, int step, int stride, Color color)
+{
+    Rectangle transformed = apply_transform(destination);
+    Rectangle clipped = apply_clip(transformed);
+
+    if (clipped.is_empty())
+    {
+        return;
+    }
+
+    Vec2i offset = clipped.position() - transformed.position();
+    coverage += offset.y() * stride + offset.x() * step;
+
+    Color *pixels = _bitmap->pixels() + clipped.y() * _bitmap->width() + clipped.x();
+
+    for (int y = 0; y < clipped.height(); y++)
+    {
+        blend_coverage_span(pixels, coverage, step, clipped.width(), color);
+
+        pixels += _bitmap->width();
+        coverage += stride;
+    }
+}
+
+// Coverage is sampled one span at a time and only for the visible part of the
+// destination, the sampler gets positions relative to the destination.
+template <typename TSampler>
+void Painter::blend_coverage_sampled(Rectangle destination, Color color, TSampler sampler)
+{
+    Rectangle transformed = apply_transform(destination);
+    Rectangle clipped = apply_clip(transformed);
+
+    if (clipped.is_empty())
+    {
+        return;
+    }
+
+    Vec2i offset = clipped.position() - transformed.position();
+
+    uint8_t coverage[PAINTER_SPAN_SIZE];
+
+    for (int y = 0; y < clipped.height(); y++)
+    {
+        Color *pixels = _bitmap->pixels() + (clipped.y() + y) * _bitmap->width() + clipped.x();
+
+        for (int x = 0; x < clipped.width(); x += PAINTER_SPAN_SIZE)
+        {
+            int count = MIN(PAINTER_SPAN_SIZE, clipped.width() - x);
+
+            for (int i = 0; i < count; i++)
+            {
+                coverage[i] = sampler(offset + Vec2i(x + i, y)) * 255;
+            }
+
+            blend_coverage_span(pixels + x, coverage, 1, count, color);
+        }
+    }
+}
+
 void Painter::blit_bitmap_fast(Bitmap &bitmap, Rectangle source, Rectangle destination)
 {
     Rectangle clipped_destination = apply_transform(destination);
@@ -96,20 +290,127 @@ void Painter::blit_bitmap_fast(Bitmap &bitmap, Rectangle source, Rectangle desti
     }
 }
 
-void Painter::blit_bitmap_scaled(Bitmap &bitmap, Rectangle source, Rectangle destination)
+// Scaling works in 16.16 fixed point, source coordinates are computed once
+// per row and column then stepped, weights of the bilinear filter are 8 bits.
+#define SCALER_SHIFT 16
+#define SCALER_ONE (1 << SCALER_SHIFT)
+
+static inline Color scaler_lerp(Color from, Color to, uint32_t weight)
 {
-    if (destination.is_empty())
+    uint32_t inverse = 256 - weight;
+
+    return Color::from_byte(
+        (from.red() * inverse + to.red() * weight) >> 8,
+        (from.green() * inverse + to.green() * weight) >> 8,
+        (from.blue() * inverse + to.blue() * weight) >> 8,
+        (from.alpha() * inverse + to.alpha() * weight) >> 8);
+}
+
+static inline Color scaler_sample_linear(Bitmap &bitmap, Rectangle source, int sx, int sy)
+{
+    int x0 = sx >> SCALER_SHIFT;
+    int y0 = sy >> SCALER_SHIFT;
+    int x1 = MIN(x0 + 1, source.x() + source.width() - 1);
+    int y1 = MIN(y0 + 1, source.y() + source.height() - 1);
+
+    uint32_t fx = (sx >> (SCALER_SHIFT - 8)) & 0xff;
+    uint32_t fy = (sy >> (SCALER_SHIFT - 8)) & 0xff;
+
+    Color c00 = bitmap.get_pixel_no_check(Vec2i(x0, y0));
+    Color c10 = bitmap.get_pixel_no_check(Vec2i(x1, y0));
+    Color c01 = bitmap.get_pixel_no_check(Vec2i(x0, y1));
+    Color c11 = bitmap.get_pixel_no_check(Vec2i(x1, y1));
+
+    return scaler_lerp(scaler_lerp(c00, c10, fx), scaler_lerp(c01, c11, fx), fy);
+}
+
+// When shrinking by more than two, bilinear filtering skips source pixels,
+// average the whole footprint of the destination pixel instead.
+static inline Color scaler_sample_box(Bitmap &bitmap, int sx, int sy, int step_x, int step_y)
+{
+    int x0 = sx >> SCALER_SHIFT;
+    int y0 = sy >> SCALER_SHIFT;
+    int x1 = MAX(x0 + 1, (sx + step_x) >> SCALER_SHIFT);
+    int y1 = MAX(y0 + 1, (sy + step_y) >> SCALER_SHIFT);
+
+    uint32_t red = 0, green = 0, blue = 0, alpha = 0;
+
+    for (int y = y0; y < y1; y++)
+    {
+        Color *row = bitmap.pixels() + y * bitmap.width();
+
+        for (int x = x0; x < x1; x++)
+        {
+            red += row[x].red();
+            green += row[x].green();
+            blue += row[x].blue();
+            alpha += row[x].alpha();
+        }
+    }
+
+    uint32_t count = (x1 - x0) * (y1 - y0);
+
+    return Color::from_byte(red / count, green / count, blue / count, alpha / count);
+}
+
+void Painter::blit_bitmap_scaled_fixed(Bitmap &bitmap, Rectangle source, Rectangle destination, bool blend)
+{
+    source = source.clipped_with(bitmap.bound());
+
+    if (destination.is_empty() || source.is_empty())
+    {
+        return;
+    }
+
+    Rectangle transformed = apply_transform(destination);
+    Rectangle clipped = apply_clip(transformed);
+
+    if (clipped.is_empty())
+    {
         return;
+    }
+
+    int step_x = ((int64_t)source.width() << SCALER_SHIFT) / destination.width();
+    int step_y = ((int64_t)source.height() << SCALER_SHIFT) / destination.height();
+
+    bool box = bitmap.filtering() == BITMAP_FILTERING_LINEAR && (step_x > 2 * SCALER_ONE || step_y > 2 * SCALER_ONE);
+    bool linear = bitmap.filtering() == BITMAP_FILTERING_LINEAR && !box;
+
+    Vec2i offset = clipped.position() - transformed.position();
 
-    for (int x = 0; x < destination.width(); x++)
+    int start_x = (source.x() << SCALER_SHIFT) + offset.x() * step_x;
+    int sy = (source.y() << SCALER_SHIFT) + offset.y() * step_y;
+
+    for (int y = 0; y < clipped.height(); y++, sy += step_y)
     {
-        for (int y = 0; y < destination.height(); y++)
+        Color *pixels = _bitmap->pixels() + (clipped.y() + y) * _bitmap->width() + clipped.x();
+        int sx = start_x;
+
+        for (int x = 0; x < clipped.width(); x++, sx += step_x)
         {
-            float xx = x / (float)destination.width();
-            float yy = y / (float)destination.height();
+            Color sample;
+
+            if (box)
+            {
+                sample = scaler_sample_box(bitmap, sx, sy, step_x, step_y);
+            }
+            else if (linear)
+            {
+                sample = scaler_sample_linear(bitmap, source, sx, sy);
+            }
+            else
+            {
+                sample = bitmap.get_pixel_no_check(Vec2i(sx >> SCALER_SHIFT, sy >> SCALER_SHIFT));
+            }
 
-            Color sample = bitmap.sample(source, Vec2f(xx, yy));
-            plot_pixel(destination.position() + Vec2i(x, y), sample);
+            if (blend)
+            {
+                pixels[x] = Color::blend(sample, pixels[x]);
+            }
+            else
+            {
+                pixels[x] = sample.with_alpha(1);
+            }
         }
     }
 }
@@ -126,7 +427,7 @@ __flatten void Painter::blit_bitmap(Bitmap &bitmap, Rectangle source, Rectangle
     }
     else
     {
-        blit_bitmap_scaled(bitmap, source, destination);
+        blit_bitmap_scaled_fixed(bitmap, source, destination, true);
     }
 }
 
@@ -153,21 +454,6 @@ void Painter::blit_bitmap_fast_no_alpha(Bitmap &bitmap, Rectangle source, Rectan
     }
 }
 
-void Painter::blit_bitmap_scaled_no_alpha(Bitmap &bitmap, Rectangle source, Rectangle destination)
-{
-    for (int x = 0; x < destination.width(); x++)
-    {
-        for (int y = 0; y < destination.height(); y++)
-        {
-            float xx = x / (float)destination.width();
-            float yy = y / (float)destination.height();
-
-            Color sample = bitmap.sample(source, Vec2f(xx, yy));
-            plot_pixel(destination.position() + Vec2i(x, y), sample);
-        }
-    }
-}
-
 __flatten void Painter::blit_bitmap_no_alpha(Bitmap &bitmap, Rectangle source, Rectangle destination)
 {
     if (source.width() == destination.width() &&
@@ -177,7 +463,7 @@ __flatten void Painter::blit_bitmap_no_alpha(Bitmap &bitmap, Rectangle source, R
     }
     else
     {
-        blit_bitmap_scaled_no_alpha(bitmap, source, destination);
+        blit_bitmap_scaled_fixed(bitmap, source, destination, false);
     }
 }
 
@@ -322,18 +608,11 @@ static float sample_fill_circle(Vec2i center, float radius, Vec2i position)
     return clamp(0.5 - distance, 0, 1);
 }
 
-static void fill_circle_helper(Painter &painter, Rectangle bound, Vec2i center, int radius, Color color)
+void Painter::fill_circle_helper(Rectangle bound, Vec2i center, int radius, Color color)
 {
-    for (int x = 0; x < bound.width(); x++)
-    {
-        for (int y = 0; y < bound.height(); y++)
-        {
-            float distance = sample_fill_circle(center, radius - 0.5, Vec2i(x, y));
-            float alpha = color.alphaf() * distance;
-
-            painter.plot_pixel(Vec2i(bound.x() + x, bound.y() + y), color.with_alpha(alpha));
-        }
-    }
+    blend_coverage_sampled(bound, color, [&](Vec2i position) {
+        return sample_fill_circle(center, radius - 0.5, position);
+    });
 }
 
 __flatten void Painter::fill_rounded_rectangle(Rectangle bound, int radius, Color color)
@@ -344,12 +623,12 @@ __flatten void Painter::fill_rounded_rectangle(Rectangle bound, int radius, Colo
     Rectangle left_ear = bound.take_left(radius);
     Rectangle right_ear = bound.take_right(radius);
 
-    fill_circle_helper(*this, left_ear.take_top(radius), Vec2i(radius - 1, radius - 1), radius, color);
-    fill_circle_helper(*this, left_ear.take_bottom(radius), Vec2i(radius - 1, 0), radius, color);
+    fill_circle_helper(left_ear.take_top(radius), Vec2i(radius - 1, radius - 1), radius, color);
+    fill_circle_helper(left_ear.take_bottom(radius), Vec2i(radius - 1, 0), radius, color);
     fill_rectangle(left_ear.cutoff_top_and_botton(radius, radius), color);
 
-    fill_circle_helper(*this, right_ear.take_top(radius), Vec2i(0, radius - 1), radius, color);
-    fill_circle_helper(*this, right_ear.take_bottom(radius), Vec2i::zero(), radius, color);
+    fill_circle_helper(right_ear.take_top(radius), Vec2i(0, radius - 1), radius, color);
+    fill_circle_helper(right_ear.take_bottom(radius), Vec2i::zero(), radius, color);
     fill_rectangle(right_ear.cutoff_top_and_botton(radius, radius), color);
 
     fill_rectangle(bound.cutoff_left_and_right(radius, radius), color);
@@ -557,18 +836,9 @@ static double sample_draw_circle(Vec2i center, double radius, double thickness,
 
 void Painter::draw_circle_helper(Rectangle bound, Vec2i center, int radius, int thickness, Color color)
 {
-    for (int x = 0; x < bound.width(); x++)
-    {
-        for (int y = 0; y < bound.height(); y++)
-        {
-            Vec2i position = Vec2i(x, y);
-
-            double distance = sample_draw_circle(center, radius - 0.5, thickness, position);
-            double alpha = color.alphaf() * distance;
-
-            plot_pixel(bound.position() + position, color.with_alpha(alpha));
-        }
-    }
+    blend_coverage_sampled(bound, color, [&](Vec2i position) {
+        return sample_draw_circle(center, radius - 0.5, thickness, position);
+    });
 }
 
 __flatten void Painter::draw_rounded_rectangle(Rectangle bound, int radius, int thickness, Color color)
@@ -596,20 +866,25 @@ __flatten void Painter::blit_icon(Icon &icon, IconSize size, Rectangle destinati
 {
     Bitmap &bitmap = *icon.bitmap(size);
 
-    for (int x = 0; x < destination.width(); x++)
+    if (bitmap.bound().size() == destination.size())
     {
-        for (int y = 0; y < destination.height(); y++)
-        {
-            Vec2f sample_point(
-                x / (double)destination.width(),
-                y / (double)destination.height());
-
-            Color sample = bitmap.sample(sample_point);
+        blend_coverage(
+            destination,
+            reinterpret_cast<const uint8_t *>(bitmap.pixels()) + PAINTER_ALPHA_BYTE,
+            sizeof(Color),
+            bitmap.width() * sizeof(Color),
+            color);
 
-            auto alpha = sample.alphaf() * color.alphaf();
-            plot_pixel(destination.position() + Vec2i(x, y), color.with_alpha(alpha));
-        }
+        return;
     }
+
+    blend_coverage_sampled(destination, color, [&](Vec2i position) {
+        Vec2f sample_point(
+            position.x() / (double)destination.width(),
+            position.y() / (double)destination.height());
+
+        return bitmap.sample(sample_point).alphaf();
+    });
 }
 
 __flatten void Painter::blur_rectangle(Rectangle rectangle, int radius)
@@ -617,30 +892,30 @@ __flatten void Painter::blur_rectangle(Rectangle rectangle, int radius)
     rectangle = apply_transform(rectangle);
     rectangle = apply_clip(rectangle);
 
-    stackblurJob((unsigned char *)_bitmap->pixels(),
-                 _bitmap->width(),
-                 _bitmap->height(),
-                 radius,
-                 rectangle.x(), rectangle.x() + rectangle.width(),
-                 rectangle.y(), rectangle.y() + rectangle.height());
+    blur_bitmap_region(*_bitmap, rectangle, radius);
 }
 
 __flatten void Painter::blit_bitmap_colored(Bitmap &bitmap, Rectangle source, Rectangle destination, Color color)
 {
-    for (int x = 0; x < destination.width(); x++)
+    if (source.size() == destination.size())
     {
-        for (int y = 0; y < destination.height(); y++)
-        {
-            Vec2f sample_point(
-                x / (double)destination.width(),
-                y / (double)destination.height());
+        blend_coverage(
+            destination,
+            reinterpret_cast<const uint8_t *>(bitmap.pixels() + source.y() * bitmap.width() + source.x()) + PAINTER_RED_BYTE,
+            sizeof(Color),
+            bitmap.width() * sizeof(Color),
+            color);
 
-            Color sample = bitmap.sample(source, sample_point);
-
-            auto alpha = sample.redf() * color.alphaf();
-            plot_pixel(destination.position() + Vec2i(x, y), color.with_alpha(alpha));
-        }
+        return;
     }
+
+    blend_coverage_sampled(destination, color, [&](Vec2i position) {
+        Vec2f sample_point(
+            position.x() / (double)destination.width(),
+            position.y() / (double)destination.height());
+
+        return bitmap.sample(source, sample_point).redf();
+    });
 }
 
 void Painter::draw_glyph(Font &font, Glyph &glyph, Vec2i position, Color color)
@@ -669,62 +944,41 @@ void Painter::draw_string_within(Font &font, const char *str, Rectangle containe
 
 void Painter::draw_truetype_glyph(TrueTypeFont *font, TrueTypeGlyph *glyph, Vec2i position, Color color)
 {
-    Rectangle dest(position + glyph->offset, glyph->bound.size());
-    TrueTypeAtlas *atlas = truetypefont_get_atlas(font);
+    __unused(font);
 
-    for (int x = 0; x < dest.width(); x++)
-    {
-        for (int y = 0; y < dest.height(); y++)
-        {
-            int pixel_index = (y + glyph->bound.y()) * atlas->width + (x + glyph->bound.x());
-
-            auto alpha = (atlas->buffer[pixel_index] / 255.0) * color.alphaf();
+    TrueTypeAtlas *atlas = glyph->atlas;
 
-            plot_pixel(dest.position() + Vec2i(x, y), color.with_alpha(alpha));
-        }
+    if (atlas == nullptr)
+    {
+        return;
     }
 
-    //draw_rectangle( dest, COLOR_RED);
+    blend_coverage(
+        Rectangle(position + glyph->offset, glyph->bound.size()),
+        atlas->buffer + glyph->bound.y() * atlas->width + glyph->bound.x(),
+        1,
+        atlas->width,
+        color);
 }
 
-#include <libsystem/Logger.h>
-
 __flatten void Painter::draw_truetype_string(TrueTypeFont *font, const char *string, Vec2i position, Color color)
 {
-    // Rectangle bound = truetypefont_mesure_string(font, string);
-    // TrueTypeFontMetrics metrics = truetypefont_get_metrics(font);
-    //
-    // bound = rectangle_offset(bound, position);
-    // bound = rectangle_offset(bound, Vec2i(0, -metrics.ascent));
-    //
-    // draw_rectangle( bound, COLOR_GREEN);
-
-    Codepoint codepoint = 0;
-    Codepoint previouse = 0;
-    size_t size = utf8_to_codepoint((const uint8_t *)string, &codepoint);
-    string += size;
-    while (size && codepoint != 0)
-    {
-        TrueTypeGlyph *glyph = truetypefont_get_glyph_for_codepoint(font, codepoint);
+    Codepoint previous = 0;
 
-        if (glyph)
+    codepoint_foreach(reinterpret_cast<const uint8_t *>(string), [&](auto codepoint) {
+        if (previous != 0)
         {
-            if (previouse != 0)
-            {
-                int kerning = truetypefont_get_kerning_for_codepoints(font, previouse, codepoint);
-                position = position + Vec2i(kerning, 0);
-            }
+            position = position + Vec2i(truetypefont_get_kerning_for_codepoints(font, previous, codepoint), 0);
+        }
 
-            draw_truetype_glyph(font, glyph, position, color);
+        TrueTypeGlyph *glyph = truetypefont_get_glyph_for_codepoint(font, codepoint);
 
-            position = position + Vec2i(glyph->advance, 0);
-        }
+        draw_truetype_glyph(font, glyph, position, color);
 
-        previouse = codepoint;
+        position = position + Vec2i(glyph->advance, 0);
 
-        size_t size = utf8_to_codepoint((const uint8_t *)string, &codepoint);
-        string += size;
-    }
+        previous = codepoint;
+    });
 }
 
 void Painter::draw_truetype_string_within(TrueTypeFont *font, const char *str, Rectangle container, Position position, Color color)
@@ -7,6 +7,8 @@
 
 #define STATESTACK_SIZE 32
 
+#define PAINTER_SPAN_SIZE 64
+
 struct PainterState
 {
     Vec2i origine;
@@ -88,11 +90,9 @@ private:
 
     void blit_bitmap_fast(Bitmap &bitmap, Rectangle source, Rectangle destination);
 
-    void blit_bitmap_scaled(Bitmap &bitmap, Rectangle source, Rectangle destination);
-
     void blit_bitmap_fast_no_alpha(Bitmap &bitmap, Rectangle source, Rectangle destination);
 
-    void blit_bitmap_scaled_no_alpha(Bitmap &bitmap, Rectangle source, Rectangle destination);
+    void blit_bitmap_scaled_fixed(Bitmap &bitmap, Rectangle source, Rectangle destination, bool blend);
 
     void draw_line_x_aligned(int x, int start, int end, Color color);
 
@@ -103,4 +103,11 @@ private:
     void blit_bitmap_colored(Bitmap &src, Rectangle src_rect, Rectangle dst_rect, Color color);
 
     void draw_circle_helper(Rectangle bound, Vec2i center, int radius, int thickness, Color color);
+
+    void fill_circle_helper(Rectangle bound, Vec2i center, int radius, Color color);
+
+    void blend_coverage(Rectangle destination, const uint8_t *coverage, int step, int stride, Color color);
+
+    template <typename TSampler>
+    void blend_coverage_sampled(Rectangle destination, Color color, TSampler sampler);
 };
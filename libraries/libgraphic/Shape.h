@@ -154,6 +154,16 @@ public:
 
     bool is_empty() const { return _width == 0 || _height == 0; };
 
+    bool operator==(const Rectangle &other) const
+    {
+        return _x == other._x &&
+               _y == other._y &&
+               _width == other._width &&
+               _height == other._height;
+    }
+
+    bool operator!=(const Rectangle &other) const { return !(*this == other); }
+
     Rectangle() = default;
 
     Rectangle(int width, int height)
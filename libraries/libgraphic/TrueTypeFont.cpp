@@ -1,201 +1,393 @@
+#include <libfile/MappedFile.h>
 #include <libgraphic/Bitmap.h>
 #include <libgraphic/TrueType.h>
 #include <libgraphic/TrueTypeFont.h>
+#include <libsystem/Logger.h>
 #include <libsystem/io/Stream.h>
 #include <libsystem/math/Vectors.h>
+#include <libutils/HashMap.h>
+#include <libutils/Vector.h>
+
+#define TRUETYPE_PAGE_SIZE 512
+#define TRUETYPE_PAGE_COUNT 8
+#define TRUETYPE_GLYPH_PADDING 1
+#define TRUETYPE_ASCII_COUNT 128
 
 struct TrueTypeFamily
 {
     truetype::File info;
-    void *buffer;
-    size_t buffer_size;
+    RefPtr<MappedFile> file;
 };
 
 struct TrueTypeFont
 {
-    truetype_pack_context rasterizer;
-
     TrueTypeFamily *family;
     int size;
+    float scale;
 
-    size_t glyphs_count;
-    TrueTypeGlyph *glyphs;
-    TrueTypeAtlas *atlas;
+    TrueTypeGlyph *ascii[TRUETYPE_ASCII_COUNT] = {};
+    HashMap<Codepoint, TrueTypeGlyph *> glyphs{};
+
+    // Both codepoints of the pair are packed in the key, the kerning of pairs
+    // outside of the BMP isn't cached.
+    HashMap<uint32_t, int> kerning{};
 };
 
-TrueTypeFamily *truetype_family_create(const char *path)
+struct TrueTypeShelf
 {
-    Stream *font_file = stream_open(path, OPEN_READ);
+    int y;
+    int height;
+    int used;
+};
 
-    FileState state = {};
-    stream_stat(font_file, &state);
+struct TrueTypePage
+{
+    TrueTypeAtlas *atlas;
+    Vector<TrueTypeShelf> shelves;
+    Vector<TrueTypeGlyph *> glyphs;
+    int used;
+    uint32_t last_used;
+};
 
-    TrueTypeFamily *family = __create(TrueTypeFamily);
-    family->buffer_size = state.size;
-    family->buffer = malloc(state.size);
+/* --- Glyph Cache ---------------------------------------------------------- */
 
-    stream_read(font_file, family->buffer, state.size);
+static Vector<TrueTypePage *> _pages{};
 
-    truetype_InitFont(&family->info, (unsigned char *)family->buffer);
+static uint32_t _clock = 0;
 
-    return family;
+static TrueTypePage *truetype_page_create()
+{
+    auto page = new TrueTypePage();
+
+    page->atlas = (TrueTypeAtlas *)calloc(1, sizeof(TrueTypeAtlas) + TRUETYPE_PAGE_SIZE * TRUETYPE_PAGE_SIZE);
+    page->atlas->width = TRUETYPE_PAGE_SIZE;
+    page->atlas->height = TRUETYPE_PAGE_SIZE;
+
+    _pages.push_back(page);
+
+    return page;
 }
 
-void truetype_family_destroy(TrueTypeFamily *family)
+static void truetypefont_forget_glyph(TrueTypeFont *font, TrueTypeGlyph *glyph)
 {
-    free(family->buffer);
-    free(family);
+    if (glyph->codepoint < TRUETYPE_ASCII_COUNT)
+    {
+        font->ascii[glyph->codepoint] = nullptr;
+    }
+    else
+    {
+        font->glyphs.remove_key(glyph->codepoint);
+    }
 }
 
-TrueTypeFont *truetypefont_create(TrueTypeFamily *family, int size)
+static void truetype_page_evict(TrueTypePage *page)
 {
-    TrueTypeFont *font = __create(TrueTypeFont);
+    for (size_t i = 0; i < page->glyphs.count(); i++)
+    {
+        truetypefont_forget_glyph(page->glyphs[i]->font, page->glyphs[i]);
+        delete page->glyphs[i];
+    }
 
-    font->family = family;
-    font->size = size;
+    page->glyphs.clear();
+    page->shelves.clear();
+    page->used = 0;
+}
 
-    TrueTypeAtlas *atlas = (TrueTypeAtlas *)malloc(sizeof(TrueTypeAtlas) + 512 * 512);
-    atlas->width = 512;
-    atlas->height = 512;
+// Shelf packing: glyphs go on the shortest shelf they fit on, a new shelf is
+// only opened when the best one would waste more than half of its height.
+static bool truetype_page_allocate(TrueTypePage *page, int width, int height, Vec2i &position)
+{
+    TrueTypeShelf *best = nullptr;
 
-    font->atlas = atlas;
+    for (size_t i = 0; i < page->shelves.count(); i++)
+    {
+        TrueTypeShelf &shelf = page->shelves[i];
 
-    truetype_PackBegin(
-        &font->rasterizer,
-        atlas->buffer,
-        atlas->width,
-        atlas->height,
-        0,
-        1);
+        if (shelf.height >= height &&
+            shelf.used + width <= TRUETYPE_PAGE_SIZE &&
+            (best == nullptr || shelf.height < best->height))
+        {
+            best = &shelf;
+        }
+    }
 
-    //truetypefont_raster_range(font, 0x0020, 0x007f);
-    //truetypefont_raster_range(font, 0x00A0, 0x00FF);
+    bool can_open_shelf = page->used + height <= TRUETYPE_PAGE_SIZE;
 
-    return font;
+    if (best == nullptr || (can_open_shelf && best->height > height * 2))
+    {
+        if (!can_open_shelf)
+        {
+            return false;
+        }
+
+        page->shelves.push_back({page->used, height, 0});
+        page->used += height;
+
+        best = &page->shelves[page->shelves.count() - 1];
+    }
+
+    position = Vec2i(best->used, best->y);
+    best->used += width;
+
+    return true;
 }
 
-void truetypefont_destroy(TrueTypeFont *font)
+static TrueTypePage *truetype_cache_allocate(int width, int height, Vec2i &position)
 {
-    truetype_PackEnd(&font->rasterizer);
+    width += TRUETYPE_GLYPH_PADDING;
+    height += TRUETYPE_GLYPH_PADDING;
 
-    if (font->glyphs)
+    if (width > TRUETYPE_PAGE_SIZE || height > TRUETYPE_PAGE_SIZE)
     {
-        free(font->glyphs);
+        return nullptr;
     }
 
-    free(font->atlas);
-    free(font);
-}
+    for (size_t i = 0; i < _pages.count(); i++)
+    {
+        if (truetype_page_allocate(_pages[i], width, height, position))
+        {
+            return _pages[i];
+        }
+    }
 
-void truetypefont_raster_range(TrueTypeFont *font, Codepoint start, Codepoint end)
-{
-    size_t start_index = 0;
-    size_t count = end - start + 1;
+    TrueTypePage *page = nullptr;
 
-    if (!font->glyphs)
+    if (_pages.count() < TRUETYPE_PAGE_COUNT)
     {
-        font->glyphs_count = count;
-        font->glyphs = (TrueTypeGlyph *)calloc(font->glyphs_count, sizeof(TrueTypeGlyph));
+        page = truetype_page_create();
     }
     else
     {
-        start_index = font->glyphs_count;
+        page = _pages[0];
+
+        for (size_t i = 1; i < _pages.count(); i++)
+        {
+            if (_pages[i]->last_used < page->last_used)
+            {
+                page = _pages[i];
+            }
+        }
 
-        font->glyphs_count += count;
-        font->glyphs = (TrueTypeGlyph *)realloc(font->glyphs, font->glyphs_count * sizeof(TrueTypeGlyph));
+        truetype_page_evict(page);
     }
 
-    __cleanup_malloc truetype_packedchar *packedchar = (truetype_packedchar *)calloc(0x02AF, sizeof(truetype_packedchar));
-    truetype_PackFontRange(&font->rasterizer, (unsigned char *)font->family->buffer, font->size, start, count, packedchar);
+    truetype_page_allocate(page, width, height, position);
+
+    return page;
+}
 
-    for (size_t i = 0; i < count; i++)
+/* --- Family --------------------------------------------------------------- */
+
+TrueTypeFamily *truetype_family_create(const char *path)
+{
+    auto result_or_file = MappedFile::open(path);
+
+    if (!result_or_file.success())
     {
-        TrueTypeGlyph *glyph = &font->glyphs[start_index + i];
+        logger_error("Failed to open font %s: %s", path, result_to_string(result_or_file.result()));
+        return nullptr;
+    }
+
+    auto family = new TrueTypeFamily();
+    family->file = result_or_file.take_value();
+
+    // The tables are read straight from the mapped file.
+    truetype_InitFont(&family->info, reinterpret_cast<const unsigned char *>(family->file->start()));
+
+    return family;
+}
+
+void truetype_family_destroy(TrueTypeFamily *family)
+{
+    delete family;
+}
 
-        glyph->advance = packedchar[i].xadvance;
+/* --- Font ----------------------------------------------------------------- */
 
-        glyph->offset = Vec2i(packedchar[i].xoff, packedchar[i].yoff);
+TrueTypeFont *truetypefont_create(TrueTypeFamily *family, int size)
+{
+    auto font = new TrueTypeFont();
 
-        glyph->codepoint = start + i;
+    font->family = family;
+    font->size = size;
+    font->scale = truetype_ScaleForPixelHeight(&family->info, size);
 
-        glyph->bound = Rectangle(
-            packedchar[i].x0,
-            packedchar[i].y0,
-            packedchar[i].x1 - packedchar[i].x0,
-            packedchar[i].y1 - packedchar[i].y0);
+    return font;
+}
+
+static void truetypefont_release_glyph(TrueTypeGlyph *glyph)
+{
+    if (glyph == nullptr)
+    {
+        return;
     }
+
+    if (glyph->page)
+    {
+        glyph->page->glyphs.remove_value(glyph);
+    }
+
+    delete glyph;
 }
 
-TrueTypeAtlas *truetypefont_get_atlas(TrueTypeFont *font)
+void truetypefont_destroy(TrueTypeFont *font)
 {
-    return font->atlas;
+    for (size_t i = 0; i < TRUETYPE_ASCII_COUNT; i++)
+    {
+        truetypefont_release_glyph(font->ascii[i]);
+    }
+
+    font->glyphs.foreach ([](auto &, auto &glyph) {
+        truetypefont_release_glyph(glyph);
+        return Iteration::CONTINUE;
+    });
+
+    delete font;
 }
 
-static TrueTypeGlyph *lookup_glyph(TrueTypeFont *font, Codepoint codepoint)
+static TrueTypeGlyph *truetypefont_raster_glyph(TrueTypeFont *font, Codepoint codepoint)
 {
-    for (size_t i = 0; i < font->glyphs_count; i++)
+    auto info = &font->family->info;
+
+    int index = truetype_FindGlyphIndex(info, codepoint);
+
+    int x0, y0, x1, y1;
+    truetype_GetGlyphBitmapBox(info, index, font->scale, font->scale, &x0, &y0, &x1, &y1);
+
+    int advance, left_side_bearing;
+    truetype_GetGlyphHMetrics(info, index, &advance, &left_side_bearing);
+
+    auto glyph = new TrueTypeGlyph();
+
+    glyph->codepoint = codepoint;
+    glyph->offset = Vec2i(x0, y0);
+    glyph->advance = font->scale * advance;
+    glyph->font = font;
+
+    int width = x1 - x0;
+    int height = y1 - y0;
+
+    Vec2i position = Vec2i::zero();
+    TrueTypePage *page = nullptr;
+
+    if (width > 0 && height > 0)
     {
-        if (font->glyphs[i].codepoint == codepoint)
-        {
-            return &font->glyphs[i];
-        }
+        page = truetype_cache_allocate(width, height, position);
+    }
+
+    if (page != nullptr)
+    {
+        TrueTypeAtlas *atlas = page->atlas;
+
+        truetype_MakeGlyphBitmap(
+            info,
+            atlas->buffer + position.y() * atlas->width + position.x(),
+            width, height, atlas->width,
+            font->scale, font->scale,
+            index);
+
+        glyph->bound = Rectangle(position, Vec2i(width, height));
+        glyph->page = page;
+        glyph->atlas = atlas;
+
+        page->glyphs.push_back(glyph);
     }
+    else
+    {
+        // Blank glyphs and glyphs bigger than a page don't take space in the cache.
+        glyph->bound = Rectangle::empty();
+        glyph->page = nullptr;
+        glyph->atlas = nullptr;
+    }
+
+    return glyph;
+}
 
-    return nullptr;
+void truetypefont_raster_range(TrueTypeFont *font, Codepoint start, Codepoint end)
+{
+    for (Codepoint codepoint = start; codepoint <= end; codepoint++)
+    {
+        truetypefont_get_glyph_for_codepoint(font, codepoint);
+    }
 }
 
 TrueTypeGlyph *truetypefont_get_glyph_for_codepoint(TrueTypeFont *font, Codepoint codepoint)
 {
-    TrueTypeGlyph *glyph = lookup_glyph(font, codepoint);
+    TrueTypeGlyph *glyph = nullptr;
 
-    if (glyph != nullptr)
+    if (codepoint < TRUETYPE_ASCII_COUNT)
     {
-        return glyph;
+        glyph = font->ascii[codepoint];
+    }
+    else if (font->glyphs.has_key(codepoint))
+    {
+        glyph = font->glyphs[codepoint];
+    }
+
+    if (glyph == nullptr)
+    {
+        // Rasterizing may evict a page and drop entries of this font, only
+        // store the new glyph once it has found its place in the atlas.
+        glyph = truetypefont_raster_glyph(font, codepoint);
+
+        if (codepoint < TRUETYPE_ASCII_COUNT)
+        {
+            font->ascii[codepoint] = glyph;
+        }
+        else
+        {
+            font->glyphs[codepoint] = glyph;
+        }
     }
 
-    truetypefont_raster_range(font, codepoint, codepoint);
+    if (glyph->page)
+    {
+        glyph->page->last_used = ++_clock;
+    }
 
-    return lookup_glyph(font, codepoint);
+    return glyph;
 }
 
 Rectangle truetypefont_mesure_string(TrueTypeFont *font, const char *string)
 {
-    Codepoint codepoint = 0;
-
     int width = 0;
+    Codepoint previous = 0;
 
-    size_t size = utf8_to_codepoint((const uint8_t *)string, &codepoint);
-    string += size;
-    while (size && codepoint != 0)
-    {
-        TrueTypeGlyph *glyph = truetypefont_get_glyph_for_codepoint(font, codepoint);
+    codepoint_foreach(reinterpret_cast<const uint8_t *>(string), [&](auto codepoint) {
+        if (previous != 0)
+        {
+            width += truetypefont_get_kerning_for_codepoints(font, previous, codepoint);
+        }
 
-        width += glyph->advance;
+        width += truetypefont_get_glyph_for_codepoint(font, codepoint)->advance;
 
-        size_t size = utf8_to_codepoint((const uint8_t *)string, &codepoint);
-        string += size;
-    }
+        previous = codepoint;
+    });
 
     return Rectangle(width, font->size);
 }
 
-#include <libsystem/Logger.h>
-
 int truetypefont_get_kerning_for_codepoints(TrueTypeFont *font, Codepoint left, Codepoint right)
 {
-    auto scale = truetype_ScaleForPixelHeight(&font->family->info, font->size);
+    if (left > 0xffff || right > 0xffff)
+    {
+        return truetype_GetCodepointKernAdvance(&font->family->info, left, right) * font->scale;
+    }
 
-    int kerning = truetype_GetCodepointKernAdvance(&font->family->info, left, right);
+    uint32_t pair = (left << 16) | right;
 
-    return kerning * scale;
+    if (!font->kerning.has_key(pair))
+    {
+        font->kerning[pair] = truetype_GetCodepointKernAdvance(&font->family->info, left, right) * font->scale;
+    }
+
+    return font->kerning[pair];
 }
 
 TrueTypeFontMetrics truetypefont_get_metrics(TrueTypeFont *font)
 {
     TrueTypeFontMetrics metrics = {};
 
-    auto scale = truetype_ScaleForPixelHeight(&font->family->info, font->size);
-
     truetype_GetFontVMetrics(
         &font->family->info,
 
@@ -203,9 +395,9 @@ TrueTypeFontMetrics truetypefont_get_metrics(TrueTypeFont *font)
         &metrics.descent,
         &metrics.linegap);
 
-    metrics.ascent *= scale;
-    metrics.descent *= scale;
-    metrics.linegap *= scale;
+    metrics.ascent *= font->scale;
+    metrics.descent *= font->scale;
+    metrics.linegap *= font->scale;
 
     return metrics;
 }
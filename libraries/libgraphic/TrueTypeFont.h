@@ -14,19 +14,27 @@ struct TrueTypeFontMetrics
     int linegap;
 };
 
+struct TrueTypeAtlas
+{
+    int width;
+    int height;
+    uint8_t buffer[];
+};
+
+struct TrueTypePage;
+
+// Glyphs live in atlas pages shared by every font, they stay valid until the
+// next glyph lookup since that may evict the page they are on.
 struct TrueTypeGlyph
 {
     Codepoint codepoint;
     Rectangle bound;
     Vec2i offset;
     int advance;
-};
 
-struct TrueTypeAtlas
-{
-    int width;
-    int height;
-    uint8_t buffer[];
+    TrueTypeFont *font;
+    TrueTypePage *page;
+    TrueTypeAtlas *atlas;
 };
 
 TrueTypeFamily *truetype_family_create(const char *path);
@@ -35,9 +43,9 @@ void truetype_family_destroy(TrueTypeFamily *family);
 
 TrueTypeFont *truetypefont_create(TrueTypeFamily *family, int size);
 
-void truetypefont_raster_range(TrueTypeFont *font, Codepoint start, Codepoint end);
+void truetypefont_destroy(TrueTypeFont *font);
 
-TrueTypeAtlas *truetypefont_get_atlas(TrueTypeFont *font);
+void truetypefont_raster_range(TrueTypeFont *font, Codepoint start, Codepoint end);
 
 TrueTypeGlyph *truetypefont_get_glyph_for_codepoint(TrueTypeFont *font, Codepoint codepoint);
 
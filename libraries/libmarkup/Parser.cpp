@@ -3,6 +3,7 @@
 #include <libsystem/core/CString.h>
 #include <libsystem/unicode/Codepoint.h>
 #include <libsystem/utils/NumberParser.h>
+#include <libutils/Intern.h>
 #include <libutils/Scanner.h>
 #include <libutils/ScannerUtils.h>
 #include <libutils/StringBuilder.h>
@@ -32,7 +33,7 @@ static String identifier(Scanner &scan)
         scan.foreward();
     }
 
-    return builder.finalize();
+    return intern(builder.view());
 }
 
 static String string(Scanner &scan)
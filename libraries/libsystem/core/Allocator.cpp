@@ -5,473 +5,789 @@
 #include <libsystem/io/Stream.h>
 #include <libsystem/math/MinMax.h>
 
-#define LIBALLOC_MAGIC 0xc001c0de
-#define LIBALLOC_DEAD 0xdeaddead
+// Small allocations are served from size-classed slabs of one page, bigger
+// ones from runs of contiguous pages. Pages are carved out of chunks
+// requested from the system, which are given back once they are empty.
+// Huge allocations get their own mapping.
+//
+// Every slab, run and huge mapping starts with an AllocatorSpan, so free()
+// finds the owner of a pointer by rounding it down to its page.
+//
+// Threads keep a cache of free small objects of each class, most calls to
+// malloc() and free() never take the lock.
+
+#define ALLOCATOR_SPAN_MAGIC 0x5ba5c0de
+#define ALLOCATOR_SPAN_DEAD 0xdeaddead
+
+#define ALLOCATOR_ALIGN 16
+#define ALLOCATOR_PAGE_SIZE 4096
+#define ALLOCATOR_CHUNK_PAGES 16
+
+// Runs bigger than this are mapped on their own.
+#define ALLOCATOR_LARGE_PAGES 8
+
+// Objects of each class a thread cache holds, it is refilled and flushed
+// by halves.
+#define ALLOCATOR_CACHE_DEPTH 32
+
+#define ALLOCATOR_CLASS_LARGE 0xfffe
+#define ALLOCATOR_CLASS_HUGE 0xffff
+
+static constexpr size_t _size_classes[] = {
+    16, 32, 48, 64, 80, 96, 112, 128,
+    160, 192, 224, 256, 320, 384, 448, 512,
+    640, 768, 1024};
+
+#define ALLOCATOR_CLASS_COUNT (sizeof(_size_classes) / sizeof(size_t))
+#define ALLOCATOR_SMALL_MAX 1024
+
+// Maps (size + 15) / 16 to the smallest class that fits, so picking a
+// class doesn't need a search.
+struct AllocatorClassTable
+{
+    uint8_t classes[ALLOCATOR_SMALL_MAX / ALLOCATOR_ALIGN + 1];
+
+    constexpr AllocatorClassTable() : classes()
+    {
+        size_t size_class = 0;
+
+        for (size_t i = 0; i <= ALLOCATOR_SMALL_MAX / ALLOCATOR_ALIGN; i++)
+        {
+            while (_size_classes[size_class] < i * ALLOCATOR_ALIGN)
+            {
+                size_class++;
+            }
+
+            classes[i] = size_class;
+        }
+    }
+};
 
-#define USE_CASE1
-#define USE_CASE2
-#define USE_CASE3
-#define USE_CASE4
-#define USE_CASE5
+static constexpr AllocatorClassTable _class_table{};
 
-struct MinorBlock;
+struct AllocatorChunk;
 
-struct MajorBlock
+struct AllocatorSpan
 {
-    // The number of pages in the block.
-    size_t pages;
+    uint32_t magic;
+
+    // Index in _size_classes or ALLOCATOR_CLASS_LARGE/HUGE.
+    uint32_t size_class;
 
-    // The number of pages in the block.
-    size_t size;
+    // Number of pages covered by the span.
+    uint32_t pages;
 
-    // The number of bytes used in the block.
-    size_t usage;
+    // Objects handed out, and how many fit in the slab.
+    uint32_t used;
+    uint32_t capacity;
 
-    // Linked list information.
-    MajorBlock *prev;
+    // Objects never handed out yet, they are carved lazily from the end of the slab.
+    uint32_t carved;
 
-    // Linked list information.
-    MajorBlock *next;
+    AllocatorChunk *chunk;
 
-    // A pointer to the first allocated memory in the block.
-    MinorBlock *first;
+    // Objects freed back to the slab.
+    void *free_list;
+
+    // Slabs of the same class with free objects.
+    AllocatorSpan *prev;
+    AllocatorSpan *next;
 };
 
-#define MAJOR_BLOCK_HEADER_SIZE (__align_up(sizeof(MajorBlock), 16))
+#define ALLOCATOR_SPAN_HEADER_SIZE (__align_up(sizeof(AllocatorSpan), ALLOCATOR_ALIGN))
 
-struct MinorBlock
+// Lives in the first page of the chunk, right after the span header of that page.
+struct AllocatorChunk
 {
-    // A magic number to identify correctness.
-    size_t magic;
+    // One bit per free page.
+    uint32_t free_pages;
+
+    // Chunks with at least one free page.
+    AllocatorChunk *prev;
+    AllocatorChunk *next;
+};
 
-    // The size of the memory allocated. Could be 1 byte or more.
-    size_t size;
+#define ALLOCATOR_CHUNK_HEADER_SIZE (__align_up(sizeof(AllocatorChunk), ALLOCATOR_ALIGN))
+#define ALLOCATOR_CHUNK_ALL_FREE ((uint32_t)((1ull << ALLOCATOR_CHUNK_PAGES) - 1))
 
-    // The size of memory requested.
-    size_t req_size;
+struct AllocatorStatistics
+{
+    size_t allocations;
+
+    size_t chunks;
 
-    // Linked list information.
-    MinorBlock *prev;
+    size_t spans[ALLOCATOR_CLASS_COUNT];
+    size_t used[ALLOCATOR_CLASS_COUNT];
 
-    // Linked list information.
-    MinorBlock *next;
+    size_t large_allocations;
+    size_t large_pages;
 
-    // The owning block. A pointer to the major structure.
-    MajorBlock *block;
+    size_t huge_allocations;
+    size_t huge_pages;
 };
 
-#define MINOR_BLOCK_HEADER_SIZE (__align_up(sizeof(MinorBlock), 16))
+// Cached objects still count as used in their slab.
+struct AllocatorCache
+{
+    // Served from the cache, added to the statistics when the thread exits.
+    size_t allocations;
+
+    uint32_t counts[ALLOCATOR_CLASS_COUNT];
+    void *objects[ALLOCATOR_CLASS_COUNT][ALLOCATOR_CACHE_DEPTH];
+
+    AllocatorCache *prev;
+    AllocatorCache *next;
+};
+
+static AllocatorSpan *_partial_spans[ALLOCATOR_CLASS_COUNT] = {};
+
+static AllocatorChunk *_free_chunks = nullptr;
 
-// The root memory block acquired from the system.
-static MajorBlock *_heap_root = nullptr;
+// Completely free chunks kept around to avoid bouncing pages with the system.
+static size_t _empty_chunks = 0;
 
-// The major with the most free memory.
-static MajorBlock *_best_bet = nullptr;
+static AllocatorStatistics _statistics = {};
 
-// The size of an individual page. Set up in liballoc_init.
-static constexpr size_t _page_size = 4096;
+static AllocatorCache *_caches = nullptr;
 
-// The number of pages to request per chunk. Set up in liballoc_init.
-static constexpr size_t _page_count = 16;
+/* --- Chunks --------------------------------------------------------------- */
 
-static MajorBlock *heap_major_block_create(size_t size)
+static uintptr_t allocator_chunk_base(AllocatorChunk *chunk)
 {
-    // This is how much space is required.
-    size_t st = size + MAJOR_BLOCK_HEADER_SIZE;
-    st += MINOR_BLOCK_HEADER_SIZE;
+    return (uintptr_t)chunk - ALLOCATOR_SPAN_HEADER_SIZE;
+}
+
+static void allocator_chunk_link(AllocatorChunk *chunk)
+{
+    chunk->prev = nullptr;
+    chunk->next = _free_chunks;
 
-    // Perfect amount of space?
-    if ((st % _page_size) == 0)
+    if (_free_chunks)
     {
-        st = st / (_page_size);
+        _free_chunks->prev = chunk;
+    }
+
+    _free_chunks = chunk;
+}
+
+static void allocator_chunk_unlink(AllocatorChunk *chunk)
+{
+    if (chunk->prev)
+    {
+        chunk->prev->next = chunk->next;
     }
     else
     {
-        st = st / (_page_size) + 1;
+        _free_chunks = chunk->next;
     }
 
-    // Make sure it's >= the minimum size.
-    st = MAX(st, _page_count);
+    if (chunk->next)
+    {
+        chunk->next->prev = chunk->prev;
+    }
+}
 
-    MajorBlock *maj = (MajorBlock *)__plug_memalloc_alloc(st * _page_size);
+static AllocatorChunk *allocator_chunk_create()
+{
+    uintptr_t base = (uintptr_t)__plug_memalloc_alloc(ALLOCATOR_CHUNK_PAGES * ALLOCATOR_PAGE_SIZE);
 
-    if (maj == nullptr)
+    if (base == 0)
     {
-        logger_warn("__plug_memalloc_alloc( %i ) return nullptr", st);
+        logger_warn("__plug_memalloc_alloc(%d) returned nullptr", ALLOCATOR_CHUNK_PAGES * ALLOCATOR_PAGE_SIZE);
         return nullptr;
     }
 
-    maj->prev = nullptr;
-    maj->next = nullptr;
-    maj->pages = st;
-    maj->size = st * _page_size;
-    maj->usage = MAJOR_BLOCK_HEADER_SIZE;
-    maj->first = nullptr;
+    auto chunk = (AllocatorChunk *)(base + ALLOCATOR_SPAN_HEADER_SIZE);
+    chunk->free_pages = ALLOCATOR_CHUNK_ALL_FREE;
+
+    allocator_chunk_link(chunk);
 
-    return maj;
+    _empty_chunks++;
+    _statistics.chunks++;
+
+    return chunk;
 }
 
-bool check_minor_magic(MinorBlock *min, void *ptr, void *caller)
+static void allocator_chunk_destroy(AllocatorChunk *chunk)
 {
-    if (min->magic == LIBALLOC_MAGIC)
+    allocator_chunk_unlink(chunk);
+
+    _empty_chunks--;
+    _statistics.chunks--;
+
+    __plug_memalloc_free((void *)allocator_chunk_base(chunk), ALLOCATOR_CHUNK_PAGES * ALLOCATOR_PAGE_SIZE);
+}
+
+static int allocator_chunk_find_run(AllocatorChunk *chunk, size_t pages)
+{
+    uint32_t mask = (1u << pages) - 1;
+
+    for (size_t i = 0; i + pages <= ALLOCATOR_CHUNK_PAGES; i++)
     {
-        return true;
+        if (((chunk->free_pages >> i) & mask) == mask)
+        {
+            return i;
+        }
     }
 
-    // Check for overrun errors. For all bytes of LIBALLOC_MAGIC
-    if (((min->magic & 0xFFFFFF) == (LIBALLOC_MAGIC & 0xFFFFFF)) ||
-        ((min->magic & 0xFFFF) == (LIBALLOC_MAGIC & 0xFFFF)) ||
-        ((min->magic & 0xFF) == (LIBALLOC_MAGIC & 0xFF)))
+    return -1;
+}
+
+static uintptr_t allocator_pages_alloc(size_t pages, AllocatorChunk **owner)
+{
+    AllocatorChunk *chunk = _free_chunks;
+    int index = -1;
+
+    if (pages == 1)
+    {
+        // Every chunk in the list has at least one free page.
+        if (chunk)
+        {
+            index = __builtin_ctz(chunk->free_pages);
+        }
+    }
+    else
     {
-        logger_error("Possible 1-3 byte overrun for magic 0x%x != 0x%x from 0x%x.",
-                     min->magic,
-                     LIBALLOC_MAGIC,
-                     caller);
+        while (chunk && (index = allocator_chunk_find_run(chunk, pages)) < 0)
+        {
+            chunk = chunk->next;
+        }
     }
 
-    if (min->magic == LIBALLOC_DEAD)
+    if (index < 0)
     {
-        logger_error("Multiple free(0x%x) attempt from 0x%x.",
-                     ptr,
-                     caller);
+        chunk = allocator_chunk_create();
+
+        if (chunk == nullptr)
+        {
+            return 0;
+        }
+
+        index = 0;
     }
-    else
+
+    if (chunk->free_pages == ALLOCATOR_CHUNK_ALL_FREE)
     {
-        logger_error("Bad free(0x%x) from 0x%x", ptr, caller);
+        _empty_chunks--;
     }
 
-    __plug_memalloc_unlock();
+    chunk->free_pages &= ~(((1u << pages) - 1) << index);
 
-    return false;
+    if (chunk->free_pages == 0)
+    {
+        allocator_chunk_unlink(chunk);
+    }
+
+    *owner = chunk;
+
+    return allocator_chunk_base(chunk) + index * ALLOCATOR_PAGE_SIZE;
 }
 
-void *malloc(size_t req_size)
+static void allocator_pages_free(AllocatorChunk *chunk, uintptr_t address, size_t pages)
 {
-    unsigned long long bestSize = 0;
-    unsigned long size = req_size;
-
-    __plug_memalloc_lock();
+    int index = (address - allocator_chunk_base(chunk)) / ALLOCATOR_PAGE_SIZE;
 
-    if (size == 0)
+    if (chunk->free_pages == 0)
     {
-        logger_warn("alloc(0) called from 0x%x", __builtin_return_address(0));
-        __plug_memalloc_unlock();
-
-        return malloc(1);
+        allocator_chunk_link(chunk);
     }
 
-    // Is this the first time we are being used?
-    if (_heap_root == nullptr)
+    chunk->free_pages |= ((1u << pages) - 1) << index;
+
+    if (chunk->free_pages == ALLOCATOR_CHUNK_ALL_FREE)
     {
-        _heap_root = heap_major_block_create(size);
+        _empty_chunks++;
 
-        if (_heap_root == nullptr)
+        if (_empty_chunks > 1)
         {
-            __plug_memalloc_unlock();
-            return nullptr;
+            allocator_chunk_destroy(chunk);
         }
     }
+}
+
+/* --- Spans ---------------------------------------------------------------- */
 
-    // Now we need to bounce through every major and find enough space....
-    MajorBlock *maj = _heap_root;
-    bool started_with_bestbet = false;
+static uintptr_t allocator_span_data(AllocatorSpan *span)
+{
+    uintptr_t data = (uintptr_t)span + ALLOCATOR_SPAN_HEADER_SIZE;
 
-    // Start at the best bet....
-    if (_best_bet != nullptr)
+    // The first page of a chunk also holds the chunk header.
+    if (span->chunk && (uintptr_t)span == allocator_chunk_base(span->chunk))
     {
-        bestSize = _best_bet->size - _best_bet->usage;
+        data += ALLOCATOR_CHUNK_HEADER_SIZE;
+    }
 
-        if (bestSize > (size + MINOR_BLOCK_HEADER_SIZE))
-        {
-            maj = _best_bet;
-            started_with_bestbet = true;
-        }
+    return data;
+}
+
+static size_t allocator_span_usable_size(AllocatorSpan *span)
+{
+    if (span->size_class < ALLOCATOR_CLASS_COUNT)
+    {
+        return _size_classes[span->size_class];
     }
 
-    while (maj != nullptr)
+    return (uintptr_t)span + span->pages * ALLOCATOR_PAGE_SIZE - allocator_span_data(span);
+}
+
+static AllocatorSpan *allocator_span_create(uint32_t size_class, size_t pages)
+{
+    AllocatorChunk *chunk = nullptr;
+    uintptr_t address = allocator_pages_alloc(pages, &chunk);
+
+    if (address == 0)
+    {
+        return nullptr;
+    }
+
+    auto span = (AllocatorSpan *)address;
+
+    span->magic = ALLOCATOR_SPAN_MAGIC;
+    span->size_class = size_class;
+    span->pages = pages;
+    span->used = 0;
+    span->capacity = 0;
+    span->carved = 0;
+    span->chunk = chunk;
+    span->free_list = nullptr;
+    span->prev = nullptr;
+    span->next = nullptr;
+
+    if (size_class < ALLOCATOR_CLASS_COUNT)
+    {
+        span->capacity = (address + ALLOCATOR_PAGE_SIZE - allocator_span_data(span)) / _size_classes[size_class];
+        _statistics.spans[size_class]++;
+    }
+
+    return span;
+}
+
+static void allocator_span_destroy(AllocatorSpan *span)
+{
+    if (span->size_class < ALLOCATOR_CLASS_COUNT)
+    {
+        _statistics.spans[span->size_class]--;
+    }
+
+    span->magic = ALLOCATOR_SPAN_DEAD;
+    allocator_pages_free(span->chunk, (uintptr_t)span, span->pages);
+}
+
+static void allocator_span_link(AllocatorSpan *span)
+{
+    AllocatorSpan *&head = _partial_spans[span->size_class];
+
+    span->prev = nullptr;
+    span->next = head;
+
+    if (head)
+    {
+        head->prev = span;
+    }
+
+    head = span;
+}
+
+static void allocator_span_unlink(AllocatorSpan *span)
+{
+    if (span->prev)
+    {
+        span->prev->next = span->next;
+    }
+    else
+    {
+        _partial_spans[span->size_class] = span->next;
+    }
+
+    if (span->next)
+    {
+        span->next->prev = span->prev;
+    }
+
+    span->prev = nullptr;
+    span->next = nullptr;
+}
+
+static AllocatorSpan *allocator_span_from_pointer(void *ptr)
+{
+    return (AllocatorSpan *)__align_down((uintptr_t)ptr, ALLOCATOR_PAGE_SIZE);
+}
+
+/* --- Small allocations ---------------------------------------------------- */
+
+static uint32_t allocator_small_class(size_t size)
+{
+    return _class_table.classes[(size + ALLOCATOR_ALIGN - 1) / ALLOCATOR_ALIGN];
+}
+
+static void *allocator_small_alloc(uint32_t size_class)
+{
+    AllocatorSpan *span = _partial_spans[size_class];
+
+    if (span == nullptr)
     {
-        size_t diff = maj->size - maj->usage;
-        // free memory in the block
+        span = allocator_span_create(size_class, 1);
 
-        if (bestSize < diff)
+        if (span == nullptr)
         {
-            // Hmm.. this one has more memory then our bestBet. Remember!
-            _best_bet = maj;
-            bestSize = diff;
+            return nullptr;
         }
 
-#ifdef USE_CASE1
+        allocator_span_link(span);
+    }
 
-        // CASE 1:  There is not enough space in this major block.
-        if (diff < (size + MINOR_BLOCK_HEADER_SIZE))
-        {
+    void *ptr = nullptr;
 
-            // Another major block next to this one?
-            if (maj->next != nullptr)
-            {
-                maj = maj->next; // Hop to that one.
-                continue;
-            }
+    if (span->free_list)
+    {
+        ptr = span->free_list;
+        span->free_list = *(void **)ptr;
+    }
+    else
+    {
+        ptr = (void *)(allocator_span_data(span) + span->carved * _size_classes[size_class]);
+        span->carved++;
+    }
 
-            if (started_with_bestbet)
-            {
-                // let's start all over again.
-                maj = _heap_root;
-                started_with_bestbet = false;
-                continue;
-            }
+    span->used++;
+    _statistics.used[size_class]++;
 
-            // Create a new major block next to this one and...
-            maj->next = heap_major_block_create(size);
+    if (span->used == span->capacity)
+    {
+        allocator_span_unlink(span);
+    }
+
+    return ptr;
+}
 
-            if (maj->next == nullptr)
-                break; // no more memory :sad:
+static void allocator_small_free(AllocatorSpan *span, void *ptr)
+{
+    if (span->used == span->capacity)
+    {
+        allocator_span_link(span);
+    }
 
-            maj->next->prev = maj;
-            maj = maj->next;
+    *(void **)ptr = span->free_list;
+    span->free_list = ptr;
 
-            // .. fall through to CASE 2 ..
-        }
+    span->used--;
+    _statistics.used[span->size_class]--;
 
-#endif
+    // Empty slabs go back to their chunk right away, the spare empty chunk
+    // keeps alloc/free loops from reaching the system.
+    if (span->used == 0)
+    {
+        allocator_span_unlink(span);
+        allocator_span_destroy(span);
+    }
+}
 
-#ifdef USE_CASE2
+/* --- Large and huge allocations ------------------------------------------- */
 
-        // CASE 2: It's a brand new block.
-        if (maj->first == nullptr)
-        {
-            maj->first = (MinorBlock *)((uintptr_t)maj + MAJOR_BLOCK_HEADER_SIZE);
+static size_t allocator_pages_for(size_t size, size_t header)
+{
+    return __align_up(size + header, ALLOCATOR_PAGE_SIZE) / ALLOCATOR_PAGE_SIZE;
+}
 
-            maj->first->magic = LIBALLOC_MAGIC;
-            maj->first->prev = nullptr;
-            maj->first->next = nullptr;
-            maj->first->block = maj;
-            maj->first->size = size;
-            maj->first->req_size = req_size;
-            maj->usage += size + MINOR_BLOCK_HEADER_SIZE;
+static void *allocator_large_alloc(size_t size)
+{
+    // Assume the worst case of a run starting at the first page of its chunk.
+    size_t pages = allocator_pages_for(size, ALLOCATOR_SPAN_HEADER_SIZE + ALLOCATOR_CHUNK_HEADER_SIZE);
 
-            void *p = (void *)((uintptr_t)(maj->first) + MINOR_BLOCK_HEADER_SIZE);
+    if (pages <= ALLOCATOR_LARGE_PAGES)
+    {
+        AllocatorSpan *span = allocator_span_create(ALLOCATOR_CLASS_LARGE, pages);
 
-            __plug_memalloc_unlock();
-            return p;
+        if (span == nullptr)
+        {
+            return nullptr;
         }
 
-#endif
+        _statistics.large_allocations++;
+        _statistics.large_pages += pages;
 
-#ifdef USE_CASE3
-        {
-            // CASE 3: Block in use and enough space at the start of the block.
-            size_t diff = (uintptr_t)(maj->first);
-            diff -= (uintptr_t)maj;
-            diff -= MAJOR_BLOCK_HEADER_SIZE;
+        return (void *)allocator_span_data(span);
+    }
 
-            if (diff >= (size + MINOR_BLOCK_HEADER_SIZE))
-            {
-                // Yes, space in front. Squeeze in.
-                maj->first->prev = (MinorBlock *)((uintptr_t)maj + MAJOR_BLOCK_HEADER_SIZE);
-                maj->first->prev->next = maj->first;
-                maj->first = maj->first->prev;
-
-                maj->first->magic = LIBALLOC_MAGIC;
-                maj->first->prev = nullptr;
-                maj->first->block = maj;
-                maj->first->size = size;
-                maj->first->req_size = req_size;
-                maj->usage += size + MINOR_BLOCK_HEADER_SIZE;
-
-                void *p = (void *)((uintptr_t)(maj->first) + MINOR_BLOCK_HEADER_SIZE);
-                __plug_memalloc_unlock(); // release the lock
-                return p;
-            }
-        }
+    pages = allocator_pages_for(size, ALLOCATOR_SPAN_HEADER_SIZE);
 
-#endif
+    auto span = (AllocatorSpan *)__plug_memalloc_alloc(pages * ALLOCATOR_PAGE_SIZE);
 
-#ifdef USE_CASE4
+    if (span == nullptr)
+    {
+        logger_warn("__plug_memalloc_alloc(%d) returned nullptr", pages * ALLOCATOR_PAGE_SIZE);
+        return nullptr;
+    }
 
-        // CASE 4: There is enough space in this block. But is it contiguous?
-        MinorBlock *min = maj->first;
+    *span = {};
+    span->magic = ALLOCATOR_SPAN_MAGIC;
+    span->size_class = ALLOCATOR_CLASS_HUGE;
+    span->pages = pages;
 
-        // Looping within the block now...
-        while (min != nullptr)
-        {
-            // CASE 4.1: End of minors in a block. Space from last and end?
-            if (min->next == nullptr)
-            {
-                // the rest of this block is free...  is it big enough?
-                size_t diff = (uintptr_t)(maj) + maj->size;
-                diff -= (uintptr_t)min;
-                diff -= MINOR_BLOCK_HEADER_SIZE;
-                diff -= min->size;
-                // minus already existing usage..
-
-                if (diff >= (size + MINOR_BLOCK_HEADER_SIZE))
-                {
-                    min->next = (MinorBlock *)((uintptr_t)min + MINOR_BLOCK_HEADER_SIZE + min->size);
-                    min->next->prev = min;
-                    min = min->next;
-                    min->next = nullptr;
-                    min->magic = LIBALLOC_MAGIC;
-                    min->block = maj;
-                    min->size = size;
-                    min->req_size = req_size;
-                    maj->usage += size + MINOR_BLOCK_HEADER_SIZE;
-
-                    void *p = (void *)((uintptr_t)min + MINOR_BLOCK_HEADER_SIZE);
-                    __plug_memalloc_unlock(); // release the lock
-                    return p;
-                }
-            }
+    _statistics.huge_allocations++;
+    _statistics.huge_pages += pages;
 
-            // CASE 4.2: Is there space between two minors?
-            if (min->next != nullptr)
-            {
-                // is the difference between here and next big enough?
-                size_t diff = (uintptr_t)(min->next);
-                diff -= (uintptr_t)min;
-                diff -= MINOR_BLOCK_HEADER_SIZE;
-                diff -= min->size;
-                // minus our existing usage.
+    return (void *)allocator_span_data(span);
+}
 
-                if (diff >= (size + MINOR_BLOCK_HEADER_SIZE))
-                {
-                    MinorBlock *new_min = (MinorBlock *)((uintptr_t)min + MINOR_BLOCK_HEADER_SIZE + min->size);
+static void allocator_large_free(AllocatorSpan *span)
+{
+    if (span->size_class == ALLOCATOR_CLASS_LARGE)
+    {
+        _statistics.large_allocations--;
+        _statistics.large_pages -= span->pages;
 
-                    new_min->magic = LIBALLOC_MAGIC;
-                    new_min->next = min->next;
-                    new_min->prev = min;
-                    new_min->size = size;
-                    new_min->req_size = req_size;
-                    new_min->block = maj;
-                    min->next->prev = new_min;
-                    min->next = new_min;
-                    maj->usage += size + MINOR_BLOCK_HEADER_SIZE;
+        allocator_span_destroy(span);
+    }
+    else
+    {
+        _statistics.huge_allocations--;
+        _statistics.huge_pages -= span->pages;
 
-                    void *p = (void *)((uintptr_t)new_min + MINOR_BLOCK_HEADER_SIZE);
+        span->magic = ALLOCATOR_SPAN_DEAD;
+        __plug_memalloc_free(span, span->pages * ALLOCATOR_PAGE_SIZE);
+    }
+}
 
-                    __plug_memalloc_unlock();
+/* --- Thread caches -------------------------------------------------------- */
 
-                    return p;
-                }
-            } // min->next != nullptr
+static AllocatorCache *allocator_cache(bool create)
+{
+    void **slot = __plug_memalloc_thread_cache();
 
-            min = min->next;
-        } // while min != nullptr ...
+    if (slot == nullptr)
+    {
+        return nullptr;
+    }
 
-#endif
+    if (*slot == nullptr && create)
+    {
+        __plug_memalloc_lock();
 
-#ifdef USE_CASE5
+        auto cache = (AllocatorCache *)allocator_large_alloc(sizeof(AllocatorCache));
 
-        // CASE 5: Block full! Ensure next block and loop.
-        if (maj->next == nullptr)
+        if (cache)
         {
+            *cache = {};
+            cache->next = _caches;
 
-            if (started_with_bestbet)
+            if (_caches)
             {
-                // let's start all over again.
-                maj = _heap_root;
-                started_with_bestbet = false;
-                continue;
+                _caches->prev = cache;
             }
 
-            // we've run out. we need more...
-            // next one guaranteed to be okay
-            maj->next = heap_major_block_create(size);
+            _caches = cache;
+        }
 
-            if (maj->next == nullptr)
+        __plug_memalloc_unlock();
+
+        *slot = cache;
+    }
+
+    return (AllocatorCache *)*slot;
+}
+
+static void allocator_cache_flush(AllocatorCache *cache, uint32_t size_class, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        void *ptr = cache->objects[size_class][--cache->counts[size_class]];
+        allocator_small_free(allocator_span_from_pointer(ptr), ptr);
+    }
+}
+
+static void *allocator_cache_alloc(AllocatorCache *cache, uint32_t size_class)
+{
+    if (cache->counts[size_class] == 0)
+    {
+        __plug_memalloc_lock();
+
+        for (size_t i = 0; i < ALLOCATOR_CACHE_DEPTH / 2; i++)
+        {
+            void *ptr = allocator_small_alloc(size_class);
+
+            if (ptr == nullptr)
             {
-                //  uh oh,  no more memory.....
                 break;
             }
 
-            maj->next->prev = maj;
+            cache->objects[size_class][cache->counts[size_class]++] = ptr;
         }
 
-#endif
+        __plug_memalloc_unlock();
 
-        maj = maj->next;
-    } // while (maj != nullptr)
+        if (cache->counts[size_class] == 0)
+        {
+            return nullptr;
+        }
+    }
 
-    __plug_memalloc_unlock();
+    cache->allocations++;
 
-    logger_warn("All cases exhausted. No memory available.");
+    return cache->objects[size_class][--cache->counts[size_class]];
+}
 
-    return nullptr;
+static void allocator_cache_free(AllocatorCache *cache, uint32_t size_class, void *ptr, void *caller)
+{
+    // Only catches freeing the same object twice in a row, a full search of
+    // the cache would cost more than the cache saves.
+    if (cache->counts[size_class] > 0 &&
+        cache->objects[size_class][cache->counts[size_class] - 1] == ptr)
+    {
+        logger_error("Multiple free(0x%x) attempt from 0x%x.", ptr, caller);
+        return;
+    }
+
+    if (cache->counts[size_class] == ALLOCATOR_CACHE_DEPTH)
+    {
+        __plug_memalloc_lock();
+        allocator_cache_flush(cache, size_class, ALLOCATOR_CACHE_DEPTH / 2);
+        __plug_memalloc_unlock();
+    }
+
+    cache->objects[size_class][cache->counts[size_class]++] = ptr;
 }
 
-void free(void *ptr)
+void malloc_release_cache()
 {
-    if (ptr == nullptr)
+    void **slot = __plug_memalloc_thread_cache();
+
+    if (slot == nullptr || *slot == nullptr)
     {
-        logger_warn("free( nullptr ) called from 0x%x", __builtin_return_address(0));
         return;
     }
 
+    auto cache = (AllocatorCache *)*slot;
+    *slot = nullptr;
+
     __plug_memalloc_lock();
 
-    MinorBlock *min = (MinorBlock *)((uintptr_t)ptr - MINOR_BLOCK_HEADER_SIZE);
+    for (size_t i = 0; i < ALLOCATOR_CLASS_COUNT; i++)
+    {
+        allocator_cache_flush(cache, i, cache->counts[i]);
+    }
+
+    _statistics.allocations += cache->allocations;
 
-    if (!check_minor_magic(min, ptr, __builtin_return_address(0)))
+    if (cache->prev)
     {
-        return;
+        cache->prev->next = cache->next;
+    }
+    else
+    {
+        _caches = cache->next;
     }
 
-    MajorBlock *maj = min->block;
+    if (cache->next)
+    {
+        cache->next->prev = cache->prev;
+    }
+
+    allocator_large_free(allocator_span_from_pointer(cache));
+
+    __plug_memalloc_unlock();
+}
 
-    maj->usage -= (min->size + MINOR_BLOCK_HEADER_SIZE);
-    min->magic = LIBALLOC_DEAD;
+/* --- Public API ----------------------------------------------------------- */
 
-    if (min->next != nullptr)
+static bool allocator_check_span(AllocatorSpan *span, void *ptr, void *caller)
+{
+    if (span->magic == ALLOCATOR_SPAN_MAGIC)
     {
-        min->next->prev = min->prev;
+        return true;
     }
 
-    if (min->prev != nullptr)
+    if (span->magic == ALLOCATOR_SPAN_DEAD)
     {
-        min->prev->next = min->next;
+        logger_error("Multiple free(0x%x) attempt from 0x%x.", ptr, caller);
+    }
+    else
+    {
+        logger_error("Bad free(0x%x) from 0x%x", ptr, caller);
     }
 
-    if (min->prev == nullptr)
+    return false;
+}
+
+void *malloc(size_t size)
+{
+    if (size == 0)
     {
-        maj->first = min->next;
+        logger_warn("alloc(0) called from 0x%x", __builtin_return_address(0));
+        size = 1;
     }
 
-    if (maj->first == nullptr)
+    void *ptr = nullptr;
+
+    AllocatorCache *cache = size <= ALLOCATOR_SMALL_MAX ? allocator_cache(true) : nullptr;
+
+    if (cache)
     {
-        if (_heap_root == maj)
-        {
-            _heap_root = maj->next;
-        }
+        ptr = allocator_cache_alloc(cache, allocator_small_class(size));
 
-        if (_best_bet == maj)
+        if (ptr == nullptr)
         {
-            _best_bet = nullptr;
+            logger_warn("No memory available for alloc(%d).", size);
         }
 
-        if (maj->prev != nullptr)
-        {
-            maj->prev->next = maj->next;
-        }
+        return ptr;
+    }
 
-        if (maj->next != nullptr)
-        {
-            maj->next->prev = maj->prev;
-        }
+    __plug_memalloc_lock();
+
+    _statistics.allocations++;
 
-        __plug_memalloc_free(maj, maj->pages * _page_size);
+    if (size <= ALLOCATOR_SMALL_MAX)
+    {
+        ptr = allocator_small_alloc(allocator_small_class(size));
     }
     else
     {
-        if (_best_bet != nullptr)
-        {
-            int bestSize = _best_bet->size - _best_bet->usage;
-            int majSize = maj->size - maj->usage;
+        ptr = allocator_large_alloc(size);
+    }
 
-            if (majSize > bestSize)
-            {
-                _best_bet = maj;
-            }
-        }
+    __plug_memalloc_unlock();
+
+    if (ptr == nullptr)
+    {
+        logger_warn("No memory available for alloc(%d).", size);
+    }
+
+    return ptr;
+}
+
+void free(void *ptr)
+{
+    if (ptr == nullptr)
+    {
+        logger_warn("free( nullptr ) called from 0x%x", __builtin_return_address(0));
+        return;
+    }
+
+    AllocatorSpan *span = allocator_span_from_pointer(ptr);
+    AllocatorCache *cache = allocator_cache(false);
+
+    if (cache && span->magic == ALLOCATOR_SPAN_MAGIC && span->size_class < ALLOCATOR_CLASS_COUNT)
+    {
+        allocator_cache_free(cache, span->size_class, ptr, __builtin_return_address(0));
+        return;
+    }
+
+    __plug_memalloc_lock();
+
+    if (!allocator_check_span(span, ptr, __builtin_return_address(0)))
+    {
+        __plug_memalloc_unlock();
+        return;
+    }
+
+    if (span->size_class < ALLOCATOR_CLASS_COUNT)
+    {
+        allocator_small_free(span, ptr);
+    }
+    else
+    {
+        allocator_large_free(span);
     }
 
     __plug_memalloc_unlock();
@@ -514,26 +830,102 @@ void *realloc(void *ptr, size_t size)
 
     __plug_memalloc_lock();
 
-    MinorBlock *min = (MinorBlock *)((uintptr_t)ptr - MINOR_BLOCK_HEADER_SIZE);
+    AllocatorSpan *span = allocator_span_from_pointer(ptr);
 
-    if (!check_minor_magic(min, ptr, __builtin_return_address(0)))
+    if (!allocator_check_span(span, ptr, __builtin_return_address(0)))
     {
         __plug_memalloc_unlock();
         return nullptr;
     }
 
-    if (min->size >= size)
+    size_t usable_size = allocator_span_usable_size(span);
+
+    __plug_memalloc_unlock();
+
+    if (usable_size >= size)
     {
-        min->req_size = size;
-        __plug_memalloc_unlock();
         return ptr;
     }
 
-    __plug_memalloc_unlock();
-
     void *new_ptr = malloc(size);
-    memcpy(new_ptr, ptr, min->req_size);
+
+    if (new_ptr == nullptr)
+    {
+        return nullptr;
+    }
+
+    memcpy(new_ptr, ptr, usable_size);
     free(ptr);
 
     return new_ptr;
 }
+
+size_t malloc_count()
+{
+    __plug_memalloc_lock();
+
+    size_t allocations = _statistics.allocations;
+
+    for (AllocatorCache *cache = _caches; cache; cache = cache->next)
+    {
+        allocations += cache->allocations;
+    }
+
+    __plug_memalloc_unlock();
+
+    return allocations;
+}
+
+void malloc_stats()
+{
+    __plug_memalloc_lock();
+
+    AllocatorStatistics statistics = _statistics;
+
+    size_t caches = 0;
+    size_t cached = 0;
+
+    for (AllocatorCache *cache = _caches; cache; cache = cache->next)
+    {
+        caches++;
+
+        for (size_t i = 0; i < ALLOCATOR_CLASS_COUNT; i++)
+        {
+            cached += cache->counts[i];
+        }
+    }
+
+    __plug_memalloc_unlock();
+
+    stream_format(err_stream, "class  slabs   used   free\n");
+
+    size_t small_used = 0;
+    size_t small_slabs = 0;
+
+    for (size_t i = 0; i < ALLOCATOR_CLASS_COUNT; i++)
+    {
+        if (statistics.spans[i] == 0)
+        {
+            continue;
+        }
+
+        size_t capacity = statistics.spans[i] * ((ALLOCATOR_PAGE_SIZE - ALLOCATOR_SPAN_HEADER_SIZE) / _size_classes[i]);
+
+        stream_format(err_stream, "%5d %6d %6d %6d\n",
+                      _size_classes[i],
+                      statistics.spans[i],
+                      statistics.used[i],
+                      capacity - statistics.used[i]);
+
+        small_used += statistics.used[i] * _size_classes[i];
+        small_slabs += statistics.spans[i];
+    }
+
+    stream_format(err_stream, "small: %d KiB in use in %d slabs\n", small_used / 1024, small_slabs);
+    stream_format(err_stream, "cached: %d objects in %d thread caches\n", cached, caches);
+    stream_format(err_stream, "large: %d allocations, %d pages\n", statistics.large_allocations, statistics.large_pages);
+    stream_format(err_stream, "huge:  %d allocations, %d pages\n", statistics.huge_allocations, statistics.huge_pages);
+    stream_format(err_stream, "system: %d KiB (%d chunks + huge allocations)\n",
+                  (statistics.chunks * ALLOCATOR_CHUNK_PAGES + statistics.huge_pages) * ALLOCATOR_PAGE_SIZE / 1024,
+                  statistics.chunks);
+}
@@ -15,4 +15,13 @@ void free(void *);
 
 void malloc_cleanup(void *buffer);
 
+// Number of calls to malloc() since the start of the process.
+size_t malloc_count();
+
+// Print the allocator usage per size class to err_stream.
+void malloc_stats();
+
+// Give the objects cached by the calling thread back, before it exits.
+void malloc_release_cache();
+
 __END_HEADER
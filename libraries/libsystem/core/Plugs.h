@@ -36,6 +36,10 @@ void *__plug_memalloc_alloc(size_t size);
 
 void __plug_memalloc_free(void *address, size_t size);
 
+// Where the calling thread keeps its allocator cache, or nullptr if threads
+// don't get one.
+void **__plug_memalloc_thread_cache();
+
 /* --- File system ---------------------------------------------------------- */
 
 Result __plug_filesystem_link(const char *oldpath, const char *newpath);
@@ -54,6 +58,8 @@ uint __plug_system_get_ticks();
 
 int __plug_process_this();
 
+int __plug_process_clone();
+
 const char *__plug_process_name();
 
 Result __plug_process_launch(Launchpad *launchpad, int *pid);
@@ -72,6 +78,12 @@ Result __plug_process_sleep(int time);
 
 Result __plug_process_wait(int pid, int *exit_value);
 
+/* --- Threads -------------------------------------------------------------- */
+
+int __plug_thread_this();
+
+void __plug_thread_yield();
+
 /* --- I/O ------------------------------------------------------------------ */
 
 void __plug_handle_open(Handle *handle, const char *path, OpenFlag flags);
@@ -88,6 +100,10 @@ size_t __plug_handle_read(Handle *handle, void *buffer, size_t size);
 
 size_t __plug_handle_write(Handle *handle, const void *buffer, size_t size);
 
+size_t __plug_handle_readv(Handle *handle, const IOVector *vectors, size_t count);
+
+size_t __plug_handle_writev(Handle *handle, const IOVector *vectors, size_t count);
+
 Result __plug_handle_call(Handle *handle, IOCall request, void *args);
 
 int __plug_handle_seek(Handle *handle, int offset, Whence whence);
@@ -96,6 +112,8 @@ int __plug_handle_tell(Handle *handle, Whence whence);
 
 int __plug_handle_stat(Handle *handle, FileState *stat);
 
+Result __plug_handle_map(Handle *handle, uintptr_t *address, size_t *size);
+
 void __plug_handle_connect(Handle *handle, const char *path);
 
 void __plug_handle_accept(Handle *handle, Handle *connection_handle);
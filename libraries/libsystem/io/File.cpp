@@ -19,14 +19,25 @@ Result file_read_all(const char *path, void **buffer, size_t *size)
     }
 
     *buffer = malloc(state.size);
-    *size = state.size;
+    *size = 0;
 
-    stream_read(stream, *buffer, state.size);
-
-    if (handle_has_error(stream))
+    // Reads may come back short, keep going until the end of the file.
+    while (*size < state.size)
     {
-        free(buffer);
-        return handle_get_error(stream);
+        size_t read = stream_read(stream, (char *)*buffer + *size, state.size - *size);
+
+        if (handle_has_error(stream))
+        {
+            free(*buffer);
+            return handle_get_error(stream);
+        }
+
+        if (read == 0)
+        {
+            break;
+        }
+
+        *size += read;
     }
 
     return SUCCESS;
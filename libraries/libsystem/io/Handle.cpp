@@ -16,6 +16,21 @@ int __handle_printf_error(Handle *handle, const char *fmt, ...)
     return result;
 }
 
+size_t __handle_readv(Handle *handle, const IOVector *vectors, size_t count)
+{
+    return __plug_handle_readv(handle, vectors, count);
+}
+
+size_t __handle_writev(Handle *handle, const IOVector *vectors, size_t count)
+{
+    return __plug_handle_writev(handle, vectors, count);
+}
+
+Result __handle_map(Handle *handle, uintptr_t *address, size_t *size)
+{
+    return __plug_handle_map(handle, address, size);
+}
+
 Result handle_poll(
     Handle **handles,
     PollEvent *events,
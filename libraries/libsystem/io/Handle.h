@@ -6,8 +6,24 @@
 
 #define handle_printf_error(__handle, __args...) __handle_printf_error(HANDLE(__handle), __args)
 
+#define handle_readv(__handle, __vectors, __count) __handle_readv(HANDLE(__handle), (__vectors), (__count))
+
+#define handle_writev(__handle, __vectors, __count) __handle_writev(HANDLE(__handle), (__vectors), (__count))
+
+#define handle_map(__handle, __address, __size) __handle_map(HANDLE(__handle), (__address), (__size))
+
 int __handle_printf_error(Handle *handle, const char *fmt, ...);
 
+// Vectored I/O goes straight to the handle, a stream's buffer must be flushed
+// or drained before mixing these with stream_read()/stream_write().
+size_t __handle_readv(Handle *handle, const IOVector *vectors, size_t count);
+
+size_t __handle_writev(Handle *handle, const IOVector *vectors, size_t count);
+
+// Map the content of a file read-only, the mapping is released with
+// memory_free() and doesn't see writes made after it was created.
+Result __handle_map(Handle *handle, uintptr_t *address, size_t *size);
+
 Result handle_poll(
     Handle **handles,
     PollEvent *events,
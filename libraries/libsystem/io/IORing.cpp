@@ -0,0 +1,81 @@
+#include <abi/Syscalls.h>
+
+#include <libsystem/io/IORing.h>
+
+IORing *io_ring_create()
+{
+    return __create(IORing);
+}
+
+void io_ring_destroy(IORing *ring)
+{
+    free(ring);
+}
+
+static bool io_ring_queue(IORing *ring, IORingSubmission submission)
+{
+    uint32_t head = __atomic_load_n(&ring->submission_head, __ATOMIC_ACQUIRE);
+    uint32_t tail = ring->submission_tail;
+
+    if (tail - head >= IO_RING_SIZE)
+    {
+        return false;
+    }
+
+    ring->submissions[tail & (IO_RING_SIZE - 1)] = submission;
+
+    __atomic_store_n(&ring->submission_tail, tail + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+bool io_ring_read(IORing *ring, Handle *handle, void *buffer, size_t size, uintptr_t data)
+{
+    return io_ring_queue(ring, {IO_RING_READ, handle->id, buffer, size, 0, 0, data});
+}
+
+bool io_ring_write(IORing *ring, Handle *handle, const void *buffer, size_t size, uintptr_t data)
+{
+    return io_ring_queue(ring, {IO_RING_WRITE, handle->id, const_cast<void *>(buffer), size, 0, 0, data});
+}
+
+bool io_ring_poll(IORing *ring, Handle *handle, PollEvent events, Timeout timeout, uintptr_t data)
+{
+    return io_ring_queue(ring, {IO_RING_POLL, handle->id, nullptr, 0, events, timeout, data});
+}
+
+bool io_ring_accept(IORing *ring, Handle *handle, uintptr_t data)
+{
+    return io_ring_queue(ring, {IO_RING_ACCEPT, handle->id, nullptr, 0, 0, 0, data});
+}
+
+Result io_ring_submit(IORing *ring, size_t *completed)
+{
+    size_t count = 0;
+
+    Result result = hj_handle_submit(ring, &count);
+
+    if (completed != nullptr)
+    {
+        *completed = count;
+    }
+
+    return result;
+}
+
+bool io_ring_reap(IORing *ring, IORingCompletion *completion)
+{
+    uint32_t head = ring->completion_head;
+    uint32_t tail = __atomic_load_n(&ring->completion_tail, __ATOMIC_ACQUIRE);
+
+    if (head == tail)
+    {
+        return false;
+    }
+
+    *completion = ring->completions[head & (IO_RING_SIZE - 1)];
+
+    __atomic_store_n(&ring->completion_head, head + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
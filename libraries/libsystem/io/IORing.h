@@ -0,0 +1,25 @@
+#pragma once
+
+#include <abi/IORing.h>
+
+#include <libsystem/io/Handle.h>
+
+IORing *io_ring_create();
+
+void io_ring_destroy(IORing *ring);
+
+// Queueing returns false when the submission queue is full, submit what is
+// already queued and try again.
+bool io_ring_read(IORing *ring, Handle *handle, void *buffer, size_t size, uintptr_t data);
+
+bool io_ring_write(IORing *ring, Handle *handle, const void *buffer, size_t size, uintptr_t data);
+
+bool io_ring_poll(IORing *ring, Handle *handle, PollEvent events, Timeout timeout, uintptr_t data);
+
+bool io_ring_accept(IORing *ring, Handle *handle, uintptr_t data);
+
+// Run every queued submission with a single kernel entry.
+Result io_ring_submit(IORing *ring, size_t *completed);
+
+// Pop the oldest completion, returns false when there is none.
+bool io_ring_reap(IORing *ring, IORingCompletion *completion);
@@ -5,6 +5,7 @@
 #include <libsystem/math/Math.h>
 #include <libsystem/unicode/Codepoint.h>
 #include <libsystem/utils/NumberParser.h>
+#include <libutils/Intern.h>
 #include <libutils/Scanner.h>
 #include <libutils/ScannerUtils.h>
 #include <libutils/StringBuilder.h>
@@ -99,10 +100,8 @@ static Value number(Scanner &scan)
 #endif
 }
 
-static String string(Scanner &scan)
+static void string(Scanner &scan, StringBuilder &builder)
 {
-    StringBuilder builder{};
-
     scan.skip('"');
 
     while (scan.current() != '"' && scan.do_continue())
@@ -119,10 +118,25 @@ static String string(Scanner &scan)
     }
 
     scan.skip('"');
+}
+
+static String string(Scanner &scan)
+{
+    StringBuilder builder{};
+    string(scan, builder);
 
     return builder.finalize();
 }
 
+// Keys repeat across objects, they are interned instead of copied.
+static String key(Scanner &scan)
+{
+    StringBuilder builder{};
+    string(scan, builder);
+
+    return intern(builder.view());
+}
+
 static Value array(Scanner &scan)
 {
     scan.skip('[');
@@ -164,7 +178,7 @@ static Value object(Scanner &scan)
 
     while (scan.current() != '}')
     {
-        auto k = string(scan);
+        auto k = key(scan);
         whitespace(scan);
 
         scan.skip(':');
@@ -138,6 +138,24 @@ size_t __plug_handle_write(Handle *handle, const void *buffer, size_t size)
     return written;
 }
 
+size_t __plug_handle_readv(Handle *handle, const IOVector *vectors, size_t count)
+{
+    size_t read = 0;
+
+    handle->result = hj_handle_readv(handle->id, vectors, count, &read);
+
+    return read;
+}
+
+size_t __plug_handle_writev(Handle *handle, const IOVector *vectors, size_t count)
+{
+    size_t written = 0;
+
+    handle->result = hj_handle_writev(handle->id, vectors, count, &written);
+
+    return written;
+}
+
 Result __plug_handle_call(Handle *handle, IOCall request, void *args)
 {
     handle->result = hj_handle_call(handle->id, request, args);
@@ -167,6 +185,13 @@ int __plug_handle_stat(Handle *handle, FileState *stat)
     return 0;
 }
 
+Result __plug_handle_map(Handle *handle, uintptr_t *address, size_t *size)
+{
+    handle->result = hj_handle_map(handle->id, address, size);
+
+    return handle->result;
+}
+
 void __plug_handle_accept(Handle *handle, Handle *connection_handle)
 {
     handle->result = hj_handle_accept(handle->id, &connection_handle->id);
@@ -24,3 +24,8 @@ Result memory_get_handle(uintptr_t address, int *out_handle)
 {
     return hj_memory_get_handle(address, out_handle);
 }
+
+Result memory_seal(uintptr_t address)
+{
+    return hj_memory_seal(address);
+}
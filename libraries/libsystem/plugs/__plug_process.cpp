@@ -4,12 +4,32 @@
 #include <libsystem/Assert.h>
 #include <libsystem/core/CString.h>
 #include <libsystem/core/Plugs.h>
+#include <libsystem/thread/Thread.h>
 #include <libutils/Path.h>
 
+// The pid only changes when the process is cloned.
+static int _cached_pid = -1;
+
 int __plug_process_this()
+{
+    if (_cached_pid == -1)
+    {
+        assert(hj_process_this(&_cached_pid) == SUCCESS);
+    }
+
+    return _cached_pid;
+}
+
+int __plug_process_clone()
 {
     int pid = -1;
-    assert(hj_process_this(&pid) == SUCCESS);
+    hj_process_clone(&pid);
+
+    if (pid == 0)
+    {
+        _cached_pid = -1;
+    }
+
     return pid;
 }
 
@@ -53,3 +73,15 @@ Result __plug_process_wait(int pid, int *exit_value)
 {
     return hj_process_wait(pid, exit_value);
 }
+
+/* --- Threads -------------------------------------------------------------- */
+
+int __plug_thread_this()
+{
+    return thread_this();
+}
+
+void __plug_thread_yield()
+{
+    hj_thread_yield();
+}
@@ -6,9 +6,7 @@
 
 TimeStamp __plug_system_get_time()
 {
-    TimeStamp timestamp = 0;
-    assert(hj_system_time(&timestamp) == SUCCESS);
-    return timestamp;
+    return vdso()->boot_time + vdso()->ticks / 1000;
 }
 
 uint __plug_system_get_ticks()
@@ -7,6 +7,7 @@
 #include <libsystem/process/Process.h>
 #include <libsystem/system/Memory.h>
 #include <libsystem/thread/Lock.h>
+#include <libsystem/thread/Thread.h>
 
 #include <libsystem/cxx/cxx.h>
 
@@ -26,6 +27,8 @@ void __plug_init()
     lock_init(memlock);
     lock_init(loglock);
 
+    thread_initialize();
+
     // Open io stream
     in_stream = stream_open_handle(0, OPEN_READ);
     out_stream = stream_open_handle(1, OPEN_WRITE | OPEN_BUFFERED);
@@ -122,3 +125,8 @@ void __plug_memalloc_free(void *address, size_t size)
     __unused(size);
     memory_free((uintptr_t)address);
 }
+
+void **__plug_memalloc_thread_cache()
+{
+    return thread_allocator_cache();
+}
@@ -27,9 +27,7 @@ Result process_run(const char *command, int *pid)
 
 int process_clone()
 {
-    int pid = -1;
-    hj_process_clone(&pid);
-    return pid;
+    return __plug_process_clone();
 }
 
 void __no_return process_exit(int code)
@@ -18,3 +18,6 @@ Result memory_free(uintptr_t address);
 Result memory_include(int handle, uintptr_t *out_address, size_t *out_size);
 
 Result memory_get_handle(uintptr_t address, int *out_handle);
+
+// Once sealed, other processes can only include the memory read-only.
+Result memory_seal(uintptr_t address);
@@ -2,7 +2,6 @@
 #include <libsystem/Assert.h>
 #include <libsystem/Logger.h>
 #include <libsystem/core/Plugs.h>
-#include <libsystem/process/Process.h>
 #include <libsystem/thread/Lock.h>
 
 #define LOCK_NO_HOLDER 0xDEADDEAD
@@ -16,13 +15,14 @@ void __lock_init(Lock *lock, const char *name)
 
 void __lock_acquire(Lock *lock)
 {
-    __lock_acquire_by(lock, process_this());
+    __lock_acquire_by(lock, __plug_thread_this());
 }
 
 void __lock_acquire_by(Lock *lock, int holder)
 {
+    // Give the CPU to the holder, it may be a thread of the same process.
     while (!__sync_bool_compare_and_swap(&lock->locked, 0, 1))
-        asm("hlt"); // Don't burn the CPU ;)
+        __plug_thread_yield();
 
     __sync_synchronize();
 
@@ -35,7 +35,7 @@ bool __lock_try_acquire(Lock *lock)
     {
         __sync_synchronize();
 
-        lock->holder = process_this();
+        lock->holder = __plug_thread_this();
 
         return true;
     }
@@ -77,9 +77,9 @@ void __lock_release_by(Lock *lock, int holder, const char *file, const char *fun
 
 void __lock_assert(Lock *lock, const char *file, const char *function, int line)
 {
-    if (lock->holder != process_this() && !lock->locked)
+    if (lock->holder != __plug_thread_this() && !lock->locked)
     {
-        logger_error("The thread(%d) holding the lock %s isn't the same has the one releasing(%d) it!", lock->holder, lock->name, process_this());
+        logger_error("The thread(%d) holding the lock %s isn't the same has the one releasing(%d) it!", lock->holder, lock->name, __plug_thread_this());
         __plug_lock_assert_failed(lock, file, function, line);
     }
 }
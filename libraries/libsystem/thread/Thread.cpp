@@ -0,0 +1,125 @@
+#include <abi/Syscalls.h>
+
+#include <libsystem/Assert.h>
+#include <libsystem/process/Process.h>
+#include <libsystem/thread/Thread.h>
+
+static ThreadControlBlock _main_thread = {};
+
+static ThreadControlBlock *thread_control_block()
+{
+    ThreadControlBlock *block = nullptr;
+
+#if defined(__i386__)
+    asm volatile("movl %%gs:0, %0"
+                 : "=r"(block));
+#else
+    block = &_main_thread;
+#endif
+
+    return block;
+}
+
+void thread_initialize()
+{
+    _main_thread.self = &_main_thread;
+    _main_thread.id = process_this();
+
+    hj_thread_set_tls((uintptr_t)&_main_thread);
+}
+
+static void thread_control_block_deref(ThreadControlBlock *block)
+{
+    if (__atomic_sub_fetch(&block->references, 1, __ATOMIC_ACQ_REL) == 0)
+    {
+        delete block;
+    }
+}
+
+static void thread_trampoline(ThreadControlBlock *block)
+{
+    thread_exit(block->entry(block->argument));
+}
+
+Result thread_create(ThreadEntryPoint entry, void *argument, int *tid)
+{
+    auto block = new ThreadControlBlock{};
+
+    block->self = block;
+    block->entry = entry;
+    block->argument = argument;
+    block->references = 2;
+
+    Result result = hj_thread_create((uintptr_t)thread_trampoline, (uintptr_t)block, (uintptr_t)block, &block->id);
+
+    if (result != SUCCESS)
+    {
+        delete block;
+        return result;
+    }
+
+    if (tid)
+    {
+        *tid = block->id;
+    }
+
+    thread_control_block_deref(block);
+
+    return SUCCESS;
+}
+
+Result thread_join(int tid, int *exit_value)
+{
+    return hj_thread_join(tid, exit_value);
+}
+
+Result thread_detach(int tid)
+{
+    return hj_thread_detach(tid);
+}
+
+void __no_return thread_exit(int exit_value)
+{
+    malloc_release_cache();
+
+    ThreadControlBlock *block = thread_control_block();
+
+    if (block != &_main_thread)
+    {
+        thread_control_block_deref(block);
+    }
+
+    hj_thread_exit(exit_value);
+    ASSERT_NOT_REACHED();
+}
+
+void thread_yield()
+{
+    hj_thread_yield();
+}
+
+int thread_this()
+{
+    return thread_control_block()->id;
+}
+
+void *thread_get_local()
+{
+    return thread_control_block()->local;
+}
+
+void thread_set_local(void *local)
+{
+    thread_control_block()->local = local;
+}
+
+void **thread_allocator_cache()
+{
+    // There is no control block to look at before thread_initialize().
+    if (_main_thread.self == nullptr)
+    {
+        return nullptr;
+    }
+
+    return &thread_control_block()->allocator_cache;
+}
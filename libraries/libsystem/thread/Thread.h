@@ -0,0 +1,47 @@
+#pragma once
+
+#include <libsystem/Common.h>
+#include <libsystem/Result.h>
+
+typedef int (*ThreadEntryPoint)(void *argument);
+
+// Each thread has a control block pointed by its thread local storage segment,
+// the first field points back to the block so it can be found from %gs:0.
+struct ThreadControlBlock
+{
+    ThreadControlBlock *self;
+    int id;
+
+    ThreadEntryPoint entry;
+    void *argument;
+
+    void *local;
+
+    // Held by the thread and by its creator until it read the id, the new
+    // thread may exit before hj_thread_create() returns.
+    int references;
+
+    // Free objects malloc() keeps for this thread.
+    void *allocator_cache;
+};
+
+void thread_initialize();
+
+Result thread_create(ThreadEntryPoint entry, void *argument, int *tid);
+
+Result thread_join(int tid, int *exit_value);
+
+Result thread_detach(int tid);
+
+void __no_return thread_exit(int exit_value);
+
+// Gives the rest of the time slice to the other threads.
+void thread_yield();
+
+int thread_this();
+
+void *thread_get_local();
+
+void thread_set_local(void *local);
+
+void **thread_allocator_cache();
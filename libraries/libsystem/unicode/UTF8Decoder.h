@@ -13,6 +13,9 @@ private:
     Callback<void(Codepoint)> _callback{};
 
 public:
+    // A sequence is partially decoded, the next bytes belong to it.
+    bool decoding() { return _decoding; }
+
     void callback(Callback<void(Codepoint)> callback)
     {
         _callback = callback;
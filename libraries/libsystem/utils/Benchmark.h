@@ -0,0 +1,54 @@
+#pragma once
+
+#include <libsystem/core/Allocator.h>
+#include <libsystem/io/Stream.h>
+#include <libsystem/system/System.h>
+
+struct Benchmark
+{
+    const char *name;
+    size_t operations;
+    void (*run)(size_t operations);
+};
+
+// Counts the ticks and the calls to malloc() since it was created.
+struct BenchmarkClock
+{
+    size_t allocations = malloc_count();
+    uint start = system_get_ticks();
+
+    uint elapsed() { return system_get_ticks() - start; }
+
+    size_t allocated() { return malloc_count() - allocations; }
+};
+
+// Prints the time and the allocations per operation, the unit is what a single
+// operation is called in the output.
+static inline void benchmark_report(const char *name, size_t operations, const char *unit, BenchmarkClock &clock)
+{
+    uint elapsed = clock.elapsed();
+    size_t allocations = clock.allocated();
+
+    printf("%-26s %8d %ss %6dms %8dns/%s %6d allocs/%s\n",
+           name,
+           operations,
+           unit,
+           elapsed,
+           (uint)((elapsed * 1000000ull) / operations),
+           unit,
+           allocations / operations,
+           unit);
+}
+
+template <size_t N>
+static inline void benchmark_run(Benchmark (&benchmarks)[N], const char *unit = "op")
+{
+    for (size_t i = 0; i < N; i++)
+    {
+        Benchmark &benchmark = benchmarks[i];
+
+        BenchmarkClock clock{};
+        benchmark.run(benchmark.operations);
+        benchmark_report(benchmark.name, benchmark.operations, unit, clock);
+    }
+}
@@ -9,7 +9,6 @@ struct Cell
 {
     Codepoint codepoint;
     Attributes attributes;
-    bool dirty;
 };
 
 } // namespace terminal
@@ -1,16 +1,27 @@
 
 #include <libsystem/Assert.h>
+#include <libsystem/core/CString.h>
 #include <libsystem/math/MinMax.h>
 #include <libterminal/Terminal.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 namespace terminal
 {
 
-Terminal::Terminal(int width, int height)
+Terminal::Terminal(int width, int height, int scrollback)
 {
     _width = width;
     _height = height;
-    _buffer = (Cell *)calloc(_width * _height, sizeof(Cell));
+
+    _scrollback = scrollback;
+    _history = 0;
+    _top = 0;
+    _buffer = (Cell *)calloc(_width * (_height + _scrollback), sizeof(Cell));
+    _dirty = (bool *)calloc(_height + _scrollback, sizeof(bool));
+    _scrolled = 0;
 
     _decoder.callback([this](auto codepoint) { write(codepoint); });
 
@@ -33,13 +44,14 @@ Terminal::Terminal(int width, int height)
 Terminal::~Terminal()
 {
     free(_buffer);
+    free(_dirty);
 }
 
 void Terminal::clear(int fromx, int fromy, int tox, int toy)
 {
     for (int i = fromx + fromy * _width; i < tox + toy * _width; i++)
     {
-        set_cell(i % _width, i / _width, (Cell){U' ', _attributes, true});
+        set_cell(i % _width, i / _width, (Cell){U' ', _attributes});
     }
 }
 
@@ -54,31 +66,42 @@ void Terminal::clear_line(int line)
     {
         for (int i = 0; i < _width; i++)
         {
-            set_cell(i, line, (Cell){U' ', _attributes, true});
+            set_cell(i, line, (Cell){U' ', _attributes});
         }
     }
 }
 
 void Terminal::resize(int width, int height)
 {
-    Cell *new_buffer = (Cell *)malloc(sizeof(Cell) * width * height);
+    int lines = height + _scrollback;
+
+    Cell *new_buffer = (Cell *)malloc(sizeof(Cell) * width * lines);
 
-    for (int i = 0; i < width * height; i++)
+    for (int i = 0; i < width * lines; i++)
     {
-        new_buffer[i] = {U' ', _attributes, true};
+        new_buffer[i] = {U' ', _attributes};
     }
 
-    for (int x = 0; x < MIN(width, _width); x++)
+    // The history is kept, the screen is laid out right after it.
+    for (int y = -_history; y < MIN(height, _height); y++)
     {
-        for (int y = 0; y < MIN(height, _height); y++)
-        {
-            new_buffer[y * width + x] = cell_at(x, y);
-        }
+        memcpy(&new_buffer[(y + _history) * width], line(y), sizeof(Cell) * MIN(width, _width));
     }
 
     free(_buffer);
     _buffer = new_buffer;
 
+    free(_dirty);
+    _dirty = (bool *)malloc(sizeof(bool) * lines);
+
+    for (int i = 0; i < lines; i++)
+    {
+        _dirty[i] = true;
+    }
+
+    _top = _history;
+    _scrolled = 0;
+
     _width = width;
     _height = height;
 
@@ -88,20 +111,32 @@ void Terminal::resize(int width, int height)
 
 Cell Terminal::cell_at(int x, int y)
 {
-    if (x >= 0 && x < _width && y >= 0 && y < _height)
+    if (x >= 0 && x < _width && y >= -_history && y < _height)
     {
-        return _buffer[y * _width + x];
+        return line(y)[x];
     }
 
-    return {U' ', _attributes, true};
+    return {U' ', _attributes};
 }
 
-void Terminal::cell_undirty(int x, int y)
+bool Terminal::line_dirty(int y)
 {
-    if (x >= 0 && x < _width && y >= 0 && y < _height)
+    if (y >= 0 && y < _height)
     {
-        _buffer[y * _width + x].dirty = false;
+        return _dirty[line_index(y)];
     }
+
+    return false;
+}
+
+void Terminal::undirty()
+{
+    for (int y = 0; y < _height; y++)
+    {
+        _dirty[line_index(y)] = false;
+    }
+
+    _scrolled = 0;
 }
 
 void Terminal::set_cell(int x, int y, Cell cell)
@@ -109,13 +144,13 @@ void Terminal::set_cell(int x, int y, Cell cell)
     if (x >= 0 && x < _width &&
         y >= 0 && y < _height)
     {
-        Cell old_cell = _buffer[y * _width + x];
+        Cell &old_cell = line(y)[x];
 
         if (old_cell.codepoint != cell.codepoint ||
             old_cell.attributes != cell.attributes)
         {
-            _buffer[y * _width + x] = cell;
-            _buffer[y * _width + x].dirty = true;
+            old_cell = cell;
+            _dirty[line_index(y)] = true;
         }
     }
 }
@@ -168,32 +203,42 @@ void Terminal::scroll(int how_many_line)
 {
     if (how_many_line < 0)
     {
-        for (int line = 0; line < how_many_line; line++)
+        // Lines pushed out of the bottom of the screen are lost, move what
+        // stays down line by line.
+        int count = MIN(-how_many_line, _height);
+
+        for (int y = _height - 1; y >= count; y--)
         {
-            for (int i = (_width * _height) - 1; i >= _height; i++)
-            {
-                int x = i % _width;
-                int y = i / _width;
+            memcpy(line(y), line(y - count), sizeof(Cell) * _width);
+            _dirty[line_index(y)] = true;
+        }
 
-                set_cell(x, y, cell_at(x, y - 1));
+        for (int y = 0; y < count; y++)
+        {
+            for (int x = 0; x < _width; x++)
+            {
+                line(y)[x] = {U' ', _attributes};
             }
 
-            clear_line(0);
+            _dirty[line_index(y)] = true;
         }
     }
     else if (how_many_line > 0)
     {
-        for (int line = 0; line < how_many_line; line++)
+        // The top line goes to the history and the oldest line of the
+        // history, or the spare one, comes back as the new bottom line.
+        for (int i = 0; i < how_many_line; i++)
         {
-            for (int i = 0; i < _width * (_height - 1); i++)
-            {
-                int x = i % _width;
-                int y = i / _width;
+            _top = line_index(1);
+            _history = MIN(_history + 1, _scrollback);
+            _scrolled++;
 
-                set_cell(x, y, cell_at(x, y + 1));
+            for (int x = 0; x < _width; x++)
+            {
+                line(_height - 1)[x] = {U' ', _attributes};
             }
 
-            clear_line(_height - 1);
+            _dirty[line_index(_height - 1)] = true;
         }
     }
 }
@@ -228,11 +273,46 @@ void Terminal::append(Codepoint codepoint)
     }
     else
     {
-        set_cell(_cursor.x, _cursor.y, {codepoint, _attributes, true});
+        set_cell(_cursor.x, _cursor.y, {codepoint, _attributes});
         cursor_move(1, 0);
     }
 }
 
+// Printable ASCII is written straight into the line, the cursor moves once
+// per line instead of once per cell.
+void Terminal::append(const char *ascii, size_t size)
+{
+    while (size > 0)
+    {
+        int count = MIN((int)size, _width - _cursor.x);
+
+        Cell *cells = line(_cursor.y) + _cursor.x;
+        bool changed = false;
+
+        for (int i = 0; i < count; i++)
+        {
+            Codepoint codepoint = ascii[i];
+
+            if (cells[i].codepoint != codepoint ||
+                cells[i].attributes != _attributes)
+            {
+                cells[i] = {codepoint, _attributes};
+                changed = true;
+            }
+        }
+
+        if (changed)
+        {
+            _dirty[line_index(_cursor.y)] = true;
+        }
+
+        ascii += count;
+        size -= count;
+
+        cursor_move(count, 0);
+    }
+}
+
 void Terminal::do_ansi(Codepoint codepoint)
 {
     switch (codepoint)
@@ -526,11 +606,78 @@ void Terminal::write(char c)
     _decoder.write(c);
 }
 
+// Length of the run of printable ASCII at the start of the buffer, sixteen
+// or four bytes are checked at once for control characters, DEL and non-ASCII.
+static size_t printable_ascii_run(const char *buffer, size_t size)
+{
+    size_t length = 0;
+
+#ifdef __SSE2__
+    // Compared as signed bytes, non-ASCII is below the space too.
+    const __m128i space = _mm_set1_epi8(0x20);
+    const __m128i del = _mm_set1_epi8(0x7f);
+
+    while (length + 16 <= size)
+    {
+        __m128i bytes = _mm_loadu_si128((const __m128i *)(buffer + length));
+        __m128i invalid = _mm_or_si128(_mm_cmplt_epi8(bytes, space), _mm_cmpeq_epi8(bytes, del));
+
+        int mask = _mm_movemask_epi8(invalid);
+
+        if (mask != 0)
+        {
+            return length + __builtin_ctz(mask);
+        }
+
+        length += 16;
+    }
+#endif
+
+    while (length + sizeof(uint32_t) <= size)
+    {
+        uint32_t word;
+        memcpy(&word, buffer + length, sizeof(uint32_t));
+
+        uint32_t below_space = (word - 0x20202020) & ~word;
+        uint32_t above_tilde = word + 0x01010101;
+
+        if ((below_space | above_tilde | word) & 0x80808080)
+        {
+            break;
+        }
+
+        length += sizeof(uint32_t);
+    }
+
+    while (length < size && buffer[length] >= 0x20 && buffer[length] < 0x7f)
+    {
+        length++;
+    }
+
+    return length;
+}
+
 void Terminal::write(const char *buffer, size_t size)
 {
-    for (size_t i = 0; i < size; i++)
+    size_t i = 0;
+
+    while (i < size)
     {
+        if (_state == State::WAIT_ESC && !_decoder.decoding())
+        {
+            size_t run = printable_ascii_run(buffer + i, size - i);
+
+            if (run > 0)
+            {
+                append(buffer + i, run);
+                i += run;
+
+                continue;
+            }
+        }
+
         write(buffer[i]);
+        i++;
     }
 }
 
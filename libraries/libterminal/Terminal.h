@@ -26,7 +26,17 @@ struct Terminal
 private:
     int _height;
     int _width;
+
+    // Lines are kept in a ring of `_height + _scrollback` lines, the screen
+    // starts at `_top` and is preceded by the `_history` lines scrolled out of
+    // it. Scrolling only moves `_top`.
+    int _scrollback;
+    int _history;
+    int _top;
     Cell *_buffer;
+    bool *_dirty;
+    int _scrolled;
+
     UTF8Decoder _decoder;
 
     State _state;
@@ -39,14 +49,24 @@ private:
     int _parameters_top;
     Parameter _parameters[MAX_PARAMETERS];
 
+    int line_index(int y) { return (_top + y + _height + _scrollback) % (_height + _scrollback); }
+
+    Cell *line(int y) { return &_buffer[line_index(y) * _width]; }
+
 public:
     int width() { return _width; }
 
     int height() { return _height; }
 
+    // Number of lines above the screen which can be read back with cell_at().
+    int history() { return _history; }
+
+    // Number of lines scrolled up since the last call to undirty().
+    int scrolled() { return _scrolled; }
+
     const Cursor &cursor() { return _cursor; }
 
-    Terminal(int width, int height);
+    Terminal(int width, int height, int scrollback = 0);
 
     ~Terminal();
 
@@ -60,7 +80,9 @@ public:
 
     Cell cell_at(int x, int y);
 
-    void cell_undirty(int x, int y);
+    bool line_dirty(int y);
+
+    void undirty();
 
     void set_cell(int x, int y, Cell cell);
 
@@ -76,6 +98,8 @@ public:
 
     void append(Codepoint codepoint);
 
+    void append(const char *ascii, size_t size);
+
     void do_ansi(Codepoint codepoint);
 
     void write(Codepoint codepoint);
@@ -1,6 +1,8 @@
 #pragma once
 
-#include <libsystem/io/File.h>
+#include <libfile/MappedFile.h>
+#include <libutils/Slice.h>
+#include <libutils/String.h>
 
 #include <libtruetype/Header.h>
 #include <libtruetype/Utils.h>
@@ -23,7 +25,7 @@ private:
     Slice _data{};
     bool _valid = false;
 
-    const Header *_header;
+    const Header *_header = nullptr;
 
     const CMAP *_cmap = nullptr;
     const GLYF *_glyf = nullptr;
@@ -46,27 +48,23 @@ public:
     {
         _path = path;
 
-        auto result_or_data = file_read_all(path);
+        auto result_or_file = MappedFile::open(path.cstring());
 
-        if (!result_or_data.success())
+        if (!result_or_file.success())
         {
             return;
         }
         else
         {
-            _data = result_or_data.take_value();
+            _data = Slice{result_or_file.take_value()};
         }
 
         logger_info("The file is %d bytes", _data.size());
 
-        if (_data.size() < sizeof(Header))
-        {
-            return;
-        }
-
-        _header = (const Header *)_data.start();
+        _header = _data.as<Header>();
 
-        if (_data.size() < sizeof(Header) + sizeof(Element) * _header->table_count())
+        if (!_header ||
+            !_data.as_array<Element>(sizeof(Header), _header->table_count()))
         {
             return;
         }
@@ -64,6 +64,8 @@ public:
 
     HashMap()
     {
+        _buckets.reserve(BUCKET_COUNT);
+
         for (size_t i = 0; i < BUCKET_COUNT; i++)
         {
             _buckets.push_back({});
@@ -82,7 +84,10 @@ public:
 
     void clear()
     {
-        _buckets.clear();
+        for (size_t i = 0; i < BUCKET_COUNT; i++)
+        {
+            _buckets[i].clear();
+        }
     }
 
     void remove_key(TKey &key)
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <libsystem/thread/Lock.h>
+#include <libutils/String.h>
+#include <libutils/StringView.h>
+
+// Identifiers repeated many times, like JSON keys or widget ids, are interned
+// so every copy shares one storage and compares by pointer. Interned strings
+// live for as long as the process, so the table is bounded: long strings and
+// anything past the last entry are returned as plain strings.
+static constexpr int INTERN_BUCKET_COUNT = 256;
+static constexpr size_t INTERN_LENGTH_MAX = 64;
+static constexpr size_t INTERN_ENTRY_MAX = 4096;
+
+struct InternEntry
+{
+    StringStorage *storage;
+    InternEntry *next;
+};
+
+struct InternTable
+{
+    Lock lock;
+    size_t count;
+    InternEntry *buckets[INTERN_BUCKET_COUNT];
+};
+
+inline InternTable &intern_table()
+{
+    static InternTable table = {
+        .lock = {.locked = false, .holder = 0, .name = "intern"},
+        .count = 0,
+        .buckets = {},
+    };
+
+    return table;
+}
+
+inline String intern(StringView view)
+{
+    // Short strings are stored inline, there is nothing to share.
+    if (view.length() <= String::INLINE_CAPACITY ||
+        view.length() > INTERN_LENGTH_MAX)
+    {
+        return String(view);
+    }
+
+    InternTable &table = intern_table();
+    LockHolder holder(table.lock);
+
+    InternEntry *&bucket = table.buckets[hash(view) % INTERN_BUCKET_COUNT];
+
+    for (InternEntry *entry = bucket; entry; entry = entry->next)
+    {
+        if (StringView(entry->storage->cstring(), entry->storage->length()) == view)
+        {
+            return String(RefPtr<StringStorage>{*entry->storage});
+        }
+    }
+
+    if (table.count == INTERN_ENTRY_MAX)
+    {
+        return String(view);
+    }
+
+    auto storage = make<StringStorage>(view.start(), view.length());
+
+    bucket = new InternEntry{storage.give_ref(), bucket};
+    table.count++;
+
+    return String(RefPtr<StringStorage>{*bucket->storage});
+}
@@ -5,6 +5,7 @@
 #include <libutils/Scanner.h>
 #include <libutils/String.h>
 #include <libutils/StringBuilder.h>
+#include <libutils/StringView.h>
 #include <libutils/Vector.h>
 
 struct Path
@@ -13,6 +14,24 @@ private:
     bool _absolute = false;
     Vector<String> _elements{};
 
+    static size_t extension_start(StringView filename)
+    {
+        size_t start = 0;
+
+        // It's not a file extention it's an hidden file.
+        if (filename.length() > 0 && filename[0] == '.')
+        {
+            start++;
+        }
+
+        while (start < filename.length() && filename[start] != '.')
+        {
+            start++;
+        }
+
+        return start;
+    }
+
 public:
     static constexpr int PARENT_SHORTHAND = 1; // .... -> ../../..
 
@@ -24,71 +43,71 @@ public:
 
     static Path parse(const String &string, int flags = 0)
     {
-        return parse(string.cstring(), string.length(), flags);
+        return parse(string.view(), flags);
     }
 
     static Path parse(const char *path, int flags = 0)
     {
-        return parse(path, strlen(path), flags);
+        return parse(StringView(path), flags);
     }
 
     static Path parse(const char *path, size_t size, int flags)
     {
-        StringScanner scan{path, size};
+        return parse(StringView(path, size), flags);
+    }
+
+    // Elements are sliced out of the path, short ones don't allocate.
+    static Path parse(StringView path, int flags = 0)
+    {
+        size_t current = 0;
 
         bool absolute = false;
 
-        if (scan.skip(PATH_SEPARATOR))
+        if (path.length() > 0 && path[0] == PATH_SEPARATOR)
         {
             absolute = true;
+            current++;
         }
 
-        auto parse_element = [](auto &scan) {
-            StringBuilder builder{};
-
-            while (!scan.skip(PATH_SEPARATOR) &&
-                   scan.do_continue())
-            {
-                builder.append(scan.current());
-                scan.foreward();
-            }
-
-            return builder.finalize();
-        };
-
-        auto parse_shorthand = [](auto &scan) {
-            Vector<String> elements{};
+        Vector<String> elements{};
 
-            scan.skip_word("..");
-            elements.push("..");
+        while (current < path.length())
+        {
+            size_t end = current;
 
-            while (scan.skip('.'))
+            while (end < path.length() && path[end] != PATH_SEPARATOR)
             {
-                elements.push("..");
+                end++;
             }
 
-            scan.skip('/');
+            StringView element = path.substring(current, end - current);
 
-            return move(elements);
-        };
+            auto is_shorthand = [&]() {
+                for (size_t i = 0; i < element.length(); i++)
+                {
+                    if (element[i] != '.')
+                    {
+                        return false;
+                    }
+                }
 
-        Vector<String> elements{};
+                return element.length() >= 2;
+            };
 
-        while (scan.do_continue())
-        {
-            if ((flags & PARENT_SHORTHAND) && scan.current_is_word(".."))
-            {
-                elements.push_back_many(parse_shorthand(scan));
-            }
-            else
+            if ((flags & PARENT_SHORTHAND) && is_shorthand())
             {
-                auto el = parse_element(scan);
-
-                if (el.length() > 0)
+                // Each dot after the first one goes up one more directory.
+                for (size_t i = 1; i < element.length(); i++)
                 {
-                    elements.push_back(move(el));
+                    elements.push_back("..");
                 }
             }
+            else if (element.length() > 0)
+            {
+                elements.push_back(String(element));
+            }
+
+            current = end + 1;
         }
 
         return {absolute, move(elements)};
@@ -222,24 +241,9 @@ public:
 
     String basename_without_extension() const
     {
-        StringBuilder builder{basename().length()};
-
-        StringScanner scan{basename().cstring(), basename().length()};
-
-        // It's not a file extention it's an hidden file.
-        if (scan.current_is("."))
-        {
-            builder.append(scan.current());
-            scan.foreward();
-        }
-
-        while (!scan.current_is(".") && scan.do_continue())
-        {
-            builder.append(scan.current());
-            scan.foreward();
-        }
+        auto filename = basename();
 
-        return builder.finalize();
+        return String(filename.view().substring(0, extension_start(filename.view())));
     }
 
     String dirname() const
@@ -290,29 +294,7 @@ public:
     {
         auto filename = basename();
 
-        StringBuilder builder{filename.length()};
-
-        StringScanner scan{filename.cstring(), filename.length()};
-
-        // It's not a file extention it's an hidden file.
-        if (scan.current_is("."))
-        {
-            scan.foreward();
-        }
-
-        while (!scan.current_is(".") &&
-               scan.do_continue())
-        {
-            scan.foreward();
-        }
-
-        while (scan.do_continue())
-        {
-            builder.append(scan.current());
-            scan.foreward();
-        }
-
-        return builder.finalize();
+        return String(filename.view().substring(extension_start(filename.view())));
     }
 
     Path parent(size_t index) const
@@ -2,6 +2,7 @@
 
 #include <libsystem/Common.h>
 #include <libutils/RefCounted.h>
+#include <libutils/Traits.h>
 
 enum AdoptTag
 {
@@ -162,6 +163,11 @@ public:
     }
 };
 
+template <typename T>
+struct IsTriviallyRelocatable<RefPtr<T>> : TrueType
+{
+};
+
 template <typename T>
 class CallableRefPtr : public RefPtr<T>
 {
@@ -48,9 +48,38 @@ public:
         assert(offset + size <= storage->size());
     }
 
+    bool contains(size_t offset, size_t size)
+    {
+        return offset <= _size && size <= _size - offset;
+    }
+
     Slice slice(size_t offset, size_t size)
     {
-        // FIXME: bound checking.
+        if (!contains(offset, size))
+        {
+            return {};
+        }
+
         return {_storage, _offset + offset, size};
     }
+
+    // Typed views into the data, null when they would go past its end.
+    template <typename T>
+    const T *as(size_t offset = 0)
+    {
+        return as_array<T>(offset, 1);
+    }
+
+    template <typename T>
+    const T *as_array(size_t offset, size_t count)
+    {
+        if (_storage == nullptr ||
+            offset > _size ||
+            count > (_size - offset) / sizeof(T))
+        {
+            return nullptr;
+        }
+
+        return reinterpret_cast<const T *>(reinterpret_cast<const char *>(start()) + offset);
+    }
 };
@@ -59,11 +59,11 @@ public:
             _data = malloc(size);
             memcpy(_data, data, size);
             _size = size;
-            _owned = false;
+            _owned = true;
         }
     }
 
-    ~SliceStorage()
+    virtual ~SliceStorage()
     {
         if (!_data)
         {
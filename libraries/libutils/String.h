@@ -4,56 +4,115 @@
 #include <libutils/Move.h>
 #include <libutils/RefPtr.h>
 #include <libutils/StringStorage.h>
+#include <libutils/StringView.h>
+#include <libutils/Traits.h>
 
 class String
 {
+public:
+    // Short strings are stored in the string itself, longer ones in a shared
+    // heap storage.
+    static constexpr size_t INLINE_CAPACITY = 15;
+
 private:
     RefPtr<StringStorage> _buffer;
+    size_t _length = 0;
+    char _inline[INLINE_CAPACITY + 1] = {};
+
+    void assign(const char *cstring, size_t length)
+    {
+        _length = length;
+
+        if (length <= INLINE_CAPACITY)
+        {
+            _buffer = nullptr;
+            memcpy(_inline, cstring, length);
+            _inline[length] = '\0';
+        }
+        else
+        {
+            _buffer = make<StringStorage>(cstring, length);
+        }
+    }
+
+    void assign(const String &other)
+    {
+        _buffer = const_cast<String &>(other)._buffer;
+        _length = other._length;
+
+        if (_buffer == nullptr)
+        {
+            memcpy(_inline, other._inline, _length + 1);
+        }
+    }
+
+    void assign(String &&other)
+    {
+        _buffer = move(other._buffer);
+        _length = other._length;
+
+        if (_buffer == nullptr)
+        {
+            memcpy(_inline, other._inline, _length + 1);
+        }
+
+        other._length = 0;
+        other._inline[0] = '\0';
+    }
 
 public:
-    size_t length() const { return _buffer->length(); }
-    const char *cstring() const { return _buffer->cstring(); }
-    char at(int index) const { return _buffer->cstring()[index]; }
+    size_t length() const { return _length; }
+    const char *cstring() const { return _buffer != nullptr ? _buffer->cstring() : _inline; }
+    char at(int index) const { return cstring()[index]; }
+
+    bool null_or_empty() const { return _length == 0; }
 
-    bool null_or_empty() const { return _buffer == nullptr || _buffer->length() == 0; }
+    StringView view() const { return {cstring(), _length}; }
 
     String(const char *cstring = "")
     {
-        _buffer = make<StringStorage>(cstring);
+        assign(cstring, strlen(cstring));
     }
 
     String(const char *cstring, size_t length)
     {
-        _buffer = make<StringStorage>(cstring, length);
+        assign(cstring, length);
+    }
+
+    String(StringView view)
+    {
+        assign(view.start(), view.length());
     }
 
     String(char c)
     {
-        char cstr[2];
-        cstr[0] = c;
-        _buffer = make<StringStorage>(cstr, 1);
+        assign(&c, 1);
     }
 
     String(RefPtr<StringStorage> storage)
         : _buffer(storage)
     {
+        if (_buffer != nullptr)
+        {
+            _length = _buffer->length();
+        }
     }
 
     String(const String &other)
-        : _buffer(const_cast<String &>(other)._buffer)
     {
+        assign(other);
     }
 
     String(String &&other)
-        : _buffer(move(other._buffer))
     {
+        assign(move(other));
     }
 
     String &operator=(const String &other)
     {
         if (this != &other)
         {
-            _buffer = const_cast<String &>(other)._buffer;
+            assign(other);
         }
 
         return *this;
@@ -63,7 +122,7 @@ public:
     {
         if (this != &other)
         {
-            swap(_buffer, other._buffer);
+            assign(move(other));
         }
 
         return *this;
@@ -71,50 +130,50 @@ public:
 
     String &operator+=(String &other)
     {
-        _buffer = make<StringStorage>(*_buffer, *other._buffer);
-
-        return *this;
-    }
+        size_t length = _length + other._length;
 
-    bool operator==(const String &other) const
-    {
-        if (_buffer == other._buffer)
+        if (length <= INLINE_CAPACITY)
         {
-            return true;
-        }
+            // A short string may still be held in a storage it was built from.
+            if (_buffer != nullptr)
+            {
+                memcpy(_inline, _buffer->cstring(), _length);
+                _buffer = nullptr;
+            }
 
-        if (length() != other.length())
-        {
-            return false;
+            memcpy(_inline + _length, other.cstring(), other._length);
+            _inline[length] = '\0';
+            _length = length;
         }
-
-        for (size_t i = 0; i < length(); i++)
+        else
         {
-            if (cstring()[i] != other.cstring()[i])
-            {
-                return false;
-            }
+            char *buffer = new char[length + 1];
+
+            memcpy(buffer, cstring(), _length);
+            memcpy(buffer + _length, other.cstring(), other._length);
+            buffer[length] = '\0';
+
+            _buffer = make<StringStorage>(AdoptTag::ADOPT, buffer, length);
+            _length = length;
         }
 
-        return true;
+        return *this;
     }
 
-    bool operator==(const char *str) const
+    bool operator==(const String &other) const
     {
-        if (length() != strlen(str))
+        // Interned strings share their storage.
+        if (_buffer != nullptr && _buffer == other._buffer)
         {
-            return false;
+            return true;
         }
 
-        for (size_t i = 0; i < length(); i++)
-        {
-            if (cstring()[i] != str[i])
-            {
-                return false;
-            }
-        }
+        return view() == other.view();
+    }
 
-        return true;
+    bool operator==(const char *str) const
+    {
+        return view() == StringView(str);
     }
 
     char operator[](int index) const
@@ -124,10 +183,20 @@ public:
 
     RefPtr<StringStorage> underlying_storage()
     {
+        if (_buffer == nullptr)
+        {
+            return make<StringStorage>(_inline, _length);
+        }
+
         return _buffer;
     }
 };
 
+template <>
+struct IsTriviallyRelocatable<String> : TrueType
+{
+};
+
 template <>
 inline uint32_t hash<String>(const String &value)
 {
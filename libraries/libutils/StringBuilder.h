@@ -12,9 +12,13 @@ struct StringBuilder
     __nonmovable(StringBuilder);
 
 private:
+    // Most strings are built in place and never touch the heap.
+    static constexpr size_t INLINE_SIZE = 64;
+
     size_t _used = 0;
-    size_t _size = 0;
-    char *_buffer = nullptr;
+    size_t _size = INLINE_SIZE;
+    char *_buffer = _inline;
+    char _inline[INLINE_SIZE];
 
 public:
     size_t length() const
@@ -22,93 +26,98 @@ public:
         return _used;
     }
 
-    StringBuilder() : StringBuilder(16) {}
+    StringBuilder() : StringBuilder(INLINE_SIZE) {}
 
     StringBuilder(size_t preallocated)
     {
-        preallocated = MAX(preallocated, 16);
+        _inline[0] = '\0';
 
-        _buffer = new char[preallocated];
-        _size = preallocated;
-        _used = 0;
+        if (preallocated > INLINE_SIZE)
+        {
+            _buffer = new char[preallocated];
+            _buffer[0] = '\0';
+            _size = preallocated;
+        }
     }
 
     ~StringBuilder()
     {
-        if (_buffer)
+        if (_buffer != _inline)
             delete[] _buffer;
     }
 
     String finalize()
     {
+        if (_buffer == _inline)
+        {
+            String result{_inline, _used};
+
+            _used = 0;
+            _inline[0] = '\0';
+
+            return result;
+        }
+
         char *result = _buffer;
         size_t size = _used;
 
-        _buffer = nullptr;
+        _buffer = _inline;
         _used = 0;
-        _size = 0;
+        _size = INLINE_SIZE;
+        _inline[0] = '\0';
 
         return String(make<StringStorage>(AdoptTag::ADOPT, result, size));
     }
 
     String intermediate()
     {
-        return String(make<StringStorage>(_buffer, _used));
+        return String(_buffer, _used);
+    }
+
+    StringView view() const
+    {
+        return {_buffer, _used};
     }
 
     StringBuilder &append(String string)
     {
-        return append(string.cstring());
+        return append(string.cstring(), string.length());
+    }
+
+    StringBuilder &append(StringView view)
+    {
+        return append(view.start(), view.length());
     }
 
     StringBuilder &append(const char *str)
     {
         if (!str)
         {
-            append("<null>");
-        }
-        else
-        {
-            for (size_t i = 0; str[i]; i++)
-            {
-                append(str[i]);
-            }
+            return append("<null>");
         }
 
-        return *this;
+        return append(str, strlen(str));
     }
 
     StringBuilder &append(const char *str, size_t size)
     {
         if (!str)
         {
-            append("<null>");
-        }
-        else
-        {
-            for (size_t i = 0; i < size; i++)
-            {
-                append(str[i]);
-            }
+            return append("<null>");
         }
 
+        reserve(size);
+
+        memcpy(_buffer + _used, str, size);
+        _used += size;
+        _buffer[_used] = '\0';
+
         return *this;
     }
 
     StringBuilder &append(char chr)
     {
-        if (_size == 0)
-        {
-            _buffer = new char[16];
-            _size = 16;
-            _used = 0;
-        }
-
-        if (_used + 1 == _size)
-        {
-            _size += _size / 4;
-            _buffer = (char *)realloc(_buffer, _size);
-        }
+        reserve(1);
 
         _buffer[_used] = chr;
         _buffer[_used + 1] = '\0';
@@ -117,6 +126,27 @@ public:
         return *this;
     }
 
+    // Make room for `how_many` more characters and the null terminator.
+    void reserve(size_t how_many)
+    {
+        if (_used + how_many + 1 <= _size)
+        {
+            return;
+        }
+
+        _size = MAX(_size + _size / 4, _used + how_many + 1);
+
+        if (_buffer == _inline)
+        {
+            _buffer = new char[_size];
+            memcpy(_buffer, _inline, _used + 1);
+        }
+        else
+        {
+            _buffer = (char *)realloc(_buffer, _size);
+        }
+    }
+
     StringBuilder &rewind(size_t how_many)
     {
         assert(_used >= how_many);
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <libsystem/core/CString.h>
+#include <libutils/Hash.h>
+
+// A non-owning view of characters, it must not outlive the string it was
+// taken from and it is not null terminated.
+class StringView
+{
+private:
+    const char *_buffer = "";
+    size_t _length = 0;
+
+public:
+    size_t length() const { return _length; }
+
+    bool empty() const { return _length == 0; }
+
+    const char *start() const { return _buffer; }
+
+    const char *end() const { return _buffer + _length; }
+
+    char at(size_t index) const { return _buffer[index]; }
+
+    StringView()
+    {
+    }
+
+    StringView(const char *cstring)
+        : _buffer(cstring), _length(strlen(cstring))
+    {
+    }
+
+    StringView(const char *buffer, size_t length)
+        : _buffer(buffer), _length(length)
+    {
+    }
+
+    StringView substring(size_t start, size_t length) const
+    {
+        if (start >= _length)
+        {
+            return {};
+        }
+
+        return {_buffer + start, length < _length - start ? length : _length - start};
+    }
+
+    StringView substring(size_t start) const
+    {
+        return substring(start, _length);
+    }
+
+    bool operator==(const StringView &other) const
+    {
+        return _length == other._length &&
+               memcmp(_buffer, other._buffer, _length) == 0;
+    }
+
+    bool operator!=(const StringView &other) const { return !(*this == other); }
+
+    char operator[](size_t index) const
+    {
+        return at(index);
+    }
+};
+
+template <>
+inline uint32_t hash<StringView>(const StringView &value)
+{
+    return hash(value.start(), value.length());
+}
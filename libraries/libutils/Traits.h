@@ -502,3 +502,11 @@ using IsFloatingPoint = __IsFloatingPoint<typename RemoveConstVolatile<T>::Type>
 template <typename ReferenceType, typename T>
 using CopyConst =
     typename Conditional<IsConst<ReferenceType>::value, typename AddConst<T>::Type, typename RemoveConst<T>::Type>::Type;
+
+// Types whose objects can be moved around with memcpy, without running their
+// move constructor and destructor. Containers use this to relocate their items
+// in bulk, specialize it for types that only hold pointers to other objects.
+template <typename T>
+struct IsTriviallyRelocatable : IntegralConstant<bool, __is_trivially_copyable(T)>
+{
+};
@@ -8,6 +8,7 @@
 #include <libutils/Iteration.h>
 #include <libutils/New.h>
 #include <libutils/RefPtr.h>
+#include <libutils/Traits.h>
 
 template <typename T>
 void typed_copy(T *destination, T *source, size_t count)
@@ -41,29 +42,155 @@ void typed_move(T *destination, T *source, size_t count)
     }
 }
 
+// Move items to uninitialized memory and end the lifetime of the originals,
+// the two ranges must not overlap.
+template <typename T>
+void typed_relocate(T *destination, T *source, size_t count)
+{
+    if constexpr (IsTriviallyRelocatable<T>::value)
+    {
+        if (count > 0)
+        {
+            memcpy(destination, source, sizeof(T) * count);
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            new (&destination[i]) T(move(source[i]));
+            source[i].~T();
+        }
+    }
+}
+
 template <typename T>
 class Vector
 {
 private:
+    static constexpr size_t MINIMUM_CAPACITY = 8;
+
     T *_storage = nullptr;
     size_t _count = 0;
     size_t _capacity = 0;
 
+    // Storage provided by SmallVector, it is used until the vector outgrows it.
+    T *_inline = nullptr;
+    size_t _inline_capacity = 0;
+
+    void release()
+    {
+        if (_storage && _storage != _inline)
+        {
+            free(_storage);
+        }
+
+        _storage = _inline;
+        _capacity = _inline_capacity;
+    }
+
+    void reallocate(size_t capacity)
+    {
+        if (_inline && capacity <= _inline_capacity)
+        {
+            if (_storage != _inline)
+            {
+                typed_relocate(_inline, _storage, _count);
+                free(_storage);
+
+                _storage = _inline;
+                _capacity = _inline_capacity;
+            }
+
+            return;
+        }
+
+        if constexpr (IsTriviallyRelocatable<T>::value)
+        {
+            if (_storage && _storage != _inline)
+            {
+                // The allocator grows the block in place when it has room.
+                _storage = reinterpret_cast<T *>(realloc(_storage, capacity * sizeof(T)));
+                _capacity = capacity;
+
+                return;
+            }
+        }
+
+        T *new_storage = reinterpret_cast<T *>(malloc(capacity * sizeof(T)));
+
+        typed_relocate(new_storage, _storage, _count);
+
+        if (_storage && _storage != _inline)
+        {
+            free(_storage);
+        }
+
+        _storage = new_storage;
+        _capacity = capacity;
+    }
+
+    void grow(size_t needed)
+    {
+        if (needed <= _capacity)
+        {
+            return;
+        }
+
+        size_t new_capacity = MAX(_capacity + _capacity / 2, MINIMUM_CAPACITY);
+
+        reallocate(MAX(new_capacity, needed));
+    }
+
+    void take(Vector &other)
+    {
+        if (other._storage && other._storage == other._inline)
+        {
+            reserve(other._count);
+            typed_relocate(_storage, other._storage, other._count);
+
+            _count = other._count;
+            other._count = 0;
+        }
+        else
+        {
+            release();
+
+            _storage = other._storage;
+            _count = other._count;
+            _capacity = other._capacity;
+
+            other._storage = other._inline;
+            other._count = 0;
+            other._capacity = other._inline_capacity;
+        }
+    }
+
+protected:
+    Vector(T *inline_storage, size_t inline_capacity) :
+        _storage(inline_storage),
+        _capacity(inline_capacity),
+        _inline(inline_storage),
+        _inline_capacity(inline_capacity)
+    {
+    }
+
 public:
     size_t count() const { return _count; }
 
+    size_t capacity() const { return _capacity; }
+
     bool empty() const { return _count == 0; }
 
     bool any() const { return !empty(); }
 
     T *raw_storage() { return _storage; }
 
-    Vector() :
-        Vector(16) {}
+    Vector() {}
 
     Vector(size_t capacity)
     {
-        ensure_capacity(capacity);
+        reserve(capacity);
     }
 
     Vector(AdoptTag, T *storage, size_t size) :
@@ -75,7 +202,7 @@ public:
 
     Vector(const Vector &other)
     {
-        ensure_capacity(other.count());
+        reserve(other.count());
 
         _count = other.count();
         typed_copy(_storage, other._storage, _count);
@@ -83,17 +210,13 @@ public:
 
     Vector(Vector &&other)
     {
-        swap(_storage, other._storage);
-        swap(_count, other._count);
-        swap(_capacity, other._capacity);
+        take(other);
     }
 
     ~Vector()
     {
         clear();
-
-        if (_storage)
-            free(_storage);
+        release();
     }
 
     Vector &operator=(const Vector &other)
@@ -102,7 +225,7 @@ public:
         {
             clear();
 
-            ensure_capacity(other.count());
+            reserve(other.count());
             _count = other.count();
             typed_copy(_storage, other._storage, _count);
         }
@@ -114,9 +237,8 @@ public:
     {
         if (this != &other)
         {
-            swap(_storage, other._storage);
-            swap(_count, other._count);
-            swap(_capacity, other._capacity);
+            clear();
+            take(other);
         }
 
         return *this;
@@ -161,11 +283,6 @@ public:
 
     void clear()
     {
-        if (!_storage)
-        {
-            return;
-        }
-
         if constexpr (!std::is_trivially_destructible_v<T>)
         {
             for (size_t i = 0; i < _count; i++)
@@ -194,7 +311,7 @@ public:
     template <typename Comparator>
     void sort(Comparator comparator)
     {
-        for (size_t i = 0; i < _count - 1; i++)
+        for (size_t i = 0; i + 1 < _count; i++)
         {
             for (size_t j = i + 1; j < _count; j++)
             {
@@ -206,86 +323,23 @@ public:
         }
     }
 
-    void ensure_capacity(size_t capacity)
+    void reserve(size_t capacity)
     {
-        capacity = MAX(capacity, 16);
-
-        if (!_storage)
+        if (capacity > _capacity)
         {
-            _storage = reinterpret_cast<T *>(calloc(capacity, sizeof(T)));
-            _capacity = capacity;
-            _count = 0;
-
-            return;
+            reallocate(capacity);
         }
-
-        capacity = MAX(_count, capacity);
-
-        if (capacity <= _capacity)
-        {
-            return;
-        }
-
-        size_t new_capacity = _capacity;
-
-        while (new_capacity <= capacity)
-        {
-            new_capacity += new_capacity / 4;
-        }
-
-        T *new_storage = reinterpret_cast<T *>(calloc(new_capacity, sizeof(T)));
-
-        for (size_t i = 0; i < _count; i++)
-        {
-            new (&new_storage[i]) T(move(_storage[i]));
-        }
-
-        free(_storage);
-        _storage = new_storage;
-        _capacity = new_capacity;
-
-        _count++;
     }
 
-    void grow()
+    void shrink_to_fit()
     {
-        if (_count + 1 >= _capacity)
+        if (_count == 0)
         {
-            size_t new_capacity = _capacity + _capacity / 4;
-            T *new_storage = reinterpret_cast<T *>(calloc(new_capacity, sizeof(T)));
-
-            for (size_t i = 0; i < _count; i++)
-            {
-                new (&new_storage[i]) T(move(_storage[i]));
-            }
-
-            free(_storage);
-            _storage = new_storage;
-            _capacity = new_capacity;
+            release();
         }
-
-        _count++;
-    }
-
-    void shrink()
-    {
-        _count--;
-
-        size_t new_capacity = _capacity - _capacity / 4;
-
-        if (MAX(_count, 16) < new_capacity)
+        else if (_count < _capacity)
         {
-            T *new_storage = reinterpret_cast<T *>(calloc(new_capacity, sizeof(T)));
-
-            for (size_t i = 0; i < _count; i++)
-            {
-                new (&new_storage[i]) T(move(_storage[i]));
-                _storage[i].~T();
-            }
-
-            free(_storage);
-            _storage = new_storage;
-            _capacity = new_capacity;
+            reallocate(_count);
         }
     }
 
@@ -298,14 +352,23 @@ public:
     {
         assert(index <= _count);
 
-        grow();
+        grow(_count + 1);
 
-        for (size_t j = _count; j > index; j--)
+        if constexpr (IsTriviallyRelocatable<T>::value)
         {
-            new (&_storage[j]) T(move(_storage[j - 1]));
+            memmove(&_storage[index + 1], &_storage[index], sizeof(T) * (_count - index));
+        }
+        else
+        {
+            for (size_t j = _count; j > index; j--)
+            {
+                new (&_storage[j]) T(move(_storage[j - 1]));
+                _storage[j - 1].~T();
+            }
         }
 
         new (&_storage[index]) T(move(value));
+        _count++;
 
         return _storage[index];
     }
@@ -355,13 +418,20 @@ public:
 
         _storage[index].~T();
 
-        for (size_t i = index; i < _count - 1; ++i)
+        if constexpr (IsTriviallyRelocatable<T>::value)
+        {
+            memmove(&_storage[index], &_storage[index + 1], sizeof(T) * (_count - index - 1));
+        }
+        else
         {
-            new (&_storage[i]) T(move(_storage[i + 1]));
-            _storage[i + 1].~T();
+            for (size_t i = index; i < _count - 1; ++i)
+            {
+                new (&_storage[i]) T(move(_storage[i + 1]));
+                _storage[i + 1].~T();
+            }
         }
 
-        shrink();
+        _count--;
     }
 
     void remove_value(const T &value)
@@ -435,6 +505,8 @@ public:
 
     void push_back_many(const Vector<T> &values)
     {
+        grow(_count + values.count());
+
         for (size_t i = 0; i < values.count(); i++)
         {
             push_back(values[i]);
@@ -486,3 +558,52 @@ public:
         return false;
     }
 };
+
+template <typename T>
+struct IsTriviallyRelocatable<Vector<T>> : TrueType
+{
+};
+
+// A vector that keeps its first N items in the object itself, for the many
+// short lists that would otherwise pay for a heap allocation.
+template <typename T, size_t N>
+class SmallVector : public Vector<T>
+{
+private:
+    alignas(T) char _buffer[N * sizeof(T)];
+
+public:
+    SmallVector() :
+        Vector<T>(reinterpret_cast<T *>(_buffer), N)
+    {
+    }
+
+    SmallVector(const SmallVector &other) :
+        Vector<T>(reinterpret_cast<T *>(_buffer), N)
+    {
+        Vector<T>::operator=(other);
+    }
+
+    SmallVector(SmallVector &&other) :
+        Vector<T>(reinterpret_cast<T *>(_buffer), N)
+    {
+        Vector<T>::operator=(move(other));
+    }
+
+    ~SmallVector()
+    {
+        this->clear();
+    }
+
+    SmallVector &operator=(const SmallVector &other)
+    {
+        Vector<T>::operator=(other);
+        return *this;
+    }
+
+    SmallVector &operator=(SmallVector &&other)
+    {
+        Vector<T>::operator=(move(other));
+        return *this;
+    }
+};
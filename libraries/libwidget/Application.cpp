@@ -39,6 +39,24 @@ void application_do_message(CompositorMessage *message)
             window->dispatch_event(&message->event_window.event);
         }
     }
+    else if (message->type == COMPOSITOR_MESSAGE_BUFFER_RELEASED)
+    {
+        Window *window = application_get_window(message->buffer_released.id);
+
+        if (window)
+        {
+            window->buffer_released(message->buffer_released.buffer);
+        }
+    }
+    else if (message->type == COMPOSITOR_MESSAGE_FRAME_DONE)
+    {
+        Window *window = application_get_window(message->frame_done.id);
+
+        if (window)
+        {
+            window->frame_presented(message->frame_done.frame);
+        }
+    }
     else if (message->type == COMPOSITOR_MESSAGE_CHANGED_RESOLUTION)
     {
         Screen::bound(message->changed_resolution.resolution);
@@ -100,15 +118,6 @@ CompositorMessage *application_wait_for_message(CompositorMessageType expected_m
     return message;
 }
 
-void application_wait_for_ack()
-{
-    CompositorMessage *ack_message = application_wait_for_message(COMPOSITOR_MESSAGE_ACK);
-    if (ack_message)
-    {
-        free(ack_message);
-    }
-}
-
 void application_request_callback(
     void *target,
     Connection *connection,
@@ -314,10 +323,8 @@ void application_show_window(Window *window)
             .id = window->handle(),
             .flags = window->_flags,
             .type = window->type(),
-            .frontbuffer = window->frontbuffer_handle(),
-            .frontbuffer_size = window->frontbuffer->size(),
-            .backbuffer = window->backbuffer_handle(),
-            .backbuffer_size = window->frontbuffer->size(),
+            .buffer = window->frontbuffer_handle(),
+            .buffer_size = window->frontbuffer().size(),
             .bound = window->bound_on_screen(),
         },
     };
@@ -341,7 +348,7 @@ void application_hide_window(Window *window)
     application_exit_if_all_windows_are_closed();
 }
 
-void application_flip_window(Window *window, Rectangle bound)
+void application_flip_window(Window *window, int frame, const CompositorDamage &damage)
 {
     assert(_state >= APPLICATION_INITALIZED);
     assert(list_contains(_windows, window));
@@ -350,16 +357,15 @@ void application_flip_window(Window *window, Rectangle bound)
         .type = COMPOSITOR_MESSAGE_FLIP_WINDOW,
         .flip_window = {
             .id = window->handle(),
-            .frontbuffer = window->frontbuffer_handle(),
-            .frontbuffer_size = window->frontbuffer->size(),
-            .backbuffer = window->backbuffer_handle(),
-            .backbuffer_size = window->frontbuffer->size(),
-            .bound = bound,
+            .buffer = window->frontbuffer_handle(),
+            .buffer_size = window->frontbuffer().size(),
+            .frame = frame,
+            .damage = damage,
+            .opaque = window->opaque_region(),
         },
     };
 
     application_send_message(message);
-    application_wait_for_ack();
 }
 
 void application_move_window(Window *window, Vec2i position)
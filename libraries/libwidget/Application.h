@@ -26,7 +26,7 @@ void application_show_window(Window *window);
 
 void application_hide_window(Window *window);
 
-void application_flip_window(Window *window, Rectangle bound);
+void application_flip_window(Window *window, int frame, const CompositorDamage &damage);
 
 void application_move_window(Window *window, Vec2i position);
 
@@ -362,6 +362,11 @@ WindowFlag window_flags_from_markup(markup::Node &node)
         flags |= WINDOW_TRANSPARENT;
     }
 
+    if (node.has_attribute("blur-behind"))
+    {
+        flags |= WINDOW_BLUR_BEHIND;
+    }
+
     return flags;
 }
 
@@ -390,6 +395,11 @@ Window *window_create_from_file(const char *path)
 {
     auto root = markup::parse_file(path);
 
+    return window_create_from_document(root);
+}
+
+Window *window_create_from_document(markup::Node &root)
+{
     auto window = window_create_from_markup(root);
 
     widget_apply_attribute_from_markup(window->root(), root);
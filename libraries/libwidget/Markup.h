@@ -1,5 +1,8 @@
 #pragma once
 
+#include <libmarkup/Markup.h>
 #include <libwidget/Window.h>
 
 Window *window_create_from_file(const char *path);
+
+Window *window_create_from_document(markup::Node &root);
@@ -2,6 +2,7 @@
 #include <libsystem/core/CString.h>
 #include <libsystem/json/Json.h>
 #include <libsystem/utils/NumberParser.h>
+#include <libutils/Intern.h>
 #include <libwidget/Theme.h>
 
 static bool _theme_is_dark = true;
@@ -132,7 +133,7 @@ void theme_load(const char *path)
 
     for (int i = 0; i < __THEME_COLOR_COUNT; i++)
     {
-        auto &color = colors.get(_theme_colors_names[i]);
+        auto &color = colors.get(intern(_theme_colors_names[i]));
 
         if (color.is(json::STRING))
         {
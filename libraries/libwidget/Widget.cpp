@@ -290,8 +290,30 @@ void Widget::do_layout()
     }
 }
 
+void Widget::bound(Rectangle value)
+{
+    if (_bound == value)
+    {
+        return;
+    }
+
+    should_repaint(_bound);
+
+    _bound = value;
+    _layout_dirty = true;
+
+    should_repaint(_bound);
+}
+
 void Widget::relayout()
 {
+    if (!_layout_dirty)
+    {
+        return;
+    }
+
+    _layout_dirty = false;
+
     do_layout();
 
     if (_childs->count() == 0)
@@ -305,6 +327,12 @@ void Widget::relayout()
 
 void Widget::should_relayout()
 {
+    for (Widget *widget = this; widget; widget = widget->_parent)
+    {
+        widget->_layout_dirty = true;
+        widget->_size_dirty = true;
+    }
+
     if (_window)
     {
         _window->should_relayout();
@@ -554,6 +582,11 @@ void Widget::dispatch_event(Event *event)
 
 Vec2i Widget::compute_size()
 {
+    if (!_size_dirty)
+    {
+        return _size_cache;
+    }
+
     Vec2i size = this->size();
 
     int width = size.x();
@@ -582,5 +615,8 @@ Vec2i Widget::compute_size()
         height = MAX(height, _min_height);
     }
 
-    return Vec2i(width, height);
+    _size_cache = Vec2i(width, height);
+    _size_dirty = false;
+
+    return _size_cache;
 }
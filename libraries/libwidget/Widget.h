@@ -75,6 +75,12 @@ private:
     RefPtr<Font> _font;
     LayoutAttributes _layout_attributes = {};
 
+    // Set by should_relayout() on the widget and all its parents, the size
+    // hint is kept until then and only dirty subtrees are laid out again.
+    bool _layout_dirty = true;
+    bool _size_dirty = true;
+    Vec2i _size_cache = Vec2i::zero();
+
     EventHandler _handlers[EventType::__COUNT] = {};
 
     struct Widget *_parent = {};
@@ -98,6 +104,7 @@ public:
     void font(RefPtr<Font> font)
     {
         _font = font;
+        should_relayout();
     }
 
     Color color(ThemeColorRole role);
@@ -106,7 +113,7 @@ public:
     Rectangle content_bound() const { return bound().shrinked(_insets); }
 
     Rectangle bound() const { return _bound; }
-    void bound(Rectangle value) { _bound = value; }
+    void bound(Rectangle value);
 
     Insets insets() const { return _insets; }
     void insets(Insets insets)
@@ -115,9 +122,18 @@ public:
         should_relayout();
     }
 
-    void layout(Layout layout) { _layout = layout; }
+    void layout(Layout layout)
+    {
+        _layout = layout;
+        should_relayout();
+    }
+
+    void attributes(LayoutAttributes attributes)
+    {
+        _layout_attributes = attributes;
+        should_relayout();
+    }
 
-    void attributes(LayoutAttributes attributes) { _layout_attributes = attributes; }
     LayoutAttributes attributes() { return _layout_attributes; }
 
     void window(Window *window)
@@ -132,13 +148,29 @@ public:
         return _window;
     }
 
-    void max_height(int value) { _max_height = value; }
+    void max_height(int value)
+    {
+        _max_height = value;
+        should_relayout();
+    }
 
-    void max_width(int value) { _max_width = value; }
+    void max_width(int value)
+    {
+        _max_width = value;
+        should_relayout();
+    }
 
-    void min_height(int value) { _min_height = value; }
+    void min_height(int value)
+    {
+        _min_height = value;
+        should_relayout();
+    }
 
-    void min_width(int value) { _min_width = value; }
+    void min_width(int value)
+    {
+        _min_width = value;
+        should_relayout();
+    }
 
     /* --- subclass API ----------------------------------------------------- */
 
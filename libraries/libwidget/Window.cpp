@@ -4,6 +4,7 @@
 #include <libsystem/eventloop/EventLoop.h>
 #include <libsystem/io/Stream.h>
 #include <libsystem/system/Memory.h>
+#include <libutils/Intern.h>
 #include <libwidget/Application.h>
 #include <libwidget/Event.h>
 #include <libwidget/Screen.h>
@@ -13,6 +14,19 @@
 
 Rectangle window_header_bound(Window *window);
 
+static void window_create_buffers(Window *window, Vec2i size)
+{
+    for (int i = 0; i < COMPOSITOR_BUFFER_COUNT; i++)
+    {
+        window->buffers[i] = Bitmap::create_shared(size.x(), size.y()).take_value();
+        window->buffers_painter[i] = own<Painter>(window->buffers[i]);
+        window->buffers_busy[i] = false;
+        window->buffers_stale[i].clear();
+    }
+
+    window->current_buffer = 0;
+}
+
 void window_populate_header(Window *window)
 {
     window->header_container->clear_children();
@@ -65,11 +79,7 @@ Window::Window(WindowFlag flags)
     _focused = false;
     cursor_state = CURSOR_DEFAULT;
 
-    frontbuffer = Bitmap::create_shared(250, 250).take_value();
-    frontbuffer_painter = own<Painter>(frontbuffer);
-
-    backbuffer = Bitmap::create_shared(250, 250).take_value();
-    backbuffer_painter = own<Painter>(backbuffer);
+    window_create_buffers(this, Vec2i(250, 250));
 
     _bound = Rectangle(250, 250);
 
@@ -151,6 +161,35 @@ void Window::repaint(Painter &painter, Rectangle rectangle)
     painter.pop();
 }
 
+static void window_add_region(Vector<Rectangle> &regions, Rectangle rectangle)
+{
+    for (size_t i = 0; i < regions.count(); i++)
+    {
+        if (regions[i].colide_with(rectangle))
+        {
+            regions[i] = regions[i].merged_with(rectangle);
+            return;
+        }
+    }
+
+    regions.push_back(rectangle);
+}
+
+static int window_acquire_buffer(Window *window)
+{
+    for (int i = 1; i <= COMPOSITOR_BUFFER_COUNT; i++)
+    {
+        int index = (window->current_buffer + i) % COMPOSITOR_BUFFER_COUNT;
+
+        if (!window->buffers_busy[index])
+        {
+            return index;
+        }
+    }
+
+    return -1;
+}
+
 void Window::repaint_dirty()
 {
     // FIXME: find a better way to schedule update after layout.
@@ -160,43 +199,122 @@ void Window::repaint_dirty()
         relayout();
     }
 
-    Rectangle repaited_regions = Rectangle::empty();
-    Painter &painter = *backbuffer_painter;
+    if (_dirty_rects.empty())
+    {
+        return;
+    }
+
+    // Stay at most a few frames ahead of the compositor, frame_presented()
+    // and buffer_released() pick up the pending repaint.
+    if (frame - frame_done >= WINDOW_FRAMES_IN_FLIGHT)
+    {
+        return;
+    }
 
-    _dirty_rects.foreach ([&](Rectangle &rect) {
-        repaint(painter, rect);
+    int index = window_acquire_buffer(this);
+
+    if (index < 0)
+    {
+        return;
+    }
+
+    Bitmap &buffer = *buffers[index];
+    Painter &painter = *buffers_painter[index];
+
+    // Bring the buffer up to date with the frames it missed.
+    if (index != current_buffer)
+    {
+        buffers_stale[index].foreach ([&](Rectangle &rect) {
+            buffer.copy_from(*buffers[current_buffer], rect);
+            return Iteration::CONTINUE;
+        });
+    }
+
+    buffers_stale[index].clear();
+
+    CompositorDamage damage = {};
+
+    auto did_change = [&](Rectangle rect) {
+        for (int i = 0; i < COMPOSITOR_BUFFER_COUNT; i++)
+        {
+            if (i != index)
+            {
+                window_add_region(buffers_stale[i], rect);
+            }
+        }
 
-        if (repaited_regions.is_empty())
+        if (damage.count < COMPOSITOR_DAMAGE_MAX)
         {
-            repaited_regions = rect;
+            damage.rectangles[damage.count] = rect;
+            damage.count++;
         }
         else
         {
-            repaited_regions = rect.merged_with(repaited_regions);
+            damage.rectangles[COMPOSITOR_DAMAGE_MAX - 1] = rect.merged_with(damage.rectangles[COMPOSITOR_DAMAGE_MAX - 1]);
         }
+    };
+
+    if (!_scroll_rectangle.is_empty())
+    {
+        buffer.scroll(_scroll_rectangle, _scroll_offset);
+        did_change(_scroll_rectangle);
+
+        _scroll_rectangle = {};
+        _scroll_offset = 0;
+    }
+
+    _dirty_rects.foreach ([&](Rectangle &rect) {
+        repaint(painter, rect);
+        did_change(rect);
 
         return Iteration::CONTINUE;
     });
 
     _dirty_rects.clear();
 
-    frontbuffer->copy_from(*backbuffer, repaited_regions);
+    current_buffer = index;
+    buffers_busy[index] = true;
+    frame++;
+
+    application_flip_window(this, frame, damage);
+}
+
+void Window::buffer_released(int buffer_handle)
+{
+    for (int i = 0; i < COMPOSITOR_BUFFER_COUNT; i++)
+    {
+        if (buffers[i]->handle() == buffer_handle)
+        {
+            buffers_busy[i] = false;
+        }
+    }
+
+    if (!_dirty_rects.empty())
+    {
+        _repaint_invoker->invoke_later();
+    }
+}
 
-    swap(frontbuffer, backbuffer);
-    swap(frontbuffer_painter, backbuffer_painter);
+void Window::frame_presented(int presented_frame)
+{
+    frame_done = MAX(frame_done, presented_frame);
 
-    application_flip_window(this, repaited_regions);
+    if (!_dirty_rects.empty())
+    {
+        _repaint_invoker->invoke_later();
+    }
 }
 
 void Window::relayout()
 {
+    // Widgets may ask for another layout pass while this one runs.
+    dirty_layout = false;
+
     header()->bound(window_header_bound(this));
     header()->relayout();
 
     root()->bound(content_bound());
     root()->relayout();
-
-    dirty_layout = false;
 }
 
 void Window::should_repaint(Rectangle rectangle)
@@ -221,6 +339,41 @@ void Window::should_repaint(Rectangle rectangle)
     _dirty_rects.push_back(rectangle);
 }
 
+// Move what is already painted in the rectangle instead of repainting it, only
+// the rows uncovered are repainted.
+void Window::should_scroll(Rectangle rectangle, int offset)
+{
+    if (!_visible)
+        return;
+
+    bool pending_damage = !_scroll_rectangle.is_empty() ||
+                          abs(offset) >= rectangle.height();
+
+    for (size_t i = 0; i < _dirty_rects.count(); i++)
+    {
+        pending_damage |= _dirty_rects[i].colide_with(rectangle);
+    }
+
+    // Whatever is waiting to be repainted would be moved with the pixels.
+    if (pending_damage)
+    {
+        should_repaint(rectangle);
+        return;
+    }
+
+    _scroll_rectangle = rectangle;
+    _scroll_offset = offset;
+
+    if (offset < 0)
+    {
+        should_repaint(rectangle.take_bottom(-offset));
+    }
+    else
+    {
+        should_repaint(rectangle.take_top(offset));
+    }
+}
+
 void Window::should_relayout()
 {
     if (dirty_layout || !_visible)
@@ -233,15 +386,15 @@ void Window::should_relayout()
 
 static void window_change_framebuffer_if_needed(Window *window)
 {
-    if (window->bound().width() > window->frontbuffer->width() ||
-        window->bound().height() > window->frontbuffer->height() ||
-        window->bound().area() < window->frontbuffer->bound().area() * 0.75)
-    {
-        window->frontbuffer = Bitmap::create_shared(window->width(), window->height()).take_value();
-        window->frontbuffer_painter = own<Painter>(window->frontbuffer);
+    Bitmap &buffer = *window->buffers[0];
 
-        window->backbuffer = Bitmap::create_shared(window->width(), window->height()).take_value();
-        window->backbuffer_painter = own<Painter>(window->backbuffer);
+    if (window->bound().width() > buffer.width() ||
+        window->bound().height() > buffer.height() ||
+        window->bound().area() < buffer.bound().area() * 0.75)
+    {
+        // The compositor keeps its own references to the old buffers,
+        // their release is ignored since the handles don't match anymore.
+        window_create_buffers(window, window->size());
     }
 }
 
@@ -263,8 +416,27 @@ void Window::show()
 
     window_change_framebuffer_if_needed(this);
 
+    // The compositor doesn't hold any of our buffers after the window was hidden.
+    for (int i = 0; i < COMPOSITOR_BUFFER_COUNT; i++)
+    {
+        buffers_busy[i] = false;
+        buffers_stale[i].clear();
+
+        if (i != current_buffer)
+        {
+            buffers_stale[i].push_back(bound());
+        }
+    }
+
+    frame_done = frame;
+
     relayout();
-    repaint(*backbuffer_painter, bound());
+    repaint(*buffers_painter[current_buffer], bound());
+
+    // The whole window was just painted, including what the layout damaged.
+    _dirty_rects.clear();
+
+    buffers_busy[current_buffer] = true;
 
     application_show_window(this);
 }
@@ -669,7 +841,7 @@ void Window::widget_removed(Widget *widget)
 
 void Window::register_widget_by_id(String id, Widget *widget)
 {
-    widget_by_id[id] = widget;
+    widget_by_id[intern(id.view())] = widget;
 }
 
 Color Window::color(ThemeColorRole role)
@@ -14,6 +14,7 @@
 #define WINDOW_RESIZE_AREA 16
 #define WINDOW_HEADER_AREA 36
 #define WINDOW_CONTENT_PADDING 1
+#define WINDOW_FRAMES_IN_FLIGHT 2
 
 struct Window
 {
@@ -26,6 +27,7 @@ struct Window
     WindowType _type;
 
     float _opacity;
+    Rectangle _opaque_region{};
 
     bool _focused = false;
     bool _visible = false;
@@ -39,15 +41,25 @@ struct Window
 
     CursorState cursor_state;
 
-    RefPtr<Bitmap> frontbuffer;
-    OwnPtr<Painter> frontbuffer_painter;
+    RefPtr<Bitmap> buffers[COMPOSITOR_BUFFER_COUNT];
+    OwnPtr<Painter> buffers_painter[COMPOSITOR_BUFFER_COUNT];
 
-    RefPtr<Bitmap> backbuffer;
-    OwnPtr<Painter> backbuffer_painter;
+    // Buffers are busy from the time they are flipped until the compositor
+    // releases them, stale regions were repainted since they were current.
+    bool buffers_busy[COMPOSITOR_BUFFER_COUNT] = {};
+    SmallVector<Rectangle, 8> buffers_stale[COMPOSITOR_BUFFER_COUNT];
+    int current_buffer = 0;
 
-    Vector<Rectangle> _dirty_rects{};
+    int frame = 0;
+    int frame_done = 0;
+
+    SmallVector<Rectangle, 8> _dirty_rects{};
     bool dirty_layout;
 
+    // A region to move in the buffer before repainting the dirty rectangles.
+    Rectangle _scroll_rectangle{};
+    int _scroll_offset = 0;
+
     EventHandler handlers[EventType::__COUNT];
 
     Widget *header_container;
@@ -64,8 +76,8 @@ struct Window
 
 public:
     int handle() { return this->_handle; }
-    int frontbuffer_handle() { return frontbuffer->handle(); }
-    int backbuffer_handle() { return backbuffer->handle(); }
+    int frontbuffer_handle() { return buffers[current_buffer]->handle(); }
+    Bitmap &frontbuffer() { return *buffers[current_buffer]; }
 
     void title(String title);
     void icon(RefPtr<Icon> icon);
@@ -101,6 +113,11 @@ public:
     void opacity(float value) { _opacity = value; }
     float opacity() { return _opacity; }
 
+    // Transparent windows can tell the compositor which part of them is
+    // always painted opaque, nothing behind that part needs to be drawn.
+    void opaque_region(Rectangle region) { _opaque_region = region; }
+    Rectangle opaque_region() { return _opaque_region; }
+
     bool visible() { return _visible; }
     bool focused()
     {
@@ -141,8 +158,14 @@ public:
 
     void should_repaint(Rectangle rectangle);
 
+    void should_scroll(Rectangle rectangle, int offset);
+
     void should_relayout();
 
+    void buffer_released(int buffer_handle);
+
+    void frame_presented(int presented_frame);
+
     template <typename WidgetType, typename CallbackType>
     void with_widget(String name, CallbackType callback)
     {
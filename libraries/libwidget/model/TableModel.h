@@ -2,13 +2,89 @@
 
 #include <libgraphic/Color.h>
 #include <libutils/Observable.h>
+#include <libutils/Vector.h>
 
 #include <libwidget/utils/Variant.h>
 
+enum TableModelChangeType
+{
+    TABLE_MODEL_ROWS_INSERTED,
+    TABLE_MODEL_ROWS_REMOVED,
+    TABLE_MODEL_ROWS_UPDATED,
+};
+
+struct TableModelChange
+{
+    TableModelChangeType type;
+    int row;
+    int count;
+};
+
 class TableModel : public RefCounted<TableModel>,
                    public Observable<TableModel>
 {
+private:
+    Vector<TableModelChange> _changes{};
+    bool _incremental = false;
+
+    void did_change_rows(TableModelChangeType type, int row, int count)
+    {
+        if (count <= 0)
+        {
+            return;
+        }
+
+        if (!_changes.empty())
+        {
+            auto &last = _changes[_changes.count() - 1];
+
+            if (last.type == type && type != TABLE_MODEL_ROWS_REMOVED && last.row + last.count == row)
+            {
+                last.count += count;
+                return;
+            }
+
+            if (last.type == type && type == TABLE_MODEL_ROWS_REMOVED && last.row == row)
+            {
+                last.count += count;
+                return;
+            }
+        }
+
+        _changes.push_back({type, row, count});
+    }
+
+protected:
+    // Changes are applied in order, each row index is relative to the rows
+    // as they are after the previous changes.
+    void did_insert_rows(int row, int count) { did_change_rows(TABLE_MODEL_ROWS_INSERTED, row, count); }
+
+    void did_remove_rows(int row, int count) { did_change_rows(TABLE_MODEL_ROWS_REMOVED, row, count); }
+
+    void did_update_rows(int row, int count) { did_change_rows(TABLE_MODEL_ROWS_UPDATED, row, count); }
+
+    // Notify the observers of the changes recorded since the last
+    // notification only, did_update() means that everything changed.
+    void did_change()
+    {
+        _incremental = true;
+        Observable<TableModel>::did_update();
+        _incremental = false;
+
+        _changes.clear();
+    }
+
 public:
+    bool incremental() { return _incremental; }
+
+    const Vector<TableModelChange> &changes() { return _changes; }
+
+    void did_update()
+    {
+        Observable<TableModel>::did_update();
+        _changes.clear();
+    }
+
     TableModel() {}
 
     virtual ~TableModel() {}
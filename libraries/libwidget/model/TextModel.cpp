@@ -1,61 +1,465 @@
-#include <libutils/Scanner.h>
+#include <libsystem/core/CString.h>
+#include <libsystem/io/File.h>
 
 #include <libwidget/model/TextModel.h>
 
+/* --- Pieces --------------------------------------------------------------- */
+
+static size_t text_codepoint_size(uint8_t lead)
+{
+    if ((lead & 0xf8) == 0xf0)
+    {
+        return 4;
+    }
+    else if ((lead & 0xf0) == 0xe0)
+    {
+        return 3;
+    }
+    else if ((lead & 0xe0) == 0xc0)
+    {
+        return 2;
+    }
+    else
+    {
+        return 1;
+    }
+}
+
+size_t text_decode(const uint8_t *data, size_t size, Codepoint *codepoint)
+{
+    if (text_codepoint_size(data[0]) > size)
+    {
+        // Truncated sequence, show the byte as is.
+        *codepoint = data[0];
+        return 1;
+    }
+
+    return utf8_to_codepoint(data, codepoint);
+}
+
+size_t text_piece_offset(TextStorage &storage, const TextPiece &piece, size_t length)
+{
+    if (piece.size == piece.length)
+    {
+        return length;
+    }
+
+    const uint8_t *data = storage.data(piece);
+    size_t offset = 0;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        Codepoint codepoint;
+        offset += text_decode(data + offset, piece.size - offset, &codepoint);
+    }
+
+    return offset;
+}
+
+static size_t text_length(const uint8_t *data, size_t size)
+{
+    size_t length = 0;
+    size_t offset = 0;
+
+    while (offset < size)
+    {
+        if (data[offset] < 0x80)
+        {
+            offset++;
+        }
+        else
+        {
+            Codepoint codepoint;
+            offset += text_decode(data + offset, size - offset, &codepoint);
+        }
+
+        length++;
+    }
+
+    return length;
+}
+
+/* --- Lines ---------------------------------------------------------------- */
+
+void TextModelLine::insert_piece(size_t index, TextPiece piece)
+{
+    _pieces.insert(index, move(piece));
+}
+
+void TextModelLine::remove_piece(size_t index)
+{
+    _pieces.remove_index(index);
+}
+
+// Make sure a piece starts at the codepoint index and return it.
+size_t TextModelLine::split(size_t index)
+{
+    size_t position = 0;
+
+    for (size_t i = 0; i < _pieces.count(); i++)
+    {
+        TextPiece piece = _pieces[i];
+
+        if (index == position)
+        {
+            return i;
+        }
+
+        if (index < position + piece.length)
+        {
+            size_t length = index - position;
+            size_t size = text_piece_offset(*_storage, piece, length);
+
+            _pieces[i] = {piece.source, piece.start, size, length};
+            insert_piece(i + 1, {piece.source, piece.start + size, piece.size - size, piece.length - length});
+
+            return i + 1;
+        }
+
+        position += piece.length;
+    }
+
+    return _pieces.count();
+}
+
+void TextModelLine::edited()
+{
+    _spans = nullptr;
+}
+
+Codepoint TextModelLine::operator[](size_t index)
+{
+    assert(index < length());
+
+    for (size_t i = 0; i < _pieces.count(); i++)
+    {
+        TextPiece &piece = _pieces[i];
+
+        if (index < piece.length)
+        {
+            const uint8_t *data = _storage->data(piece);
+
+            if (piece.size == piece.length)
+            {
+                return data[index];
+            }
+
+            size_t offset = text_piece_offset(*_storage, piece, index);
+
+            Codepoint codepoint;
+            text_decode(data + offset, piece.size - offset, &codepoint);
+
+            return codepoint;
+        }
+
+        index -= piece.length;
+    }
+
+    ASSERT_NOT_REACHED();
+}
+
+void TextModelLine::append(TextPiece piece)
+{
+    if (piece.size == 0)
+    {
+        return;
+    }
+
+    TextPiece *last = _pieces.count() > 0 ? &_pieces[_pieces.count() - 1] : nullptr;
+
+    if (last &&
+        last->source == piece.source &&
+        last->start + last->size == piece.start)
+    {
+        last->size += piece.size;
+        last->length += piece.length;
+    }
+    else
+    {
+        insert_piece(_pieces.count(), piece);
+    }
+
+    _length += piece.length;
+
+    edited();
+}
+
+void TextModelLine::append(Codepoint codepoint)
+{
+    append_at(_length, codepoint);
+}
+
+void TextModelLine::append(TextModelLine &line)
+{
+    for (size_t i = 0; i < line._pieces.count(); i++)
+    {
+        append(line._pieces[i]);
+    }
+
+    edited();
+}
+
+void TextModelLine::append_at(size_t index, Codepoint codepoint)
+{
+    TextPiece piece = _storage->append(codepoint);
+
+    size_t i = split(index);
+
+    // Typing extends the piece that was added last.
+    if (i > 0 &&
+        _pieces[i - 1].source == TEXT_PIECE_ADDED &&
+        _pieces[i - 1].start + _pieces[i - 1].size == piece.start)
+    {
+        _pieces[i - 1].size += piece.size;
+        _pieces[i - 1].length += piece.length;
+    }
+    else
+    {
+        insert_piece(i, piece);
+    }
+
+    _length++;
+
+    edited();
+}
+
+void TextModelLine::delete_at(size_t index)
+{
+    assert(index < length());
+
+    size_t i = split(index);
+    split(index + 1);
+    remove_piece(i);
+
+    _length--;
+
+    edited();
+}
+
+OwnPtr<TextModelLine> TextModelLine::split_at(size_t index)
+{
+    auto right = own<TextModelLine>(*_storage);
+
+    size_t i = split(index);
+
+    for (size_t j = i; j < _pieces.count(); j++)
+    {
+        right->append(_pieces[j]);
+    }
+
+    while (_pieces.count() > i)
+    {
+        _pieces.pop_back();
+    }
+
+    _length = index;
+
+    edited();
+
+    return right;
+}
+
+void TextModelLine::span_add(const TextModelSpan &span)
+{
+    if (!_spans)
+    {
+        _spans = own<Vector<TextModelSpan>>();
+    }
+
+    _spans->push_back(span);
+}
+
+TextModelSpan TextModelLine::span_at(size_t line, size_t column)
+{
+    if (_spans)
+    {
+        for (size_t i = 0; i < _spans->count(); i++)
+        {
+            auto &span = (*_spans)[i];
+
+            if (column >= span.start() && column < span.end())
+            {
+                return span;
+            }
+        }
+    }
+
+    return TextModelSpan(line, column, column + 1);
+}
+
+/* --- Model ---------------------------------------------------------------- */
+
 RefPtr<TextModel> TextModel::empty()
 {
     auto model = make<TextModel>();
-    model->append_line(own<TextModelLine>());
+    model->append_line(own<TextModelLine>(model->storage()));
     return model;
 }
 
 RefPtr<TextModel> TextModel::from_file(const char *path)
 {
-    auto model = make<TextModel>();
+    void *buffer = nullptr;
+    size_t size = 0;
+
+    if (file_read_all(path, &buffer, &size) != SUCCESS)
+    {
+        return empty();
+    }
 
-    Stream *stream = stream_open(path, OPEN_READ | OPEN_BUFFERED);
+    // The file is kept as is, lines are pieces of it.
+    auto model = make<TextModel>(own<TextStorage>((uint8_t *)buffer, size));
 
-    StreamScanner scan{stream};
+    const uint8_t *data = (const uint8_t *)buffer;
+    size_t offset = 0;
 
     // Skip the utf8 bom header if present.
-    scan.skip_word("\xEF\xBB\xBF");
+    if (size >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0)
+    {
+        offset = 3;
+    }
 
-    while (scan.do_continue())
+    while (offset < size)
     {
-        auto line = own<TextModelLine>();
+        size_t end = offset;
 
-        while (scan.do_continue() &&
-               scan.current_codepoint() != '\n')
+        while (end < size && data[end] != '\n')
         {
-            line->append(scan.current_codepoint());
-            scan.foreward_codepoint();
+            end++;
         }
-        scan.skip('\n'); // skip the \n
 
+        auto line = own<TextModelLine>(model->storage());
+        line->append({TEXT_PIECE_ORIGINAL, offset, end - offset, text_length(data + offset, end - offset)});
         model->append_line(line);
-    }
 
-    stream_close(stream);
+        offset = end + 1;
+    }
 
     if (model->line_count() == 0)
     {
-        model->append_line(own<TextModelLine>());
+        model->append_line(own<TextModelLine>(model->storage()));
     }
 
     model->span_add(TextModelSpan(0, 0, 10, THEME_ANSI_RED, THEME_ANSI_BLUE));
 
-    if (model->line_count() == 0)
+    return model;
+}
+
+static Vector<TextPiece> text_line_pieces(TextModelLine &line)
+{
+    Vector<TextPiece> pieces{};
+
+    for (size_t i = 0; i < line.piece_count(); i++)
     {
-        model->append_line(own<TextModelLine>());
+        pieces.push_back(line.piece(i));
     }
 
-    return model;
+    return pieces;
+}
+
+void TextModel::begin_edit(bool typing, size_t line, size_t count, TextCursor &cursor)
+{
+    _pending = {};
+    _pending.typing = typing;
+    _pending.line = line;
+
+    for (size_t i = line; i < line + count; i++)
+    {
+        _pending.before.push_back(text_line_pieces(this->line(i)));
+    }
+
+    _pending.cursor_line_before = cursor.line();
+    _pending.cursor_column_before = cursor.column();
+}
+
+void TextModel::end_edit(size_t count, TextCursor &cursor)
+{
+    for (size_t i = _pending.line; i < _pending.line + count; i++)
+    {
+        _pending.after.push_back(text_line_pieces(line(i)));
+    }
+
+    _pending.cursor_line_after = cursor.line();
+    _pending.cursor_column_after = cursor.column();
+
+    highlight(_pending.line, count);
+
+    _redo.clear();
+
+    if (_pending.typing && _undo.any())
+    {
+        auto &last = _undo.peek_back();
+
+        if (last.typing &&
+            last.line == _pending.line &&
+            last.cursor_line_after == _pending.cursor_line_before &&
+            last.cursor_column_after == _pending.cursor_column_before)
+        {
+            last.after = move(_pending.after);
+            last.cursor_line_after = _pending.cursor_line_after;
+            last.cursor_column_after = _pending.cursor_column_after;
+
+            return;
+        }
+    }
+
+    _undo.push_back(move(_pending));
+
+    if (_undo.count() > TEXT_MODEL_UNDO_LIMIT)
+    {
+        _undo.remove_index(0);
+    }
+}
+
+void TextModel::replace_lines(size_t line, size_t count, Vector<Vector<TextPiece>> &pieces)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        _lines.remove_index(line);
+    }
+
+    for (size_t i = 0; i < pieces.count(); i++)
+    {
+        auto replacement = own<TextModelLine>(*_storage);
+
+        for (size_t j = 0; j < pieces[i].count(); j++)
+        {
+            replacement->append(pieces[i][j]);
+        }
+
+        _lines.insert(line + i, replacement);
+    }
+}
+
+void TextModel::highlight(size_t from, size_t count)
+{
+    if (!_highlighter)
+    {
+        return;
+    }
+
+    for (size_t i = from; i < MIN(from + count, line_count()); i++)
+    {
+        line(i).span_clear();
+        _highlighter(*this, i);
+    }
+}
+
+void TextModel::highlighter(TextModelHighlighter highlighter)
+{
+    _highlighter = move(highlighter);
+
+    span_clear();
+    highlight(0, line_count());
 }
 
 void TextModel::append_at(TextCursor &cursor, Codepoint codepoint)
 {
+    begin_edit(true, cursor.line(), 1, cursor);
+
     line(cursor.line()).append_at(cursor.column(), codepoint);
     cursor.move_right_within(*this);
+
+    end_edit(1, cursor);
 }
 
 void TextModel::backspace_at(TextCursor &cursor)
@@ -63,6 +467,8 @@ void TextModel::backspace_at(TextCursor &cursor)
     if (cursor.line() > 0 &&
         cursor.column() == 0)
     {
+        begin_edit(false, cursor.line() - 1, 2, cursor);
+
         int line_length = line(cursor.line() - 1).length();
         line(cursor.line() - 1).append(line(cursor.line()));
 
@@ -70,11 +476,17 @@ void TextModel::backspace_at(TextCursor &cursor)
 
         cursor.move_up_within(*this);
         cursor.move_to_within(line(cursor.line()), line_length);
+
+        end_edit(1, cursor);
     }
     else if (cursor.column() > 0 && line(cursor.line()).length() > 0)
     {
+        begin_edit(false, cursor.line(), 1, cursor);
+
         line(cursor.line()).backspace_at(cursor.column());
         cursor.move_left_within(*this);
+
+        end_edit(1, cursor);
     }
 }
 
@@ -82,54 +494,95 @@ void TextModel::delete_at(TextCursor &cursor)
 {
     if (cursor.line() < line_count() - 1 && cursor.column() == line(cursor.line()).length())
     {
+        begin_edit(false, cursor.line(), 2, cursor);
+
         line(cursor.line()).append(line(cursor.line() + 1));
 
         _lines.remove_index(cursor.line() + 1);
+
+        end_edit(1, cursor);
     }
     else if (cursor.column() < line(cursor.line()).length() && line(cursor.line()).length() > 0)
     {
+        begin_edit(false, cursor.line(), 1, cursor);
+
         line(cursor.line()).delete_at(cursor.column());
+
+        end_edit(1, cursor);
     }
 }
 
 void TextModel::newline_at(TextCursor &cursor)
 {
-    auto left_side_line = own<TextModelLine>();
-    auto right_side_line = own<TextModelLine>();
-
-    for (size_t i = 0; i < cursor.column(); i++)
-    {
-        left_side_line->append(line(cursor.line())[i]);
-    }
-
-    for (size_t i = cursor.column(); i < line(cursor.line()).length(); i++)
-    {
-        right_side_line->append(line(cursor.line())[i]);
-    }
-
-    _lines.remove_index(cursor.line());
+    begin_edit(false, cursor.line(), 1, cursor);
 
-    _lines.insert(cursor.line(), left_side_line);
+    auto right_side_line = line(cursor.line()).split_at(cursor.column());
     _lines.insert(cursor.line() + 1, right_side_line);
 
     cursor.move_down_within(*this);
     cursor.move_to_beginning_of_the_line();
+
+    end_edit(2, cursor);
 }
 
 void TextModel::move_line_up_at(TextCursor &cursor)
 {
     if (cursor.line() > 0)
     {
+        begin_edit(false, cursor.line() - 1, 2, cursor);
+
         _lines.insert(cursor.line() - 1, _lines.take_at(cursor.line()));
         cursor.move_up_within(*this);
+
+        end_edit(2, cursor);
     }
 }
 
 void TextModel::move_line_down_at(TextCursor &cursor)
 {
-    if (cursor.line() < line_count())
+    if (cursor.line() < line_count() - 1)
     {
+        begin_edit(false, cursor.line(), 2, cursor);
+
         _lines.insert(cursor.line() + 1, _lines.take_at(cursor.line()));
         cursor.move_down_within(*this);
+
+        end_edit(2, cursor);
     }
 }
+
+void TextModel::undo(TextCursor &cursor)
+{
+    if (!can_undo())
+    {
+        return;
+    }
+
+    auto edit = _undo.pop_back();
+
+    replace_lines(edit.line, edit.after.count(), edit.before);
+    highlight(edit.line, edit.before.count());
+
+    cursor.move_to_within(*this, edit.cursor_line_before);
+    cursor.move_to_within(line(cursor.line()), edit.cursor_column_before);
+
+    _redo.push_back(move(edit));
+}
+
+void TextModel::redo(TextCursor &cursor)
+{
+    if (!can_redo())
+    {
+        return;
+    }
+
+    auto edit = _redo.pop_back();
+
+    replace_lines(edit.line, edit.before.count(), edit.after);
+    highlight(edit.line, edit.after.count());
+
+    cursor.move_to_within(*this, edit.cursor_line_after);
+    cursor.move_to_within(line(cursor.line()), edit.cursor_column_after);
+
+    _undo.push_back(move(edit));
+}
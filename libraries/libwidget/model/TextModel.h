@@ -1,6 +1,7 @@
 #pragma once
 
 #include <libsystem/unicode/Codepoint.h>
+#include <libutils/Callback.h>
 #include <libutils/OwnPtr.h>
 #include <libutils/RefCounted.h>
 #include <libutils/Vector.h>
@@ -8,115 +9,269 @@
 #include <libwidget/Theme.h>
 
 struct TextCursor;
+class TextModel;
 
-class TextModelLine
+class TextModelSpan
 {
 private:
-    Vector<Codepoint> _codepoints{};
+    size_t _line;
+    size_t _start;
+    size_t _end;
+
+    ThemeColorRole _foreground;
+    ThemeColorRole _background;
 
 public:
-    TextModelLine()
-    {
-    }
+    size_t line() { return _line; }
 
-    ~TextModelLine()
-    {
-    }
+    size_t start() { return _start; }
 
-    Codepoint operator[](size_t index)
-    {
-        assert(index < length());
+    size_t end() { return _end; }
+
+    ThemeColorRole foreground() { return _foreground; }
+
+    ThemeColorRole background() { return _background; }
 
-        return _codepoints[index];
+    TextModelSpan(size_t line, size_t start, size_t end) : TextModelSpan(line, start, end, THEME_FOREGROUND, THEME_BACKGROUND)
+    {
     }
 
-    size_t length()
+    TextModelSpan(size_t line, size_t start, size_t end, ThemeColorRole foreground, ThemeColorRole background)
+        : _line(line),
+          _start(start),
+          _end(end),
+          _foreground(foreground),
+          _background(background)
     {
-        return _codepoints.count();
     }
 
-    void append(Codepoint codepoint)
+    ~TextModelSpan()
     {
-        _codepoints.push_back(codepoint);
     }
+};
+
+enum TextPieceSource
+{
+    TEXT_PIECE_ORIGINAL,
+    TEXT_PIECE_ADDED,
+};
 
-    void append(TextModelLine &line)
+// A run of utf8 text in one of the buffers of the storage, size is in bytes
+// and length in codepoints.
+struct TextPiece
+{
+    TextPieceSource source;
+    size_t start;
+    size_t size;
+    size_t length;
+};
+
+// The two buffers of the piece table: the original content of the file is
+// never modified and edits only append to the added buffer, so a piece stays
+// valid for the lifetime of the model, this is what undo and redo rely on.
+class TextStorage
+{
+private:
+    __noncopyable(TextStorage);
+    __nonmovable(TextStorage);
+
+    uint8_t *_original = nullptr;
+    size_t _original_size = 0;
+
+    Vector<uint8_t> _added{};
+
+public:
+    TextStorage() {}
+
+    TextStorage(uint8_t *original, size_t size)
+        : _original(original),
+          _original_size(size)
     {
-        _codepoints.push_back_many(line._codepoints);
     }
 
-    void append_at(size_t index, Codepoint codepoint)
+    ~TextStorage()
     {
-        _codepoints.insert(index, codepoint);
+        if (_original)
+        {
+            free(_original);
+        }
     }
 
-    void backspace_at(size_t index)
+    const uint8_t *data(const TextPiece &piece)
     {
-        _codepoints.remove_index(index - 1);
+        if (piece.source == TEXT_PIECE_ORIGINAL)
+        {
+            return _original + piece.start;
+        }
+        else
+        {
+            return _added.raw_storage() + piece.start;
+        }
     }
 
-    void delete_at(size_t index)
+    TextPiece append(Codepoint codepoint)
     {
-        _codepoints.remove_index(index);
+        uint8_t utf8[5];
+        int size = codepoint_to_utf8(codepoint, utf8);
+
+        TextPiece piece = {TEXT_PIECE_ADDED, _added.count(), (size_t)size, 1};
+
+        for (int i = 0; i < size; i++)
+        {
+            _added.push_back(utf8[i]);
+        }
+
+        return piece;
     }
 };
 
-class TextModelSpan
+// Decode one codepoint without reading past the end of the piece.
+size_t text_decode(const uint8_t *data, size_t size, Codepoint *codepoint);
+
+// Number of bytes used by the first length codepoints of the piece.
+size_t text_piece_offset(TextStorage &storage, const TextPiece &piece, size_t length);
+
+class TextModelLine
 {
 private:
-    size_t _line;
-    size_t _start;
-    size_t _end;
+    __noncopyable(TextModelLine);
+    __nonmovable(TextModelLine);
 
-    ThemeColorRole _foreground;
-    ThemeColorRole _background;
+    TextStorage *_storage;
 
-public:
-    size_t line() { return _line; }
+    // Most lines are a single piece of the original buffer, it is kept
+    // inline so loading a file does not allocate pieces for every line.
+    SmallVector<TextPiece, 1> _pieces{};
 
-    size_t start() { return _start; }
+    size_t _length = 0;
 
-    size_t end() { return _end; }
+    OwnPtr<Vector<TextModelSpan>> _spans;
 
-    ThemeColorRole foreground() { return _foreground; }
+    void insert_piece(size_t index, TextPiece piece);
 
-    ThemeColorRole background() { return _background; }
+    void remove_piece(size_t index);
 
-    TextModelSpan(size_t line, size_t start, size_t end) : TextModelSpan(line, start, end, THEME_FOREGROUND, THEME_BACKGROUND)
+    size_t split(size_t index);
+
+    void edited();
+
+public:
+    TextModelLine(TextStorage &storage)
+        : _storage(&storage)
     {
     }
 
-    TextModelSpan(size_t line, size_t start, size_t end, ThemeColorRole foreground, ThemeColorRole background)
-        : _line(line),
-          _start(start),
-          _end(end),
-          _foreground(foreground),
-          _background(background)
+    Codepoint operator[](size_t index);
+
+    size_t length()
     {
+        return _length;
     }
 
-    ~TextModelSpan()
+    size_t piece_count() { return _pieces.count(); }
+
+    TextPiece piece(size_t index) { return _pieces[index]; }
+
+    template <typename TCallback>
+    void foreach(TCallback callback)
+    {
+        for (size_t i = 0; i < _pieces.count(); i++)
+        {
+            const uint8_t *data = _storage->data(_pieces[i]);
+            size_t size = _pieces[i].size;
+
+            while (size > 0)
+            {
+                Codepoint codepoint;
+                size_t decoded = text_decode(data, size, &codepoint);
+
+                callback(codepoint);
+
+                data += decoded;
+                size -= decoded;
+            }
+        }
+    }
+
+    void append(TextPiece piece);
+
+    void append(Codepoint codepoint);
+
+    void append(TextModelLine &line);
+
+    void append_at(size_t index, Codepoint codepoint);
+
+    void backspace_at(size_t index)
     {
+        delete_at(index - 1);
     }
+
+    void delete_at(size_t index);
+
+    OwnPtr<TextModelLine> split_at(size_t index);
+
+    void span_add(const TextModelSpan &span);
+
+    TextModelSpan span_at(size_t line, size_t column);
+
+    void span_clear() { _spans = nullptr; }
+};
+
+struct TextModelEdit
+{
+    bool typing;
+
+    // Lines [line, line + before.count()) were replaced by the lines in after,
+    // both are only lists of pieces, the text itself is never copied.
+    size_t line;
+    Vector<Vector<TextPiece>> before;
+    Vector<Vector<TextPiece>> after;
+
+    size_t cursor_line_before;
+    size_t cursor_column_before;
+    size_t cursor_line_after;
+    size_t cursor_column_after;
 };
 
+#define TEXT_MODEL_UNDO_LIMIT 256
+
+using TextModelHighlighter = Callback<void(TextModel &model, size_t line)>;
+
 class TextModel : public RefCounted<TextModel>
 {
 private:
+    OwnPtr<TextStorage> _storage;
     Vector<OwnPtr<TextModelLine>> _lines{1024};
-    Vector<TextModelSpan> _spans{1024};
+
+    TextModelEdit _pending{};
+    Vector<TextModelEdit> _undo{};
+    Vector<TextModelEdit> _redo{};
+
+    TextModelHighlighter _highlighter;
+
+    void begin_edit(bool typing, size_t line, size_t count, TextCursor &cursor);
+
+    void end_edit(size_t count, TextCursor &cursor);
+
+    void replace_lines(size_t line, size_t count, Vector<Vector<TextPiece>> &pieces);
+
+    void highlight(size_t from, size_t count);
 
 public:
     static RefPtr<TextModel> empty();
 
     static RefPtr<TextModel> from_file(const char *path);
 
-    TextModel() {}
+    TextModel() : TextModel(own<TextStorage>()) {}
+
+    TextModel(OwnPtr<TextStorage> storage) : _storage(storage) {}
 
     ~TextModel() {}
 
     /* --- Editing ---------------------------------------------------------- */
 
+    TextStorage &storage() { return *_storage; }
+
     TextModelLine &line(int index) { return *_lines[index]; }
 
     size_t line_count() const { return _lines.count(); }
@@ -135,34 +290,38 @@ public:
 
     void move_line_down_at(TextCursor &cursor);
 
+    /* --- Undo/Redo -------------------------------------------------------- */
+
+    bool can_undo() { return _undo.any(); }
+
+    bool can_redo() { return _redo.any(); }
+
+    void undo(TextCursor &cursor);
+
+    void redo(TextCursor &cursor);
+
     /* --- Coloration ------------------------------------------------------- */
 
+    // The highlighter is called for every line when it is set and then only
+    // for the lines touched by an edit, their spans are cleared beforehand.
+    void highlighter(TextModelHighlighter highlighter);
+
     void span_add(TextModelSpan span)
     {
-        _spans.insert_sorted(span, [](auto &left, auto &right) {
-            return left.line() < right.line() &&
-                   left.start() < right.start();
-        });
+        line(span.line()).span_add(span);
     }
 
     TextModelSpan span_at(size_t line, size_t column)
     {
-        for (size_t i = 0; i < _spans.count(); i++)
-        {
-            auto &span = _spans[i];
-
-            if (span.line() == line && column >= span.start() && column < span.end())
-            {
-                return span;
-            }
-        }
-
-        return TextModelSpan(line, column, column + 1);
+        return this->line(line).span_at(line, column);
     }
 
     void span_clear()
     {
-        _spans.clear();
+        for (size_t i = 0; i < _lines.count(); i++)
+        {
+            _lines[i]->span_clear();
+        }
     }
 };
 
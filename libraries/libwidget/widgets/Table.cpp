@@ -107,6 +107,105 @@ void Table::paint_cell(Painter &painter, int row, int column)
     painter.pop();
 }
 
+void Table::update_scrollbar()
+{
+    _scrollbar->update(TABLE_ROW_HEIGHT * _model->rows(), list_bound().height(), _scroll_offset);
+}
+
+void Table::should_repaint_rows(int from, int to)
+{
+    if (from < 0 || from >= to)
+    {
+        return;
+    }
+
+    // Rows scrolled under the header show through its blur.
+    Rectangle dirty = row_bound(from).merged_with(row_bound(to - 1));
+
+    if (dirty.colide_with(body_bound()))
+    {
+        should_repaint(dirty.clipped_with(body_bound()));
+    }
+}
+
+void Table::model_changed(TableModel &model)
+{
+    if (!model.incremental())
+    {
+        should_repaint();
+        should_relayout();
+        return;
+    }
+
+    int rows = model.rows();
+
+    // Walk the changes from the row count before the first one, so each
+    // change repaints down to the last row it moved.
+    int running_rows = rows;
+
+    for (size_t i = 0; i < model.changes().count(); i++)
+    {
+        auto &change = model.changes()[i];
+
+        if (change.type == TABLE_MODEL_ROWS_INSERTED)
+        {
+            running_rows -= change.count;
+        }
+        else if (change.type == TABLE_MODEL_ROWS_REMOVED)
+        {
+            running_rows += change.count;
+        }
+    }
+
+    for (size_t i = 0; i < model.changes().count(); i++)
+    {
+        auto &change = model.changes()[i];
+
+        if (change.type == TABLE_MODEL_ROWS_UPDATED)
+        {
+            should_repaint_rows(change.row, change.row + change.count);
+            continue;
+        }
+
+        int old_rows = running_rows;
+
+        if (change.type == TABLE_MODEL_ROWS_INSERTED)
+        {
+            running_rows += change.count;
+        }
+        else
+        {
+            running_rows -= change.count;
+        }
+
+        // Every row after the change moved.
+        should_repaint_rows(change.row, MAX(old_rows, running_rows));
+
+        if (change.type == TABLE_MODEL_ROWS_INSERTED && _selected >= change.row)
+        {
+            _selected += change.count;
+        }
+        else if (change.type == TABLE_MODEL_ROWS_REMOVED && _selected >= change.row)
+        {
+            if (_selected < change.row + change.count)
+            {
+                _selected = -1;
+            }
+            else
+            {
+                _selected -= change.count;
+            }
+        }
+    }
+
+    if (rows == 0)
+    {
+        should_repaint(list_bound().take_top(TABLE_ROW_HEIGHT));
+    }
+
+    update_scrollbar();
+}
+
 Table::Table(Widget *parent)
     : Widget(parent)
 {
@@ -131,8 +230,6 @@ void Table::paint(Painter &painter, Rectangle rectangle)
         return;
     }
 
-    __unused(rectangle);
-
     painter.push();
     painter.clip(bound());
 
@@ -145,9 +242,11 @@ void Table::paint(Painter &painter, Rectangle rectangle)
     }
     else
     {
-        for (int row = MAX(0, _scroll_offset / TABLE_ROW_HEIGHT - 1);
-             row < MIN(_model->rows(), ((_scroll_offset + list_bound().height()) / TABLE_ROW_HEIGHT) + 1);
-             row++)
+        // Only the rows under the repainted rectangle are visited.
+        int first = (rectangle.top() - list_bound().y() + _scroll_offset) / TABLE_ROW_HEIGHT - 1;
+        int last = (rectangle.bottom() - list_bound().y() + _scroll_offset) / TABLE_ROW_HEIGHT + 1;
+
+        for (int row = MAX(0, first); row < MIN(_model->rows(), last); row++)
         {
 
             if (_selected == row)
@@ -233,5 +332,5 @@ void Table::do_layout()
     }
 
     _scrollbar->bound(scrollbar_bound());
-    _scrollbar->update(TABLE_ROW_HEIGHT * _model->rows(), list_bound().height(), _scroll_offset);
+    update_scrollbar();
 }
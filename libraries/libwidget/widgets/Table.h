@@ -28,14 +28,16 @@ private:
     Rectangle cell_bound(int row, int column) const;
     int row_at(Vec2i position) const;
     void paint_cell(Painter &painter, int row, int column);
+    void update_scrollbar();
+    void should_repaint_rows(int from, int to);
+    void model_changed(TableModel &model);
 
 public:
     void model(RefPtr<TableModel> model)
     {
         _model = model;
-        _model_observer = model->observe([this](auto &) {
-            should_repaint();
-            should_relayout();
+        _model_observer = model->observe([this](auto &model) {
+            model_changed(model);
         });
     }
 
@@ -58,8 +60,9 @@ public:
             return;
         }
 
+        should_repaint_rows(_selected, _selected + 1);
         _selected = index;
-        should_repaint();
+        should_repaint_rows(_selected, _selected + 1);
     }
 
     void scroll_to_top()
@@ -85,10 +85,10 @@ void TextField::paint(Painter &painter, Rectangle rectangle)
 
         Vec2i current_position = line_bound.cutoff_left_and_right((_linenumbers ? 32 : 0) + 4, 0).position() + Vec2i(0, LINE_HEIGHT / 2 + 4);
 
-        for (size_t j = 0; j < line.length(); j++)
-        {
-            Codepoint codepoint = line[j];
+        // Decode the line once instead of looking up every column.
+        size_t j = 0;
 
+        line.foreach([&](Codepoint codepoint) {
             if (i == _cursor.line() && j == _cursor.column())
             {
                 paint_cursor(painter, current_position);
@@ -104,14 +104,16 @@ void TextField::paint(Painter &painter, Rectangle rectangle)
             }
             else
             {
-                auto span = _model->span_at(i, j);
+                auto span = line.span_at(i, j);
 
                 auto glyph = font()->glyph(codepoint);
                 painter.draw_glyph(*font(), glyph, current_position, color(span.foreground()));
 
                 current_position += Vec2i(glyph.advance, 0);
             }
-        }
+
+            j++;
+        });
 
         if (i == _cursor.line() && line.length() == _cursor.column())
         {
@@ -211,7 +213,17 @@ void TextField::event(Event *event)
 
         if (!_readonly)
         {
-            if (event->keyboard.key == KEYBOARD_KEY_BKSPC)
+            if (event->keyboard.key == KEYBOARD_KEY_Z && event->keyboard.modifiers & KEY_MODIFIER_CTRL)
+            {
+                _model->undo(_cursor);
+                scroll_to_cursor();
+            }
+            else if (event->keyboard.key == KEYBOARD_KEY_Y && event->keyboard.modifiers & KEY_MODIFIER_CTRL)
+            {
+                _model->redo(_cursor);
+                scroll_to_cursor();
+            }
+            else if (event->keyboard.key == KEYBOARD_KEY_BKSPC)
             {
                 _model->backspace_at(_cursor);
                 scroll_to_cursor();